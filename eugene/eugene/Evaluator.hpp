@@ -0,0 +1,149 @@
+/* This file is part of Eugene
+ * Copyright 2007-2012 David Robillard <http://drobilla.net>
+ *
+ * Eugene is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Eugene is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Eugene.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EUGENE_EVALUATOR_HPP
+#define EUGENE_EVALUATOR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "eugene/Problem.hpp"
+
+namespace eugene {
+
+/** Evaluates batches of genes on a pool of worker threads.
+ *
+ * Problem::evaluate() must be a pure function of the gene, so the result of
+ * a batch is the same regardless of how it is split between threads.  The
+ * calling thread takes part in evaluation, so a pool of 1 spawns no threads.
+ */
+template<typename G>
+class Evaluator
+{
+public:
+	Evaluator(const Problem<G>& problem, size_t num_threads)
+		: _problem(problem)
+		, _batch(NULL)
+		, _next(0)
+		, _chunk(1)
+		, _busy(0)
+		, _round(0)
+		, _exit(false)
+	{
+		for (size_t i = 1; i < num_threads; ++i) {
+			_threads.push_back(std::thread(&Evaluator::run, this));
+		}
+	}
+
+	~Evaluator() {
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_exit = true;
+		}
+		_start.notify_all();
+		for (auto& t : _threads) {
+			t.join();
+		}
+	}
+
+	Evaluator(const Evaluator&) = delete;
+	Evaluator& operator=(const Evaluator&) = delete;
+
+	size_t num_threads() const { return _threads.size() + 1; }
+
+	/** Set the fitness of every gene in `batch`, blocking until done. */
+	void evaluate(const std::vector<G*>& batch) {
+		if (_threads.empty() || batch.size() < 2) {
+			for (auto g : batch) {
+				g->fitness = _problem.evaluate(*g);
+			}
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_batch = &batch;
+			_next  = 0;
+			_chunk = std::max(size_t(1), batch.size() / (num_threads() * 8));
+			_busy  = _threads.size();
+			++_round;
+		}
+		_start.notify_all();
+
+		work();
+
+		std::unique_lock<std::mutex> lock(_mutex);
+		_done.wait(lock, [this]{ return _busy == 0; });
+		_batch = NULL;
+	}
+
+private:
+	void run() {
+		unsigned round = 0;
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock(_mutex);
+				_start.wait(lock, [&]{ return _exit || _round != round; });
+				if (_exit) {
+					return;
+				}
+				round = _round;
+			}
+
+			work();
+
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (--_busy == 0) {
+				_done.notify_one();
+			}
+		}
+	}
+
+	/** Evaluate chunks of the current batch until none are left. */
+	void work() {
+		const std::vector<G*>& batch = *_batch;
+		const size_t           n     = batch.size();
+		for (size_t begin = _next.fetch_add(_chunk); begin < n;
+		     begin = _next.fetch_add(_chunk)) {
+			const size_t end = std::min(begin + _chunk, n);
+			for (size_t i = begin; i < end; ++i) {
+				batch[i]->fitness = _problem.evaluate(*batch[i]);
+			}
+		}
+	}
+
+	const Problem<G>&        _problem;
+	std::vector<std::thread> _threads;
+	std::mutex               _mutex;
+	std::condition_variable  _start;
+	std::condition_variable  _done;
+	const std::vector<G*>*   _batch;
+	std::atomic<size_t>      _next;
+	size_t                   _chunk;
+	size_t                   _busy;
+	unsigned                 _round;
+	bool                     _exit;
+};
+
+} // namespace eugene
+
+#endif // EUGENE_EVALUATOR_HPP
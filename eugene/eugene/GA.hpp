@@ -20,14 +20,17 @@
 
 #include <float.h>
 
+#include <algorithm>
 #include <atomic>
 #include <cassert>
 #include <list>
 #include <memory>
 #include <ostream>
 #include <utility>
+#include <vector>
 
 #include "eugene/Crossover.hpp"
+#include "eugene/Evaluator.hpp"
 #include "eugene/Mutation.hpp"
 #include "eugene/Problem.hpp"
 #include "eugene/Random.hpp"
@@ -49,7 +52,8 @@ public:
 	   size_t                           population_size,
 	   size_t                           num_elites,
 	   float                            mutation_probability,
-	   float                            crossover_probability);
+	   float                            crossover_probability,
+	   size_t                           num_threads = 1);
 
 	~GA() {}
 
@@ -62,6 +66,12 @@ public:
 
 	void iteration();
 
+	/** Return copies of (at most) the `n` fittest individuals found so far. */
+	std::vector<G> emigrants(size_t n) const;
+
+	/** Replace the least fit members of the population with `migrants`. */
+	void immigrate(std::vector<G>&& migrants);
+
 	float best_fitness() const { return _problem->evaluate(_best); }
 
 	bool fitness_less_than(float a, float b) const
@@ -72,6 +82,7 @@ public:
 	inline bool    optimum_known()   const { return _problem->optimum_known(); }
 	inline int32_t optimum()         const { return _problem->optimum(); }
 	inline int     evaluations()     const { return _selection->evaluations(); }
+	inline size_t  num_threads()     const { return _evaluator.num_threads(); }
 
 	std::shared_ptr< Problem<G> >   problem()   const { return _problem; }
 	std::shared_ptr< Selection<G> > selection() const { return _selection; }
@@ -98,8 +109,11 @@ protected:
 	std::shared_ptr< Selection<G> >  _selection;
 	std::shared_ptr< Crossover<G> >  _crossover;
 	std::shared_ptr< Mutation<G> >   _mutation;
+	Evaluator<G>                     _evaluator;
 	typename Problem<G>::Population  _population;
 	G                                _best;
+	G                                _parent;   ///< Scratch for mutation
+	std::vector<size_t>              _changed;  ///< Scratch for mutation
 	std::atomic<unsigned>            _generation;
 	Elites                           _elites;
 	size_t                           _gene_length;
@@ -120,14 +134,17 @@ GA<G>::GA(Random&                          rng,
           size_t                           population_size,
           size_t                           num_elites,
           float                            mutation_probability,
-          float                            crossover_probability)
+          float                            crossover_probability,
+          size_t                           num_threads)
 	: _rng(rng)
 	, _problem(problem)
 	, _selection(selection)
 	, _crossover(crossover)
 	, _mutation(mutation)
+	, _evaluator(*problem.get(), num_threads)
 	, _population(population)
 	, _best(population.front())
+	, _parent(population.front())
 	, _generation(0)
 	, _gene_length(gene_length)
 	, _num_elites(num_elites)
@@ -136,9 +153,12 @@ GA<G>::GA(Random&                          rng,
 	, _elite_threshold(FLT_MAX)
 {
 	assert(gene_length > 0);
+	std::vector<G*> batch;
+	batch.reserve(_population.size());
 	for (auto& p : _population) {
-		p.fitness = _problem->evaluate(p);
+		batch.push_back(&p);
 	}
+	_evaluator.evaluate(batch);
 	_best = _population.front();
 	find_elites(_population);
 	assert(_elites.size() == num_elites);
@@ -214,8 +234,13 @@ GA<G>::iteration()
 	typename Problem<G>::Population new_population;
 	new_population.reserve(_population.size());
 
+	// Whether each member of new_population needs to be evaluated
+	std::vector<bool> dirty;
+	dirty.reserve(_population.size());
+
 	// Elitism (preserve the most fit solutions from last generation)
 	new_population.insert(new_population.begin(), _elites.begin(), _elites.end());
+	dirty.assign(new_population.size(), false);
 
 	// Crossover parents until new population is as large as the old
 	while (new_population.size() < _population.size()) {
@@ -224,35 +249,75 @@ GA<G>::iteration()
 
 		std::pair<G, G> children = std::make_pair(
 			*parents.first, *parents.second);
+		bool crossed = false;
 		if (_crossover && _rng.gamble(_crossover_probability)) {
 			// Crossover parents to yield two new children
 			children = _crossover->crossover(
 				_rng, *parents.first, *parents.second);
-			children.first.fitness  = _problem->evaluate(children.first);
-			children.second.fitness = _problem->evaluate(children.second);
+			crossed = true;
 		}
 
 		// Add both children, or the fittest if there's only room for 1
 		if (new_population.size() < _population.size() - 1) {
 			new_population.push_back(children.first);
 			new_population.push_back(children.second);
-		} else if (_problem->fitness_less_than(children.first.fitness,
-		                                       children.second.fitness)) {
+			dirty.push_back(crossed);
+			dirty.push_back(crossed);
+			continue;
+		}
+
+		if (crossed) {
+			// Fitness is needed to choose now, evaluate this pair immediately
+			children.first.fitness  = _problem->evaluate(children.first);
+			children.second.fitness = _problem->evaluate(children.second);
+		}
+
+		if (_problem->fitness_less_than(children.first.fitness,
+		                                children.second.fitness)) {
 			new_population.push_back(children.second);
 		} else {
 			new_population.push_back(children.first);
 		}
+		dirty.push_back(false);
 	}
 
 	// Mutate new population
-	for (typename Problem<G>::Population::iterator i = new_population.begin();
-	     i != new_population.end(); ++i) {
+	std::vector<size_t> mutants;
+	for (size_t i = 0; i < new_population.size(); ++i) {
 		if (_rng.gamble(_mutation_probability)) {
-			_mutation->mutate(_rng, (G &) * i);
-			i->fitness = _problem->evaluate(*i);
-			if (_problem->fitness_less_than(_elite_threshold, i->fitness)) {
-				_elites.push_back(*i);
+			G& gene = new_population[i];
+			if (!dirty[i] && _problem->incremental()) {
+				// Fitness is up to date, try to only evaluate the change
+				_parent = gene;
+				_changed.clear();
+				if (_mutation->mutate_changes(_rng, gene, _changed)) {
+					gene.fitness = _problem->evaluate_change(
+						_parent, gene, _changed);
+				} else {
+					dirty[i] = true;
+				}
+			} else {
+				_mutation->mutate(_rng, gene);
+				dirty[i] = true;
 			}
+			mutants.push_back(i);
+		}
+	}
+
+	// Evaluate every new child in one batch
+	std::vector<G*> batch;
+	batch.reserve(new_population.size());
+	for (size_t i = 0; i < new_population.size(); ++i) {
+		if (dirty[i]) {
+			batch.push_back(&new_population[i]);
+		}
+	}
+	_evaluator.evaluate(batch);
+
+	for (size_t i : mutants) {
+		if (_problem->fitness_less_than(_elite_threshold,
+		                                new_population[i].fitness)) {
+			_elites.push_back(new_population[i]);
 		}
 	}
 
@@ -266,7 +331,44 @@ GA<G>::iteration()
 #endif
 
 	assert(new_population.size() == _population.size());
-	_population = new_population;
+	_population.swap(new_population);
+}
+
+template<typename G>
+std::vector<G>
+GA<G>::emigrants(size_t n) const
+{
+	std::vector<G> result;
+	for (typename Elites::const_iterator i = _elites.begin();
+	     i != _elites.end() && result.size() < n; ++i) {
+		result.push_back(*i);
+	}
+	return result;
+}
+
+template<typename G>
+void
+GA<G>::immigrate(std::vector<G>&& migrants)
+{
+	const size_t n = std::min(migrants.size(), _population.size());
+	if (n == 0) {
+		return;
+	}
+
+	// Move the n least fit members to the end of the population
+	typename Problem<G>::FitnessGreaterThan cmp(*_problem.get());
+	std::nth_element(_population.begin(), _population.end() - n,
+	                 _population.end(), cmp);
+
+	for (size_t i = 0; i < n; ++i) {
+		G& slot = _population[_population.size() - n + i];
+		slot = std::move(migrants[i]);
+		if (_problem->fitness_less_than(_elite_threshold, slot.fitness)) {
+			_elites.push_back(slot);
+		}
+	}
+
+	find_elites(_population);
 }
 
 } // namespace eugene
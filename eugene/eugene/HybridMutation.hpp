@@ -64,6 +64,17 @@ public:
 	}
 
 	void mutate(Random& rng, G& gene) {
+		choose(rng)->mutate(rng, gene);
+	}
+
+	bool mutate_changes(Random& rng, G& gene, std::vector<size_t>& changed) {
+		return choose(rng)->mutate_changes(rng, gene, changed);
+	}
+
+	const Mutations& mutations() const { return _mutations; }
+
+private:
+	Mutation<G>* choose(Random& rng) {
 		const float cut = rng.normal();
 
 		float accum = 0;
@@ -71,17 +82,13 @@ public:
 		     i != _mutations.end(); ++i) {
 			accum += i->first;
 			if (cut <= accum) {
-				i->second->mutate(rng, gene);
-				return;
+				return i->second.get();
 			}
 		}
 
-		_mutations.back().second->mutate(rng, gene);
+		return _mutations.back().second.get();
 	}
 
-	const Mutations& mutations() const { return _mutations; }
-
-private:
 	Mutations _mutations;
 };
 
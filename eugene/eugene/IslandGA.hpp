@@ -0,0 +1,217 @@
+/* This file is part of Eugene
+ * Copyright 2007-2012 David Robillard <http://drobilla.net>
+ *
+ * Eugene is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Eugene is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Eugene.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EUGENE_ISLANDGA_HPP
+#define EUGENE_ISLANDGA_HPP
+
+#include <cassert>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "eugene/GA.hpp"
+#include "eugene/Problem.hpp"
+#include "eugene/Random.hpp"
+
+namespace eugene {
+
+/** Which islands receive migrants from each island in an IslandGA. */
+enum Topology {
+	RING,      ///< Island i sends migrants to island i + 1
+	COMPLETE,  ///< Every island sends migrants to every other island
+	RANDOM     ///< Every island sends migrants to a random other island
+};
+
+/** Island model GA: several independent populations with migration.
+ *
+ * Each island is a complete GA with its own population and Random, evolved
+ * on its own thread.  Every `migration_interval` generations the islands
+ * stop and copies of the elites of each island replace the least fit
+ * members of its neighbours, as defined by the topology.
+ *
+ * Islands are seeded from the given Random in order and migration happens
+ * on the calling thread, so results for a fixed seed are reproducible.
+ */
+template<typename G>
+class IslandGA
+{
+public:
+	/** Build the GA for one island, which must use `rng` for everything.
+	 *
+	 * Each island must have its own Selection, since that is where
+	 * evaluations are counted.
+	 */
+	typedef std::function<std::shared_ptr< GA<G> >(Random& rng)> Factory;
+
+	IslandGA(Random&        rng,
+	         const Factory& factory,
+	         size_t         num_islands,
+	         Topology       topology,
+	         size_t         migration_interval,
+	         size_t         num_migrants);
+
+	/** Evolve every island for one migration interval, then migrate. */
+	void iteration();
+
+	const G& best() const { return _islands[_best]->ga->best(); }
+
+	float best_fitness() const { return _islands[_best]->ga->best_fitness(); }
+
+	inline int     generation()    const { return front().generation(); }
+	inline bool    optimum_known() const { return front().optimum_known(); }
+	inline int32_t optimum()       const { return front().optimum(); }
+
+	/** Total evaluations on all islands. */
+	inline int evaluations() const {
+		int total = 0;
+		for (const auto& i : _islands) {
+			total += i->ga->evaluations();
+		}
+		return total;
+	}
+
+	size_t num_islands() const { return _islands.size(); }
+
+	std::shared_ptr< GA<G> > island(size_t i) const { return _islands[i]->ga; }
+
+private:
+	struct Island {
+		explicit Island(unsigned seed) : rng(seed) {}
+
+		Random                   rng;
+		std::shared_ptr< GA<G> > ga;
+	};
+
+	GA<G>& front() const { return *_islands.front()->ga.get(); }
+
+	void migrate();
+	void find_best();
+
+	Random&                                _rng;
+	std::vector< std::unique_ptr<Island> > _islands;
+	Topology                               _topology;
+	size_t                                 _migration_interval;
+	size_t                                 _num_migrants;
+	size_t                                 _best;
+};
+
+template<typename G>
+IslandGA<G>::IslandGA(Random&        rng,
+                      const Factory& factory,
+                      size_t         num_islands,
+                      Topology       topology,
+                      size_t         migration_interval,
+                      size_t         num_migrants)
+	: _rng(rng)
+	, _topology(topology)
+	, _migration_interval(migration_interval)
+	, _num_migrants(num_migrants)
+	, _best(0)
+{
+	assert(num_islands > 0);
+	assert(migration_interval > 0);
+	for (size_t i = 0; i < num_islands; ++i) {
+		_islands.push_back(std::unique_ptr<Island>(new Island(_rng.natural())));
+		_islands.back()->ga = factory(_islands.back()->rng);
+	}
+	find_best();
+}
+
+template<typename G>
+void
+IslandGA<G>::iteration()
+{
+	const size_t n_generations = _migration_interval;
+	auto evolve = [n_generations](GA<G>* ga) {
+		for (size_t g = 0; g < n_generations; ++g) {
+			ga->iteration();
+		}
+	};
+
+	// Evolve all islands but the first in other threads
+	std::vector<std::thread> threads;
+	for (size_t i = 1; i < _islands.size(); ++i) {
+		threads.push_back(std::thread(evolve, _islands[i]->ga.get()));
+	}
+	evolve(_islands.front()->ga.get());
+	for (auto& t : threads) {
+		t.join();
+	}
+
+	if (_islands.size() > 1 && _num_migrants > 0) {
+		migrate();
+	}
+
+	find_best();
+}
+
+template<typename G>
+void
+IslandGA<G>::migrate()
+{
+	const size_t n = _islands.size();
+
+	std::vector< std::vector<G> > incoming(n);
+	for (size_t i = 0; i < n; ++i) {
+		std::vector<G> emigrants = _islands[i]->ga->emigrants(_num_migrants);
+		switch (_topology) {
+		case RING:
+			incoming[(i + 1) % n] = std::move(emigrants);
+			break;
+		case COMPLETE:
+			for (size_t j = 0; j < n; ++j) {
+				if (j != i) {
+					incoming[j].insert(incoming[j].end(),
+					                   emigrants.begin(), emigrants.end());
+				}
+			}
+			break;
+		case RANDOM: {
+			size_t dest = _rng.natural(n - 1);
+			if (dest >= i) {
+				++dest;  // Anywhere but home
+			}
+			for (auto& e : emigrants) {
+				incoming[dest].push_back(std::move(e));
+			}
+			break;
+		}
+		}
+	}
+
+	for (size_t i = 0; i < n; ++i) {
+		_islands[i]->ga->immigrate(std::move(incoming[i]));
+	}
+}
+
+template<typename G>
+void
+IslandGA<G>::find_best()
+{
+	for (size_t i = 0; i < _islands.size(); ++i) {
+		if (front().fitness_less_than(_islands[_best]->ga->best().fitness,
+		                              _islands[i]->ga->best().fitness)) {
+			_best = i;
+		}
+	}
+}
+
+} // namespace eugene
+
+#endif // EUGENE_ISLANDGA_HPP
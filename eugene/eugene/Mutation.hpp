@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <vector>
 
 #include "eugene/Random.hpp"
 
@@ -29,6 +30,19 @@ template<typename G>
 struct Mutation {
 	virtual ~Mutation() {}
 	virtual void mutate(Random& rng, G& g) = 0;
+
+	/** Mutate `g` and append the index of every changed allele to `changed`.
+	 *
+	 * Returns false if the mutation can not describe its changes, so `g` must
+	 * be fully evaluated.  Mutations which implement this should implement
+	 * mutate() by calling it.
+	 */
+	virtual bool mutate_changes(Random&              rng,
+	                            G&                   g,
+	                            std::vector<size_t>& /*changed*/) {
+		mutate(rng, g);
+		return false;
+	}
 };
 
 template<typename G>
@@ -41,8 +55,15 @@ public:
 	{}
 
 	void mutate(Random& rng, G& g) {
+		std::vector<size_t> changed;
+		mutate_changes(rng, g, changed);
+	}
+
+	bool mutate_changes(Random& rng, G& g, std::vector<size_t>& changed) {
 		const size_t index = rng.natural(g.size());
 		g[index] = rng.integer(_min, _max);
+		changed.push_back(index);
+		return true;
 	}
 
 private:
@@ -55,8 +76,15 @@ class FlipMutation : public Mutation<G>
 {
 public:
 	void mutate(Random& rng, G& g) {
+		std::vector<size_t> changed;
+		mutate_changes(rng, g, changed);
+	}
+
+	bool mutate_changes(Random& rng, G& g, std::vector<size_t>& changed) {
 		const size_t index = rng.natural(g.size());
 		g[index] *= -1;
+		changed.push_back(index);
+		return true;
 	}
 
 };
@@ -66,6 +94,11 @@ class FlipRangeMutation : public Mutation<G>
 {
 public:
 	void mutate(Random& rng, G& g) {
+		std::vector<size_t> changed;
+		mutate_changes(rng, g, changed);
+	}
+
+	bool mutate_changes(Random& rng, G& g, std::vector<size_t>& changed) {
 		const size_t rand_1 = rng.natural(g.size());
 		const size_t rand_2 = rng.natural(g.size());
 		const size_t left   = std::min(rand_1, rand_2);
@@ -74,7 +107,9 @@ public:
 		for (size_t i = left; i <= right; ++i) {
 			assert(g[i] == 1 || g[i] == -1);
 			g[i] *= -1;
+			changed.push_back(i);
 		}
+		return true;
 	}
 
 };
@@ -84,12 +119,19 @@ class FlipRandomMutation : public Mutation<G>
 {
 public:
 	void mutate(Random& rng, G& g) {
+		std::vector<size_t> changed;
+		mutate_changes(rng, g, changed);
+	}
+
+	bool mutate_changes(Random& rng, G& g, std::vector<size_t>& changed) {
 		for (size_t i = 0; i < g.size(); ++i) {
 			assert(g[i] == 1 || g[i] == -1);
 			if (rng.gamble(1 / (g.size() / 2.0f)) == 0) {
 				g[i] *= -1;
+				changed.push_back(i);
 			}
 		}
+		return true;
 	}
 
 };
@@ -99,11 +141,17 @@ class SwapRangeMutation : public Mutation<G>
 {
 public:
 	void mutate(Random& rng, G& g) {
+		std::vector<size_t> changed;
+		mutate_changes(rng, g, changed);
+	}
+
+	bool mutate_changes(Random& rng, G& g, std::vector<size_t>& changed) {
 		const size_t index_a = rng.natural(g.size());
 		const size_t index_b = rng.natural(g.size());
-		typename G::value_type temp = g[index_a];
-		g[index_a]                  = g[index_b];
-		g[index_b]                  = temp;
+		std::swap(g[index_a], g[index_b]);
+		changed.push_back(index_a);
+		changed.push_back(index_b);
+		return true;
 	}
 
 };
@@ -113,11 +161,17 @@ class SwapAlleleMutation : public Mutation<G>
 {
 public:
 	void mutate(Random& rng, G& g) {
+		std::vector<size_t> changed;
+		mutate_changes(rng, g, changed);
+	}
+
+	bool mutate_changes(Random& rng, G& g, std::vector<size_t>& changed) {
 		const size_t index_a = rng.natural(g.size());
 		const size_t index_b = rng.natural(g.size());
-		typename G::value_type temp = g[index_a];
-		g[index_a]                  = g[index_b];
-		g[index_b]                  = temp;
+		std::swap(g[index_a], g[index_b]);
+		changed.push_back(index_a);
+		changed.push_back(index_b);
+		return true;
 	}
 
 };
@@ -127,16 +181,23 @@ class ReverseMutation : public Mutation<G>
 {
 public:
 	void mutate(Random& rng, G& g) {
+		std::vector<size_t> changed;
+		mutate_changes(rng, g, changed);
+	}
+
+	bool mutate_changes(Random& rng, G& g, std::vector<size_t>& changed) {
 		const size_t index_a = rng.natural(g.size());
 		const size_t index_b = rng.natural(g.size());
 		const size_t left    = std::min(index_a, index_b);
 		const size_t right   = std::max(index_a, index_b);
 
 		for (size_t i = 0; i < right - left; ++i) {
-			typename G::value_type temp = g[left + i];
-			g[left + i]                 = g[right - i];
-			g[right - i]                = temp;
+			std::swap(g[left + i], g[right - i]);
+		}
+		for (size_t i = left; i <= right; ++i) {
+			changed.push_back(i);
 		}
+		return true;
 	}
 
 };
@@ -40,6 +40,22 @@ public:
 
 	virtual float evaluate(const G& g) const = 0;
 
+	/** Return true iff evaluate_change() is cheaper than evaluate(). */
+	virtual bool incremental() const { return false; }
+
+	/** Return the fitness of `child`, which differs from `parent` only at
+	 * the indices in `changed`.
+	 *
+	 * The fitness of `parent` must be up to date.  Problems that can compute
+	 * the effect of a local change override this, by default `child` is
+	 * simply evaluated from scratch.
+	 */
+	virtual float evaluate_change(const G&                   /*parent*/,
+	                              const G&                   child,
+	                              const std::vector<size_t>& /*changed*/) const {
+		return evaluate(child);
+	}
+
 	virtual bool fitness_less_than(float a, float b) const = 0;
 
 	inline float total_fitness(const Population& pop) const {
@@ -15,18 +15,162 @@
  * with Eugene.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <cassert>
 #include <stdexcept>
 #include <sstream>
 #include <iostream>
 #include <fstream>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#    include <immintrin.h>
+#    define EUGENE_HAVE_AVX2_KERNEL 1
+#endif
+
 #include "LABS.hpp"
 
 using namespace std;
 
 namespace eugene {
 
+/** Pack `s` into a word, with bit i set iff s[i] is -1. */
+static inline uint64_t
+pack(const LABS::GeneType& s)
+{
+	uint64_t x = 0;
+	for (size_t i = 0; i < s.size(); ++i) {
+		x |= uint64_t(s[i] < 0) << i;
+	}
+	return x;
+}
+
+/** Return C_g of packed sequence x of length n.
+ *
+ * Equal bits contribute +1 and differing bits -1, so C_g is the number of
+ * compared pairs minus twice the number of differing ones.
+ */
+static inline int32_t
+packed_c_g(uint64_t x, size_t n, size_t g)
+{
+	const size_t   len  = n - g;  // < 64 since g >= 1
+	const uint64_t mask = (uint64_t(1) << len) - 1;
+	return int32_t(len) - 2 * __builtin_popcountll((x ^ (x >> g)) & mask);
+}
+
+static void
+packed_correlations(uint64_t x, size_t n, int32_t* c)
+{
+	for (size_t g = 1; g < n; ++g) {
+		c[g - 1] = packed_c_g(x, n, g);
+	}
+}
+
+#ifdef EUGENE_HAVE_AVX2_KERNEL
+__attribute__((target("avx2")))
+static void
+avx2_correlations(uint64_t x, size_t n, int32_t* c)
+{
+	// Nibble popcount table, since AVX2 has no 64-bit popcount
+	const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3,
+	                                       1, 2, 2, 3, 2, 3, 3, 4,
+	                                       0, 1, 1, 2, 1, 2, 2, 3,
+	                                       1, 2, 2, 3, 2, 3, 3, 4);
+	const __m256i nibble = _mm256_set1_epi8(0x0F);
+	const __m256i one    = _mm256_set1_epi64x(1);
+	const __m256i vn     = _mm256_set1_epi64x(n);
+	const __m256i vx     = _mm256_set1_epi64x(x);
+
+	size_t g = 1;
+	for (; g + 3 < n; g += 4) {
+		const __m256i shift = _mm256_setr_epi64x(g, g + 1, g + 2, g + 3);
+		const __m256i len   = _mm256_sub_epi64(vn, shift);
+		const __m256i mask  = _mm256_sub_epi64(_mm256_sllv_epi64(one, len), one);
+		const __m256i diff  = _mm256_and_si256(
+			_mm256_xor_si256(vx, _mm256_srlv_epi64(vx, shift)), mask);
+
+		const __m256i lo  = _mm256_and_si256(diff, nibble);
+		const __m256i hi  = _mm256_and_si256(_mm256_srli_epi16(diff, 4), nibble);
+		const __m256i cnt = _mm256_sad_epu8(
+			_mm256_add_epi8(_mm256_shuffle_epi8(table, lo),
+			                _mm256_shuffle_epi8(table, hi)),
+			_mm256_setzero_si256());
+
+		const __m256i cg = _mm256_sub_epi64(len, _mm256_add_epi64(cnt, cnt));
+
+		int64_t out[4];
+		_mm256_storeu_si256((__m256i*)out, cg);
+		c[g - 1] = out[0];
+		c[g]     = out[1];
+		c[g + 1] = out[2];
+		c[g + 2] = out[3];
+	}
+
+	for (; g < n; ++g) {
+		c[g - 1] = packed_c_g(x, n, g);
+	}
+}
+#endif
+
+LABS::LABS(size_t gene_size)
+	: Problem<LABSGene>(gene_size)
+	, _kernel(SCALAR)
+{
+	if (!set_kernel(AVX2)) {
+		set_kernel(PACKED);
+	}
+}
+
+bool
+LABS::kernel_supported(Kernel kernel) const
+{
+	switch (kernel) {
+	case SCALAR:
+		return true;
+	case PACKED:
+		return _gene_size <= 64;
+	case AVX2:
+#ifdef EUGENE_HAVE_AVX2_KERNEL
+		return _gene_size <= 64 && __builtin_cpu_supports("avx2");
+#else
+		return false;
+#endif
+	}
+	return false;
+}
+
+bool
+LABS::set_kernel(Kernel kernel)
+{
+	if (kernel_supported(kernel)) {
+		_kernel = kernel;
+		return true;
+	}
+	return false;
+}
+
+void
+LABS::correlations(const GeneType& s, std::vector<int32_t>& c) const
+{
+	const size_t n = s.size();
+	c.resize(n - 1);
+
+	switch (_kernel) {
+	case SCALAR:
+		for (size_t g = 1; g < n; ++g) {
+			c[g - 1] = c_g(n, g, s);
+		}
+		break;
+	case PACKED:
+		packed_correlations(pack(s), n, &c[0]);
+		break;
+	case AVX2:
+#ifdef EUGENE_HAVE_AVX2_KERNEL
+		avx2_correlations(pack(s), n, &c[0]);
+#endif
+		break;
+	}
+}
+
 void
 LABS::initial_population(Random&     rng,
                          Population& pop,
@@ -50,14 +194,32 @@ LABS::initial_population(Random&     rng,
 float
 LABS::evaluate(const GeneType& gene) const
 {
-	float f = 0.0f;
+	correlations(gene, gene.correlations);
+	return fitness(gene.correlations);
+}
+
+float
+LABS::evaluate_change(const GeneType&            parent,
+                      const GeneType&            child,
+                      const std::vector<size_t>& changed) const
+{
+	const size_t n = child.size();
+	if (parent.correlations.size() != n - 1 || changed.size() * 4 > n) {
+		return evaluate(child);  // Not much cheaper than a full evaluation
+	}
 
-	for (size_t g = 1; g < gene.size(); ++g) {
-		int32_t cg = c_g(gene.size(), g, gene);
-		f += cg * cg;
+	// Apply each flip in turn to a copy of the parent
+	std::vector<int32_t>  s(parent.begin(), parent.end());
+	std::vector<int32_t>& c = child.correlations;
+	c = parent.correlations;
+	for (size_t i : changed) {
+		if (s[i] != child[i]) {
+			flip(s, i, c);
+		}
 	}
 
-	return f;
+	assert(std::equal(s.begin(), s.end(), child.begin()));
+	return fitness(c);
 }
 
 float
@@ -18,9 +18,12 @@
 #ifndef EUGENE_LABS_HPP
 #define EUGENE_LABS_HPP
 
+#include <stdint.h>
+
 #include <utility>
 #include <string>
 #include <set>
+#include <vector>
 #include <cmath>
 
 #include "eugene/Problem.hpp"
@@ -28,15 +31,50 @@
 
 namespace eugene {
 
-class LABS : public Problem< Gene<int32_t> > {
+/** A binary sequence of 1 and -1 which caches its autocorrelations.
+ *
+ * The autocorrelations are set whenever the sequence is evaluated, so that
+ * a child which differs in only a few alleles can be evaluated in O(n) per
+ * changed allele rather than O(n^2).
+ */
+struct LABSGene : public Gene<int32_t> {
+	LABSGene(size_t gene_size, const int32_t& initial = 0)
+		: Gene<int32_t>(gene_size, initial)
+	{}
+
+	/** C_g for g = 1..n-1 at index g - 1, or empty if unknown. */
+	mutable std::vector<int32_t> correlations;
+};
+
+class LABS : public Problem<LABSGene> {
 public:
-	explicit LABS(size_t gene_size) : Problem< Gene<int32_t> >(gene_size) {}
+	/** Implementation used to calculate autocorrelations. */
+	enum Kernel {
+		SCALAR,  ///< Nested loops over alleles, any length
+		PACKED,  ///< Popcount of bit-packed sequence, up to 64 alleles
+		AVX2     ///< PACKED for 4 shifts at once with AVX2, up to 64 alleles
+	};
+
+	explicit LABS(size_t gene_size);
+
+	typedef int32_t  Allele;
+	typedef LABSGene GeneType;
+
+	/** Return true iff `kernel` can be used on this machine and problem. */
+	bool kernel_supported(Kernel kernel) const;
+
+	/** Use `kernel` for evaluation if supported, return true on success. */
+	bool set_kernel(Kernel kernel);
 
-	typedef int32_t      Allele;
-	typedef Gene<Allele> GeneType;
+	Kernel kernel() const { return _kernel; }
 
 	float evaluate(const GeneType& g) const;
 
+	bool  incremental() const { return true; }
+	float evaluate_change(const GeneType&            parent,
+	                      const GeneType&            child,
+	                      const std::vector<size_t>& changed) const;
+
 	bool fitness_less_than(float a, float b) const { return a > b; }
 
 	void initial_population(Random&     rng,
@@ -71,6 +109,41 @@ private:
 
 		return ret;
 	}
+
+	/** Update correlations `c` of `s` for flipping `s[i]`, and flip it. */
+	inline void flip(std::vector<int32_t>& s,
+	                 size_t                i,
+	                 std::vector<int32_t>& c) const {
+		const size_t  n  = s.size();
+		const int32_t si = s[i];
+
+		// Only the products s[i] * s[i +/- g] change sign
+		for (size_t g = 1; g < n; ++g) {
+			int32_t d = 0;
+			if (i + g < n) {
+				d += s[i + g];
+			}
+			if (i >= g) {
+				d += s[i - g];
+			}
+			c[g - 1] -= 2 * si * d;
+		}
+
+		s[i] = -si;
+	}
+
+	/** Set `c` to the autocorrelations of `s` using the current kernel. */
+	void correlations(const GeneType& s, std::vector<int32_t>& c) const;
+
+	static float fitness(const std::vector<int32_t>& c) {
+		float f = 0.0f;
+		for (size_t g = 0; g < c.size(); ++g) {
+			f += c[g] * c[g];
+		}
+		return f;
+	}
+
+	Kernel _kernel;
 };
 
 } // namespace eugene
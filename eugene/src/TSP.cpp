@@ -79,6 +79,15 @@ TSP::TSP(const std::string& filename)
 
 	_gene_size = cities;
 
+	if (cities <= MAX_MATRIX_CITIES) {
+		_distances.resize(cities * cities);
+		for (size_t a = 0; a < cities; ++a) {
+			for (size_t b = 0; b < cities; ++b) {
+				_distances[a * cities + b] = distance(_cities[a], _cities[b]);
+			}
+		}
+	}
+
 	cout << "Loaded " << cities << " cities" << endl;
 }
 
@@ -106,21 +115,47 @@ TSP::initial_population(Random&     rng,
 float
 TSP::evaluate(const GeneType& g) const
 {
-	//assert(g.size() == _cities.size());
+	assert(g.size() == _cities.size());
 
-	float d = 0.0f;
+	double d = 0.0;
 
-	for (size_t i = 0; i < _cities.size() - 1; ++i) {
-		assert(i < g.size());
+	for (size_t i = 0; i < g.size(); ++i) {
 		assert(g[i] < _cities.size());
-		assert(g[i+1] < _cities.size());
-		d += distance(_cities[g[i]], _cities[g[i+1]]);
+		d += edge(g, i);
 	}
 
-	d += distance(_cities[_cities.size()-1], _cities[0]);
-
 	return d;
 }
 
+float
+TSP::evaluate_change(const GeneType&            parent,
+                     const GeneType&            child,
+                     const std::vector<size_t>& changed) const
+{
+	const size_t n = child.size();
+	if (changed.size() * 4 > n) {
+		return evaluate(child);  // Not much cheaper than a full evaluation
+	}
+
+	// Every edge that starts or ends at a changed position
+	std::vector<size_t> edges;
+	edges.reserve(changed.size() * 2);
+	for (size_t i : changed) {
+		edges.push_back((i + n - 1) % n);
+		edges.push_back(i);
+	}
+	std::sort(edges.begin(), edges.end());
+	edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+	// Sum the change in double so it is rounded only once, when applied
+	// to the parent's fitness (which may itself be incremental)
+	double delta = 0.0;
+	for (size_t i : edges) {
+		delta += (double)edge(child, i) - edge(parent, i);
+	}
+
+	return (double)parent.fitness + delta;
+}
+
 } // namespace eugene
 
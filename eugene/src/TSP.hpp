@@ -24,6 +24,7 @@
 #include <utility>
 #include <string>
 #include <set>
+#include <vector>
 
 #include "eugene/Problem.hpp"
 #include "eugene/Gene.hpp"
@@ -38,6 +39,12 @@ public:
 	explicit TSP(const std::string& filename);
 
 	float evaluate(const GeneType& g) const;
+
+	bool  incremental() const { return true; }
+	float evaluate_change(const GeneType&            parent,
+	                      const GeneType&            child,
+	                      const std::vector<size_t>& changed) const;
+
 	bool fitness_less_than(float a, float b) const { return a > b; }
 
 	typedef std::pair<uint32_t,uint32_t> City;
@@ -73,6 +80,22 @@ public:
 
 private:
 
+	/** Maximum number of cities to precompute a distance matrix for. */
+	static const size_t MAX_MATRIX_CITIES = 4096;
+
+	/** Return the distance between the cities with indices a and b. */
+	inline float distance(uint32_t a, uint32_t b) const {
+		if (!_distances.empty()) {
+			return _distances[a * _cities.size() + b];
+		}
+		return distance(_cities[a], _cities[b]);
+	}
+
+	/** Return the length of the edge from position i to the next city. */
+	inline float edge(const GeneType& g, size_t i) const {
+		return distance(g[i], g[(i + 1) % g.size()]);
+	}
+
 	inline float distance(const City& a, const City& b) const {
 		// FIXME: this will blow up if the distances exceed int32_t range..
 		int32_t dx = b.first - a.first;
@@ -82,8 +105,9 @@ private:
 		return sqrt(dx + dy);
 	}
 
-	const std::string _filename;
-	Cities _cities;
+	const std::string  _filename;
+	Cities             _cities;
+	std::vector<float> _distances;  ///< Row-major distance matrix, or empty
 };
 
 } // namespace eugene
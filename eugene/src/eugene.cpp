@@ -27,6 +27,7 @@
 #include "eugene/Crossover.hpp"
 #include "eugene/GA.hpp"
 #include "eugene/Gene.hpp"
+#include "eugene/IslandGA.hpp"
 #include "eugene/Mutation.hpp"
 #include "eugene/Mutation.hpp"
 #include "eugene/OnePointCrossover.hpp"
@@ -150,9 +151,9 @@ static bool key_pressed()
 	return FD_ISSET(STDIN_FILENO, &fds);
 }
 
-template<typename G>
+template<typename Engine>
 void
-run(GA<G>* ga, bool quiet, bool limit_generations, int limit)
+run(Engine* ga, bool quiet, bool limit_generations, int limit)
 {
 	float best_fitness = ga->best_fitness();
 	if (!quiet) {
@@ -200,10 +201,75 @@ run(GA<G>* ga, bool quiet, bool limit_generations, int limit)
 	*/
 }
 
+/** Run a single GA, or an island model GA if num_islands > 1. */
+template<typename G>
+void
+evolve(Random&                              rng,
+       const typename IslandGA<G>::Factory& factory,
+       size_t                               num_islands,
+       Topology                             topology,
+       size_t                               migration_interval,
+       bool                                 quiet,
+       bool                                 limit_generations,
+       int                                  limit)
+{
+	if (num_islands > 1) {
+		if (!quiet) {
+			cout << "Islands:              " << num_islands << endl;
+		}
+		IslandGA<G> islands(rng, factory, num_islands, topology,
+		                    migration_interval, 2);
+		run(&islands, quiet, limit_generations, limit);
+	} else {
+		std::shared_ptr< GA<G> > ga = factory(rng);
+		run(ga.get(), quiet, limit_generations, limit);
+	}
+}
+
 int
 main(int argc, char** argv)
 {
-	Random rng(time(NULL));
+	unsigned seed        = time(NULL);
+	size_t   num_threads = 1;
+	size_t   num_islands = 1;
+	size_t   migration   = 20;
+
+	Topology    topology = RING;
+	const char* kernel   = NULL;
+
+	// Strip options that may appear anywhere before positional handling
+	int n_args = 1;
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+			num_threads = std::max(1, atoi(argv[++i]));
+		} else if (!strcmp(argv[i], "--islands") && i + 1 < argc) {
+			num_islands = std::max(1, atoi(argv[++i]));
+		} else if (!strcmp(argv[i], "--migration") && i + 1 < argc) {
+			migration = std::max(1, atoi(argv[++i]));
+		} else if (!strcmp(argv[i], "--topology") && i + 1 < argc) {
+			++i;
+			if (!strcmp(argv[i], "ring")) {
+				topology = RING;
+			} else if (!strcmp(argv[i], "complete")) {
+				topology = COMPLETE;
+			} else if (!strcmp(argv[i], "random")) {
+				topology = RANDOM;
+			} else {
+				cerr << "Unknown topology `" << argv[i] << "', exiting" << endl;
+				return -1;
+			}
+		} else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+			seed = strtoul(argv[++i], NULL, 10);
+		} else if (!strcmp(argv[i], "--kernel") && i + 1 < argc) {
+			kernel = argv[++i];
+		} else {
+			argv[n_args++] = argv[i];
+		}
+	}
+	argc = n_args;
+
+	Random rng(seed);
+	srand(seed);
 
 	enum Mode { ONE_MAX, SIMPLE_MAX, TSP, CROSSOVER, LABS };
 	Mode mode = ONE_MAX;
@@ -224,7 +290,15 @@ main(int argc, char** argv)
 			 << "       " << argv[0] << " --simple-max"   << endl
 			 << "       " << argv[0] << " --tsp FILENAME" << endl
 			 << "       " << argv[0] << " --crossover"    << endl
-		     << "       " << argv[0] << " --labs N P M [ 1 | 2 | U ] [ G | L ] L [--quiet]" << endl;
+		     << "       " << argv[0] << " --labs N P M [ 1 | 2 | U ] [ G | L ] L [--quiet]" << endl
+		     << endl
+		     << "Options (any mode):" << endl
+		     << "  --threads N    Evaluate fitness on N threads" << endl
+		     << "  --islands N    Evolve N populations with migration" << endl
+		     << "  --migration N  Migrate every N generations" << endl
+		     << "  --topology T   Migration topology (ring, complete, random)" << endl
+		     << "  --seed S       Seed random number generator with S" << endl
+		     << "  --kernel K     LABS kernel (scalar, packed, avx2)" << endl;
 
 		return -1;
 	}
@@ -260,6 +334,8 @@ main(int argc, char** argv)
 	if (!quiet) {
 		cout << "Population Size:      " << population_size << endl;
 		cout << "Mutation Probability: " << mutation_probability << endl;
+		cout << "Threads:              " << num_threads << endl;
+		cout << "Seed:                 " << seed << endl;
 	}
 
 	if (limit == 0 && !quiet)
@@ -270,42 +346,44 @@ main(int argc, char** argv)
 		typedef GA<OneMax::GeneType> OneMaxGA;
 
 		std::shared_ptr< Problem<OneMax::GeneType> > p(new OneMax(50));
-		std::shared_ptr< Selection<OneMax::GeneType> > s(
-			new RouletteSelection<OneMax::GeneType>(*p.get()));
 		std::shared_ptr< Crossover<OneMax::GeneType> > c(
 				new OnePointCrossover<OneMax::GeneType>());
 		std::shared_ptr< Mutation<SimpleMax::GeneType> > m(
 				new RandomMutation<SimpleMax::GeneType>(0, 1));
 
-		SimpleMax::Population pop;
-		p->initial_population(rng, pop, 50, population_size);
-		OneMaxGA ga(rng, p, s, c, m, pop, 50, population_size, 5, mutation_probability, 1.0);
-		run(&ga, quiet, limit_generations, limit);
+		evolve<OneMax::GeneType>(rng, [&](Random& r) {
+			std::shared_ptr< Selection<OneMax::GeneType> > s(
+				new RouletteSelection<OneMax::GeneType>(*p.get()));
+			SimpleMax::Population pop;
+			p->initial_population(r, pop, 50, population_size);
+			return std::make_shared<OneMaxGA>(
+				r, p, s, c, m, pop, 50, population_size, 5, mutation_probability, 1.0, num_threads);
+		}, num_islands, topology, migration, quiet, limit_generations, limit);
 
 	// 1) b)
 	} else if (mode == SIMPLE_MAX) {
 		typedef GA<SimpleMax::GeneType> SimpleMaxGA;
 
 		std::shared_ptr< Problem<SimpleMax::GeneType> > p(new SimpleMax());
-		std::shared_ptr< Selection<SimpleMax::GeneType> > s(
-			new RouletteSelection<SimpleMax::GeneType>(*p.get()));
 		std::shared_ptr< Crossover<SimpleMax::GeneType> > c(
 				new OnePointCrossover<SimpleMax::GeneType>());
 		std::shared_ptr< Mutation<SimpleMax::GeneType> > m(
 				new RandomMutation<SimpleMax::GeneType>(1, 10));
 
-		SimpleMax::Population pop;
-		p->initial_population(rng, pop, 10, population_size);
-		SimpleMaxGA ga(rng, p, s, c, m, pop, 10, population_size, 5, mutation_probability, 1.0);
-		run(&ga, quiet, limit_generations, limit);
+		evolve<SimpleMax::GeneType>(rng, [&](Random& r) {
+			std::shared_ptr< Selection<SimpleMax::GeneType> > s(
+				new RouletteSelection<SimpleMax::GeneType>(*p.get()));
+			SimpleMax::Population pop;
+			p->initial_population(r, pop, 10, population_size);
+			return std::make_shared<SimpleMaxGA>(
+				r, p, s, c, m, pop, 10, population_size, 5, mutation_probability, 1.0, num_threads);
+		}, num_islands, topology, migration, quiet, limit_generations, limit);
 
 	} else if (mode == TSP) {
 		typedef GA<TSP::GeneType> TSPGA;
 
 		std::shared_ptr< Problem<eugene::TSP::GeneType> > p(
 			new eugene::TSP(argv[2]));
-		std::shared_ptr< Selection<TSP::GeneType> > s(
-			new TournamentSelection<TSP::GeneType>(*p.get(), 4, 0.8));
 		std::shared_ptr< Crossover<TSP::GeneType> > c(
 				//new OrderCrossover<TSP::GeneType>());
 				//new PositionBasedCrossover<TSP::GeneType>());
@@ -313,19 +391,37 @@ main(int argc, char** argv)
 		std::shared_ptr< Mutation<TSP::GeneType> > m(
 				new SwapAlleleMutation<TSP::GeneType>());
 
-		TSP::Population pop;
-		p->initial_population(rng, pop, p->gene_size(), population_size);
-		TSPGA ga(rng, p, s, c, m, pop, p->gene_size(), population_size, 5, mutation_probability, 1.0);
-		run(&ga, quiet, limit_generations, limit);
+		evolve<TSP::GeneType>(rng, [&](Random& r) {
+			std::shared_ptr< Selection<TSP::GeneType> > s(
+				new TournamentSelection<TSP::GeneType>(*p.get(), 4, 0.8));
+			TSP::Population pop;
+			p->initial_population(r, pop, p->gene_size(), population_size);
+			return std::make_shared<TSPGA>(
+				r, p, s, c, m, pop, p->gene_size(), population_size, 5, mutation_probability, 1.0, num_threads);
+		}, num_islands, topology, migration, quiet, limit_generations, limit);
 
 	} else if (mode == LABS) {
 		typedef GA<LABS::GeneType> LABSGA;
 
 		size_t gene_size = atoi(argv[2]);
-		std::shared_ptr< Problem<eugene::LABS::GeneType> > p(
-			new eugene::LABS(gene_size));
-		std::shared_ptr< Selection<LABS::GeneType> > s(
-			new TournamentSelection<LABS::GeneType>(*p.get(), 3, 0.95));
+		std::shared_ptr<eugene::LABS> p(new eugene::LABS(gene_size));
+		if (kernel) {
+			eugene::LABS::Kernel k;
+			if (!strcmp(kernel, "scalar")) {
+				k = eugene::LABS::SCALAR;
+			} else if (!strcmp(kernel, "packed")) {
+				k = eugene::LABS::PACKED;
+			} else if (!strcmp(kernel, "avx2")) {
+				k = eugene::LABS::AVX2;
+			} else {
+				cerr << "Unknown kernel `" << kernel << "', exiting" << endl;
+				return -1;
+			}
+			if (!p->set_kernel(k)) {
+				cerr << "Unsupported kernel `" << kernel << "', exiting" << endl;
+				return -1;
+			}
+		}
 		std::shared_ptr< Crossover<LABS::GeneType> > c;
 		switch (argv[5][0]) {
 		case '1':
@@ -351,14 +447,18 @@ main(int argc, char** argv)
 			return -1;
 		}
 
-		LABS::Population pop;
-		p->initial_population(rng, pop, p->gene_size(), population_size);
-		std::shared_ptr< Mutation<LABS::GeneType> > m(
-				//new FlipMutation<LABS::GeneType>());
-				//new FlipRangeMutation<LABS::GeneType>());
-				new FlipRandomMutation<LABS::GeneType>());
-		LABSGA ga(rng, p, s, c, m, pop, p->gene_size(), population_size, 3, mutation_probability, 0.8);
-		run(&ga, quiet, limit_generations, limit);
+		evolve<LABS::GeneType>(rng, [&](Random& r) {
+			std::shared_ptr< Selection<LABS::GeneType> > s(
+				new TournamentSelection<LABS::GeneType>(*p.get(), 3, 0.95));
+			LABS::Population pop;
+			p->initial_population(r, pop, p->gene_size(), population_size);
+			std::shared_ptr< Mutation<LABS::GeneType> > m(
+					//new FlipMutation<LABS::GeneType>());
+					//new FlipRangeMutation<LABS::GeneType>());
+					new FlipRandomMutation<LABS::GeneType>());
+			return std::make_shared<LABSGA>(
+				r, p, s, c, m, pop, p->gene_size(), population_size, 3, mutation_probability, 0.8, num_threads);
+		}, num_islands, topology, migration, quiet, limit_generations, limit);
 
 	} else if (mode == CROSSOVER) {
 		/*string p1_str, p2_str;
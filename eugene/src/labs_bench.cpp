@@ -0,0 +1,103 @@
+/* This file is part of Eugene
+ * Copyright 2007-2012 David Robillard <http://drobilla.net>
+ *
+ * Eugene is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Eugene is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Eugene.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** Benchmark of LABS evaluation kernels for sequence lengths 20..64. */
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+#include "eugene/Random.hpp"
+
+#include "LABS.hpp"
+
+using namespace std;
+using namespace eugene;
+
+static const size_t POPULATION_SIZE = 10000;
+
+/** Return nanoseconds per evaluation, or -1 if unsupported. */
+static double
+bench(LABS& labs, LABS::Kernel kernel, LABS::Population& pop, float* sum)
+{
+	if (!labs.set_kernel(kernel)) {
+		return -1.0;
+	}
+
+	typedef std::chrono::steady_clock Clock;
+
+	const Clock::time_point start = Clock::now();
+	float total = 0.0f;
+	for (const auto& g : pop) {
+		total += labs.evaluate(g);
+	}
+	const Clock::time_point end = Clock::now();
+
+	*sum = total;
+	return std::chrono::duration<double, std::nano>(end - start).count()
+		/ pop.size();
+}
+
+static void
+print_time(double ns)
+{
+	if (ns < 0.0) {
+		cout << setw(10) << "-";
+	} else {
+		cout << setw(10) << fixed << setprecision(1) << ns;
+	}
+}
+
+int
+main(int argc, char** argv)
+{
+	const unsigned seed = (argc > 1) ? strtoul(argv[1], NULL, 10) : 1;
+	Random         rng(seed);
+
+	cout << "# ns/evaluation for " << POPULATION_SIZE << " sequences" << endl;
+	cout << "# n" << setw(10) << "scalar" << setw(10) << "packed"
+	     << setw(10) << "avx2" << setw(10) << "speedup" << endl;
+
+	int ret = 0;
+	for (size_t n = 20; n <= 64; n += 4) {
+		LABS             labs(n);
+		LABS::Population pop;
+		labs.initial_population(rng, pop, n, POPULATION_SIZE);
+
+		float        scalar_sum = 0.0f;
+		float        packed_sum = 0.0f;
+		float        avx2_sum   = 0.0f;
+		const double scalar     = bench(labs, LABS::SCALAR, pop, &scalar_sum);
+		const double packed     = bench(labs, LABS::PACKED, pop, &packed_sum);
+		const double avx2       = bench(labs, LABS::AVX2, pop, &avx2_sum);
+
+		if (packed_sum != scalar_sum || (avx2 >= 0.0 && avx2_sum != scalar_sum)) {
+			cerr << "error: kernel results differ for n = " << n << endl;
+			ret = 1;
+		}
+
+		const double best = (avx2 >= 0.0 && avx2 < packed) ? avx2 : packed;
+		cout << setw(3) << n;
+		print_time(scalar);
+		print_time(packed);
+		print_time(avx2);
+		cout << setw(9) << setprecision(1) << scalar / best << "x" << endl;
+	}
+
+	return ret;
+}
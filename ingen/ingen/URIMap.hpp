@@ -1,6 +1,6 @@
 /*
   This file is part of Ingen.
-  Copyright 2007-2012 David Robillard <http://drobilla.net/>
+  Copyright 2007-2015 David Robillard <http://drobilla.net/>
 
   Ingen is free software: you can redistribute it and/or modify it under the
   terms of the GNU Affero General Public License as published by the Free
@@ -17,8 +17,9 @@
 #ifndef INGEN_URIMAP_HPP
 #define INGEN_URIMAP_HPP
 
-#include <map>
-#include <utility>
+#include <atomic>
+#include <mutex>
+#include <string>
 
 #include "ingen/LV2Features.hpp"
 #include "ingen/Log.hpp"
@@ -29,12 +30,18 @@
 namespace Ingen {
 
 /** URI to integer map and implementation of LV2 URID extension.
+ *
+ * Unless the host provides its own URID features, URIs are mapped with a
+ * table owned by Ingen.  Mapping a URI which is already mapped, and unmapping,
+ * never block, so both are safe in any thread, including the audio thread.
+ * Only mapping a new URI takes a lock, and URIs are validated only then.
+ *
  * @ingroup IngenShared
  */
 class URIMap : public Raul::Noncopyable {
 public:
 	URIMap(Log& log, LV2_URID_Map* map, LV2_URID_Unmap* unmap);
-	virtual ~URIMap() {}
+	virtual ~URIMap();
 
 	uint32_t    map_uri(const char* uri);
 	const char* unmap_uri(uint32_t urid) const;
@@ -75,6 +82,32 @@ public:
 	SPtr<URIDUnmapFeature> urid_unmap_feature() { return _urid_unmap_feature; }
 
 private:
+	/** Number of entries in the first chunk, as a power of 2. */
+	static const unsigned CHUNK_BITS = 6;
+
+	/** Number of chunks, enough for every 32-bit URID. */
+	static const unsigned N_CHUNKS = 32 - CHUNK_BITS + 1;
+
+	struct Entry {
+		std::string uri;
+		uint32_t    hash;
+	};
+
+	struct Table;
+
+	/** Return the chunk of entry `index`, making `index` relative to it. */
+	static unsigned chunk_index(uint32_t& index);
+
+	LV2_URID     find(const char* uri, uint32_t hash) const;
+	LV2_URID     insert(const char* uri, uint32_t hash);
+	const Entry& entry(LV2_URID urid) const;
+
+	Log&                   _log;
+	std::atomic<Entry*>    _chunks[N_CHUNKS];  ///< Entries, never moved
+	std::atomic<Table*>    _table;             ///< Current hash table
+	std::atomic<uint32_t>  _size;              ///< Number of URIDs
+	std::mutex             _mutex;             ///< Lock for inserting
+
 	SPtr<URIDMapFeature>   _urid_map_feature;
 	SPtr<URIDUnmapFeature> _urid_unmap_feature;
 };
@@ -63,6 +63,8 @@ Configuration::Configuration(Forge& forge)
 	add("path",           "path",           'L', "Target path for loaded graph", SESSION, forge.String, Atom());
 	add("queueSize",      "queue-size",     'q', "Event queue size", GLOBAL, forge.Int, forge.make(4096));
 	add("run",            "run",            'r', "Run script", SESSION, forge.String, Atom());
+	add("workerThreads",  "worker-threads",  0,  "Number of LV2 worker threads (0 for one per CPU)", GLOBAL, forge.Int, forge.make(0));
+	add("workerStats",    "worker-stats",    0,  "Print LV2 worker statistics on exit", GLOBAL, forge.Bool, forge.make(false));
 	add("humanNames",     "human-names",     0,  "Show human names in GUI", GUI, forge.Bool, forge.make(true));
 	add("portLabels",     "port-labels",     0,  "Show port labels in GUI", GUI, forge.Bool, forge.make(true));
 	add("graphDirectory", "graph-directory", 0,  "Default directory for opening graphs", GUI, forge.String, Atom());
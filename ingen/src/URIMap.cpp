@@ -1,6 +1,6 @@
 /*
   This file is part of Ingen.
-  Copyright 2007-2012 David Robillard <http://drobilla.net/>
+  Copyright 2007-2015 David Robillard <http://drobilla.net/>
 
   Ingen is free software: you can redistribute it and/or modify it under the
   terms of the GNU Affero General Public License as published by the Free
@@ -16,18 +16,158 @@
 
 #include <stdint.h>
 
-#include <glib.h>
-
 #include "ingen/URIMap.hpp"
 
 using namespace std;
 
 namespace Ingen {
 
+/** Initial number of hash table slots, enough for all of Ingen::URIs. */
+static const uint32_t INITIAL_SLOTS = 256;
+
+/** Open addressing hash table of URIDs, where 0 is an empty slot.
+ *
+ * Tables are never resized in place, a full table is replaced by a larger
+ * one, so a reader still using an old table at worst misses a URI and takes
+ * the locked path.  Old tables are kept until the map is destroyed.
+ */
+struct URIMap::Table {
+	Table(uint32_t n_slots, Table* p)
+		: prev(p)
+		, mask(n_slots - 1)
+		, slots(new std::atomic<LV2_URID>[n_slots]())
+	{}
+
+	~Table() { delete[] slots; }
+
+	Table* const                 prev;
+	const uint32_t               mask;
+	std::atomic<LV2_URID>* const slots;
+};
+
+/** FNV-1a hash of a string. */
+static uint32_t
+hash_uri(const char* str)
+{
+	uint32_t h = 2166136261u;
+	for (const unsigned char* s = (const unsigned char*)str; *s; ++s) {
+		h = (h ^ *s) * 16777619u;
+	}
+	return h;
+}
+
+unsigned
+URIMap::chunk_index(uint32_t& index)
+{
+	// Chunk c holds 2^(CHUNK_BITS + c) entries, so entry i is in chunk
+	// floor(log2(i + 2^CHUNK_BITS)) - CHUNK_BITS
+	const uint32_t i     = index + (1u << CHUNK_BITS);
+	const unsigned chunk = (31 - __builtin_clz(i)) - CHUNK_BITS;
+	index = i - ((1u << CHUNK_BITS) << chunk);
+	return chunk;
+}
+
 URIMap::URIMap(Log& log, LV2_URID_Map* map, LV2_URID_Unmap* unmap)
-	: _urid_map_feature(new URIDMapFeature(this, map, log))
+	: _log(log)
+	, _table(new Table(INITIAL_SLOTS, NULL))
+	, _size(0)
+	, _urid_map_feature(new URIDMapFeature(this, map, log))
 	, _urid_unmap_feature(new URIDUnmapFeature(this, unmap))
 {
+	for (unsigned i = 0; i < N_CHUNKS; ++i) {
+		_chunks[i] = NULL;
+	}
+}
+
+URIMap::~URIMap()
+{
+	for (unsigned i = 0; i < N_CHUNKS; ++i) {
+		delete[] _chunks[i].load();
+	}
+
+	for (Table* t = _table; t;) {
+		Table* const prev = t->prev;
+		delete t;
+		t = prev;
+	}
+}
+
+const URIMap::Entry&
+URIMap::entry(LV2_URID urid) const
+{
+	uint32_t       index = urid - 1;
+	const unsigned chunk = chunk_index(index);
+	return _chunks[chunk].load(std::memory_order_acquire)[index];
+}
+
+LV2_URID
+URIMap::find(const char* uri, uint32_t hash) const
+{
+	const Table* const table = _table.load(std::memory_order_acquire);
+	for (uint32_t i = hash & table->mask;; i = (i + 1) & table->mask) {
+		const LV2_URID urid = table->slots[i].load(std::memory_order_acquire);
+		if (!urid) {
+			return 0;
+		}
+
+		const Entry& e = entry(urid);
+		if (e.hash == hash && e.uri == uri) {
+			return urid;
+		}
+	}
+}
+
+LV2_URID
+URIMap::insert(const char* uri, uint32_t hash)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	// Search again, another thread may have mapped uri in the meantime
+	Table* table = _table.load(std::memory_order_relaxed);
+	uint32_t i = hash & table->mask;
+	for (;; i = (i + 1) & table->mask) {
+		const LV2_URID urid = table->slots[i].load(std::memory_order_relaxed);
+		if (!urid) {
+			break;
+		}
+
+		const Entry& e = entry(urid);
+		if (e.hash == hash && e.uri == uri) {
+			return urid;
+		}
+	}
+
+	// Allocate a new chunk if necessary and initialise entry
+	const LV2_URID urid  = _size.load(std::memory_order_relaxed) + 1;
+	uint32_t       index = urid - 1;
+	const unsigned chunk = chunk_index(index);
+	if (!_chunks[chunk].load(std::memory_order_relaxed)) {
+		_chunks[chunk].store(new Entry[(1u << CHUNK_BITS) << chunk],
+		                     std::memory_order_release);
+	}
+
+	Entry& e = _chunks[chunk].load(std::memory_order_relaxed)[index];
+	e.uri  = uri;
+	e.hash = hash;
+
+	// Publish entry
+	_size.store(urid, std::memory_order_release);
+	table->slots[i].store(urid, std::memory_order_release);
+
+	// Replace the table with a larger one when it is half full
+	if (urid * 2 > table->mask + 1) {
+		Table* const bigger = new Table((table->mask + 1) * 2, table);
+		for (LV2_URID u = 1; u <= urid; ++u) {
+			uint32_t j = entry(u).hash & bigger->mask;
+			while (bigger->slots[j].load(std::memory_order_relaxed)) {
+				j = (j + 1) & bigger->mask;
+			}
+			bigger->slots[j].store(u, std::memory_order_relaxed);
+		}
+		_table.store(bigger, std::memory_order_release);
+	}
+
+	return urid;
 }
 
 URIMap::URIDMapFeature::URIDMapFeature(URIMap*       map,
@@ -40,7 +180,7 @@ URIMap::URIDMapFeature::URIDMapFeature(URIMap*       map,
 		urid_map = *impl;
 	} else {
 		urid_map.map    = default_map;
-		urid_map.handle = NULL;
+		urid_map.handle = map;
 	}
 }
 
@@ -48,13 +188,27 @@ LV2_URID
 URIMap::URIDMapFeature::default_map(LV2_URID_Map_Handle handle,
                                     const char*         uri)
 {
-	return static_cast<LV2_URID>(g_quark_from_string(uri));
+	URIMap* const  me   = static_cast<URIMap*>(handle);
+	const uint32_t hash = hash_uri(uri);
+	const LV2_URID urid = me->find(uri, hash);
+	if (urid) {
+		return urid;
+	}
+
+	if (!Raul::URI::is_valid(uri)) {
+		me->_log.error(fmt("Attempt to map invalid URI <%1%>\n") % uri);
+		return 0;
+	}
+
+	return me->insert(uri, hash);
 }
 
 LV2_URID
 URIMap::URIDMapFeature::map(const char* uri)
 {
-	if (!Raul::URI::is_valid(uri)) {
+	if (urid_map.map == default_map) {
+		return default_map(urid_map.handle, uri);  // Validates new URIs
+	} else if (!Raul::URI::is_valid(uri)) {
 		log.error(fmt("Attempt to map invalid URI <%1%>\n") % uri);
 		return 0;
 	}
@@ -69,7 +223,7 @@ URIMap::URIDUnmapFeature::URIDUnmapFeature(URIMap*         map,
 		urid_unmap = *impl;
 	} else {
 		urid_unmap.unmap  = default_unmap;
-		urid_unmap.handle = NULL;
+		urid_unmap.handle = map;
 	}
 }
 
@@ -77,7 +231,11 @@ const char*
 URIMap::URIDUnmapFeature::default_unmap(LV2_URID_Unmap_Handle handle,
                                         LV2_URID              urid)
 {
-	return g_quark_to_string(urid);
+	const URIMap* const me = static_cast<const URIMap*>(handle);
+	if (urid == 0 || urid > me->_size.load(std::memory_order_acquire)) {
+		return NULL;
+	}
+	return me->entry(urid).uri.c_str();
 }
 
 const char*
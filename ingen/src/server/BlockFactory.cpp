@@ -119,18 +119,9 @@ BlockFactory::load_plugin(const Raul::URI& uri)
 void
 BlockFactory::load_lv2_plugins()
 {
-	// Build an array of port type nodes for checking compatibility
-	typedef std::vector< SPtr<LilvNode> > Types;
-	Types types;
-	for (unsigned t = PortType::ID::AUDIO; t <= PortType::ID::ATOM; ++t) {
-		const Raul::URI& uri(PortType((PortType::ID)t).uri());
-		types.push_back(
-			SPtr<LilvNode>(lilv_new_uri(_world->lilv_world(), uri.c_str()),
-			               lilv_node_free));
-	}
-
-	LilvNode* lv2_connectionOptional = lilv_new_uri(
-		_world->lilv_world(), LV2_CORE__connectionOptional);
+	// Port classes that correspond to an Ingen PortType
+	const uint32_t types = (LILV_PORT_AUDIO | LILV_PORT_CONTROL |
+	                        LILV_PORT_CV | LILV_PORT_ATOM);
 
 	const LilvPlugins* plugins = lilv_world_get_all_plugins(_world->lilv_world());
 	LILV_FOREACH(plugins, i, plugins) {
@@ -162,18 +153,14 @@ BlockFactory::load_lv2_plugins()
 			continue;
 		}
 
-		const uint32_t n_ports = lilv_plugin_get_num_ports(lv2_plug);
+		const uint32_t            n_ports = lilv_plugin_get_num_ports(lv2_plug);
+		const LilvPortDescriptor* descs   = lilv_plugin_get_port_descriptors(
+			lv2_plug);
 		for (uint32_t p = 0; p < n_ports; ++p) {
 			const LilvPort* port = lilv_plugin_get_port_by_index(lv2_plug, p);
-			supported = false;
-			for (const auto& t : types) {
-				if (lilv_port_is_a(lv2_plug, port, t.get())) {
-					supported = true;
-					break;
-				}
-			}
+			supported = (descs[p].classes & types);
 			if (!supported &&
-			    !lilv_port_has_property(lv2_plug, port, lv2_connectionOptional)) {
+			    !(descs[p].properties & LILV_PORT_CONNECTION_OPTIONAL)) {
 				_world->log().warn(
 					fmt("Ignoring <%1%>; unsupported port <%2%>\n")
 					% uri % lilv_node_as_string(
@@ -193,8 +180,6 @@ BlockFactory::load_lv2_plugins()
 	}
 
 	_world->log().info(fmt("Loaded %1% plugins\n") % _plugins.size());
-
-	lilv_node_free(lv2_connectionOptional);
 }
 
 } // namespace Server
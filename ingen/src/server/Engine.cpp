@@ -66,7 +66,10 @@ Engine::Engine(Ingen::World* world)
 	, _pre_processor(new PreProcessor())
 	, _post_processor(new PostProcessor(*this))
 	, _root_graph(NULL)
-	, _worker(new Worker(world->log(), event_queue_size()))
+	, _worker(new Worker(world->log(),
+	                     event_queue_size(),
+	                     world->conf().option("worker-threads").get<int32_t>(),
+	                     world->conf().option("worker-stats").get<int32_t>()))
 	, _process_context(*this)
 	, _rand_engine(0)
 	, _uniform_dist(0.0f, 1.0f)
@@ -125,8 +128,8 @@ Engine::~Engine()
 	delete _control_bindings;
 	delete _broadcaster;
 	delete _event_writer;
+	delete _maid;  // Before worker, since disposed blocks remove their queues
 	delete _worker;
-	delete _maid;
 
 	_driver.reset();
 
@@ -60,12 +60,14 @@ LV2Block::LV2Block(LV2Plugin*          plugin,
 	, _instances(NULL)
 	, _prepared_instances(NULL)
 	, _worker_iface(NULL)
+	, _worker_queue(NULL)
 {
 	assert(_lv2_plugin);
 }
 
 LV2Block::~LV2Block()
 {
+	delete _worker_queue;
 	delete _instances;
 }
 
@@ -213,22 +215,18 @@ LV2Block::instantiate(BufferFactory& bufs)
 	Ingen::Forge&      forge     = bufs.forge();
 	const uint32_t     num_ports = lilv_plugin_get_num_ports(plug);
 
-	LilvNode* lv2_connectionOptional = lilv_new_uri(
-		bufs.engine().world()->lilv_world(), LV2_CORE__connectionOptional);
-
 	_ports = new Raul::Array<PortImpl*>(num_ports, NULL);
 
 	bool ret = true;
 
-	float* min_values = new float[num_ports];
-	float* max_values = new float[num_ports];
-	float* def_values = new float[num_ports];
-	lilv_plugin_get_port_ranges_float(plug, min_values, max_values, def_values);
+	// Most port information is read from the model in one pass by lilv
+	const LilvPortDescriptor* descs = lilv_plugin_get_port_descriptors(plug);
 	uint32_t max_sequence_size = 0;
 
 	// Get all the necessary information about ports
 	for (uint32_t j = 0; j < num_ports; ++j) {
-		const LilvPort* id = lilv_plugin_get_port_by_index(plug, j);
+		const LilvPort*           id   = lilv_plugin_get_port_by_index(plug, j);
+		const LilvPortDescriptor& desc = descs[j];
 
 		/* LV2 port symbols are guaranteed to be unique, valid C identifiers,
 		   and Lilv guarantees that lilv_port_get_symbol() is valid. */
@@ -241,8 +239,8 @@ LV2Block::instantiate(BufferFactory& bufs)
 		LV2_URID buffer_type   = 0;
 		bool     is_morph      = false;
 		bool     is_auto_morph = false;
-		if (lilv_port_is_a(plug, id, info->lv2_ControlPort)) {
-			if (lilv_port_is_a(plug, id, info->morph_MorphPort)) {
+		if (desc.classes & LILV_PORT_CONTROL) {
+			if (desc.classes & LILV_PORT_MORPH) {
 				is_morph = true;
 				LilvNodes* types = lilv_port_get_value(
 					plug, id, info->morph_supportsType);
@@ -259,36 +257,27 @@ LV2Block::instantiate(BufferFactory& bufs)
 				port_type   = PortType::CONTROL;
 				buffer_type = uris.atom_Float;
 			}
-		} else if (lilv_port_is_a(plug, id, info->lv2_CVPort)) {
+		} else if (desc.classes & LILV_PORT_CV) {
 			port_type   = PortType::CV;
 			buffer_type = uris.atom_Sound;
-		} else if (lilv_port_is_a(plug, id, info->lv2_AudioPort)) {
+		} else if (desc.classes & LILV_PORT_AUDIO) {
 			port_type   = PortType::AUDIO;
 			buffer_type = uris.atom_Sound;
-		} else if (lilv_port_is_a(plug, id, info->atom_AtomPort)) {
+		} else if (desc.classes & LILV_PORT_ATOM) {
 			port_type = PortType::ATOM;
 		}
 
-		if (lilv_port_is_a(plug, id, info->morph_AutoMorphPort)) {
+		if (desc.classes & LILV_PORT_AUTO_MORPH) {
 			is_auto_morph = true;
 		}
 
 		// Get buffer type if necessary (atom ports)
-		if (!buffer_type) {
-			LilvNodes* types = lilv_port_get_value(
-				plug, id, info->atom_bufferType);
-			LILV_FOREACH(nodes, i, types) {
-				const LilvNode* type = lilv_nodes_get(types, i);
-				if (lilv_node_is_uri(type)) {
-					buffer_type = bufs.engine().world()->uri_map().map_uri(
-						lilv_node_as_uri(type));
-				}
-			}
-			lilv_nodes_free(types);
+		if (!buffer_type && desc.buffer_type) {
+			buffer_type = bufs.engine().world()->uri_map().map_uri(
+				lilv_node_as_uri(desc.buffer_type));
 		}
 
-		const bool optional = lilv_port_has_property(
-			plug, id, lv2_connectionOptional);
+		const bool optional = desc.properties & LILV_PORT_CONNECTION_OPTIONAL;
 
 		uint32_t port_buffer_size = bufs.default_size(buffer_type);
 		if (port_buffer_size == 0 && !optional) {
@@ -322,23 +311,15 @@ LV2Block::instantiate(BufferFactory& bufs)
 			}
 
 			// Get minimum size, if set in data
-			LilvNodes* sizes = lilv_port_get_value(plug, id, info->rsz_minimumSize);
-			LILV_FOREACH(nodes, i, sizes) {
-				const LilvNode* d = lilv_nodes_get(sizes, i);
-				if (lilv_node_is_int(d)) {
-					uint32_t size_val = lilv_node_as_int(d);
-					port_buffer_size = std::max(port_buffer_size, size_val);
-				}
-			}
-			lilv_nodes_free(sizes);
+			port_buffer_size = std::max(port_buffer_size, desc.minimum_size);
 			max_sequence_size = std::max(port_buffer_size, max_sequence_size);
 			bufs.set_seq_size(max_sequence_size);
 		}
 
 		enum { UNKNOWN, INPUT, OUTPUT } direction = UNKNOWN;
-		if (lilv_port_is_a(plug, id, info->lv2_InputPort)) {
+		if (desc.classes & LILV_PORT_INPUT) {
 			direction = INPUT;
-		} else if (lilv_port_is_a(plug, id, info->lv2_OutputPort)) {
+		} else if (desc.classes & LILV_PORT_OUTPUT) {
 			direction = OUTPUT;
 		}
 
@@ -353,7 +334,7 @@ LV2Block::instantiate(BufferFactory& bufs)
 
 		if (!val.type() && (port_type != PortType::ATOM)) {
 			// Ensure numeric ports have a value, use 0 by default
-			val = forge.make(isnan(def_values[j]) ? 0.0f : def_values[j]);
+			val = forge.make(isnan(desc.def) ? 0.0f : desc.def);
 		}
 
 		PortImpl* port = (direction == INPUT)
@@ -368,11 +349,11 @@ LV2Block::instantiate(BufferFactory& bufs)
 		if (direction == INPUT && (port_type == PortType::CONTROL
 		                           || port_type == PortType::CV)) {
 			port->set_value(val);
-			if (!isnan(min_values[j])) {
-				port->set_minimum(forge.make(min_values[j]));
+			if (!isnan(desc.min)) {
+				port->set_minimum(forge.make(desc.min));
 			}
-			if (!isnan(max_values[j])) {
-				port->set_maximum(forge.make(max_values[j]));
+			if (!isnan(desc.max)) {
+				port->set_maximum(forge.make(desc.max));
 			}
 		}
 
@@ -398,12 +379,6 @@ LV2Block::instantiate(BufferFactory& bufs)
 		_ports->at(j) = port;
 	}
 
-	delete[] min_values;
-	delete[] max_values;
-	delete[] def_values;
-
-	lilv_node_free(lv2_connectionOptional);
-
 	if (!ret) {
 		delete _ports;
 		_ports = NULL;
@@ -427,6 +402,9 @@ LV2Block::instantiate(BufferFactory& bufs)
 		_worker_iface = (const LV2_Worker_Interface*)
 			lilv_instance_get_extension_data(instance(0),
 			                                 LV2_WORKER__interface);
+		if (_worker_iface) {
+			_worker_queue = bufs.engine().worker()->add_block(this);
+		}
 	}
 
 	return ret;
@@ -450,23 +428,13 @@ LV2Block::deactivate()
 		lilv_instance_deactivate(instance(i));
 }
 
-LV2_Worker_Status
-LV2Block::work_respond(LV2_Worker_Respond_Handle handle,
-                       uint32_t                  size,
-                       const void*               data)
-{
-	LV2Block* block = (LV2Block*)handle;
-	LV2Block::Response* r = new LV2Block::Response(size, data);
-	block->_responses.push_back(*r);
-	return LV2_WORKER_SUCCESS;
-}
-
 void
 LV2Block::work(uint32_t size, const void* data)
 {
 	if (_worker_iface) {
 		LV2_Handle inst = lilv_instance_get_handle(instance(0));
-		if (_worker_iface->work(inst, work_respond, this, size, data)) {
+		if (_worker_iface->work(
+			    inst, Worker::respond, _worker_queue, size, data)) {
 			parent_graph()->engine().log().error(
 				fmt("Error calling %1% work method\n") % _path);
 		}
@@ -487,11 +455,10 @@ LV2Block::post_process(ProcessContext& context)
 
 	if (_worker_iface) {
 		LV2_Handle inst = lilv_instance_get_handle(instance(0));
-		while (!_responses.empty()) {
-			Response& r = _responses.front();
-			_worker_iface->work_response(inst, r.size, r.data);
-			_responses.pop_front();
-			context.engine().maid()->dispose(&r);
+		uint32_t    size = 0;
+		const void* data = NULL;
+		while (_worker_queue->read_response(&size, &data)) {
+			_worker_iface->work_response(inst, size, data);
 		}
 
 		if (_worker_iface->end_run) {
@@ -23,6 +23,7 @@
 
 #include "BufferRef.hpp"
 #include "BlockImpl.hpp"
+#include "Worker.hpp"
 #include "ingen/LV2Features.hpp"
 #include "types.hpp"
 
@@ -56,6 +57,8 @@ public:
 
 	void work(uint32_t size, const void* data);
 
+	Worker::Queue* worker_queue() const { return _worker_queue; }
+
 	void run(ProcessContext& context);
 	void post_process(ProcessContext& context);
 
@@ -76,38 +79,11 @@ protected:
 
 	typedef Raul::Array< SPtr<void> > Instances;
 
-	struct Response : public Raul::Maid::Disposable
-	                , public Raul::Noncopyable
-	                , public boost::intrusive::slist_base_hook<>
-	{
-		inline Response(uint32_t s, const void* d)
-			: size(s)
-			, data(malloc(s))
-		{
-			memcpy(data, d, s);
-		}
-
-		~Response() {
-			free(data);
-		}
-
-		const uint32_t size;
-		void* const    data;
-	};
-
-	typedef boost::intrusive::slist<Response,
-	                                boost::intrusive::cache_last<true>,
-	                                boost::intrusive::constant_time_size<false>
-	                                > Responses;
-
-	static LV2_Worker_Status work_respond(
-		LV2_Worker_Respond_Handle handle, uint32_t size, const void* data);
-
 	LV2Plugin*                      _lv2_plugin;
 	Instances*                      _instances;
 	Instances*                      _prepared_instances;
 	const LV2_Worker_Interface*     _worker_iface;
-	Responses                       _responses;
+	Worker::Queue*                  _worker_queue;
 	SPtr<LV2Features::FeatureArray> _features;
 };
 
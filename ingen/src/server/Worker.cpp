@@ -1,6 +1,6 @@
 /*
   This file is part of Ingen.
-  Copyright 2007-2012 David Robillard <http://drobilla.net/>
+  Copyright 2007-2015 David Robillard <http://drobilla.net/>
 
   Ingen is free software: you can redistribute it and/or modify it under the
   terms of the GNU Affero General Public License as published by the Free
@@ -14,9 +14,15 @@
   along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
 #include "ingen/LV2Features.hpp"
 #include "ingen/Log.hpp"
 #include "lv2/lv2plug.in/ns/ext/worker/worker.h"
+#include "raul/Semaphore.hpp"
 
 #include "Driver.hpp"
 #include "Engine.hpp"
@@ -27,13 +33,45 @@
 namespace Ingen {
 namespace Server {
 
-/// A message in the Worker::_requests ring
-struct MessageHeader {
-	LV2Block* block;  ///< Node this message is from
-	uint32_t  size;  ///< Size of following data
+/// A worker thread and the queues assigned to it
+struct Worker::Thread {
+	Thread() : sem(0), n_queues(0) {}
+
+	Raul::Semaphore     sem;       ///< Posted for every request
+	std::mutex          mutex;     ///< Protects queues
+	std::vector<Queue*> queues;    ///< Queues assigned to this thread
+	std::atomic<size_t> n_queues;  ///< Size of queues, read without locking
+	std::thread         thread;
+};
+
+/// A message in a Queue::_requests ring
+struct RequestHeader {
+	uint32_t size;  ///< Size of following data
+	uint64_t time;  ///< Time of request in nanoseconds
+	// `size' bytes of data follow here
+};
+
+/// A message in a Queue::_responses ring
+struct ResponseHeader {
+	uint32_t size;  ///< Size of following data
 	// `size' bytes of data follow here
 };
 
+static inline uint64_t
+now_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template<typename T>
+static inline void
+update_max(std::atomic<T>& max, T value)
+{
+	T prev = max.load();
+	while (prev < value && !max.compare_exchange_weak(prev, value)) {}
+}
+
 static LV2_Worker_Status
 schedule(LV2_Worker_Schedule_Handle handle,
          uint32_t                   size,
@@ -43,35 +81,104 @@ schedule(LV2_Worker_Schedule_Handle handle,
 	Engine&   engine = block->parent_graph()->engine();
 	Worker*   worker = engine.worker();
 
-	return worker->request(block, size, data);
+	return worker->request(block->worker_queue(), size, data);
+}
+
+Worker::Queue::Queue(const Work& work, Thread* thread, uint32_t buffer_size)
+	: _work(work)
+	, _thread(thread)
+	, _requests(buffer_size)
+	, _responses(buffer_size)
+	, _request_buffer((uint8_t*)malloc(buffer_size))
+	, _response_buffer((uint8_t*)malloc(buffer_size))
+	, _buffer_size(buffer_size)
+	, _depth(0)
+{}
+
+Worker::Queue::~Queue()
+{
+	{
+		std::lock_guard<std::mutex> lock(_thread->mutex);
+		std::vector<Queue*>& queues = _thread->queues;
+		for (auto q = queues.begin(); q != queues.end(); ++q) {
+			if (*q == this) {
+				queues.erase(q);
+				break;
+			}
+		}
+	}
+	--_thread->n_queues;
+
+	{
+		// Wait for any work in progress, the thread can not start any more
+		std::lock_guard<std::mutex> lock(_mutex);
+	}
+
+	free(_request_buffer);
+	free(_response_buffer);
+}
+
+bool
+Worker::Queue::read_response(uint32_t* size, const void** data)
+{
+	ResponseHeader msg;
+	if (_responses.read_space() < sizeof(msg) ||
+	    _responses.peek(sizeof(msg), &msg) != sizeof(msg) ||
+	    _responses.read_space() < sizeof(msg) + msg.size) {
+		return false;  // No complete response
+	}
+
+	_responses.skip(sizeof(msg));
+	_responses.read(msg.size, _response_buffer);
+	*size = msg.size;
+	*data = _response_buffer;
+	return true;
 }
 
 LV2_Worker_Status
-Worker::request(LV2Block*   block,
+Worker::request(Queue*      queue,
                 uint32_t    size,
                 const void* data)
 {
-	Engine& engine = block->parent_graph()->engine();
-	if (_requests.write_space() < sizeof(MessageHeader) + size) {
-		engine.log().error("Work request ring overflow\n");
+	if (!queue) {
+		return LV2_WORKER_ERR_UNKNOWN;
+	} else if (queue->_requests.write_space() < sizeof(RequestHeader) + size) {
+		_log.error("Work request ring overflow\n");
 		return LV2_WORKER_ERR_NO_SPACE;
 	}
 
-	const MessageHeader msg = { block, size };
-	if (_requests.write(sizeof(msg), &msg) != sizeof(msg)) {
-		engine.log().error("Error writing header to work request ring\n");
+	const RequestHeader msg = { size, now_ns() };
+	if (queue->_requests.write(sizeof(msg), &msg) != sizeof(msg)) {
+		_log.error("Error writing header to work request ring\n");
 		return LV2_WORKER_ERR_UNKNOWN;
 	}
-	if (_requests.write(size, data) != size) {
-		engine.log().error("Error writing body to work request ring\n");
+	if (queue->_requests.write(size, data) != size) {
+		_log.error("Error writing body to work request ring\n");
 		return LV2_WORKER_ERR_UNKNOWN;
 	}
 
-	_sem.post();
+	update_max(_max_depth, ++queue->_depth);
+	queue->_thread->sem.post();
 
 	return LV2_WORKER_SUCCESS;
 }
 
+LV2_Worker_Status
+Worker::respond(LV2_Worker_Respond_Handle handle,
+                uint32_t                  size,
+                const void*               data)
+{
+	Queue* const         queue = (Queue*)handle;
+	const ResponseHeader msg   = { size };
+	if (queue->_responses.write_space() < sizeof(msg) + size) {
+		return LV2_WORKER_ERR_NO_SPACE;
+	}
+
+	queue->_responses.write(sizeof(msg), &msg);
+	queue->_responses.write(size, data);
+	return LV2_WORKER_SUCCESS;
+}
+
 static void
 delete_feature(LV2_Feature* feature)
 {
@@ -99,47 +206,135 @@ Worker::Schedule::feature(World* world, Node* n)
 	return SPtr<LV2_Feature>(f, &delete_feature);
 }
 
-Worker::Worker(Log& log, uint32_t buffer_size)
+Worker::Worker(Log&     log,
+               uint32_t buffer_size,
+               int32_t  n_threads,
+               bool     print_stats)
 	: _schedule(new Schedule())
 	, _log(log)
-	, _sem(0)
-	, _requests(buffer_size)
-	, _responses(buffer_size)
-	, _buffer((uint8_t*)malloc(buffer_size))
 	, _buffer_size(buffer_size)
-	, _thread(&Worker::run, this)
-{}
+	, _print_stats(print_stats)
+	, _exit_flag(false)
+	, _n_requests(0)
+	, _max_depth(0)
+	, _total_latency(0)
+	, _max_latency(0)
+{
+	if (n_threads <= 0) {
+		n_threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	for (int32_t i = 0; i < n_threads; ++i) {
+		_threads.push_back(new Thread());
+	}
+	for (Thread* t : _threads) {
+		t->thread = std::thread(&Worker::run, this, t);
+	}
+}
 
 Worker::~Worker()
 {
 	_exit_flag = true;
-	_sem.post();
-	_thread.join();
-	free(_buffer);
+	for (Thread* t : _threads) {
+		t->sem.post();
+		t->thread.join();
+		delete t;
+	}
+
+	if (_print_stats) {
+		const Stats s = stats();
+		_log.info(fmt("Worker: %1% requests, max depth %2%, "
+		              "latency mean %3% us, max %4% us\n")
+		          % s.n_requests % s.max_depth
+		          % (s.mean_latency / 1000) % (s.max_latency / 1000));
+	}
+}
+
+Worker::Queue*
+Worker::add_block(LV2Block* block)
+{
+	return add_queue([block](uint32_t size, const void* data) {
+			block->work(size, data);
+		});
+}
+
+Worker::Queue*
+Worker::add_queue(const Work& work)
+{
+	Thread* thread = _threads.front();
+	for (Thread* t : _threads) {
+		if (t->n_queues < thread->n_queues) {
+			thread = t;
+		}
+	}
+
+	Queue* queue = new Queue(work, thread, _buffer_size);
+	std::lock_guard<std::mutex> lock(thread->mutex);
+	thread->queues.push_back(queue);
+	++thread->n_queues;
+	return queue;
+}
+
+Worker::Stats
+Worker::stats() const
+{
+	const uint64_t n = _n_requests;
+	const Stats    s = { n,
+	                     _max_depth,
+	                     n ? _total_latency / n : 0,
+	                     _max_latency };
+	return s;
 }
 
 void
-Worker::run()
-{
-	while (_sem.wait() && !_exit_flag) {
-		MessageHeader msg;
-		if (_requests.read_space() > sizeof(msg)) {
-			if (_requests.read(sizeof(msg), &msg) != sizeof(msg)) {
-				_log.error("Error reading header from work request ring\n");
-				continue;
-			}
+Worker::handle(Queue* queue)
+{
+	RequestHeader msg;
+	while (queue->_requests.read_space() >= sizeof(msg)) {
+		if (queue->_requests.peek(sizeof(msg), &msg) != sizeof(msg)) {
+			_log.error("Error reading header from work request ring\n");
+			return;
+		} else if (msg.size > _buffer_size - sizeof(msg)) {
+			_log.error("Corrupt work request ring\n");
+			return;
+		} else if (queue->_requests.read_space() < sizeof(msg) + msg.size) {
+			return;  // Body not written yet, will be posted again
+		}
 
-			if (msg.size >= _buffer_size - sizeof(msg)) {
-				_log.error("Corrupt work request ring\n");
-				return;
-			}
+		queue->_requests.skip(sizeof(msg));
+		queue->_requests.read(msg.size, queue->_request_buffer);
+		queue->_work(msg.size, queue->_request_buffer);
+		--queue->_depth;
 
-			if (_requests.read(msg.size, _buffer) != msg.size) {
-				_log.error("Error reading body from work request ring\n");
-				continue;
-			}
+		const uint64_t latency = now_ns() - msg.time;
+		++_n_requests;
+		_total_latency += latency;
+		update_max(_max_latency, latency);
+	}
+}
 
-			msg.block->work(msg.size, _buffer);
+void
+Worker::run(Thread* thread)
+{
+	std::vector<Queue*> queues;
+	while (thread->sem.wait() && !_exit_flag) {
+		{
+			std::lock_guard<std::mutex> lock(thread->mutex);
+			queues = thread->queues;
+		}
+
+		for (Queue* q : queues) {
+			std::unique_lock<std::mutex> queue_lock;
+			{
+				// Lock the queue only if it has not been removed since
+				std::lock_guard<std::mutex> lock(thread->mutex);
+				if (std::find(thread->queues.begin(), thread->queues.end(), q)
+				    == thread->queues.end()) {
+					continue;
+				}
+				queue_lock = std::unique_lock<std::mutex>(q->_mutex);
+			}
+			handle(q);
 		}
 	}
 }
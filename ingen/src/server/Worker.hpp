@@ -1,6 +1,6 @@
 /*
   This file is part of Ingen.
-  Copyright 2007-2012 David Robillard <http://drobilla.net/>
+  Copyright 2007-2015 David Robillard <http://drobilla.net/>
 
   Ingen is free software: you can redistribute it and/or modify it under the
   terms of the GNU Affero General Public License as published by the Free
@@ -17,12 +17,15 @@
 #ifndef INGEN_ENGINE_WORKER_HPP
 #define INGEN_ENGINE_WORKER_HPP
 
-#include <thread>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <vector>
 
 #include "ingen/LV2Features.hpp"
 #include "lv2/lv2plug.in/ns/ext/worker/worker.h"
+#include "raul/Noncopyable.hpp"
 #include "raul/RingBuffer.hpp"
-#include "raul/Semaphore.hpp"
 
 namespace Ingen {
 
@@ -32,10 +35,22 @@ namespace Server {
 
 class LV2Block;
 
+/** Pool of threads which do non-realtime work for LV2 blocks.
+ *
+ * Each block which uses the LV2 worker extension has its own queue of
+ * requests and responses, and is assigned to one thread.  Work for a block
+ * is done in the order it was scheduled, but work for blocks assigned to
+ * different threads is done in parallel.  Queues may be added and removed
+ * while work is being done.
+ */
 class Worker
 {
 public:
-	Worker(Log& log, uint32_t buffer_size);
+	Worker(Log&     log,
+	       uint32_t buffer_size,
+	       int32_t  n_threads,
+	       bool     print_stats);
+
 	~Worker();
 
 	struct Schedule : public LV2Features::Feature {
@@ -44,25 +59,91 @@ public:
 		SPtr<LV2_Feature> feature(World* world, Node* n);
 	};
 
-	LV2_Worker_Status request(LV2Block*   block,
+	struct Thread;
+
+	/** Do the work for one request, called in a worker thread. */
+	typedef std::function<void(uint32_t size, const void* data)> Work;
+
+	/** Requests from, and responses to, a single block.
+	 *
+	 * Requests are written in the audio thread and read by the worker
+	 * thread, and responses are written by the worker thread and read in the
+	 * audio thread, so both rings have a single reader and writer.
+	 */
+	class Queue : public Raul::Noncopyable {
+	public:
+		/** Remove from the worker, waiting for any work in progress. */
+		~Queue();
+
+		/** Read the next response, which is valid until the next call.
+		 * Realtime safe, called in the audio thread.
+		 * @return True if a response was read.
+		 */
+		bool read_response(uint32_t* size, const void** data);
+
+	private:
+		friend class Worker;
+
+		Queue(const Work& work, Thread* thread, uint32_t buffer_size);
+
+		const Work            _work;
+		Thread* const         _thread;
+		std::mutex            _mutex;  ///< Held while handling requests
+		Raul::RingBuffer      _requests;
+		Raul::RingBuffer      _responses;
+		uint8_t* const        _request_buffer;
+		uint8_t* const        _response_buffer;
+		const uint32_t        _buffer_size;
+		std::atomic<uint32_t> _depth;  ///< Number of pending requests
+	};
+
+	/** Statistics about all requests handled so far. */
+	struct Stats {
+		uint64_t n_requests;    ///< Number of requests handled
+		uint32_t max_depth;     ///< Most requests pending for one block
+		uint64_t mean_latency;  ///< Mean time from request to done (ns)
+		uint64_t max_latency;   ///< Longest time from request to done (ns)
+	};
+
+	/** Create a queue for `block`, assigned to the least busy thread.
+	 * The returned queue is owned by the caller.
+	 */
+	Queue* add_block(LV2Block* block);
+
+	/** Create a queue whose requests are handled by `work`.
+	 * The returned queue is owned by the caller.
+	 */
+	Queue* add_queue(const Work& work);
+
+	/** Schedule work on `queue`.  Realtime safe, called in the audio thread. */
+	LV2_Worker_Status request(Queue*      queue,
 	                          uint32_t    size,
 	                          const void* data);
 
+	/** LV2 worker respond function, where `handle` is a Queue. */
+	static LV2_Worker_Status respond(LV2_Worker_Respond_Handle handle,
+	                                 uint32_t                  size,
+	                                 const void*               data);
+
+	Stats stats() const;
+
 	SPtr<Schedule> schedule_feature() { return _schedule; }
 
 private:
 	SPtr<Schedule> _schedule;
 
-	Log&             _log;
-	Raul::Semaphore  _sem;
-	Raul::RingBuffer _requests;
-	Raul::RingBuffer _responses;
-	uint8_t* const   _buffer;
-	const uint32_t   _buffer_size;
-	bool             _exit_flag;
-	std::thread      _thread;
-
-	void run();
+	Log&                  _log;
+	const uint32_t        _buffer_size;
+	const bool            _print_stats;
+	std::atomic<bool>     _exit_flag;
+	std::vector<Thread*>  _threads;
+	std::atomic<uint64_t> _n_requests;
+	std::atomic<uint32_t> _max_depth;
+	std::atomic<uint64_t> _total_latency;
+	std::atomic<uint64_t> _max_latency;
+
+	void run(Thread* thread);
+	void handle(Queue* queue);
 };
 
 } // namespace Server
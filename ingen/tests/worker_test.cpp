@@ -0,0 +1,123 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2015 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "ingen/World.hpp"
+
+#include "Worker.hpp"
+
+using namespace std;
+using namespace Ingen;
+using namespace Ingen::Server;
+
+/** A stand-in for a block, which counts the work done for it. */
+struct Block {
+	Block() : queue(NULL), n_requests(0), n_done(0), removed(false) {}
+
+	Worker::Queue*        queue;
+	uint32_t              n_requests;
+	std::atomic<uint32_t> n_done;
+	std::atomic<bool>     removed;
+};
+
+static std::atomic<uint32_t> n_late(0);  ///< Work done after removal
+
+static void
+ingen_try(bool cond, const char* msg)
+{
+	if (!cond) {
+		cerr << "ingen: Error: " << msg << endl;
+		exit(EXIT_FAILURE);
+	}
+}
+
+static void
+add(Worker& worker, Block* block)
+{
+	block->queue = worker.add_queue([block](uint32_t size, const void* data) {
+			if (block->removed) {
+				++n_late;
+			}
+			this_thread::sleep_for(chrono::microseconds(50));
+			++block->n_done;
+		});
+}
+
+static void
+remove(Block* block)
+{
+	delete block->queue;  // Waits for any work in progress
+	block->queue   = NULL;
+	block->removed = true;
+}
+
+int
+main(int argc, char** argv)
+{
+	World  world(argc, argv, NULL, NULL, NULL);
+	Worker worker(world.log(), 4096, 4, false);
+
+	const size_t n_live   = 16;
+	const size_t n_rounds = 400;
+
+	// Add a block and request work for every block each round, and remove
+	// the oldest block once there are enough, while its work is running
+	vector< unique_ptr<Block> > blocks;
+	size_t                      oldest = 0;
+	for (uint32_t r = 0; r < n_rounds; ++r) {
+		blocks.push_back(unique_ptr<Block>(new Block()));
+		add(worker, blocks.back().get());
+
+		for (size_t i = oldest; i < blocks.size(); ++i) {
+			ingen_try(worker.request(blocks[i]->queue, sizeof(r), &r)
+			          == LV2_WORKER_SUCCESS,
+			          "Failed to request work");
+			++blocks[i]->n_requests;
+		}
+
+		if (blocks.size() - oldest > n_live) {
+			remove(blocks[oldest++].get());
+		}
+	}
+
+	// Wait for the remaining blocks to finish all their work
+	const auto timeout = chrono::steady_clock::now() + chrono::seconds(30);
+	for (size_t i = oldest; i < blocks.size(); ++i) {
+		while (blocks[i]->n_done < blocks[i]->n_requests) {
+			ingen_try(chrono::steady_clock::now() < timeout,
+			          "Timed out waiting for work");
+			this_thread::sleep_for(chrono::milliseconds(1));
+		}
+		ingen_try(blocks[i]->n_done == blocks[i]->n_requests,
+		          "Work done more than once");
+	}
+
+	for (size_t i = oldest; i < blocks.size(); ++i) {
+		remove(blocks[i].get());
+	}
+
+	ingen_try(n_late == 0, "Work done after block was removed");
+	ingen_try(worker.stats().n_requests > 0, "No work done");
+
+	return EXIT_SUCCESS;
+}
@@ -69,6 +69,7 @@
 #include "suil/suil.h"
 
 #include "lv2_evbuf.h"
+#include "render.h"
 #include "worker.h"
 
 #define NS_RDF "http://www.w3.org/1999/02/22-rdf-syntax-ns#"
@@ -103,10 +104,7 @@ map_uri(LV2_URID_Map_Handle handle,
         const char*         uri)
 {
 	Jalv* jalv = (Jalv*)handle;
-	zix_sem_wait(&jalv->symap_lock);
-	const LV2_URID id = symap_map(jalv->symap, uri);
-	zix_sem_post(&jalv->symap_lock);
-	return id;
+	return symap_map(jalv->symap, uri);
 }
 
 static const char*
@@ -114,10 +112,7 @@ unmap_uri(LV2_URID_Unmap_Handle handle,
           LV2_URID              urid)
 {
 	Jalv* jalv = (Jalv*)handle;
-	zix_sem_wait(&jalv->symap_lock);
-	const char* uri = symap_unmap(jalv->symap, urid);
-	zix_sem_post(&jalv->symap_lock);
-	return uri;
+	return symap_unmap(jalv->symap, urid);
 }
 
 /**
@@ -129,10 +124,7 @@ uri_to_id(LV2_URI_Map_Callback_Data callback_data,
           const char*               uri)
 {
 	Jalv* jalv = (Jalv*)callback_data;
-	zix_sem_wait(&jalv->symap_lock);
-	const LV2_URID id = symap_map(jalv->symap, uri);
-	zix_sem_post(&jalv->symap_lock);
-	return id;
+	return symap_map(jalv->symap, uri);
 }
 
 #define NS_EXT "http://lv2plug.in/ns/ext/"
@@ -212,6 +204,9 @@ create_port(Jalv*    jalv,
 	port->control   = 0.0f;
 	port->flow      = FLOW_UNKNOWN;
 
+	/* Send the initial value of control outputs to the UI */
+	port->ui_control = NAN;
+
 	const bool optional = lilv_port_has_property(
 		jalv->plugin, port->lilv_port, jalv->nodes.lv2_connectionOptional);
 
@@ -314,6 +309,42 @@ jalv_allocate_port_buffers(Jalv* jalv)
 	}
 }
 
+/**
+   Group ports by kind in jalv->plan (see JalvPortPlan).
+*/
+static void
+jalv_plan_ports(Jalv* jalv)
+{
+	JalvPortPlan* const plan    = &jalv->plan;
+	JalvPortList* const lists[] = { &plan->audio_in, &plan->audio_out,
+	                                &plan->event_in, &plan->event_out,
+	                                &plan->control_out };
+	for (unsigned i = 0; i < sizeof(lists) / sizeof(lists[0]); ++i) {
+		lists[i]->ports   = (struct Port**)calloc(jalv->num_ports,
+		                                          sizeof(struct Port*));
+		lists[i]->n_ports = 0;
+	}
+
+	for (uint32_t i = 0; i < jalv->num_ports; ++i) {
+		struct Port* const port = &jalv->ports[i];
+		const bool         in   = (port->flow == FLOW_INPUT);
+		JalvPortList*      list = NULL;
+		if (port->flow == FLOW_UNKNOWN) {
+			continue;  // Connected to NULL
+		} else if (port->type == TYPE_AUDIO) {
+			list = in ? &plan->audio_in : &plan->audio_out;
+		} else if (port->type == TYPE_EVENT) {
+			list = in ? &plan->event_in : &plan->event_out;
+		} else if (port->type == TYPE_CONTROL && !in) {
+			list = &plan->control_out;
+		}
+
+		if (list) {
+			list->ports[list->n_ports++] = port;
+		}
+	}
+}
+
 /**
    Get a port structure by symbol.
 
@@ -360,6 +391,15 @@ activate_port(Jalv*    jalv,
 		return;
 	}
 
+	/* Without Jack, only connect control ports (see jalv_render_run()) */
+	if (!jalv->jack_client) {
+		if (port->type == TYPE_CONTROL) {
+			print_control_value(jalv, port, port->control);
+			lilv_instance_connect_port(jalv->instance, port_index, &port->control);
+		}
+		return;
+	}
+
 	/* Build Jack flags for port */
 	enum JackPortFlags jack_flags = (port->flow == FLOW_INPUT)
 		? JackPortIsInput
@@ -423,21 +463,110 @@ jack_shutdown_cb(void* data)
 	zix_sem_post(jalv->done);
 }
 
-/** Jack process callback. */
-static REALTIME int
-jack_process_cb(jack_nframes_t nframes, void* data)
+/**
+   Send output events, and changed control outputs if `send_controls` is
+   true, to the UI in a single frame.
+
+   Control outputs are only sent if they have changed since they were last
+   sent, so if the UI falls behind, it gets the latest values when it catches
+   up rather than every value in between.
+*/
+static REALTIME void
+jalv_send_ui_frame(Jalv* jalv, bool send_controls)
 {
-	Jalv* const jalv = (Jalv*)data;
+	uint8_t* const     buf   = (uint8_t*)jalv->ui_frame_buf;
+	const size_t       cap   = jalv->plugin_events->size - 1;
+	JalvUIFrame* const frame = (JalvUIFrame*)buf;
+	size_t             len   = sizeof(JalvUIFrame);
+	bool               full  = false;
+
+	/* Add control outputs which have changed */
+	const JalvPortList* const controls = &jalv->plan.control_out;
+	frame->n_controls = 0;
+	for (uint32_t i = 0; send_controls && i < controls->n_ports; ++i) {
+		struct Port* const port = controls->ports[i];
+		if (port->control != port->ui_control &&
+		    len + sizeof(JalvControlValue) <= cap) {
+			JalvControlValue* const value = (JalvControlValue*)(buf + len);
+			value->index  = port->index;
+			value->value  = port->control;
+			len          += sizeof(JalvControlValue);
+			++frame->n_controls;
+		}
+	}
 
-	/* Get Jack transport position */
-	jack_position_t pos;
-	const bool rolling = (jack_transport_query(jalv->jack_client, &pos)
-	                      == JackTransportRolling);
+	/* Add atom output events */
+	const JalvPortList* const outputs      = &jalv->plan.event_out;
+	const size_t              events_start = len;
+	for (uint32_t o = 0; o < outputs->n_ports; ++o) {
+		struct Port* const port = outputs->ports[o];
+		if (port->old_api) {
+			continue;
+		}
+
+		for (LV2_Evbuf_Iterator i = lv2_evbuf_begin(port->evbuf);
+		     lv2_evbuf_is_valid(i);
+		     i = lv2_evbuf_next(i)) {
+			uint32_t frames, subframes, type, size;
+			uint8_t* body;
+			lv2_evbuf_get(i, &frames, &subframes, &type, &size, &body);
+
+			const uint32_t ev_size = sizeof(JalvPortEvent) +
+				jalv_pad_size(sizeof(LV2_Atom) + size);
+			if (len + ev_size > cap) {
+				full = true;
+				continue;
+			}
 
+			JalvPortEvent* const ev   = (JalvPortEvent*)(buf + len);
+			LV2_Atom* const      atom = (LV2_Atom*)(ev + 1);
+			ev->index    = port->index;
+			ev->protocol = jalv->urids.atom_eventTransfer;
+			ev->size     = sizeof(LV2_Atom) + size;
+			ev->pad      = 0;
+			atom->type   = type;
+			atom->size   = size;
+			memcpy(atom + 1, body, size);
+			len += ev_size;
+		}
+	}
+	frame->events_size = len - events_start;
+
+	if (frame->n_controls || frame->events_size) {
+		if (jalv_ring_write(jalv->plugin_events, buf, len)) {
+			/* Sent, so only send these controls again if they change */
+			const JalvControlValue* values = (const JalvControlValue*)(frame + 1);
+			for (uint32_t i = 0; i < frame->n_controls; ++i) {
+				jalv->ports[values[i].index].ui_control = values[i].value;
+			}
+		} else {
+			full = true;
+		}
+	}
+
+	if (full) {
+		fprintf(stderr, "Plugin => UI buffer overflow!\n");
+	}
+}
+
+/**
+   Prepare to run the plugin for a cycle.
+
+   This sends a position event to the plugin if the transport has changed,
+   handles pause requests, and resets event port buffers.  Audio port buffers
+   and event input from outside the process are left to the caller.  Returns
+   false if the plugin is paused and must not be run this cycle.
+*/
+REALTIME bool
+jalv_process_begin(Jalv*                  jalv,
+                   uint32_t               nframes,
+                   bool                   rolling,
+                   const jack_position_t* pos)
+{
 	/* If transport state is not as expected, then something has changed */
 	const bool xport_changed = (rolling != jalv->rolling ||
-	                            pos.frame != jalv->position ||
-	                            pos.beats_per_minute != jalv->bpm);
+	                            pos->frame != jalv->position ||
+	                            pos->beats_per_minute != jalv->bpm);
 
 	uint8_t   pos_buf[256];
 	LV2_Atom* lv2_pos = (LV2_Atom*)pos_buf;
@@ -448,21 +577,21 @@ jack_process_cb(jack_nframes_t nframes, void* data)
 		LV2_Atom_Forge_Frame frame;
 		lv2_atom_forge_object(forge, &frame, 0, jalv->urids.time_Position);
 		lv2_atom_forge_key(forge, jalv->urids.time_frame);
-		lv2_atom_forge_long(forge, pos.frame);
+		lv2_atom_forge_long(forge, pos->frame);
 		lv2_atom_forge_key(forge, jalv->urids.time_speed);
 		lv2_atom_forge_float(forge, rolling ? 1.0 : 0.0);
-		if (pos.valid & JackPositionBBT) {
+		if (pos->valid & JackPositionBBT) {
 			lv2_atom_forge_key(forge, jalv->urids.time_barBeat);
 			lv2_atom_forge_float(
-				forge, pos.beat - 1 + (pos.tick / pos.ticks_per_beat));
+				forge, pos->beat - 1 + (pos->tick / pos->ticks_per_beat));
 			lv2_atom_forge_key(forge, jalv->urids.time_bar);
-			lv2_atom_forge_long(forge, pos.bar - 1);
+			lv2_atom_forge_long(forge, pos->bar - 1);
 			lv2_atom_forge_key(forge, jalv->urids.time_beatUnit);
-			lv2_atom_forge_int(forge, pos.beat_type);
+			lv2_atom_forge_int(forge, pos->beat_type);
 			lv2_atom_forge_key(forge, jalv->urids.time_beatsPerBar);
-			lv2_atom_forge_float(forge, pos.beats_per_bar);
+			lv2_atom_forge_float(forge, pos->beats_per_bar);
 			lv2_atom_forge_key(forge, jalv->urids.time_beatsPerMinute);
-			lv2_atom_forge_float(forge, pos.beats_per_minute);
+			lv2_atom_forge_float(forge, pos->beats_per_minute);
 		}
 
 		if (jalv->opts.dump) {
@@ -475,8 +604,8 @@ jack_process_cb(jack_nframes_t nframes, void* data)
 	}
 
 	/* Update transport state to expected values for next cycle */
-	jalv->position = rolling ? pos.frame + nframes : pos.frame;
-	jalv->bpm      = pos.beats_per_minute;
+	jalv->position = rolling ? pos->frame + nframes : pos->frame;
+	jalv->bpm      = pos->beats_per_minute;
 	jalv->rolling  = rolling;
 
 	switch (jalv->play_state) {
@@ -485,60 +614,43 @@ jack_process_cb(jack_nframes_t nframes, void* data)
 		zix_sem_post(&jalv->paused);
 		break;
 	case JALV_PAUSED:
-		for (uint32_t p = 0; p < jalv->num_ports; ++p) {
-			jack_port_t* jport = jalv->ports[p].jack_port;
-			if (jport && jalv->ports[p].flow == FLOW_OUTPUT) {
-				void* buf = jack_port_get_buffer(jport, nframes);
-				if (jalv->ports[p].type == TYPE_EVENT) {
-					jack_midi_clear_buffer(buf);
-				} else {
-					memset(buf, '\0', nframes * sizeof(float));
-				}
-			}
-		}
-		return 0;
+		return false;
 	default:
 		break;
 	}
 
-	/* Prepare port buffers */
-	for (uint32_t p = 0; p < jalv->num_ports; ++p) {
-		struct Port* port = &jalv->ports[p];
-		if (port->type == TYPE_AUDIO && port->jack_port) {
-			/* Connect plugin port directly to Jack port buffer */
-			lilv_instance_connect_port(
-				jalv->instance, p,
-				jack_port_get_buffer(port->jack_port, nframes));
-
-		} else if (port->type == TYPE_EVENT && port->flow == FLOW_INPUT) {
-			lv2_evbuf_reset(port->evbuf, true);
-
-			/* Write transport change event if applicable */
-			LV2_Evbuf_Iterator iter = lv2_evbuf_begin(port->evbuf);
-			if (xport_changed) {
-				lv2_evbuf_write(
-					&iter, 0, 0,
-					lv2_pos->type, lv2_pos->size, LV2_ATOM_BODY(lv2_pos));
-			}
+	/* Prepare event input buffers */
+	for (uint32_t i = 0; i < jalv->plan.event_in.n_ports; ++i) {
+		struct Port* const port = jalv->plan.event_in.ports[i];
+		lv2_evbuf_reset(port->evbuf, true);
 
-			if (port->jack_port) {
-				/* Write Jack MIDI input */
-				void* buf = jack_port_get_buffer(port->jack_port, nframes);
-				for (uint32_t i = 0; i < jack_midi_get_event_count(buf); ++i) {
-					jack_midi_event_t ev;
-					jack_midi_event_get(&ev, buf, i);
-					lv2_evbuf_write(&iter,
-					                ev.time, 0,
-					                jalv->midi_event_id,
-					                ev.size, ev.buffer);
-				}
-			}
-		} else if (port->type == TYPE_EVENT) {
-			/* Clear event output for plugin to write to */
-			lv2_evbuf_reset(port->evbuf, false);
+		/* Write transport change event if applicable */
+		LV2_Evbuf_Iterator iter = lv2_evbuf_begin(port->evbuf);
+		if (xport_changed) {
+			lv2_evbuf_write(
+				&iter, 0, 0,
+				lv2_pos->type, lv2_pos->size, LV2_ATOM_BODY(lv2_pos));
 		}
 	}
 
+	/* Clear event outputs for plugin to write to */
+	for (uint32_t i = 0; i < jalv->plan.event_out.n_ports; ++i) {
+		lv2_evbuf_reset(jalv->plan.event_out.ports[i]->evbuf, false);
+	}
+
+	return true;
+}
+
+/**
+   Run the plugin for a cycle prepared with jalv_process_begin().
+
+   This applies control changes from the UI, runs the plugin, delivers worker
+   responses, and sends output to the UI.  Event output is left in the port
+   buffers for the caller to deliver.
+*/
+REALTIME void
+jalv_process_end(Jalv* jalv, uint32_t nframes)
+{
 	/* Read and apply control change events from UI */
 	if (jalv->has_ui) {
 		ControlChange ev;
@@ -587,58 +699,90 @@ jack_process_cb(jack_nframes_t nframes, void* data)
 		jalv->event_delta_t = 0;
 	}
 
-	/* Deliver MIDI output and UI events */
-	for (uint32_t p = 0; p < jalv->num_ports; ++p) {
-		struct Port* const port = &jalv->ports[p];
-		if (port->flow == FLOW_OUTPUT && port->type == TYPE_EVENT) {
-			void* buf = NULL;
+	if (jalv->has_ui) {
+		jalv_send_ui_frame(jalv, send_ui_updates);
+	}
+}
+
+/** Jack process callback. */
+static REALTIME int
+jack_process_cb(jack_nframes_t nframes, void* data)
+{
+	Jalv* const               jalv = (Jalv*)data;
+	const JalvPortPlan* const plan = &jalv->plan;
+
+	/* Get Jack transport position */
+	jack_position_t pos;
+	const bool rolling = (jack_transport_query(jalv->jack_client, &pos)
+	                      == JackTransportRolling);
+
+	if (!jalv_process_begin(jalv, nframes, rolling, &pos)) {
+		/* Paused, silence outputs */
+		for (uint32_t i = 0; i < plan->audio_out.n_ports; ++i) {
+			jack_port_t* jport = plan->audio_out.ports[i]->jack_port;
+			if (jport) {
+				memset(jack_port_get_buffer(jport, nframes), '\0',
+				       nframes * sizeof(float));
+			}
+		}
+		for (uint32_t i = 0; i < plan->event_out.n_ports; ++i) {
+			jack_port_t* jport = plan->event_out.ports[i]->jack_port;
+			if (jport) {
+				jack_midi_clear_buffer(jack_port_get_buffer(jport, nframes));
+			}
+		}
+		return 0;
+	}
+
+	/* Connect plugin audio ports directly to Jack port buffers if changed */
+	const JalvPortList* const audio[] = { &plan->audio_in, &plan->audio_out };
+	for (unsigned a = 0; a < 2; ++a) {
+		for (uint32_t i = 0; i < audio[a]->n_ports; ++i) {
+			struct Port* const port = audio[a]->ports[i];
 			if (port->jack_port) {
-				buf = jack_port_get_buffer(port->jack_port, nframes);
-				jack_midi_clear_buffer(buf);
+				void* buf = jack_port_get_buffer(port->jack_port, nframes);
+				if (buf != port->jack_buf) {
+					lilv_instance_connect_port(jalv->instance, port->index, buf);
+					port->jack_buf = buf;
+				}
 			}
+		}
+	}
+
+	/* Write Jack MIDI input after any transport change event */
+	for (uint32_t i = 0; i < plan->event_in.n_ports; ++i) {
+		struct Port* const port = plan->event_in.ports[i];
+		if (port->jack_port) {
+			LV2_Evbuf_Iterator iter = lv2_evbuf_end(port->evbuf);
+			void* buf = jack_port_get_buffer(port->jack_port, nframes);
+			for (uint32_t e = 0; e < jack_midi_get_event_count(buf); ++e) {
+				jack_midi_event_t ev;
+				jack_midi_event_get(&ev, buf, e);
+				lv2_evbuf_write(&iter,
+				                ev.time, 0,
+				                jalv->midi_event_id,
+				                ev.size, ev.buffer);
+			}
+		}
+	}
 
-			for (LV2_Evbuf_Iterator i = lv2_evbuf_begin(port->evbuf);
-			     lv2_evbuf_is_valid(i);
-			     i = lv2_evbuf_next(i)) {
+	jalv_process_end(jalv, nframes);
+
+	/* Deliver MIDI output to Jack */
+	for (uint32_t i = 0; i < plan->event_out.n_ports; ++i) {
+		struct Port* const port = plan->event_out.ports[i];
+		if (port->jack_port) {
+			void* buf = jack_port_get_buffer(port->jack_port, nframes);
+			jack_midi_clear_buffer(buf);
+			for (LV2_Evbuf_Iterator e = lv2_evbuf_begin(port->evbuf);
+			     lv2_evbuf_is_valid(e);
+			     e = lv2_evbuf_next(e)) {
 				uint32_t frames, subframes, type, size;
 				uint8_t* body;
-				lv2_evbuf_get(i, &frames, &subframes, &type, &size, &body);
-				if (buf && type == jalv->midi_event_id) {
+				lv2_evbuf_get(e, &frames, &subframes, &type, &size, &body);
+				if (type == jalv->midi_event_id) {
 					jack_midi_event_write(buf, frames, body, size);
 				}
-
-				/* TODO: Be more disciminate about what to send */
-				if (jalv->has_ui && !port->old_api) {
-					char evbuf[sizeof(ControlChange) + sizeof(LV2_Atom)];
-					ControlChange* ev = (ControlChange*)evbuf;
-					ev->index    = p;
-					ev->protocol = jalv->urids.atom_eventTransfer;
-					ev->size     = sizeof(LV2_Atom) + size;
-					LV2_Atom* atom = (LV2_Atom*)ev->body;
-					atom->type = type;
-					atom->size = size;
-					if (jack_ringbuffer_write_space(jalv->plugin_events)
-					    < sizeof(evbuf) + size) {
-						fprintf(stderr, "Plugin => UI buffer overflow!\n");
-						break;
-					}
-					jack_ringbuffer_write(jalv->plugin_events, evbuf, sizeof(evbuf));
-					/* TODO: race, ensure reader handles this correctly */
-					jack_ringbuffer_write(jalv->plugin_events, (void*)body, size);
-				}
-			}
-		} else if (send_ui_updates
-		           && port->flow != FLOW_INPUT
-		           && port->type == TYPE_CONTROL) {
-			char buf[sizeof(ControlChange) + sizeof(float)];
-			ControlChange* ev = (ControlChange*)buf;
-			ev->index    = p;
-			ev->protocol = 0;
-			ev->size     = sizeof(float);
-			*(float*)ev->body = port->control;
-			if (jack_ringbuffer_write(jalv->plugin_events, buf, sizeof(buf))
-			    < sizeof(buf)) {
-				fprintf(stderr, "Plugin => UI buffer overflow!\n");
 			}
 		}
 	}
@@ -801,43 +945,76 @@ jalv_ui_port_index(SuilController controller, const char* symbol)
 	return port ? port->index : LV2UI_INVALID_PORT_INDEX;
 }
 
+/** Deliver a port event from the plugin to the UI. */
+static void
+jalv_ui_port_event_deliver(Jalv*       jalv,
+                           uint32_t    port_index,
+                           uint32_t    size,
+                           uint32_t    protocol,
+                           const void* body)
+{
+	if (jalv->opts.dump && protocol == jalv->urids.atom_eventTransfer) {
+		// Dump event in Turtle to the console
+		const LV2_Atom* atom = (const LV2_Atom*)body;
+		char*           str  = sratom_to_turtle(
+			jalv->ui_sratom, &jalv->unmap, "jalv:", NULL, NULL,
+			atom->type, atom->size, LV2_ATOM_BODY_CONST(atom));
+		printf("\n## Plugin => UI (%u bytes) ##\n%s\n", atom->size, str);
+		free(str);
+	}
+
+	if (jalv->ui_instance) {
+		suil_instance_port_event(jalv->ui_instance, port_index,
+		                         size, protocol, body);
+	} else {
+		jalv_ui_port_event(jalv, port_index, size, protocol, body);
+	}
+
+	if (protocol == 0 && jalv->opts.print_controls) {
+		print_control_value(jalv, &jalv->ports[port_index], *(const float*)body);
+	}
+}
+
 bool
 jalv_emit_ui_events(Jalv* jalv)
 {
-	ControlChange ev;
-	const size_t  space = jack_ringbuffer_read_space(jalv->plugin_events);
-	for (size_t i = 0;
-	     i + sizeof(ev) + sizeof(float) <= space;
-	     i += sizeof(ev) + ev.size) {
-		// Read event header to get the size
-		jack_ringbuffer_read(jalv->plugin_events, (char*)&ev, sizeof(ev));
-
-		// Resize read buffer if necessary
-		jalv->ui_event_buf = realloc(jalv->ui_event_buf, ev.size);
-		void* const buf = jalv->ui_event_buf;
-
-		// Read event body
-		jack_ringbuffer_read(jalv->plugin_events, buf, ev.size);
-
-		if (jalv->opts.dump && ev.protocol == jalv->urids.atom_eventTransfer) {
-			// Dump event in Turtle to the console
-			LV2_Atom* atom = (LV2_Atom*)buf;
-			char*     str  = sratom_to_turtle(
-				jalv->ui_sratom, &jalv->unmap, "jalv:", NULL, NULL,
-				atom->type, atom->size, LV2_ATOM_BODY(atom));
-			printf("\n## Plugin => UI (%u bytes) ##\n%s\n", atom->size, str);
-			free(str);
+	// Frames are written at once, so only whole frames are ever readable
+	uint8_t* const buf   = (uint8_t*)jalv->ui_event_buf;
+	const size_t   space = jack_ringbuffer_read_space(jalv->plugin_events);
+	jack_ringbuffer_read(jalv->plugin_events, (char*)buf, space);
+
+	bool controls_changed = false;
+	for (size_t offset = 0; offset < space;) {
+		const JalvUIFrame* const      frame  = (const JalvUIFrame*)(buf + offset);
+		const JalvControlValue* const values = (const JalvControlValue*)(frame + 1);
+
+		// Only the latest value of each control is shown, after all frames
+		for (uint32_t i = 0; i < frame->n_controls; ++i) {
+			struct Port* const port = &jalv->ports[values[i].index];
+			port->ui_value   = values[i].value;
+			port->ui_pending = true;
+			controls_changed = true;
 		}
 
-		if (jalv->ui_instance) {
-			suil_instance_port_event(jalv->ui_instance, ev.index,
-			                         ev.size, ev.protocol, buf);
-		} else {
-			jalv_ui_port_event(jalv, ev.index, ev.size, ev.protocol, buf);
+		// Deliver every event in order
+		const uint8_t* const events = (const uint8_t*)(values + frame->n_controls);
+		for (uint32_t e = 0; e < frame->events_size;) {
+			const JalvPortEvent* const ev = (const JalvPortEvent*)(events + e);
+			jalv_ui_port_event_deliver(jalv, ev->index, ev->size, ev->protocol,
+			                           ev + 1);
+			e += sizeof(JalvPortEvent) + jalv_pad_size(ev->size);
 		}
 
-		if (ev.protocol == 0 && jalv->opts.print_controls) {
-			print_control_value(jalv, &jalv->ports[ev.index], *(float*)buf);
+		offset += (sizeof(JalvUIFrame) +
+		           frame->n_controls * sizeof(JalvControlValue) +
+		           frame->events_size);
+	}
+
+	for (uint32_t i = 0; controls_changed && i < jalv->num_ports; ++i) {
+		struct Port* const port = &jalv->ports[i];
+		if (port->ui_pending) {
+			port->ui_pending = false;
+			jalv_ui_port_event_deliver(jalv, i, sizeof(float), 0, &port->ui_value);
 		}
 	}
 
@@ -864,6 +1041,78 @@ jalv_apply_control_arg(Jalv* jalv, const char* s)
 	return true;
 }
 
+/** Open a Jack client and get the sample rate and buffer sizes from it. */
+static void
+jalv_jack_open(Jalv* jalv)
+{
+	/* Determine the name of the JACK client */
+	char* jack_name = NULL;
+
+	if (jalv->opts.name) {
+
+		/* If name has been set upon invocation */
+		if (strlen(jalv->opts.name) >= (unsigned)jack_client_name_size() - 1) {
+			jack_name = (char*)calloc(jack_client_name_size(), 1);
+			strncpy(jack_name, jalv->opts.name, jack_client_name_size() - 1);
+		} else {
+			jack_name = jalv_strdup(jalv->opts.name);
+		}
+
+	} else {
+
+		/* Get the plugin's name */
+		LilvNode*   name     = lilv_plugin_get_name(jalv->plugin);
+		const char* name_str = lilv_node_as_string(name);
+
+		/* Truncate plugin name to suit JACK (if necessary) */
+		if (strlen(name_str) >= (unsigned)jack_client_name_size() - 1) {
+			jack_name = (char*)calloc(jack_client_name_size(), 1);
+			strncpy(jack_name, name_str, jack_client_name_size() - 1);
+		} else {
+			jack_name = jalv_strdup(name_str);
+		}
+
+		lilv_node_free(name);
+
+	}
+
+	/* Connect to JACK */
+	printf("JACK Name:    %s\n", jack_name);
+#ifdef JALV_JACK_SESSION
+	if (jalv->opts.uuid) {
+		jalv->jack_client = jack_client_open(
+			jack_name,
+			JackSessionID | jalv->opts.name_exact ? JackUseExactName : 0,
+			NULL,
+			jalv->opts.uuid
+		);
+	}
+#endif
+
+	if (!jalv->jack_client) {
+		jalv->jack_client = jack_client_open(
+			jack_name,
+			jalv->opts.name_exact ? JackUseExactName : JackNullOption,
+			NULL
+		);
+	}
+
+	free(jack_name);
+
+	if (!jalv->jack_client)
+		die("Failed to connect to JACK.\n");
+
+	jalv->sample_rate  = jack_get_sample_rate(jalv->jack_client);
+	jalv->block_length = jack_get_buffer_size(jalv->jack_client);
+#ifdef HAVE_JACK_PORT_TYPE_GET_BUFFER_SIZE
+	jalv->midi_buf_size = jack_port_type_get_buffer_size(
+		jalv->jack_client, JACK_DEFAULT_MIDI_TYPE);
+#else
+	jalv->midi_buf_size = 4096;
+	fprintf(stderr, "warning: No jack_port_type_get_buffer_size.\n");
+#endif
+}
+
 static void
 signal_handler(int ignored)
 {
@@ -890,7 +1139,6 @@ main(int argc, char** argv)
 	}
 
 	jalv.symap = symap_new();
-	zix_sem_init(&jalv.symap_lock, 1);
 	uri_map.callback_data = &jalv;
 
 	jalv.map.handle  = &jalv;
@@ -986,8 +1234,9 @@ main(int argc, char** argv)
 	jalv.nodes.end                    = NULL;
 
 	/* Get plugin URI from loaded state or command line */
-	LilvState* state      = NULL;
-	LilvNode*  plugin_uri = NULL;
+	LilvState*  state      = NULL;
+	LilvNode*   plugin_uri = NULL;
+	JalvRender* render     = NULL;
 	if (jalv.opts.load) {
 		struct stat info;
 		stat(jalv.opts.load, &info);
@@ -1072,72 +1321,16 @@ main(int argc, char** argv)
 	/* Create port structures (jalv.ports) */
 	jalv_create_ports(&jalv);
 
-	/* Determine the name of the JACK client */
-	char* jack_name = NULL;
-
-	if (jalv.opts.name) {
-
-		/* If name has been set upon invocation */
-		if (strlen(jalv.opts.name) >= (unsigned)jack_client_name_size() - 1) {
-			jack_name = (char*)calloc(jack_client_name_size(), 1);
-			strncpy(jack_name, jalv.opts.name, jack_client_name_size() - 1);
-		} else {
-			jack_name = jalv_strdup(jalv.opts.name);
+	if (jalv.opts.render) {
+		/* Render offline, without Jack */
+		render = jalv_render_new(&jalv);
+		if (!render) {
+			return EXIT_FAILURE;
 		}
-
 	} else {
-
-		/* Get the plugin's name */
-		LilvNode*   name     = lilv_plugin_get_name(jalv.plugin);
-		const char* name_str = lilv_node_as_string(name);
-
-		/* Truncate plugin name to suit JACK (if necessary) */
-		if (strlen(name_str) >= (unsigned)jack_client_name_size() - 1) {
-			jack_name = (char*)calloc(jack_client_name_size(), 1);
-			strncpy(jack_name, name_str, jack_client_name_size() - 1);
-		} else {
-			jack_name = jalv_strdup(name_str);
-		}
-
-		lilv_node_free(name);
-
+		jalv_jack_open(&jalv);
 	}
 
-	/* Connect to JACK */
-	printf("JACK Name:    %s\n", jack_name);
-#ifdef JALV_JACK_SESSION
-	if (jalv.opts.uuid) {
-		jalv.jack_client = jack_client_open(
-			jack_name,
-			JackSessionID | jalv.opts.name_exact ? JackUseExactName : 0,
-			NULL,
-			jalv.opts.uuid
-		);
-	}
-#endif
-
-	if (!jalv.jack_client) {
-		jalv.jack_client = jack_client_open(
-			jack_name,
-			jalv.opts.name_exact ? JackUseExactName : JackNullOption,
-			NULL
-		);
-	}
-
-	free(jack_name);
-
-	if (!jalv.jack_client)
-		die("Failed to connect to JACK.\n");
-
-	jalv.sample_rate  = jack_get_sample_rate(jalv.jack_client);
-	jalv.block_length = jack_get_buffer_size(jalv.jack_client);
-#ifdef HAVE_JACK_PORT_TYPE_GET_BUFFER_SIZE
-	jalv.midi_buf_size = jack_port_type_get_buffer_size(
-		jalv.jack_client, JACK_DEFAULT_MIDI_TYPE);
-#else
-	jalv.midi_buf_size = 4096;
-	fprintf(stderr, "warning: No jack_port_type_get_buffer_size.\n");
-#endif
 	printf("Block length: %u frames\n", jalv.block_length);
 	printf("MIDI buffers: %zu bytes\n", jalv.midi_buf_size);
 
@@ -1189,6 +1382,8 @@ main(int argc, char** argv)
 	jalv.plugin_events = jack_ringbuffer_create(jalv.opts.buffer_size);
 	jack_ringbuffer_mlock(jalv.ui_events);
 	jack_ringbuffer_mlock(jalv.plugin_events);
+	jalv.ui_event_buf = malloc(jalv.plugin_events->size);
+	jalv.ui_frame_buf = malloc(jalv.plugin_events->size);
 
 	/* Instantiate the plugin */
 	jalv.instance = lilv_plugin_instantiate(
@@ -1210,7 +1405,8 @@ main(int argc, char** argv)
 		jalv_worker_init(
 			&jalv, &jalv.worker,
 			(const LV2_Worker_Interface*)lilv_instance_get_extension_data(
-				jalv.instance, LV2_WORKER__interface));
+				jalv.instance, LV2_WORKER__interface),
+			!render);
 	}
 
 	/* Apply loaded state to plugin instance if necessary */
@@ -1225,35 +1421,45 @@ main(int argc, char** argv)
 	}
 
 	/* Set Jack callbacks */
-	jack_set_process_callback(jalv.jack_client,
-	                          &jack_process_cb, (void*)(&jalv));
-	jack_set_buffer_size_callback(jalv.jack_client,
-	                              &jack_buffer_size_cb, (void*)(&jalv));
-	jack_on_shutdown(jalv.jack_client,
-	                 &jack_shutdown_cb, (void*)(&jalv));
+	if (jalv.jack_client) {
+		jack_set_process_callback(jalv.jack_client,
+		                          &jack_process_cb, (void*)(&jalv));
+		jack_set_buffer_size_callback(jalv.jack_client,
+		                              &jack_buffer_size_cb, (void*)(&jalv));
+		jack_on_shutdown(jalv.jack_client,
+		                 &jack_shutdown_cb, (void*)(&jalv));
 #ifdef JALV_JACK_SESSION
-	jack_set_session_callback(jalv.jack_client,
-	                          &jack_session_cb, (void*)(&jalv));
+		jack_set_session_callback(jalv.jack_client,
+		                          &jack_session_cb, (void*)(&jalv));
 #endif
+	}
 
 	/* Create Jack ports and connect plugin ports to buffers */
 	for (uint32_t i = 0; i < jalv.num_ports; ++i) {
 		activate_port(&jalv, i);
 	}
+	jalv_plan_ports(&jalv);
 
 	/* Activate plugin */
 	lilv_instance_activate(jalv.instance);
 
-	/* Activate Jack */
-	jack_activate(jalv.jack_client);
-	jalv.sample_rate = jack_get_sample_rate(jalv.jack_client);
-	jalv.play_state  = JALV_RUNNING;
+	int ret = 0;
+	if (render) {
+		/* Run plugin offline and write output files */
+		jalv.play_state = JALV_RUNNING;
+		ret             = jalv_render_run(render, &jalv);
+	} else {
+		/* Activate Jack */
+		jack_activate(jalv.jack_client);
+		jalv.sample_rate = jack_get_sample_rate(jalv.jack_client);
+		jalv.play_state  = JALV_RUNNING;
 
-	/* Run UI (or prompt at console) */
-	jalv_open_ui(&jalv);
+		/* Run UI (or prompt at console) */
+		jalv_open_ui(&jalv);
 
-	/* Wait for finish signal from UI or signal handler */
-	zix_sem_wait(&exit_sem);
+		/* Wait for finish signal from UI or signal handler */
+		zix_sem_wait(&exit_sem);
+	}
 	jalv.exit = true;
 
 	fprintf(stderr, "Exiting...\n");
@@ -1262,13 +1468,18 @@ main(int argc, char** argv)
 	jalv_worker_finish(&jalv.worker);
 
 	/* Deactivate JACK */
-	jack_deactivate(jalv.jack_client);
+	if (jalv.jack_client) {
+		jack_deactivate(jalv.jack_client);
+	}
 	for (uint32_t i = 0; i < jalv.num_ports; ++i) {
 		if (jalv.ports[i].evbuf) {
 			lv2_evbuf_free(jalv.ports[i].evbuf);
 		}
 	}
-	jack_client_close(jalv.jack_client);
+	if (jalv.jack_client) {
+		jack_client_close(jalv.jack_client);
+	}
+	jalv_render_free(render);
 
 	/* Deactivate plugin */
 	suil_instance_free(jalv.ui_instance);
@@ -1276,6 +1487,11 @@ main(int argc, char** argv)
 	lilv_instance_free(jalv.instance);
 
 	/* Clean up */
+	free(jalv.plan.audio_in.ports);
+	free(jalv.plan.audio_out.ports);
+	free(jalv.plan.event_in.ports);
+	free(jalv.plan.event_out.ports);
+	free(jalv.plan.control_out.ports);
 	free(jalv.ports);
 	jack_ringbuffer_free(jalv.ui_events);
 	jack_ringbuffer_free(jalv.plugin_events);
@@ -1283,7 +1499,6 @@ main(int argc, char** argv)
 		lilv_node_free(*n);
 	}
 	symap_free(jalv.symap);
-	zix_sem_destroy(&jalv.symap_lock);
 	suil_host_free(jalv.ui_host);
 	sratom_free(jalv.sratom);
 	sratom_free(jalv.ui_sratom);
@@ -1295,6 +1510,7 @@ main(int argc, char** argv)
 	remove(jalv.temp_dir);
 	free(jalv.temp_dir);
 	free(jalv.ui_event_buf);
+	free(jalv.ui_frame_buf);
 
-	return 0;
+	return ret;
 }
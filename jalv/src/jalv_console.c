@@ -41,6 +41,14 @@ print_usage(const char* name, bool error)
 	fprintf(os, "  -b SIZE      Buffer size for plugin <=> UI communication\n");
 	fprintf(os, "  -n NAME      Set JACK client name\n");
 	fprintf(os, "  -N NAME      Set exact JACK client name (exit if already taken)\n");
+	fprintf(os, "\nOffline rendering (without Jack, enabled by any of these):\n");
+	fprintf(os, "  -i FILE      Read audio input from WAV file\n");
+	fprintf(os, "  -m FILE      Read MIDI input from standard MIDI file\n");
+	fprintf(os, "  -o FILE      Write audio output to WAV file\n");
+	fprintf(os, "  -M FILE      Write MIDI output to standard MIDI file\n");
+	fprintf(os, "  -t SECONDS   Render length (default: length of input)\n");
+	fprintf(os, "  -r RATE      Sample rate (default: rate of input or 48000)\n");
+	fprintf(os, "  -f FRAMES    Block length (default: 1024)\n");
 	return error ? 1 : 0;
 }
 
@@ -103,6 +111,38 @@ jalv_init(int* argc, char*** argv, JalvOptions* opts)
 			opts->controls[n_controls]     = NULL;
 		} else if ((*argv)[a][1] == 'd') {
 			opts->dump = true;
+		} else if ((*argv)[a][1] == 'i' || (*argv)[a][1] == 'm' ||
+		           (*argv)[a][1] == 'o' || (*argv)[a][1] == 'M') {
+			const char opt = (*argv)[a][1];
+			if (++a == *argc) {
+				fprintf(stderr, "Missing argument for -%c\n", opt);
+				return 1;
+			}
+			char** const path = ((opt == 'i') ? &opts->audio_in :
+			                     (opt == 'm') ? &opts->midi_in :
+			                     (opt == 'o') ? &opts->audio_out :
+			                     &opts->midi_out);
+			*path        = jalv_strdup((*argv)[a]);
+			opts->render = true;
+		} else if ((*argv)[a][1] == 't') {
+			if (++a == *argc) {
+				fprintf(stderr, "Missing argument for -t\n");
+				return 1;
+			}
+			opts->length = atof((*argv)[a]);
+			opts->render = true;
+		} else if ((*argv)[a][1] == 'r') {
+			if (++a == *argc) {
+				fprintf(stderr, "Missing argument for -r\n");
+				return 1;
+			}
+			opts->sample_rate = atoi((*argv)[a]);
+		} else if ((*argv)[a][1] == 'f') {
+			if (++a == *argc) {
+				fprintf(stderr, "Missing argument for -f\n");
+				return 1;
+			}
+			opts->block_length = atoi((*argv)[a]);
 		} else if ((*argv)[a][1] == 'n' ){
 			if (opts->name) {
 				fprintf(stderr, "Client name is already %s, ignoring %s\n", opts->name, (*argv)[a+1]);
@@ -66,14 +66,38 @@ struct Port {
 	enum PortType   type;
 	enum PortFlow   flow;
 	jack_port_t*    jack_port;  ///< For audio/MIDI ports, otherwise NULL
+	void*           jack_buf;   ///< Jack buffer audio port is connected to
 	LV2_Evbuf*      evbuf;      ///< For MIDI ports, otherwise NULL
 	void*           widget;     ///< Control widget, if applicable
 	size_t          buf_size;   ///< Custom buffer size, or 0
 	uint32_t        index;      ///< Port index
 	float           control;    ///< For control ports, otherwise 0.0f
+	float           ui_control; ///< Control output value last sent to UI
+	float           ui_value;   ///< Latest control value received by UI
+	bool            ui_pending; ///< True iff ui_value is not yet shown
 	bool            old_api;    ///< True for event, false for atom
 };
 
+/**
+   A list of ports.
+*/
+typedef struct {
+	struct Port** ports;    ///< Array of ports
+	uint32_t      n_ports;  ///< Number of ports
+} JalvPortList;
+
+/**
+   Ports grouped by kind, built once when the plugin is activated, so that
+   each cycle only touches the ports which need something done.
+*/
+typedef struct {
+	JalvPortList audio_in;     ///< Audio inputs
+	JalvPortList audio_out;    ///< Audio outputs
+	JalvPortList event_in;     ///< Event inputs
+	JalvPortList event_out;    ///< Event outputs
+	JalvPortList control_out;  ///< Control outputs
+} JalvPortPlan;
+
 /**
    Control change event, sent through ring buffers for UI updates.
 */
@@ -84,6 +108,36 @@ typedef struct {
 	uint8_t  body[];
 } ControlChange;
 
+/**
+   Header of a frame of port events sent from the plugin to the UI.
+
+   At most one frame is sent per cycle.  The header is followed by n_controls
+   JalvControlValue, then events_size bytes of events, each a JalvPortEvent
+   followed by its body padded to 64 bits.
+*/
+typedef struct {
+	uint32_t n_controls;   ///< Number of control values
+	uint32_t events_size;  ///< Total size of events (with headers)
+} JalvUIFrame;
+
+/**
+   Value of a control port in a frame sent to the UI.
+*/
+typedef struct {
+	uint32_t index;  ///< Port index
+	float    value;  ///< Control value
+} JalvControlValue;
+
+/**
+   Header of an event in a frame sent to the UI.
+*/
+typedef struct {
+	uint32_t index;     ///< Port index
+	uint32_t protocol;  ///< Port protocol
+	uint32_t size;      ///< Size of body
+	uint32_t pad;       ///< Padding, so the body is 64-bit aligned
+} JalvPortEvent;
+
 typedef struct {
 	char*    name;              ///< Client name
 	int      name_exact;        ///< Exit if name is taken
@@ -98,6 +152,14 @@ typedef struct {
 	int      no_menu;           ///< Hide menu iff true
 	int      show_ui;           ///< Show non-embedded UI
 	int      print_controls;    ///< Print control changes to stdout
+	int      render;            ///< Render offline without Jack iff true
+	char*    audio_in;          ///< Offline audio input file (WAV)
+	char*    midi_in;           ///< Offline MIDI input file (SMF)
+	char*    audio_out;         ///< Offline audio output file (WAV)
+	char*    midi_out;          ///< Offline MIDI output file (SMF)
+	double   length;            ///< Offline render length in seconds, or 0
+	uint32_t sample_rate;       ///< Offline sample rate, or 0
+	uint32_t block_length;      ///< Offline block length, or 0
 } JalvOptions;
 
 typedef struct {
@@ -155,7 +217,11 @@ typedef enum {
 typedef struct {
 	jack_ringbuffer_t*          requests;   ///< Requests to the worker
 	jack_ringbuffer_t*          responses;  ///< Responses from the worker
+	void*                       request;    ///< Worker request buffer
 	void*                       response;   ///< Worker response buffer
+	uint32_t                    n_dropped_requests;   ///< Requests dropped
+	uint32_t                    n_dropped_responses;  ///< Responses dropped
+	bool                        threaded;   ///< Run work in worker thread
 	ZixSem                      sem;        ///< Worker semaphore
 	ZixThread                   thread;     ///< Worker thread
 	const LV2_Worker_Interface* iface;      ///< Plugin worker interface
@@ -173,11 +239,11 @@ typedef struct {
 	Sratom*            sratom;         ///< Atom serialiser
 	Sratom*            ui_sratom;      ///< Atom serialiser for UI thread
 	Symap*             symap;          ///< URI map
-	ZixSem             symap_lock;     ///< Lock for URI map
 	jack_client_t*     jack_client;    ///< Jack client
 	jack_ringbuffer_t* ui_events;      ///< Port events from UI
 	jack_ringbuffer_t* plugin_events;  ///< Port events from plugin
 	void*              ui_event_buf;   ///< Buffer for reading UI port events
+	void*              ui_frame_buf;   ///< Buffer for writing UI port events
 	JalvWorker         worker;         ///< Worker thread implementation
 	ZixSem*            done;           ///< Exit semaphore
 	ZixSem             paused;         ///< Paused signal from process thread
@@ -193,6 +259,7 @@ typedef struct {
 	SuilInstance*      ui_instance;    ///< Plugin UI instance (shared library)
 	void*              window;         ///< Window (if applicable)
 	struct Port*       ports;          ///< Port array of size num_ports
+	JalvPortPlan       plan;           ///< Ports grouped by kind
 	uint32_t           block_length;   ///< Jack buffer size (block length)
 	size_t             midi_buf_size;  ///< Size of MIDI port buffers
 	uint32_t           control_in;     ///< Index of control input port
@@ -213,6 +280,15 @@ typedef struct {
 int
 jalv_init(int* argc, char*** argv, JalvOptions* opts);
 
+bool
+jalv_process_begin(Jalv*                  jalv,
+                   uint32_t               nframes,
+                   bool                   rolling,
+                   const jack_position_t* pos);
+
+void
+jalv_process_end(Jalv* jalv, uint32_t nframes);
+
 void
 jalv_create_ports(Jalv* jalv);
 
@@ -300,6 +376,71 @@ atom_to_turtle(LV2_URID_Unmap* unmap,
                const SerdNode* predicate,
                const LV2_Atom* atom);
 
+/** Return `size` padded to 64 bits. */
+static inline uint32_t
+jalv_pad_size(uint32_t size)
+{
+	return (size + 7U) & ~7U;
+}
+
+/** Copy `size` bytes from `src` to `offset` in the two-part region `vec`. */
+static inline void
+jalv_ring_copy(jack_ringbuffer_data_t* vec,
+               size_t                  offset,
+               const void*             src,
+               size_t                  size)
+{
+	const char* s = (const char*)src;
+	if (offset < vec[0].len) {
+		const size_t space = vec[0].len - offset;
+		const size_t n     = (size < space) ? size : space;
+		memcpy(vec[0].buf + offset, s, n);
+		s      += n;
+		size   -= n;
+		offset  = vec[0].len;
+	}
+	if (size) {
+		memcpy(vec[1].buf + (offset - vec[0].len), s, size);
+	}
+}
+
+/**
+   Write `head` then `body` to `ring`, or nothing if there is not enough space.
+
+   The ring is advanced by `size` bytes, which may be more than the header and
+   body to leave room for padding.  Unlike jack_ringbuffer_write(), this makes
+   all of the data readable at once, so a reader never sees part of it.
+   Realtime safe.
+*/
+static inline bool
+jalv_ring_write_message(jack_ringbuffer_t* ring,
+                        const void*        head,
+                        size_t             head_size,
+                        const void*        body,
+                        size_t             body_size,
+                        size_t             size)
+{
+	jack_ringbuffer_data_t vec[2];
+	jack_ringbuffer_get_write_vector(ring, vec);
+	if (vec[0].len + vec[1].len < size) {
+		return false;
+	}
+
+	jalv_ring_copy(vec, 0, head, head_size);
+	if (body_size) {
+		jalv_ring_copy(vec, head_size, body, body_size);
+	}
+	jack_ringbuffer_write_advance(ring, size);
+	return true;
+}
+
+/** Write `size` bytes to `ring` at once, like jalv_ring_write_message(). */
+static inline bool
+jalv_ring_write(jack_ringbuffer_t* ring, const void* data, size_t size)
+{
+	return jalv_ring_write_message(ring, data, size, NULL, 0, size);
+}
+
 static inline char*
 jalv_strdup(const char* str)
 {
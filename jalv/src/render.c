@@ -0,0 +1,797 @@
+/*
+  Copyright 2015 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/**
+   @file render.c Offline rendering of a plugin from and to files.
+
+   Audio is read from and written to WAV files, and MIDI from and to standard
+   MIDI files.  The same process path used with Jack is run in a tight loop,
+   with a transport that rolls from the start at a constant tempo, so a render
+   with the same inputs and options always produces the same output.
+*/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lv2_evbuf.h"
+#include "render.h"
+
+/** Sample rate used if there is no input audio to take it from. */
+#define RENDER_DEFAULT_RATE 48000
+
+/** Block length used if none is given. */
+#define RENDER_DEFAULT_BLOCK 1024
+
+/** Size of MIDI port buffers, the same as Jack's default. */
+#define RENDER_MIDI_BUF_SIZE 32768
+
+/** Pulses per quarter note in written MIDI files. */
+#define RENDER_PPQN 960
+
+/** Ticks per beat in the transport position sent to the plugin. */
+#define RENDER_TICKS_PER_BEAT 1920.0
+
+/** A MIDI event (or tempo change) read from or to be written to a file. */
+typedef struct {
+	uint64_t time;    ///< Time in frames (or ticks while reading a file)
+	uint32_t seq;     ///< Position in file, to keep order when sorting
+	uint32_t tempo;   ///< Microseconds per quarter note, or 0 for MIDI
+	uint32_t size;    ///< Size of message
+	uint32_t offset;  ///< Offset of message in data
+} RenderEvent;
+
+typedef struct {
+	RenderEvent* events;
+	uint32_t     n_events;
+	uint32_t     events_cap;
+	uint8_t*     data;
+	uint32_t     data_size;
+	uint32_t     data_cap;
+} RenderEvents;
+
+struct JalvRenderImpl {
+	float*       audio_in;       ///< Interleaved input audio
+	uint32_t     n_in_channels;  ///< Number of channels in audio_in
+	uint64_t     n_in_frames;    ///< Number of frames in audio_in
+	RenderEvents midi_in;        ///< Input MIDI, with times in frames
+	RenderEvents midi_out;       ///< Output MIDI, with times in frames
+	float**      buffers;        ///< Buffer for each audio port, or NULL
+	uint32_t     n_buffers;      ///< Number of entries in buffers
+	uint64_t     n_frames;       ///< Number of frames to render
+};
+
+static inline uint32_t
+read_le16(const uint8_t* buf)
+{
+	return (uint32_t)buf[0] | ((uint32_t)buf[1] << 8);
+}
+
+static inline uint32_t
+read_le32(const uint8_t* buf)
+{
+	return read_le16(buf) | (read_le16(buf + 2) << 16);
+}
+
+static inline void
+write_le16(uint8_t* buf, uint32_t val)
+{
+	buf[0] = val & 0xFF;
+	buf[1] = (val >> 8) & 0xFF;
+}
+
+static inline void
+write_le32(uint8_t* buf, uint32_t val)
+{
+	write_le16(buf, val & 0xFFFF);
+	write_le16(buf + 2, val >> 16);
+}
+
+static inline void
+write_be16(uint8_t* buf, uint32_t val)
+{
+	buf[0] = (val >> 8) & 0xFF;
+	buf[1] = val & 0xFF;
+}
+
+static inline void
+write_be32(uint8_t* buf, uint32_t val)
+{
+	write_be16(buf, val >> 16);
+	write_be16(buf + 2, val & 0xFFFF);
+}
+
+/** Read an entire file into a newly allocated buffer. */
+static uint8_t*
+read_file(const char* path, size_t* size)
+{
+	FILE* fd = fopen(path, "rb");
+	if (!fd) {
+		fprintf(stderr, "error: Failed to open %s\n", path);
+		return NULL;
+	}
+
+	uint8_t* buf = NULL;
+	long     len = 0;
+	if (!fseek(fd, 0, SEEK_END) && (len = ftell(fd)) > 0 &&
+	    !fseek(fd, 0, SEEK_SET)) {
+		buf = (uint8_t*)malloc(len);
+		if (fread(buf, 1, len, fd) != (size_t)len) {
+			free(buf);
+			buf = NULL;
+		}
+	}
+
+	fclose(fd);
+	if (!buf) {
+		fprintf(stderr, "error: Failed to read %s\n", path);
+		return NULL;
+	}
+
+	*size = (size_t)len;
+	return buf;
+}
+
+/**
+   Read 16, 24, or 32-bit integer, or 32-bit float audio from a WAV file.
+*/
+static int
+read_wav(JalvRender* render, const char* path, uint32_t* rate)
+{
+	size_t         size = 0;
+	uint8_t* const file = read_file(path, &size);
+	if (!file) {
+		return 1;
+	}
+
+	if (size < 12 || memcmp(file, "RIFF", 4) || memcmp(file + 8, "WAVE", 4)) {
+		fprintf(stderr, "error: %s is not a WAV file\n", path);
+		free(file);
+		return 1;
+	}
+
+	uint32_t       format   = 0;
+	uint32_t       channels = 0;
+	uint32_t       bits     = 0;
+	const uint8_t* data     = NULL;
+	uint32_t       data_len = 0;
+	for (size_t off = 12; off + 8 <= size;) {
+		const uint8_t* const id  = file + off;
+		const uint32_t       len = read_le32(file + off + 4);
+		const uint8_t* const body = file + off + 8;
+		if (len > size - off - 8) {
+			break;  // Truncated chunk
+		} else if (!memcmp(id, "fmt ", 4) && len >= 16) {
+			format   = read_le16(body);
+			channels = read_le16(body + 2);
+			*rate    = read_le32(body + 4);
+			bits     = read_le16(body + 14);
+			if (format == 0xFFFE && len >= 26) {
+				format = read_le16(body + 24);  // WAVE_FORMAT_EXTENSIBLE
+			}
+		} else if (!memcmp(id, "data", 4)) {
+			data     = body;
+			data_len = len;
+		}
+		off += 8 + len + (len & 1);
+	}
+
+	const uint32_t bytes = bits / 8;
+	if (!data || !channels ||
+	    !((format == 1 && (bits == 16 || bits == 24 || bits == 32)) ||
+	      (format == 3 && bits == 32))) {
+		fprintf(stderr, "error: Unsupported WAV format in %s\n", path);
+		free(file);
+		return 1;
+	}
+
+	const uint64_t n_samples = data_len / bytes / channels * channels;
+	render->n_in_channels = channels;
+	render->n_in_frames   = n_samples / channels;
+	render->audio_in      = (float*)malloc(n_samples * sizeof(float));
+	for (uint64_t i = 0; i < n_samples; ++i) {
+		const uint8_t* s = data + i * bytes;
+		float          value;
+		if (format == 3) {
+			const uint32_t word = read_le32(s);
+			memcpy(&value, &word, sizeof(value));
+		} else if (bits == 16) {
+			value = (int16_t)read_le16(s) / 32768.0f;
+		} else if (bits == 24) {
+			const int32_t word = (int32_t)(read_le16(s) << 8 | (uint32_t)s[2] << 24);
+			value = (word >> 8) / 8388608.0f;
+		} else {
+			value = (int32_t)read_le32(s) / 2147483648.0f;
+		}
+		render->audio_in[i] = value;
+	}
+
+	free(file);
+	return 0;
+}
+
+/** Open a 32-bit float WAV file, with sizes set when it is closed. */
+static FILE*
+wav_open(const char* path, uint32_t channels, uint32_t rate)
+{
+	FILE* fd = fopen(path, "wb");
+	if (!fd) {
+		fprintf(stderr, "error: Failed to open %s\n", path);
+		return NULL;
+	}
+
+	uint8_t head[58];
+	memcpy(head, "RIFF", 4);
+	write_le32(head + 4, 50);
+	memcpy(head + 8, "WAVEfmt ", 8);
+	write_le32(head + 16, 18);
+	write_le16(head + 20, 3);  // WAVE_FORMAT_IEEE_FLOAT
+	write_le16(head + 22, channels);
+	write_le32(head + 24, rate);
+	write_le32(head + 28, rate * channels * sizeof(float));
+	write_le16(head + 32, channels * sizeof(float));
+	write_le16(head + 34, 32);
+	write_le16(head + 36, 0);
+	memcpy(head + 38, "fact", 4);
+	write_le32(head + 42, 4);
+	write_le32(head + 46, 0);
+	memcpy(head + 50, "data", 4);
+	write_le32(head + 54, 0);
+	fwrite(head, 1, sizeof(head), fd);
+	return fd;
+}
+
+/** Write the sizes to the header of a WAV file, and close it. */
+static int
+wav_close(FILE* fd, uint32_t channels, uint64_t n_frames)
+{
+	const uint32_t data_len = (uint32_t)(n_frames * channels * sizeof(float));
+	uint8_t        buf[4];
+	int            st = 0;
+
+	write_le32(buf, 50 + data_len);
+	st |= fseek(fd, 4, SEEK_SET) || fwrite(buf, 1, 4, fd) != 4;
+	write_le32(buf, (uint32_t)n_frames);
+	st |= fseek(fd, 46, SEEK_SET) || fwrite(buf, 1, 4, fd) != 4;
+	write_le32(buf, data_len);
+	st |= fseek(fd, 54, SEEK_SET) || fwrite(buf, 1, 4, fd) != 4;
+	st |= fclose(fd);
+	return st;
+}
+
+/**
+   Append an event to `evs` and return a pointer to its (uninitialised) data.
+*/
+static uint8_t*
+events_append(RenderEvents* evs, uint64_t time, uint32_t tempo, uint32_t size)
+{
+	if (evs->n_events == evs->events_cap) {
+		evs->events_cap = evs->events_cap ? evs->events_cap * 2 : 256;
+		evs->events     = (RenderEvent*)realloc(
+			evs->events, evs->events_cap * sizeof(RenderEvent));
+	}
+	while (evs->data_size + size > evs->data_cap) {
+		evs->data_cap = evs->data_cap ? evs->data_cap * 2 : 1024;
+		evs->data     = (uint8_t*)realloc(evs->data, evs->data_cap);
+	}
+
+	RenderEvent* const ev = &evs->events[evs->n_events];
+	ev->time   = time;
+	ev->seq    = evs->n_events++;
+	ev->tempo  = tempo;
+	ev->size   = size;
+	ev->offset = evs->data_size;
+
+	evs->data_size += size;
+	return evs->data + ev->offset;
+}
+
+static void
+events_free(RenderEvents* evs)
+{
+	free(evs->events);
+	free(evs->data);
+}
+
+static int
+event_cmp(const void* a, const void* b)
+{
+	const RenderEvent* const ea = (const RenderEvent*)a;
+	const RenderEvent* const eb = (const RenderEvent*)b;
+	if (ea->time != eb->time) {
+		return (ea->time < eb->time) ? -1 : 1;
+	}
+	return (ea->seq < eb->seq) ? -1 : (ea->seq > eb->seq);
+}
+
+/** Read a variable-length quantity from a MIDI file, or return false. */
+static bool
+read_vlq(const uint8_t** p, const uint8_t* end, uint32_t* val)
+{
+	*val = 0;
+	for (unsigned i = 0; i < 4 && *p < end; ++i) {
+		const uint8_t byte = *(*p)++;
+		*val = (*val << 7) | (byte & 0x7F);
+		if (!(byte & 0x80)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/** Write a variable-length quantity for a MIDI file, and return its size. */
+static uint32_t
+write_vlq(uint8_t* buf, uint32_t val)
+{
+	uint32_t n = 1;
+	for (uint32_t v = val >> 7; v; v >>= 7) {
+		++n;
+	}
+	for (uint32_t i = 0; i < n; ++i) {
+		const uint32_t shift = 7 * (n - i - 1);
+		buf[i] = ((val >> shift) & 0x7F) | ((i < n - 1) ? 0x80 : 0);
+	}
+	return n;
+}
+
+/** Read the events in a MIDI file track, with times in ticks. */
+static bool
+read_smf_track(RenderEvents* evs, const uint8_t* p, const uint8_t* end)
+{
+	uint64_t tick   = 0;
+	uint8_t  status = 0;
+	while (p < end) {
+		uint32_t delta = 0;
+		uint32_t len   = 0;
+		if (!read_vlq(&p, end, &delta) || p == end) {
+			return false;
+		}
+
+		tick += delta;
+		if (*p == 0xFF) {
+			// Meta event, only tempo is relevant
+			if (end - p < 2) {
+				return false;
+			}
+			const uint8_t type = p[1];
+			p += 2;
+			if (!read_vlq(&p, end, &len) || len > (size_t)(end - p)) {
+				return false;
+			} else if (type == 0x51 && len == 3) {
+				const uint32_t tempo = (p[0] << 16) | (p[1] << 8) | p[2];
+				if (tempo) {
+					events_append(evs, tick, tempo, 0);
+				}
+			} else if (type == 0x2F) {
+				return true;  // End of track
+			}
+			p += len;
+		} else if (*p == 0xF0 || *p == 0xF7) {
+			// System exclusive, or an escape which is ignored
+			const uint8_t first = *p++;
+			if (!read_vlq(&p, end, &len) || len > (size_t)(end - p)) {
+				return false;
+			} else if (first == 0xF0) {
+				uint8_t* const msg = events_append(evs, tick, 0, len + 1);
+				msg[0] = 0xF0;
+				memcpy(msg + 1, p, len);
+			}
+			p += len;
+			status = 0;
+		} else {
+			// Channel message, possibly with running status
+			if (*p & 0x80) {
+				status = *p++;
+			} else if (!status) {
+				return false;
+			}
+
+			const uint32_t n_data = ((status & 0xE0) == 0xC0) ? 1 : 2;
+			if ((size_t)(end - p) < n_data) {
+				return false;
+			}
+
+			uint8_t* const msg = events_append(evs, tick, 0, n_data + 1);
+			msg[0] = status;
+			memcpy(msg + 1, p, n_data);
+			p += n_data;
+		}
+	}
+	return true;
+}
+
+/**
+   Read all the events in a MIDI file (of any format) into one sequence.
+*/
+static int
+read_smf(RenderEvents* evs, const char* path, uint32_t rate)
+{
+	size_t         size = 0;
+	uint8_t* const file = read_file(path, &size);
+	if (!file) {
+		return 1;
+	}
+
+	if (size < 14 || memcmp(file, "MThd", 4) || read_le32(file + 4) == 0) {
+		fprintf(stderr, "error: %s is not a MIDI file\n", path);
+		free(file);
+		return 1;
+	}
+
+	const uint8_t* const head     = file + 8;
+	const uint32_t       n_tracks = (head[2] << 8) | head[3];
+	const uint32_t       division = (head[4] << 8) | head[5];
+	size_t               off      = 8 + ((file[4] << 24) | (file[5] << 16) |
+	                                     (file[6] << 8) | file[7]);
+	for (uint32_t t = 0; t < n_tracks && off + 8 <= size; ++t) {
+		const uint8_t* const chunk = file + off;
+		const uint32_t       len   = ((chunk[4] << 24) | (chunk[5] << 16) |
+		                              (chunk[6] << 8) | chunk[7]);
+		if (len > size - off - 8) {
+			fprintf(stderr, "error: Truncated track in %s\n", path);
+			free(file);
+			return 1;
+		} else if (!memcmp(chunk, "MTrk", 4) &&
+		           !read_smf_track(evs, chunk + 8, chunk + 8 + len)) {
+			fprintf(stderr, "error: Invalid track in %s\n", path);
+			free(file);
+			return 1;
+		}
+		off += 8 + len;
+	}
+	free(file);
+
+	if (!evs->n_events) {
+		return 0;
+	}
+
+	// Merge tracks, then convert ticks to frames along the tempo map
+	qsort(evs->events, evs->n_events, sizeof(RenderEvent), event_cmp);
+	if (division & 0x8000) {
+		// SMPTE time, with a fixed number of ticks per second
+		const uint32_t fps   = (uint32_t)(-(int8_t)(division >> 8));
+		const uint32_t per_s = fps * (division & 0xFF);
+		for (uint32_t i = 0; i < evs->n_events; ++i) {
+			evs->events[i].time = evs->events[i].time * rate / per_s;
+		}
+	} else if (division) {
+		// Metrical time, with ticks per quarter note
+		double   usec      = 0.0;
+		uint64_t last_tick = 0;
+		uint32_t tempo     = 500000;
+		for (uint32_t i = 0; i < evs->n_events; ++i) {
+			RenderEvent* const ev = &evs->events[i];
+			usec     += (ev->time - last_tick) * (double)tempo / division;
+			last_tick = ev->time;
+			tempo     = ev->tempo ? ev->tempo : tempo;
+			ev->time  = (uint64_t)(usec * rate / 1000000.0 + 0.5);
+		}
+	}
+
+	return 0;
+}
+
+/**
+   Write a MIDI file with a single track, at the given tempo.
+*/
+static int
+write_smf(const RenderEvents* evs, const char* path, uint32_t rate, float bpm)
+{
+	FILE* fd = fopen(path, "wb");
+	if (!fd) {
+		fprintf(stderr, "error: Failed to open %s\n", path);
+		return 1;
+	}
+
+	// Header, and track with a tempo event to match the transport
+	const uint32_t tempo = (uint32_t)(60000000.0 / bpm + 0.5);
+	uint8_t        head[29];
+	memcpy(head, "MThd", 4);
+	write_be32(head + 4, 6);
+	write_be16(head + 8, 0);
+	write_be16(head + 10, 1);
+	write_be16(head + 12, RENDER_PPQN);
+	memcpy(head + 14, "MTrk", 4);
+	write_be32(head + 18, 0);
+	head[22] = 0x00;
+	head[23] = 0xFF;
+	head[24] = 0x51;
+	head[25] = 0x03;
+	head[26] = (tempo >> 16) & 0xFF;
+	head[27] = (tempo >> 8) & 0xFF;
+	head[28] = tempo & 0xFF;
+	fwrite(head, 1, sizeof(head), fd);
+
+	uint32_t len       = 7;
+	uint64_t last_tick = 0;
+	for (uint32_t i = 0; i < evs->n_events; ++i) {
+		const RenderEvent* const ev   = &evs->events[i];
+		const uint8_t* const     msg  = evs->data + ev->offset;
+		const uint64_t           tick = (uint64_t)(
+			ev->time * (double)bpm * RENDER_PPQN / (60.0 * rate) + 0.5);
+
+		// Delta time, then the message (with a length if it is sysex)
+		uint8_t  buf[11];
+		uint32_t n    = write_vlq(buf, (uint32_t)(tick - last_tick));
+		uint32_t skip = 0;
+		if (msg[0] == 0xF0) {
+			buf[n++] = 0xF0;
+			n       += write_vlq(buf + n, ev->size - 1);
+			skip     = 1;
+		}
+
+		fwrite(buf, 1, n, fd);
+		fwrite(msg + skip, 1, ev->size - skip, fd);
+		len      += n + ev->size - skip;
+		last_tick = tick;
+	}
+
+	// End of track, then the track length
+	static const uint8_t eot[] = { 0x00, 0xFF, 0x2F, 0x00 };
+	fwrite(eot, 1, sizeof(eot), fd);
+	len += sizeof(eot);
+
+	uint8_t len_buf[4];
+	write_be32(len_buf, len);
+	int st = fseek(fd, 18, SEEK_SET) || fwrite(len_buf, 1, 4, fd) != 4;
+	st |= fclose(fd);
+	if (st) {
+		fprintf(stderr, "error: Failed to write %s\n", path);
+	}
+	return st;
+}
+
+JalvRender*
+jalv_render_new(Jalv* jalv)
+{
+	JalvRender* render = (JalvRender*)calloc(1, sizeof(JalvRender));
+
+	// Use the sample rate of the input audio unless one is given
+	uint32_t file_rate = 0;
+	if (jalv->opts.audio_in && read_wav(render, jalv->opts.audio_in, &file_rate)) {
+		jalv_render_free(render);
+		return NULL;
+	}
+
+	jalv->sample_rate = (jalv->opts.sample_rate ? jalv->opts.sample_rate :
+	                     file_rate ? file_rate : RENDER_DEFAULT_RATE);
+	if (file_rate && file_rate != jalv->sample_rate) {
+		fprintf(stderr, "warning: Input sample rate %u differs from %u, "
+		        "input will not be resampled\n", file_rate, jalv->sample_rate);
+	}
+
+	jalv->block_length  = (jalv->opts.block_length ? jalv->opts.block_length
+	                       : RENDER_DEFAULT_BLOCK);
+	jalv->midi_buf_size = RENDER_MIDI_BUF_SIZE;
+
+	if (jalv->opts.midi_in &&
+	    read_smf(&render->midi_in, jalv->opts.midi_in, jalv->sample_rate)) {
+		jalv_render_free(render);
+		return NULL;
+	}
+
+	// Render the given length, or until the end of the input
+	if (jalv->opts.length > 0.0) {
+		render->n_frames = (uint64_t)(jalv->opts.length * jalv->sample_rate);
+	} else {
+		render->n_frames = render->n_in_frames;
+		if (render->midi_in.n_events) {
+			const RenderEvent* last =
+				&render->midi_in.events[render->midi_in.n_events - 1];
+			if (last->time + 1 > render->n_frames) {
+				render->n_frames = last->time + 1;
+			}
+		}
+	}
+
+	if (!render->n_frames) {
+		fprintf(stderr, "error: Nothing to render, set a length with -t\n");
+		jalv_render_free(render);
+		return NULL;
+	}
+
+	printf("Sample rate:  %u Hz\n", jalv->sample_rate);
+	printf("Render:       %lu frames\n", (unsigned long)render->n_frames);
+	return render;
+}
+
+int
+jalv_render_run(JalvRender* render, Jalv* jalv)
+{
+	const uint32_t            block       = jalv->block_length;
+	const uint32_t            rate        = jalv->sample_rate;
+	const JalvPortPlan* const plan        = &jalv->plan;
+	const uint32_t            n_audio_in  = plan->audio_in.n_ports;
+	const uint32_t            n_audio_out = plan->audio_out.n_ports;
+
+	// Connect audio ports to buffers
+	render->buffers   = (float**)calloc(jalv->num_ports, sizeof(float*));
+	render->n_buffers = jalv->num_ports;
+	const JalvPortList* const audio[] = { &plan->audio_in, &plan->audio_out };
+	for (unsigned a = 0; a < 2; ++a) {
+		for (uint32_t i = 0; i < audio[a]->n_ports; ++i) {
+			const uint32_t index = audio[a]->ports[i]->index;
+			render->buffers[index] = (float*)calloc(block, sizeof(float));
+			lilv_instance_connect_port(
+				jalv->instance, index, render->buffers[index]);
+		}
+	}
+
+	// Find the MIDI input port
+	struct Port* midi_in = NULL;
+	for (uint32_t i = 0; i < plan->event_in.n_ports && !midi_in; ++i) {
+		struct Port* const port = plan->event_in.ports[i];
+		if (lilv_port_supports_event(jalv->plugin, port->lilv_port,
+		                             jalv->nodes.midi_MidiEvent)) {
+			midi_in = port;
+		}
+	}
+
+	if (render->audio_in && !n_audio_in) {
+		fprintf(stderr, "warning: Plugin has no audio inputs\n");
+	}
+	if (render->midi_in.n_events && !midi_in) {
+		fprintf(stderr, "warning: Plugin has no MIDI input\n");
+	}
+
+	FILE*    wav     = NULL;
+	uint8_t* wav_buf = NULL;
+	if (jalv->opts.audio_out) {
+		if (!(wav = wav_open(jalv->opts.audio_out, n_audio_out, rate))) {
+			return 1;
+		}
+		wav_buf = (uint8_t*)malloc(block * n_audio_out * sizeof(float));
+	}
+
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	uint32_t n_dropped = 0;
+	uint32_t next      = 0;
+	for (uint64_t offset = 0; offset < render->n_frames; offset += block) {
+		// Roll the transport from the start at a constant tempo in 4/4
+		const double    beats = offset * (double)jalv->bpm / (60.0 * rate);
+		const uint64_t  whole = (uint64_t)beats;
+		jack_position_t pos;
+		memset(&pos, '\0', sizeof(pos));
+		pos.frame            = (jack_nframes_t)offset;
+		pos.frame_rate       = rate;
+		pos.valid            = JackPositionBBT;
+		pos.bar              = (int32_t)(whole / 4) + 1;
+		pos.beat             = (int32_t)(whole % 4) + 1;
+		pos.tick             = (int32_t)((beats - whole) * RENDER_TICKS_PER_BEAT);
+		pos.beats_per_bar    = 4.0f;
+		pos.beat_type        = 4.0f;
+		pos.ticks_per_beat   = RENDER_TICKS_PER_BEAT;
+		pos.beats_per_minute = jalv->bpm;
+
+		jalv_process_begin(jalv, block, true, &pos);
+
+		// Copy input audio, with silence past the end of the input
+		for (uint32_t c = 0; c < n_audio_in; ++c) {
+			float* const buf = render->buffers[plan->audio_in.ports[c]->index];
+			for (uint32_t f = 0; f < block; ++f) {
+				const uint64_t frame = offset + f;
+				buf[f] = ((c < render->n_in_channels &&
+				           frame < render->n_in_frames)
+				          ? render->audio_in[frame * render->n_in_channels + c]
+				          : 0.0f);
+			}
+		}
+
+		// Write input MIDI events in this block
+		const RenderEvents* const evs  = &render->midi_in;
+		LV2_Evbuf_Iterator        iter = { NULL, 0 };
+		if (midi_in) {
+			iter = lv2_evbuf_end(midi_in->evbuf);
+		}
+		for (; next < evs->n_events && evs->events[next].time < offset + block;
+		     ++next) {
+			const RenderEvent* const ev = &evs->events[next];
+			if (midi_in && !ev->tempo &&
+			    !lv2_evbuf_write(&iter, (uint32_t)(ev->time - offset), 0,
+			                     jalv->midi_event_id,
+			                     ev->size, evs->data + ev->offset)) {
+				++n_dropped;
+			}
+		}
+
+		jalv_process_end(jalv, block);
+
+		// Collect output MIDI events
+		for (uint32_t o = 0; jalv->opts.midi_out && o < plan->event_out.n_ports;
+		     ++o) {
+			struct Port* const port = plan->event_out.ports[o];
+			for (LV2_Evbuf_Iterator i = lv2_evbuf_begin(port->evbuf);
+			     lv2_evbuf_is_valid(i);
+			     i = lv2_evbuf_next(i)) {
+				uint32_t frames, subframes, type, size;
+				uint8_t* body;
+				lv2_evbuf_get(i, &frames, &subframes, &type, &size, &body);
+				if (type == jalv->midi_event_id && size > 0) {
+					memcpy(events_append(&render->midi_out,
+					                     offset + frames, 0, size),
+					       body, size);
+				}
+			}
+		}
+
+		// Write output audio, up to the end of the render
+		if (wav) {
+			const uint64_t left = render->n_frames - offset;
+			const uint32_t n    = (left < block) ? (uint32_t)left : block;
+			uint8_t*       out  = wav_buf;
+			for (uint32_t f = 0; f < n; ++f) {
+				for (uint32_t c = 0; c < n_audio_out; ++c) {
+					const uint32_t index = plan->audio_out.ports[c]->index;
+					uint32_t       word;
+					memcpy(&word, &render->buffers[index][f], sizeof(word));
+					write_le32(out, word);
+					out += sizeof(word);
+				}
+			}
+			fwrite(wav_buf, 1, out - wav_buf, wav);
+		}
+	}
+
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	const double elapsed = ((end.tv_sec - start.tv_sec) +
+	                        (end.tv_nsec - start.tv_nsec) * 0.000000001);
+	const double length  = render->n_frames / (double)rate;
+
+	int st = 0;
+	if (wav && wav_close(wav, n_audio_out, render->n_frames)) {
+		fprintf(stderr, "error: Failed to write %s\n", jalv->opts.audio_out);
+		st = 1;
+	}
+	free(wav_buf);
+
+	if (jalv->opts.midi_out) {
+		// Events from several ports may be out of order
+		if (render->midi_out.n_events) {
+			qsort(render->midi_out.events, render->midi_out.n_events,
+			      sizeof(RenderEvent), event_cmp);
+		}
+		st |= write_smf(&render->midi_out, jalv->opts.midi_out, rate, jalv->bpm);
+	}
+
+	if (n_dropped) {
+		fprintf(stderr, "warning: Dropped %u MIDI input events\n", n_dropped);
+	}
+
+	printf("Rendered %.3f s in %.3f s (%.1f times realtime)\n",
+	       length, elapsed, elapsed > 0.0 ? length / elapsed : 0.0);
+	return st;
+}
+
+void
+jalv_render_free(JalvRender* render)
+{
+	if (render) {
+		free(render->audio_in);
+		events_free(&render->midi_in);
+		events_free(&render->midi_out);
+		for (uint32_t i = 0; i < render->n_buffers; ++i) {
+			free(render->buffers[i]);
+		}
+		free(render->buffers);
+		free(render);
+	}
+}
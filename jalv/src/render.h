@@ -0,0 +1,52 @@
+/*
+  Copyright 2015 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#ifndef JALV_RENDER_H
+#define JALV_RENDER_H
+
+#include "jalv_internal.h"
+
+/**
+   Offline renderer, which runs the plugin without Jack.
+*/
+typedef struct JalvRenderImpl JalvRender;
+
+/**
+   Prepare to render offline.
+
+   This reads the input files given in the options, and sets the sample rate
+   and buffer sizes that would otherwise come from Jack.  Returns NULL on error.
+*/
+JalvRender*
+jalv_render_new(Jalv* jalv);
+
+/**
+   Run the activated plugin as fast as possible and write the output files.
+
+   The plugin is run in fixed-size blocks with a rolling transport, from input
+   files rather than Jack ports, and the throughput is printed when finished.
+   Returns 0 on success.
+*/
+int
+jalv_render_run(JalvRender* render, Jalv* jalv);
+
+/**
+   Free a renderer (which may be NULL).
+*/
+void
+jalv_render_free(JalvRender* render);
+
+#endif /* JALV_RENDER_H */
@@ -171,14 +171,12 @@ set_port_value(const char* port_symbol,
 	}
 
 	if (jalv->has_ui) {
-		// Update UI
-		char buf[sizeof(ControlChange) + sizeof(fvalue)];
-		ControlChange* ev = (ControlChange*)buf;
-		ev->index    = port->index;
-		ev->protocol = 0;
-		ev->size     = sizeof(fvalue);
-		*(float*)ev->body = fvalue;
-		jack_ringbuffer_write(jalv->plugin_events, buf, sizeof(buf));
+		// Update UI (the process thread is paused, so it is not writing)
+		struct {
+			JalvUIFrame      head;
+			JalvControlValue value;
+		} frame = { { 1, 0 }, { port->index, fvalue } };
+		jalv_ring_write(jalv->plugin_events, &frame, sizeof(frame));
 	}
 }
 
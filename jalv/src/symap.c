@@ -1,5 +1,5 @@
 /*
-  Copyright 2011-2014 David Robillard <http://drobilla.net>
+  Copyright 2011-2015 David Robillard <http://drobilla.net>
 
   Permission to use, copy, modify, and/or distribute this software for any
   purpose with or without fee is hereby granted, provided that the above
@@ -19,61 +19,132 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "zix/sem.h"
+
 #include "symap.h"
 
 /**
   @file symap.c Implementation of Symap, a basic symbol map (string interner).
 
-  This implementation is primitive, but has some desirable qualities: good
-  (O(lg(n)) lookup performance for already-mapped symbols, minimal space
-  overhead, extremely fast (O(1)) reverse mapping (ID to string), simple code,
-  no dependencies.
-
-  The tradeoff is that mapping new symbols may be quite slow.  In other words,
-  this implementation is ideal for use cases with a relatively limited set of
-  symbols, or where most symbols are mapped early.  It will not fare so well
-  with very dynamic sets of symbols.  For that, you're better off with a
-  tree-based implementation (and the associated space cost, especially if you
-  need reverse mapping).
+  Symbols are found with an open addressing hash table of IDs, and the symbol
+  for an ID is found in a table of entries which is never moved, so both
+  mapping existing symbols and unmapping are O(1).
+
+  Lookups never block.  Only mapping a new symbol takes a lock, which
+  serialises writers.  A writer fully initialises an entry before publishing
+  its ID in the hash table, and replaces the table with a larger one (rather
+  than growing it in place) when it becomes half full.  A reader which misses
+  a symbol because it raced with a writer, or was still looking in an old
+  table, simply falls back to the locked path.  Old tables are kept until the
+  map is freed, which costs less memory than the current table.
 */
 
+/** Number of entries in the first chunk, which must be a power of 2. */
+#define SYMAP_CHUNK_BITS 6
+#define SYMAP_CHUNK_SIZE (1u << SYMAP_CHUNK_BITS)
+
+/** Number of chunks, enough for every 32-bit ID. */
+#define SYMAP_N_CHUNKS (32 - SYMAP_CHUNK_BITS + 1)
+
+/** Initial number of hash table slots, which must be a power of 2. */
+#define SYMAP_INITIAL_SLOTS 64
+
+#define SYMAP_LOAD(ptr)       __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define SYMAP_STORE(ptr, val) __atomic_store_n((ptr), (val), __ATOMIC_RELEASE)
+
+typedef struct {
+	char*    symbol;
+	uint32_t hash;
+} SymapEntry;
+
+/** Hash table of IDs, where 0 is an empty slot. */
+typedef struct SymapTableImpl {
+	struct SymapTableImpl* prev;   ///< Previous (smaller) table, or NULL
+	uint32_t               mask;   ///< Number of slots - 1
+	uint32_t               slots[];
+} SymapTable;
+
 struct SymapImpl {
 	/**
-	   Unsorted array of strings, such that the symbol for ID i is found
-	   at symbols[i - 1].
+	   Entries, in chunks which double in size, such that the entry for ID i
+	   is the (i - 1)th entry overall.  Chunks are never moved or freed.
 	*/
-	char** symbols;
+	SymapEntry* chunks[SYMAP_N_CHUNKS];
 
 	/**
-	   Array of IDs, sorted by corresponding string in `symbols`.
+	   Current hash table.
 	*/
-	uint32_t* index;
+	SymapTable* table;
 
 	/**
-	   Number of symbols (number of items in `symbols` and `index`).
+	   Number of symbols (and the highest ID).
 	*/
 	uint32_t size;
+
+	/**
+	   Lock for mapping new symbols.
+	*/
+	ZixSem lock;
 };
 
+/** FNV-1a hash of a string. */
+static uint32_t
+symap_hash(const char* str)
+{
+	uint32_t h = 2166136261u;
+	for (const unsigned char* s = (const unsigned char*)str; *s; ++s) {
+		h = (h ^ *s) * 16777619u;
+	}
+	return h;
+}
+
+/** Return the entry for `id`, which must be in range. */
+static inline SymapEntry*
+symap_entry(const Symap* map, uint32_t id)
+{
+	// Entry i is in chunk floor(log2(i + CHUNK_SIZE)) - CHUNK_BITS
+	const uint32_t i     = id - 1 + SYMAP_CHUNK_SIZE;
+	const unsigned chunk = (31 - __builtin_clz(i)) - SYMAP_CHUNK_BITS;
+	SymapEntry*    base  = SYMAP_LOAD(&map->chunks[chunk]);
+	return &base[i - (SYMAP_CHUNK_SIZE << chunk)];
+}
+
+static SymapTable*
+symap_table_new(uint32_t n_slots)
+{
+	SymapTable* table = (SymapTable*)calloc(
+		1, sizeof(SymapTable) + n_slots * sizeof(uint32_t));
+	table->mask = n_slots - 1;
+	return table;
+}
+
 Symap*
 symap_new(void)
 {
-	Symap* map = (Symap*)malloc(sizeof(Symap));
-	map->symbols = NULL;
-	map->index   = NULL;
-	map->size    = 0;
+	Symap* map = (Symap*)calloc(1, sizeof(Symap));
+	map->table = symap_table_new(SYMAP_INITIAL_SLOTS);
+	zix_sem_init(&map->lock, 1);
 	return map;
 }
 
 void
 symap_free(Symap* map)
 {
-	for (uint32_t i = 0; i < map->size; ++i) {
-		free(map->symbols[i]);
+	for (uint32_t id = 1; id <= map->size; ++id) {
+		free(symap_entry(map, id)->symbol);
 	}
 
-	free(map->symbols);
-	free(map->index);
+	for (unsigned i = 0; i < SYMAP_N_CHUNKS; ++i) {
+		free(map->chunks[i]);
+	}
+
+	for (SymapTable* t = map->table; t;) {
+		SymapTable* const prev = t->prev;
+		free(t);
+		t = prev;
+	}
+
+	zix_sem_destroy(&map->lock);
 	free(map);
 }
 
@@ -87,97 +158,109 @@ symap_strdup(const char* str)
 }
 
 /**
-   Return the index into map->index (not the ID) corresponding to `sym`,
-   or the index where a new entry for `sym` should be inserted.
+   Return the slot in `table` which contains the ID for `sym`, or the empty
+   slot where it should be inserted.  Safe to call concurrently with writers.
 */
-static uint32_t
-symap_search(const Symap* map, const char* sym, bool* exact)
+static uint32_t*
+symap_search(const Symap* map,
+             SymapTable*  table,
+             const char*  sym,
+             uint32_t     hash)
 {
-	*exact = false;
-	if (map->size == 0) {
-		return 0;  // Empty map, insert at 0
-	} else if (strcmp(map->symbols[map->index[map->size - 1] - 1], sym) < 0) {
-		return map->size;  // Greater than last element, append
-	}
-
-	uint32_t lower = 0;
-	uint32_t upper = map->size - 1;
-	uint32_t i     = upper;
-	int      cmp;
-
-	while (upper >= lower) {
-		i   = lower + ((upper - lower) / 2);
-		cmp = strcmp(map->symbols[map->index[i] - 1], sym);
-
-		if (cmp == 0) {
-			*exact = true;
-			return i;
-		} else if (cmp > 0) {
-			if (i == 0) {
-				break;  // Avoid underflow
+	for (uint32_t i = hash & table->mask;; i = (i + 1) & table->mask) {
+		const uint32_t id = SYMAP_LOAD(&table->slots[i]);
+		if (id == 0) {
+			return &table->slots[i];
+		}
+
+		const SymapEntry* entry = symap_entry(map, id);
+		if (entry->hash == hash && !strcmp(entry->symbol, sym)) {
+			return &table->slots[i];
+		}
+	}
+}
+
+/** Replace the hash table with one twice the size (called with lock held). */
+static void
+symap_grow(Symap* map)
+{
+	SymapTable* const old   = map->table;
+	SymapTable* const table = symap_table_new((old->mask + 1) * 2);
+	for (uint32_t id = 1; id <= map->size; ++id) {
+		const SymapEntry* entry = symap_entry(map, id);
+		for (uint32_t i = entry->hash & table->mask;;
+		     i = (i + 1) & table->mask) {
+			if (!table->slots[i]) {
+				table->slots[i] = id;
+				break;
 			}
-			upper = i - 1;
-		} else {
-			lower = ++i;
 		}
 	}
 
-	assert(!*exact || strcmp(map->symbols[map->index[i] - 1], sym) > 0);
-	return i;
+	table->prev = old;
+	SYMAP_STORE(&map->table, table);
 }
 
 uint32_t
 symap_try_map(Symap* map, const char* sym)
 {
-	bool           exact;
-	const uint32_t index = symap_search(map, sym, &exact);
-	if (exact) {
-		assert(!strcmp(map->symbols[map->index[index]], sym));
-		return map->index[index];
-	}
-
-	return 0;
+	const uint32_t hash = symap_hash(sym);
+	return SYMAP_LOAD(symap_search(map, SYMAP_LOAD(&map->table), sym, hash));
 }
 
 uint32_t
 symap_map(Symap* map, const char* sym)
 {
-	bool           exact;
-	const uint32_t index = symap_search(map, sym, &exact);
-	if (exact) {
-		assert(!strcmp(map->symbols[map->index[index] - 1], sym));
-		return map->index[index];
+	const uint32_t hash = symap_hash(sym);
+	uint32_t       id   = SYMAP_LOAD(
+		symap_search(map, SYMAP_LOAD(&map->table), sym, hash));
+	if (id) {
+		return id;  // Already mapped, no need to lock
 	}
 
-	const uint32_t id  = ++map->size;
-	char* const    str = symap_strdup(sym);
+	zix_sem_wait(&map->lock);
 
-	/* Append new symbol to symbols array */
-	map->symbols = (char**)realloc(map->symbols, map->size * sizeof(str));
-	map->symbols[id - 1] = str;
+	// Search again, another thread may have mapped sym in the meantime
+	uint32_t* slot = symap_search(map, map->table, sym, hash);
+	if ((id = *slot)) {
+		zix_sem_post(&map->lock);
+		return id;
+	}
 
-	/* Insert new index element into sorted index */
-	map->index = (uint32_t*)realloc(map->index, map->size * sizeof(uint32_t));
-	if (index < map->size - 1) {
-		memmove(map->index + index + 1,
-		        map->index + index,
-		        (map->size - index - 1) * sizeof(uint32_t));
+	// Allocate a new chunk if necessary and initialise entry
+	id = map->size + 1;
+	const uint32_t i     = id - 1 + SYMAP_CHUNK_SIZE;
+	const unsigned chunk = (31 - __builtin_clz(i)) - SYMAP_CHUNK_BITS;
+	if (!map->chunks[chunk]) {
+		SYMAP_STORE(&map->chunks[chunk],
+		            (SymapEntry*)malloc((SYMAP_CHUNK_SIZE << chunk) *
+		                                sizeof(SymapEntry)));
 	}
 
-	map->index[index] = id;
+	SymapEntry* const entry = symap_entry(map, id);
+	entry->symbol = symap_strdup(sym);
+	entry->hash   = hash;
+
+	// Publish entry
+	SYMAP_STORE(&map->size, id);
+	SYMAP_STORE(slot, id);
 
+	// Keep the table at most half full so probe sequences stay short
+	if (id * 2 > map->table->mask + 1) {
+		symap_grow(map);
+	}
+
+	zix_sem_post(&map->lock);
 	return id;
 }
 
 const char*
 symap_unmap(Symap* map, uint32_t id)
 {
-	if (id == 0) {
+	if (id == 0 || id > SYMAP_LOAD(&map->size)) {
 		return NULL;
-	} else if (id <= map->size) {
-		return map->symbols[id - 1];
 	}
-	return NULL;
+	return symap_entry(map, id)->symbol;
 }
 
 #ifdef STANDALONE
@@ -188,9 +271,8 @@ static void
 symap_dump(Symap* map)
 {
 	fprintf(stderr, "{\n");
-	for (uint32_t i = 0; i < map->size; ++i) {
-		fprintf(stderr, "\t%u = %s\n",
-		        map->index[i], map->symbols[map->index[i] - 1]);
+	for (uint32_t id = 1; id <= map->size; ++id) {
+		fprintf(stderr, "\t%u = %s\n", id, symap_unmap(map, id));
 	}
 	fprintf(stderr, "}\n");
 }
@@ -211,7 +293,7 @@ main()
 		}
 
 		const uint32_t id = symap_map(map, syms[i]);
-		if (strcmp(map->symbols[id - 1], syms[i])) {
+		if (strcmp(symap_unmap(map, id), syms[i])) {
 			fprintf(stderr, "error: Corrupt symbol table\n");
 			return 1;
 		}
@@ -221,9 +303,37 @@ main()
 			return 1;
 		}
 
+		if (symap_try_map(map, syms[i]) != id) {
+			fprintf(stderr, "error: Failed to find mapped symbol\n");
+			return 1;
+		}
+
 		symap_dump(map);
 	}
 
+	// Enough symbols to grow the table and allocate several chunks
+	char buf[32];
+	for (uint32_t i = 0; i < 10000; ++i) {
+		snprintf(buf, sizeof(buf), "sym%u", i);
+		const uint32_t id = symap_map(map, buf);
+		if (id != N_SYMS + i + 1 || strcmp(symap_unmap(map, id), buf)) {
+			fprintf(stderr, "error: Bad ID for `%s'\n", buf);
+			return 1;
+		}
+	}
+
+	for (int i = 0; i < N_SYMS; ++i) {
+		if (symap_try_map(map, syms[i]) != (uint32_t)i + 1) {
+			fprintf(stderr, "error: Lost symbol `%s'\n", syms[i]);
+			return 1;
+		}
+	}
+
+	if (symap_unmap(map, 0) || symap_unmap(map, N_SYMS + 10001)) {
+		fprintf(stderr, "error: Unmapped invalid ID\n");
+		return 1;
+	}
+
 	symap_free(map);
 	return 0;
 }
@@ -1,5 +1,5 @@
 /*
-  Copyright 2011-2012 David Robillard <http://drobilla.net>
+  Copyright 2011-2015 David Robillard <http://drobilla.net>
 
   Permission to use, copy, modify, and/or distribute this software for any
   purpose with or without fee is hereby granted, provided that the above
@@ -17,7 +17,9 @@
 /**
    @file symap.h API for Symap, a basic symbol map (string interner).
 
-   Particularly useful for implementing LV2 URI mapping.
+   Particularly useful for implementing LV2 URI mapping.  All functions except
+   symap_new() and symap_free() may be called concurrently from any thread.
+   Only mapping a new symbol may block.
 
    @see <a href="http://lv2plug.in/ns/ext/urid">LV2 URID</a>
    @see <a href="http://lv2plug.in/ns/ext/uri-map">LV2 URI Map</a>
@@ -46,6 +48,7 @@ symap_free(Symap* map);
 
 /**
    Map a string to a symbol ID if it is already mapped, otherwise return 0.
+   This never blocks or allocates.
 */
 uint32_t
 symap_try_map(Symap* map, const char* sym);
@@ -53,7 +56,8 @@ symap_try_map(Symap* map, const char* sym);
 /**
    Map a string to a symbol ID.
 
-   Note that 0 is never a valid symbol ID.
+   This never blocks if `sym` is already mapped, otherwise it allocates and
+   briefly locks the map.  Note that 0 is never a valid symbol ID.
 */
 uint32_t
 symap_map(Symap* map, const char* sym);
@@ -61,7 +65,7 @@ symap_map(Symap* map, const char* sym);
 /**
    Unmap a symbol ID back to a symbol, or NULL if no such ID exists.
 
-   Note that 0 is never a valid symbol ID.
+   This never blocks or allocates.  Note that 0 is never a valid symbol ID.
 */
 const char*
 symap_unmap(Symap* map, uint32_t id);
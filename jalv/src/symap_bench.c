@@ -0,0 +1,179 @@
+/*
+  Copyright 2015 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/**
+   @file symap_bench.c Benchmark for mapping URIs from several threads.
+
+   Every thread maps the same set of URIs, starting at a different point, so
+   threads race to map new URIs at first and then mostly look up URIs mapped
+   by others.  A second pass maps every URI again, which only looks them up.
+   Both passes are run with the map used directly, and with every call
+   wrapped in a single lock as jalv used to do.
+*/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "zix/sem.h"
+#include "zix/thread.h"
+
+#include "symap.h"
+
+typedef struct {
+	Symap*    map;
+	ZixSem*   lock;    ///< Lock around every call, or NULL
+	char**    uris;
+	uint32_t  n_uris;
+	uint32_t  offset;  ///< Index of first URI to map
+	uint32_t* ids;     ///< Output, ID of each URI
+	bool      error;
+} Task;
+
+static double
+elapsed(const struct timespec* start)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((now.tv_sec - start->tv_sec)
+	        + (now.tv_nsec - start->tv_nsec) * 0.000000001);
+}
+
+static inline uint32_t
+map_uri(Task* task, const char* uri)
+{
+	if (task->lock) {
+		zix_sem_wait(task->lock);
+	}
+	const uint32_t id = symap_map(task->map, uri);
+	if (task->lock) {
+		zix_sem_post(task->lock);
+	}
+	return id;
+}
+
+static void*
+run(void* data)
+{
+	Task* task = (Task*)data;
+	for (uint32_t n = 0; n < task->n_uris; ++n) {
+		const uint32_t i  = (task->offset + n) % task->n_uris;
+		const uint32_t id = map_uri(task, task->uris[i]);
+		if (!id || strcmp(symap_unmap(task->map, id), task->uris[i])) {
+			task->error = true;
+		}
+		task->ids[i] = id;
+	}
+	return NULL;
+}
+
+/** Run both passes, returning non-zero if the threads disagree on an ID. */
+static int
+bench(const char* name,
+      char**      uris,
+      uint32_t    n_uris,
+      unsigned    n_threads,
+      bool        locked)
+{
+	Symap*     map     = symap_new();
+	ZixSem     lock;
+	ZixThread* threads = (ZixThread*)calloc(n_threads, sizeof(ZixThread));
+	Task*      tasks   = (Task*)calloc(n_threads, sizeof(Task));
+	zix_sem_init(&lock, 1);
+	for (unsigned t = 0; t < n_threads; ++t) {
+		tasks[t].map    = map;
+		tasks[t].lock   = locked ? &lock : NULL;
+		tasks[t].uris   = uris;
+		tasks[t].n_uris = n_uris;
+		tasks[t].offset = (uint32_t)((uint64_t)n_uris * t / n_threads);
+		tasks[t].ids    = (uint32_t*)calloc(n_uris, sizeof(uint32_t));
+	}
+
+	double times[2];
+	for (unsigned pass = 0; pass < 2; ++pass) {
+		struct timespec start;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (unsigned t = 0; t < n_threads; ++t) {
+			zix_thread_create(&threads[t], 64 * 1024, run, &tasks[t]);
+		}
+		for (unsigned t = 0; t < n_threads; ++t) {
+			zix_thread_join(threads[t], NULL);
+		}
+		times[pass] = elapsed(&start);
+	}
+
+	int ret = 0;
+	for (unsigned t = 0; t < n_threads; ++t) {
+		if (tasks[t].error ||
+		    memcmp(tasks[t].ids, tasks[0].ids, n_uris * sizeof(uint32_t))) {
+			fprintf(stderr, "error: Inconsistent mapping in thread %u\n", t);
+			ret = 1;
+		}
+	}
+
+	const double n_calls = (double)n_uris * n_threads;
+	printf("%-10s %10.6f s  %8.1f ns/call  %10.6f s  %8.1f ns/call\n",
+	       name,
+	       times[0], times[0] * 1e9 / n_calls,
+	       times[1], times[1] * 1e9 / n_calls);
+
+	for (unsigned t = 0; t < n_threads; ++t) {
+		free(tasks[t].ids);
+	}
+
+	zix_sem_destroy(&lock);
+	free(tasks);
+	free(threads);
+	symap_free(map);
+	return ret;
+}
+
+int
+main(int argc, char** argv)
+{
+	if (argc > 3 || (argc > 1 && !strcmp(argv[1], "-h"))) {
+		fprintf(stderr, "Usage: %s [THREADS] [URIS]\n", argv[0]);
+		return 1;
+	}
+
+	const unsigned n_threads = (argc > 1) ? (unsigned)atoi(argv[1]) : 4;
+	const uint32_t n_uris    = (argc > 2) ? (uint32_t)atoi(argv[2]) : 100000;
+	if (n_threads < 1 || n_uris < 1) {
+		fprintf(stderr, "error: Invalid number of threads or URIs\n");
+		return 1;
+	}
+
+	char** uris = (char**)malloc(n_uris * sizeof(char*));
+	for (uint32_t i = 0; i < n_uris; ++i) {
+		uris[i] = (char*)malloc(64);
+		snprintf(uris[i], 64, "http://example.org/ns/bench#uri%u", i);
+	}
+
+	printf("%u threads, %u URIs\n", n_threads, n_uris);
+	printf("%-10s %-32s %s\n", "", "First map", "Lookup");
+	int ret = bench("Locked", uris, n_uris, n_threads, true);
+	ret |= bench("Lock-free", uris, n_uris, n_threads, false);
+
+	for (uint32_t i = 0; i < n_uris; ++i) {
+		free(uris[i]);
+	}
+	free(uris);
+	return ret;
+}
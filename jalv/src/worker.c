@@ -1,5 +1,5 @@
 /*
-  Copyright 2007-2013 David Robillard <http://drobilla.net>
+  Copyright 2007-2015 David Robillard <http://drobilla.net>
 
   Permission to use, copy, modify, and/or distribute this software for any
   purpose with or without fee is hereby granted, provided that the above
@@ -14,72 +14,111 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include <stdio.h>
+
 #include "worker.h"
 
+/** Header of a message in the worker rings, which is followed by the body. */
+typedef struct {
+	uint32_t size;  ///< Size of body
+	uint32_t pad;   ///< Padding, so the body is 64-bit aligned
+} JalvWorkerHeader;
+
+/** Size of a message with a body of `size` bytes, padded to 64 bits. */
+static inline uint32_t
+jalv_worker_message_size(uint32_t size)
+{
+	return sizeof(JalvWorkerHeader) + ((size + 7U) & ~7U);
+}
+
+/**
+   Write a message to `ring`, or return false if there is not enough space.
+   Realtime safe.
+*/
+static bool
+jalv_worker_write(jack_ringbuffer_t* ring, uint32_t size, const void* data)
+{
+	const JalvWorkerHeader head = { size, 0 };
+	return jalv_ring_write_message(ring, &head, sizeof(head), data, size,
+	                               jalv_worker_message_size(size));
+}
+
 static LV2_Worker_Status
 jalv_worker_respond(LV2_Worker_Respond_Handle handle,
                     uint32_t                  size,
                     const void*               data)
 {
 	Jalv* jalv = (Jalv*)handle;
-	jack_ringbuffer_write(jalv->worker.responses,
-	                      (const char*)&size, sizeof(size));
-	jack_ringbuffer_write(jalv->worker.responses, (const char*)data, size);
+	if (!jalv_worker_write(jalv->worker.responses, size, data)) {
+		++jalv->worker.n_dropped_responses;
+		return LV2_WORKER_ERR_NO_SPACE;
+	}
 	return LV2_WORKER_SUCCESS;
 }
 
 static void*
 worker_func(void* data)
 {
-	Jalv* jalv = (Jalv*)data;
-	void* buf  = NULL;
+	Jalv*       jalv   = (Jalv*)data;
+	JalvWorker* worker = &jalv->worker;
 	while (true) {
-		zix_sem_wait(&jalv->worker.sem);
+		zix_sem_wait(&worker->sem);
 		if (jalv->exit) {
 			break;
 		}
 
-		uint32_t size = 0;
-		jack_ringbuffer_read(jalv->worker.requests, (char*)&size, sizeof(size));
-
-		if (!(buf = realloc(buf, size))) {
-			fprintf(stderr, "error: realloc() failed\n");
-			free(buf);
-			return NULL;
-		}
-
-		jack_ringbuffer_read(jalv->worker.requests, (char*)buf, size);
+		// Messages are written at once, so a whole one is available
+		JalvWorkerHeader head;
+		jack_ringbuffer_read(worker->requests, (char*)&head, sizeof(head));
+		jack_ringbuffer_read(worker->requests, (char*)worker->request,
+		                     jalv_worker_message_size(head.size) - sizeof(head));
 
-		jalv->worker.iface->work(
-			jalv->instance->lv2_handle, jalv_worker_respond, jalv, size, buf);
+		worker->iface->work(
+			jalv->instance->lv2_handle, jalv_worker_respond, jalv,
+			head.size, worker->request);
 	}
 
-	free(buf);
 	return NULL;
 }
 
 void
 jalv_worker_init(Jalv*                       jalv,
                  JalvWorker*                 worker,
-                 const LV2_Worker_Interface* iface)
+                 const LV2_Worker_Interface* iface,
+                 bool                        threaded)
 {
-	worker->iface = iface;
-	zix_thread_create(&worker->thread, 4096, worker_func, jalv);
-	worker->requests  = jack_ringbuffer_create(4096);
-	worker->responses = jack_ringbuffer_create(4096);
-	worker->response  = malloc(4096);
+	// Buffers are as large as the rings, so no message is too large for them
+	worker->iface     = iface;
+	worker->requests  = jack_ringbuffer_create(jalv->opts.buffer_size);
+	worker->responses = jack_ringbuffer_create(jalv->opts.buffer_size);
+	worker->request   = malloc(worker->requests->size);
+	worker->response  = malloc(worker->responses->size);
+	worker->n_dropped_requests  = 0;
+	worker->n_dropped_responses = 0;
+	worker->threaded            = threaded;
 	jack_ringbuffer_mlock(worker->requests);
 	jack_ringbuffer_mlock(worker->responses);
+	if (threaded) {
+		zix_thread_create(&worker->thread, 4096, worker_func, jalv);
+	}
 }
 
 void
 jalv_worker_finish(JalvWorker* worker)
 {
 	if (worker->requests) {
-		zix_sem_post(&worker->sem);
-		zix_thread_join(worker->thread, NULL);
+		if (worker->threaded) {
+			zix_sem_post(&worker->sem);
+			zix_thread_join(worker->thread, NULL);
+		}
+		if (worker->n_dropped_requests || worker->n_dropped_responses) {
+			fprintf(stderr, "warning: Worker dropped %u requests and "
+			        "%u responses, try a larger buffer size (-b)\n",
+			        worker->n_dropped_requests, worker->n_dropped_responses);
+		}
 		jack_ringbuffer_free(worker->requests);
 		jack_ringbuffer_free(worker->responses);
+		free(worker->request);
 		free(worker->response);
 	}
 }
@@ -90,9 +129,16 @@ jalv_worker_schedule(LV2_Worker_Schedule_Handle handle,
                      const void*                data)
 {
 	Jalv* jalv = (Jalv*)handle;
-	jack_ringbuffer_write(jalv->worker.requests,
-	                      (const char*)&size, sizeof(size));
-	jack_ringbuffer_write(jalv->worker.requests, (const char*)data, size);
+	if (!jalv->worker.threaded) {
+		// Rendering offline, do the work now so the output is reproducible
+		return jalv->worker.iface->work(
+			jalv->instance->lv2_handle, jalv_worker_respond, jalv, size, data);
+	}
+
+	if (!jalv_worker_write(jalv->worker.requests, size, data)) {
+		++jalv->worker.n_dropped_requests;
+		return LV2_WORKER_ERR_NO_SPACE;
+	}
 	zix_sem_post(&jalv->worker.sem);
 	return LV2_WORKER_SUCCESS;
 }
@@ -101,18 +147,20 @@ void
 jalv_worker_emit_responses(Jalv* jalv, JalvWorker* worker)
 {
 	if (worker->responses) {
-		uint32_t read_space = jack_ringbuffer_read_space(worker->responses);
-		while (read_space) {
-			uint32_t size = 0;
-			jack_ringbuffer_read(worker->responses, (char*)&size, sizeof(size));
-
-			jack_ringbuffer_read(
-				worker->responses, (char*)worker->response, size);
+		// Read every whole response at once, then deliver them in order
+		const uint32_t read_space = jack_ringbuffer_read_space(
+			worker->responses);
+		if (!read_space) {
+			return;
+		}
 
+		char* const buf = (char*)worker->response;
+		jack_ringbuffer_read(worker->responses, buf, read_space);
+		for (uint32_t offset = 0; offset < read_space;) {
+			const JalvWorkerHeader* head = (const JalvWorkerHeader*)(buf + offset);
 			worker->iface->work_response(
-				jalv->instance->lv2_handle, size, worker->response);
-
-			read_space -= sizeof(size) + size;
+				jalv->instance->lv2_handle, head->size, head + 1);
+			offset += jalv_worker_message_size(head->size);
 		}
 	}
 }
@@ -21,7 +21,8 @@
 void
 jalv_worker_init(Jalv*                       jalv,
                  JalvWorker*                 worker,
-                 const LV2_Worker_Interface* iface);
+                 const LV2_Worker_Interface* iface,
+                 bool                        threaded);
 
 void
 jalv_worker_finish(JalvWorker* worker);
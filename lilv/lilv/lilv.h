@@ -90,6 +90,7 @@ typedef void LilvPlugins;        /**< set<Plugin>. */
 typedef void LilvScalePoints;    /**< set<ScalePoint>. */
 typedef void LilvUIs;            /**< set<UI>. */
 typedef void LilvNodes;          /**< set<Node>. */
+typedef void LilvStates;         /**< set<State>. */
 
 /**
    @defgroup lilv Lilv
@@ -478,6 +479,26 @@ LILV_API const LilvPlugin*
 lilv_plugins_get_by_uri(const LilvPlugins* plugins,
                         const LilvNode*    uri);
 
+/* States */
+
+LILV_API void
+lilv_states_free(LilvStates* collection);
+
+LILV_API unsigned
+lilv_states_size(const LilvStates* collection);
+
+LILV_API LilvIter*
+lilv_states_begin(const LilvStates* collection);
+
+LILV_API const LilvState*
+lilv_states_get(const LilvStates* collection, LilvIter* i);
+
+LILV_API LilvIter*
+lilv_states_next(const LilvStates* collection, LilvIter* i);
+
+LILV_API bool
+lilv_states_is_end(const LilvStates* collection, LilvIter* i);
+
 /**
    @}
    @name World
@@ -510,12 +531,24 @@ lilv_world_new(void);
 */
 #define LILV_OPTION_DYN_MANIFEST "http://drobilla.net/ns/lilv#dyn-manifest"
 
+/**
+   Cache parsed data in a file.
+   The value is a string node with the path of the cache file.  Statements read
+   from data files are stored in the cache when the world is destroyed, and
+   later worlds using the same cache load unchanged files from it instead of
+   parsing them.  Files are checked by size and modification time, so a file
+   edited in place is re-read.  This option should be set before loading
+   anything.  The cache is disabled by default.
+*/
+#define LILV_OPTION_CACHE "http://drobilla.net/ns/lilv#cache"
+
 /**
    Set an option option for `world`.
 
    Currently recognized options:
    @ref LILV_OPTION_FILTER_LANG
    @ref LILV_OPTION_DYN_MANIFEST
+   @ref LILV_OPTION_CACHE
 */
 LILV_API void
 lilv_world_set_option(LilvWorld*      world,
@@ -1175,6 +1208,73 @@ LILV_API LilvScalePoints*
 lilv_port_get_scale_points(const LilvPlugin* plugin,
                            const LilvPort*   port);
 
+/**
+   Well-known port classes, as bits in LilvPortDescriptor::classes.
+*/
+typedef enum {
+	LILV_PORT_INPUT      = 1u << 0,  /**< lv2:InputPort */
+	LILV_PORT_OUTPUT     = 1u << 1,  /**< lv2:OutputPort */
+	LILV_PORT_CONTROL    = 1u << 2,  /**< lv2:ControlPort */
+	LILV_PORT_AUDIO      = 1u << 3,  /**< lv2:AudioPort */
+	LILV_PORT_CV         = 1u << 4,  /**< lv2:CVPort */
+	LILV_PORT_ATOM       = 1u << 5,  /**< atom:AtomPort */
+	LILV_PORT_EVENT      = 1u << 6,  /**< ev:EventPort */
+	LILV_PORT_MORPH      = 1u << 7,  /**< morph:MorphPort */
+	LILV_PORT_AUTO_MORPH = 1u << 8   /**< morph:AutoMorphPort */
+} LilvPortClassFlag;
+
+/**
+   Well-known port properties, as bits in LilvPortDescriptor::properties.
+*/
+typedef enum {
+	LILV_PORT_CONNECTION_OPTIONAL = 1u << 0,   /**< lv2:connectionOptional */
+	LILV_PORT_ENUMERATION         = 1u << 1,   /**< lv2:enumeration */
+	LILV_PORT_INTEGER             = 1u << 2,   /**< lv2:integer */
+	LILV_PORT_IS_SIDE_CHAIN       = 1u << 3,   /**< lv2:isSideChain */
+	LILV_PORT_REPORTS_LATENCY     = 1u << 4,   /**< lv2:reportsLatency */
+	LILV_PORT_SAMPLE_RATE         = 1u << 5,   /**< lv2:sampleRate */
+	LILV_PORT_TOGGLED             = 1u << 6,   /**< lv2:toggled */
+	LILV_PORT_CAUSES_ARTIFACTS    = 1u << 7,   /**< pprops:causesArtifacts */
+	LILV_PORT_EXPENSIVE           = 1u << 8,   /**< pprops:expensive */
+	LILV_PORT_HAS_STRICT_BOUNDS   = 1u << 9,   /**< pprops:hasStrictBounds */
+	LILV_PORT_LOGARITHMIC         = 1u << 10,  /**< pprops:logarithmic */
+	LILV_PORT_NOT_AUTOMATIC       = 1u << 11,  /**< pprops:notAutomatic */
+	LILV_PORT_NOT_ON_GUI          = 1u << 12,  /**< pprops:notOnGUI */
+	LILV_PORT_TRIGGER             = 1u << 13   /**< pprops:trigger */
+} LilvPortPropertyFlag;
+
+/**
+   Commonly used properties of a port, read from the model in one pass.
+   Only the first value of each property is used, except for rsz:minimumSize
+   where the largest integer value is used.
+*/
+typedef struct {
+	uint32_t        classes;       /**< Bitwise OR of LilvPortClassFlag. */
+	uint32_t        properties;    /**< Bitwise OR of LilvPortPropertyFlag. */
+	float           min;           /**< lv2:minimum, or NAN. */
+	float           max;           /**< lv2:maximum, or NAN. */
+	float           def;           /**< lv2:default, or NAN. */
+	uint32_t        minimum_size;  /**< Largest rsz:minimumSize, or 0. */
+	const LilvNode* designation;   /**< lv2:designation, or NULL. */
+	const LilvNode* buffer_type;   /**< atom:bufferType, or NULL. */
+} LilvPortDescriptor;
+
+/**
+   Get a descriptor for every port of a plugin, indexed by port index.
+
+   The returned array has lilv_plugin_get_num_ports() elements, and is built
+   the first time this is called with a single search per port.  This is much
+   faster than calling lilv_port_is_a(), lilv_port_has_property(), and
+   lilv_port_get_value() for several properties of every port.  Classes and
+   properties which are not well-known can still be queried with those
+   functions.
+
+   Returned value is shared and must not be destroyed by caller.  Returns
+   NULL if the plugin has no valid ports.
+*/
+LILV_API const LilvPortDescriptor*
+lilv_plugin_get_port_descriptors(const LilvPlugin* plugin);
+
 /**
    @}
    @name Plugin State
@@ -1224,6 +1324,33 @@ lilv_state_new_from_string(LilvWorld*    world,
                            LV2_URID_Map* map,
                            const char*   str);
 
+/**
+   Load every preset of a plugin.
+
+   This loads each data file of the presets which apply to `plugin` into the
+   world once, even if it describes several presets, then builds a state for
+   each in a single pass over its description.  This is much faster than
+   calling lilv_world_load_resource() and lilv_state_new_from_world() for each
+   preset, which reloads shared files.
+
+   Property values which are literals are not read until they are needed, so
+   `map` must remain valid until the returned states are freed.  Functions
+   which take a const state, such as lilv_state_restore(), read these values
+   into temporary memory every time without using the world, so they do not
+   modify anything shared.  Call lilv_state_prepare() to read them into the
+   state once.
+
+   Port values are resolved to port indices of `plugin`, so they can be set
+   with lilv_state_apply_port_values() without calling lilv_state_prepare().
+
+   @param plugin The plugin to load presets for.
+   @param map URID mapper.
+   @return A new set of states sorted by URI, which must be freed with
+   lilv_states_free().
+*/
+LILV_API LilvStates*
+lilv_plugin_load_presets(const LilvPlugin* plugin, LV2_URID_Map* map);
+
 /**
    Function to get a port value.
    @param port_symbol The symbol of the port.
@@ -1333,6 +1460,14 @@ lilv_state_equals(const LilvState* a, const LilvState* b);
 LILV_API unsigned
 lilv_state_get_num_properties(const LilvState* state);
 
+/**
+   Get the URI of `state`, if it was loaded from a description.
+   @return The subject `state` was loaded from, or NULL if it was created
+   from an instance.
+*/
+LILV_API const LilvNode*
+lilv_state_get_uri(const LilvState* state);
+
 /**
    Get the URI of the plugin `state` applies to.
 */
@@ -1397,6 +1532,54 @@ lilv_state_restore(const LilvState*           state,
                    uint32_t                   flags,
                    const LV2_Feature *const * features);
 
+/**
+   Prepare `state` so its port values can be applied in a real-time thread.
+
+   This does everything that may allocate ahead of time: it reads any
+   property values which have not been read yet (see
+   lilv_plugin_load_presets()), and resolves the symbol of every port value
+   to a port index of `plugin`.  States created by
+   lilv_state_new_from_instance() already have port indices.
+
+   To switch to a prepared state, restore its properties with
+   lilv_state_restore() (with a NULL `set_value`) in a non-real-time thread,
+   then set its port values in the audio thread with
+   lilv_state_apply_port_values().
+
+   @return Zero on success, or non-zero if a port value does not correspond
+   to a port of `plugin`, in which case that value is not applied.
+*/
+LILV_API int
+lilv_state_prepare(LilvState* state, const LilvPlugin* plugin);
+
+/**
+   Function to set a port value by index.
+   @param port_index The index of the port.
+   @param user_data The user_data passed to lilv_state_apply_port_values().
+   @param value A pointer to the port value.
+   @param size The size of `value`.
+   @param type The URID of the type of `value`.
+*/
+typedef void (*LilvSetPortValueByIndexFunc)(uint32_t    port_index,
+                                            void*       user_data,
+                                            const void* value,
+                                            uint32_t    size,
+                                            uint32_t    type);
+
+/**
+   Set the port values of a prepared state.
+
+   This calls `set_value` for each port value of `state` which has a port
+   index (see lilv_state_prepare()), in order of port symbol.  It does not
+   allocate memory or take locks, so it may be called in a real-time thread
+   if `set_value` is real-time safe.  `state` must not be modified or freed
+   concurrently.
+*/
+LILV_API void
+lilv_state_apply_port_values(const LilvState*            state,
+                             LilvSetPortValueByIndexFunc set_value,
+                             void*                       user_data);
+
 /**
    Save state to a file.
    @param world The world.
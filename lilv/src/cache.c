@@ -0,0 +1,822 @@
+/*
+  Copyright 2007-2015 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L  /* for st_mtim */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "lilv_internal.h"
+
+#ifdef HAVE_MMAP
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <unistd.h>
+#endif
+
+#define USTR(s) ((const uint8_t*)(s))
+
+/**
+   @file cache.c Persistent cache of parsed data files.
+
+   The cache is a single binary file which holds the statements of every data
+   file the world has read, so later runs can insert them into the model
+   without parsing any Turtle.  The file is mapped into memory and an entry is
+   only validated (by comparing the size and modification time of the data
+   file) when that file is loaded, so opening a large cache is cheap.
+
+   Layout, in native byte order:
+
+     CacheHeader
+     uint64_t offsets[n_files]   Offset of each CacheFile, sorted by path
+     CacheFile records:
+       CacheFile
+       path, '\0', padded to 8 bytes
+       n_nodes * (CacheNode, string '\0' datatype '\0' lang '\0', padded to 4)
+       n_quads * uint32_t[3]     Subject, predicate, object node indices
+
+   Blank node IDs are stored without the prefix used when the file was read,
+   and a fresh prefix is applied when they are loaded.
+
+   The same records are used to parse files in parallel: a file can be parsed
+   into a record using only a private SordWorld, and the record is later
+   loaded into the world model like a cache entry.
+*/
+
+#define LILV_CACHE_MAGIC   "LilvQds\n"
+#define LILV_CACHE_VERSION 1
+
+typedef struct {
+	char     magic[8];
+	uint32_t version;
+	uint32_t n_files;
+} CacheHeader;
+
+typedef struct {
+	uint64_t size;        ///< Size of data file
+	int64_t  mtime_sec;   ///< Modification time of data file (seconds)
+	int64_t  mtime_nsec;  ///< Modification time of data file (nanoseconds)
+	uint32_t path_len;    ///< Length of path, excluding terminator
+	uint32_t n_nodes;     ///< Number of CacheNode records
+	uint32_t n_quads;     ///< Number of statements
+	uint32_t body_size;   ///< Size of record following this header
+} CacheFile;
+
+typedef struct {
+	uint8_t  type;          ///< SordNodeType
+	uint8_t  pad[3];
+	uint32_t len;           ///< Length of string
+	uint32_t datatype_len;  ///< Length of datatype URI, or 0
+	uint32_t lang_len;      ///< Length of language tag, or 0
+} CacheNode;
+
+/** A parsed file, which may be written to the cache. */
+struct LilvCacheRecordImpl {
+	char*    path;
+	uint8_t* data;  ///< CacheFile and body
+	size_t   size;
+};
+
+struct LilvCacheImpl {
+	char*          path;     ///< Path of cache file
+	const uint8_t* map;      ///< Mapped cache file, or NULL
+	size_t         map_size;
+	uint32_t       n_files;  ///< Number of files in map
+	ZixTree*       records;  ///< New CacheRecords, sorted by path
+};
+
+/** A node seen while recording a file, for mapping nodes to indices. */
+typedef struct {
+	const SordNode* node;
+	uint32_t        index;
+} NodeIndex;
+
+/** State for recording statements while parsing a file. */
+typedef struct {
+	SordWorld*     world;
+	SordModel*     model;     ///< Model to add statements to, or NULL
+	SerdEnv*       env;
+	SordNode*      graph;
+	const uint8_t* blank_prefix;
+	size_t         blank_prefix_len;
+	ZixTree*       index;     ///< NodeIndex, by node
+	SordNode**     nodes;     ///< Nodes, in index order
+	uint32_t       n_nodes;
+	uint32_t       nodes_size;  ///< Allocated length of nodes
+	uint32_t*      quads;     ///< Node indices, 3 per statement
+	uint32_t       n_quads;
+	uint32_t       quads_size;  ///< Allocated number of statements in quads
+} Recorder;
+
+static inline size_t
+pad_to(size_t size, size_t align)
+{
+	return (size + align - 1) & ~(align - 1);
+}
+
+static int
+record_path_cmp(const void* a, const void* b, void* user_data)
+{
+	return strcmp(((const LilvCacheRecord*)a)->path, ((const LilvCacheRecord*)b)->path);
+}
+
+static void
+record_free(void* ptr)
+{
+	LilvCacheRecord* record = (LilvCacheRecord*)ptr;
+	free(record->path);
+	free(record->data);
+	free(record);
+}
+
+static int
+node_index_cmp(const void* a, const void* b, void* user_data)
+{
+	const SordNode* const na = ((const NodeIndex*)a)->node;
+	const SordNode* const nb = ((const NodeIndex*)b)->node;
+	return (na < nb) ? -1 : ((na > nb) ? 1 : 0);
+}
+
+/** Get the size and modification time of `path`, or return non-zero. */
+static int
+file_stamp(const char* path, CacheFile* stamp)
+{
+	struct stat st;
+	if (stat(path, &st)) {
+		return errno;
+	}
+
+	stamp->size      = (uint64_t)st.st_size;
+	stamp->mtime_sec = (int64_t)st.st_mtime;
+#if defined(__APPLE__)
+	stamp->mtime_nsec = (int64_t)st.st_mtimespec.tv_nsec;
+#elif defined(_WIN32)
+	stamp->mtime_nsec = 0;
+#else
+	stamp->mtime_nsec = (int64_t)st.st_mtim.tv_nsec;
+#endif
+	return 0;
+}
+
+static inline bool
+stamp_equals(const CacheFile* a, const CacheFile* b)
+{
+	return (a->size == b->size &&
+	        a->mtime_sec == b->mtime_sec &&
+	        a->mtime_nsec == b->mtime_nsec);
+}
+
+static inline const char*
+cache_file_path(const CacheFile* file)
+{
+	return (const char*)(file + 1);
+}
+
+/** Return the mapped record for file `i`, or NULL if it is corrupt. */
+static const CacheFile*
+cache_file_at(const LilvCache* cache, uint32_t i)
+{
+	const uint64_t* offsets = (const uint64_t*)(cache->map + sizeof(CacheHeader));
+	const uint64_t  offset  = offsets[i];
+	if (offset % 8 || offset + sizeof(CacheFile) > cache->map_size) {
+		return NULL;
+	}
+
+	const CacheFile* file = (const CacheFile*)(cache->map + offset);
+	if (offset + sizeof(CacheFile) + file->body_size > cache->map_size ||
+	    file->path_len >= file->body_size ||
+	    cache_file_path(file)[file->path_len] != '\0') {
+		return NULL;
+	}
+
+	return file;
+}
+
+/** Find the mapped record for the data file at `path`. */
+static const CacheFile*
+cache_find(const LilvCache* cache, const char* path)
+{
+	uint32_t lower = 0;
+	uint32_t upper = cache->n_files;
+	while (lower < upper) {
+		const uint32_t   i    = lower + (upper - lower) / 2;
+		const CacheFile* file = cache_file_at(cache, i);
+		if (!file) {
+			return NULL;
+		}
+
+		const int cmp = strcmp(cache_file_path(file), path);
+		if (cmp < 0) {
+			lower = i + 1;
+		} else if (cmp > 0) {
+			upper = i;
+		} else {
+			return file;
+		}
+	}
+	return NULL;
+}
+
+LilvCache*
+lilv_cache_new(const char* path)
+{
+#ifdef HAVE_MMAP
+	LilvCache* cache = (LilvCache*)calloc(1, sizeof(LilvCache));
+	cache->path    = lilv_strdup(path);
+	cache->records = zix_tree_new(false, record_path_cmp, NULL, record_free);
+
+	const int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return cache;  // No cache yet
+	}
+
+	struct stat st;
+	if (!fstat(fd, &st) && (size_t)st.st_size >= sizeof(CacheHeader)) {
+		void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map != MAP_FAILED) {
+			cache->map      = (const uint8_t*)map;
+			cache->map_size = st.st_size;
+		}
+	}
+	close(fd);
+
+	if (cache->map) {
+		const CacheHeader* head = (const CacheHeader*)cache->map;
+		if (memcmp(head->magic, LILV_CACHE_MAGIC, sizeof(head->magic)) ||
+		    head->version != LILV_CACHE_VERSION ||
+		    (sizeof(CacheHeader) + head->n_files * sizeof(uint64_t)
+		     > cache->map_size)) {
+			LILV_WARNF("Ignoring invalid cache `%s'\n", path);
+		} else {
+			cache->n_files = head->n_files;
+		}
+	}
+
+	return cache;
+#else
+	LILV_WARN("Caching is not supported on this platform\n");
+	return NULL;
+#endif
+}
+
+/** Write a new cache file with new records and valid mapped records. */
+static int
+lilv_cache_write(LilvCache* cache)
+{
+	char* const dir = lilv_dirname(cache->path);
+	lilv_mkdir_p(dir);
+	free(dir);
+
+	/* Write to a unique file in the same directory and rename it over the
+	   cache, so concurrent writers never share a temporary file. */
+	char* const tmp_path = lilv_strjoin(cache->path, ".XXXXXX", NULL);
+#ifdef HAVE_MMAP
+	const int   fd  = mkstemp(tmp_path);
+	FILE* const out = (fd < 0) ? NULL : fdopen(fd, "wb");
+	if (fd >= 0 && !out) {
+		close(fd);
+		remove(tmp_path);
+	}
+#else
+	FILE* const out = NULL;  // Caching is not supported
+#endif
+	if (!out) {
+		LILV_ERRORF("Failed to open %s (%s)\n", tmp_path, strerror(errno));
+		free(tmp_path);
+		return 1;
+	}
+
+	/* Space is reserved for an offset for every record, but stale records
+	   are dropped while writing, so the table may end up partially used. */
+	const uint32_t max_files = cache->n_files + zix_tree_size(cache->records);
+	uint64_t*      offsets   = (uint64_t*)calloc(max_files, sizeof(uint64_t));
+	uint64_t       offset    = sizeof(CacheHeader) + max_files * sizeof(uint64_t);
+
+	CacheHeader head;
+	memcpy(head.magic, LILV_CACHE_MAGIC, sizeof(head.magic));
+	head.version = LILV_CACHE_VERSION;
+	head.n_files = 0;
+
+	bool error = (!fwrite(&head, sizeof(head), 1, out) ||
+	              !fwrite(offsets, sizeof(uint64_t), max_files, out));
+
+	// Merge old and new records, which are both sorted by path
+	static const uint8_t zeros[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+	ZixTreeIter*         r        = zix_tree_begin(cache->records);
+	uint32_t             i        = 0;
+	while (!error && (i < cache->n_files || !zix_tree_iter_is_end(r))) {
+		const LilvCacheRecord* record = zix_tree_iter_is_end(r)
+			? NULL : (const LilvCacheRecord*)zix_tree_get(r);
+		const CacheFile*   file   = (i < cache->n_files)
+			? cache_file_at(cache, i) : NULL;
+		if (i < cache->n_files && !file) {
+			++i;  // Corrupt, drop it
+			continue;
+		}
+
+		const int cmp = (!file ? 1 : !record ? -1
+		                 : strcmp(cache_file_path(file), record->path));
+
+		const void* data = NULL;
+		size_t      size = 0;
+		CacheFile   stamp;
+		if (cmp < 0) {
+			// Old record, keep it if the data file has not changed
+			if (!file_stamp(cache_file_path(file), &stamp) &&
+			    stamp_equals(file, &stamp)) {
+				data = file;
+				size = sizeof(CacheFile) + file->body_size;
+			}
+			++i;
+		} else {
+			// New record, which replaces any old record for the same file
+			data = record->data;
+			size = record->size;
+			r    = zix_tree_iter_next(r);
+			if (cmp == 0) {
+				++i;
+			}
+		}
+
+		if (data) {
+			const size_t padded = pad_to(size, 8);
+			offsets[head.n_files++] = offset;
+			error = (!fwrite(data, size, 1, out) ||
+			         (padded > size && !fwrite(zeros, padded - size, 1, out)));
+			offset += padded;
+		}
+	}
+
+	// Rewrite header and offset table
+	error = (error ||
+	         fseek(out, 0, SEEK_SET) ||
+	         !fwrite(&head, sizeof(head), 1, out) ||
+	         !fwrite(offsets, sizeof(uint64_t), max_files, out));
+	error = fclose(out) || error;
+	free(offsets);
+
+	if (error || rename(tmp_path, cache->path)) {
+		LILV_ERRORF("Failed to write cache %s (%s)\n",
+		            cache->path, strerror(errno));
+		remove(tmp_path);
+		free(tmp_path);
+		return 1;
+	}
+
+	free(tmp_path);
+	return 0;
+}
+
+void
+lilv_cache_free(LilvCache* cache)
+{
+	if (!cache) {
+		return;
+	}
+
+	if (zix_tree_size(cache->records) > 0) {
+		lilv_cache_write(cache);
+	}
+
+#ifdef HAVE_MMAP
+	if (cache->map) {
+		munmap((void*)cache->map, cache->map_size);
+	}
+#endif
+
+	zix_tree_free(cache->records);
+	free(cache->path);
+	free(cache);
+}
+
+/** Insert the statements of a mapped record into the world model. */
+static SerdStatus
+cache_file_load(LilvWorld*       world,
+                const CacheFile* file,
+                SordNode*        graph,
+                const uint8_t*   blank_prefix)
+{
+	const uint8_t* const body = (const uint8_t*)(file + 1);
+	const uint8_t* const end  = body + file->body_size;
+	const uint8_t*       ptr  = body + pad_to(file->path_len + 1, 8);
+	const size_t         plen = strlen((const char*)blank_prefix);
+
+	SordNode** nodes = (SordNode**)calloc(file->n_nodes ? file->n_nodes : 1,
+	                                      sizeof(SordNode*));
+	SerdStatus st    = SERD_SUCCESS;
+	for (uint32_t i = 0; i < file->n_nodes; ++i) {
+		const CacheNode* cnode = (const CacheNode*)ptr;
+		if (ptr + sizeof(CacheNode) > end) {
+			st = SERD_ERR_BAD_SYNTAX;
+			break;
+		}
+
+		const size_t size = (sizeof(CacheNode) + (size_t)cnode->len + 1 +
+		                     (size_t)cnode->datatype_len + 1 +
+		                     (size_t)cnode->lang_len + 1);
+		const uint8_t* str      = (const uint8_t*)(cnode + 1);
+		const uint8_t* datatype = str + cnode->len + 1;
+		const char*    lang     = (const char*)datatype + cnode->datatype_len + 1;
+		if (ptr + size > end || str[cnode->len] ||
+		    datatype[cnode->datatype_len] || lang[cnode->lang_len]) {
+			st = SERD_ERR_BAD_SYNTAX;
+			break;
+		}
+
+		switch ((SordNodeType)cnode->type) {
+		case SORD_URI:
+			nodes[i] = sord_new_uri(world->world, str);
+			break;
+		case SORD_BLANK: {
+			uint8_t* id = (uint8_t*)malloc(plen + cnode->len + 1);
+			memcpy(id, blank_prefix, plen);
+			memcpy(id + plen, str, cnode->len + 1);
+			nodes[i] = sord_new_blank(world->world, id);
+			free(id);
+			break;
+		}
+		case SORD_LITERAL: {
+			SordNode* dt = cnode->datatype_len
+				? sord_new_uri(world->world, datatype) : NULL;
+			nodes[i] = sord_new_literal(world->world, dt, str,
+			                            cnode->lang_len ? lang : NULL);
+			sord_node_free(world->world, dt);
+			break;
+		}
+		}
+
+		if (!nodes[i]) {
+			st = SERD_ERR_BAD_SYNTAX;
+			break;
+		}
+		ptr += pad_to(size, 4);
+	}
+
+	const uint32_t* quads = (const uint32_t*)ptr;
+	if (!st && (const uint8_t*)(quads + 3 * file->n_quads) > end) {
+		st = SERD_ERR_BAD_SYNTAX;
+	}
+
+	for (uint32_t q = 0; !st && q < file->n_quads; ++q) {
+		const uint32_t* const indices = quads + 3 * q;
+		if (indices[0] >= file->n_nodes ||
+		    indices[1] >= file->n_nodes ||
+		    indices[2] >= file->n_nodes) {
+			st = SERD_ERR_BAD_SYNTAX;
+			break;
+		}
+
+		SordQuad quad = { nodes[indices[0]],
+		                  nodes[indices[1]],
+		                  nodes[indices[2]],
+		                  graph };
+		sord_add(world->model, quad);
+	}
+
+	for (uint32_t i = 0; i < file->n_nodes; ++i) {
+		sord_node_free(world->world, nodes[i]);
+	}
+	free(nodes);
+	return st;
+}
+
+/** Return the index of `node` in the recording, adding it if necessary. */
+static uint32_t
+recorder_index(Recorder* rec, SordNode* node)
+{
+	NodeIndex    key  = { node, 0 };
+	ZixTreeIter* iter = NULL;
+	if (!zix_tree_find(rec->index, &key, &iter)) {
+		return ((const NodeIndex*)zix_tree_get(iter))->index;
+	}
+
+	NodeIndex* entry = (NodeIndex*)malloc(sizeof(NodeIndex));
+	entry->node  = node;
+	entry->index = rec->n_nodes;
+	zix_tree_insert(rec->index, entry, NULL);
+
+	if (rec->n_nodes == rec->nodes_size) {
+		rec->nodes_size = rec->nodes_size ? rec->nodes_size * 2 : 16;
+		rec->nodes      = (SordNode**)realloc(
+			rec->nodes, rec->nodes_size * sizeof(SordNode*));
+	}
+	rec->nodes[rec->n_nodes++] = sord_node_copy(node);
+	return entry->index;
+}
+
+static SerdStatus
+recorder_base(void* handle, const SerdNode* uri)
+{
+	return serd_env_set_base_uri(((Recorder*)handle)->env, uri);
+}
+
+static SerdStatus
+recorder_prefix(void* handle, const SerdNode* name, const SerdNode* uri)
+{
+	return serd_env_set_prefix(((Recorder*)handle)->env, name, uri);
+}
+
+/** Statement sink which records the statement and adds it to the model. */
+static SerdStatus
+recorder_statement(void*              handle,
+                   SerdStatementFlags flags,
+                   const SerdNode*    graph,
+                   const SerdNode*    subject,
+                   const SerdNode*    predicate,
+                   const SerdNode*    object,
+                   const SerdNode*    object_datatype,
+                   const SerdNode*    object_lang)
+{
+	Recorder*  rec   = (Recorder*)handle;
+	SordWorld* world = rec->world;
+
+	SordNode* s = sord_node_from_serd_node(world, rec->env, subject, NULL, NULL);
+	SordNode* p = sord_node_from_serd_node(world, rec->env, predicate, NULL, NULL);
+	SordNode* o = sord_node_from_serd_node(
+		world, rec->env, object, object_datatype, object_lang);
+	if (!s || !p || !o) {
+		sord_node_free(world, o);
+		sord_node_free(world, p);
+		sord_node_free(world, s);
+		return SERD_ERR_BAD_ARG;
+	}
+
+	if (rec->model) {
+		SordQuad quad = { s, p, o, rec->graph };
+		sord_add(rec->model, quad);
+	}
+
+	if (rec->n_quads == rec->quads_size) {
+		rec->quads_size = rec->quads_size ? rec->quads_size * 2 : 16;
+		rec->quads      = (uint32_t*)realloc(
+			rec->quads, rec->quads_size * 3 * sizeof(uint32_t));
+	}
+	rec->quads[3 * rec->n_quads]     = recorder_index(rec, s);
+	rec->quads[3 * rec->n_quads + 1] = recorder_index(rec, p);
+	rec->quads[3 * rec->n_quads + 2] = recorder_index(rec, o);
+	++rec->n_quads;
+
+	sord_node_free(world, o);
+	sord_node_free(world, p);
+	sord_node_free(world, s);
+	return SERD_SUCCESS;
+}
+
+/** Serialise a recording into a new cache record for `path`. */
+static LilvCacheRecord*
+recorder_finish(Recorder* rec, const char* path, const CacheFile* stamp)
+{
+	const size_t path_len = strlen(path);
+
+	// Calculate size of record body
+	size_t body_size = pad_to(path_len + 1, 8);
+	for (uint32_t i = 0; i < rec->n_nodes; ++i) {
+		const SordNode* node = rec->nodes[i];
+		const SordNode* dt   = sord_node_get_datatype(node);
+		const char*     lang = sord_node_get_language(node);
+		size_t          len  = 0;
+		sord_node_get_string_counted(node, &len);
+		if (sord_node_get_type(node) == SORD_BLANK) {
+			len -= rec->blank_prefix_len;
+		}
+		body_size += pad_to(sizeof(CacheNode) + len + 1
+		                    + (dt ? strlen((const char*)sord_node_get_string(dt)) : 0) + 1
+		                    + (lang ? strlen(lang) : 0) + 1,
+		                    4);
+	}
+	body_size += rec->n_quads * 3 * sizeof(uint32_t);
+
+	LilvCacheRecord* record = (LilvCacheRecord*)malloc(sizeof(LilvCacheRecord));
+	record->path = lilv_strdup(path);
+	record->size = sizeof(CacheFile) + body_size;
+	record->data = (uint8_t*)calloc(1, record->size);
+
+	CacheFile* file = (CacheFile*)record->data;
+	*file           = *stamp;
+	file->path_len  = path_len;
+	file->n_nodes   = rec->n_nodes;
+	file->n_quads   = rec->n_quads;
+	file->body_size = body_size;
+
+	uint8_t* ptr = (uint8_t*)(file + 1);
+	memcpy(ptr, path, path_len + 1);
+	ptr += pad_to(path_len + 1, 8);
+
+	for (uint32_t i = 0; i < rec->n_nodes; ++i) {
+		const SordNode* node = rec->nodes[i];
+		const SordNode* dt   = sord_node_get_datatype(node);
+		const char*     lang = sord_node_get_language(node);
+		size_t          len  = 0;
+		const uint8_t*  str  = sord_node_get_string_counted(node, &len);
+		if (sord_node_get_type(node) == SORD_BLANK) {
+			str += rec->blank_prefix_len;
+			len -= rec->blank_prefix_len;
+		}
+
+		const char*  dt_str = dt ? (const char*)sord_node_get_string(dt) : "";
+		const size_t dt_len = strlen(dt_str);
+		const size_t l_len  = lang ? strlen(lang) : 0;
+
+		CacheNode* cnode    = (CacheNode*)ptr;
+		cnode->type         = (uint8_t)sord_node_get_type(node);
+		cnode->len          = len;
+		cnode->datatype_len = dt_len;
+		cnode->lang_len     = l_len;
+
+		uint8_t* s = (uint8_t*)(cnode + 1);
+		memcpy(s, str, len + 1);
+		memcpy(s + len + 1, dt_str, dt_len + 1);
+		memcpy(s + len + 1 + dt_len + 1, lang ? lang : "", l_len + 1);
+		ptr += pad_to(sizeof(CacheNode) + len + 1 + dt_len + 1 + l_len + 1, 4);
+	}
+
+	if (rec->n_quads) {
+		memcpy(ptr, rec->quads, rec->n_quads * 3 * sizeof(uint32_t));
+	}
+
+	return record;
+}
+
+/** Return true iff every blank node in the recording has the read prefix. */
+static bool
+recorder_blanks_are_prefixed(const Recorder* rec)
+{
+	for (uint32_t i = 0; i < rec->n_nodes; ++i) {
+		const SordNode* node = rec->nodes[i];
+		if (sord_node_get_type(node) == SORD_BLANK &&
+		    strncmp((const char*)sord_node_get_string(node),
+		            (const char*)rec->blank_prefix,
+		            rec->blank_prefix_len)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+   Parse the file at `uri` into a new record, adding statements to `model` if
+   it is not NULL.  Only `world` and `model` are accessed, so this may be called
+   from several threads at once with different worlds.
+*/
+static SerdStatus
+record_file(SordWorld*        world,
+            SordModel*        model,
+            SordNode*         graph,
+            const LilvNode*   uri,
+            const char*       path,
+            const CacheFile*  stamp,
+            const uint8_t*    blank_prefix,
+            LilvCacheRecord** record)
+{
+	Recorder rec;
+	memset(&rec, 0, sizeof(rec));
+	rec.world            = world;
+	rec.model            = model;
+	rec.env              = serd_env_new(sord_node_to_serd_node(uri->node));
+	rec.graph            = graph;
+	rec.blank_prefix     = blank_prefix;
+	rec.blank_prefix_len = strlen((const char*)blank_prefix);
+	rec.index            = zix_tree_new(false, node_index_cmp, NULL, free);
+
+	SerdReader* reader = serd_reader_new(
+		SERD_TURTLE, &rec, NULL,
+		recorder_base, recorder_prefix, recorder_statement, NULL);
+	serd_reader_add_blank_prefix(reader, blank_prefix);
+
+	const SerdStatus st = serd_reader_read_file(
+		reader, sord_node_get_string(uri->node));
+
+	*record = NULL;
+	if (!st && recorder_blanks_are_prefixed(&rec)) {
+		*record = recorder_finish(&rec, path, stamp);
+	}
+
+	serd_reader_free(reader);
+	serd_env_free(rec.env);
+	for (uint32_t i = 0; i < rec.n_nodes; ++i) {
+		sord_node_free(world, rec.nodes[i]);
+	}
+	free(rec.nodes);
+	free(rec.quads);
+	zix_tree_free(rec.index);
+	return st;
+}
+
+SerdStatus
+lilv_cache_load_file(LilvCache*      cache,
+                     LilvWorld*      world,
+                     SordNode*       graph,
+                     const LilvNode* uri,
+                     const uint8_t*  blank_prefix)
+{
+	char* const path = lilv_file_uri_parse(lilv_node_as_uri(uri), NULL);
+	CacheFile   stamp;
+	if (!path || file_stamp(path, &stamp)) {
+		free(path);
+		return SERD_ERR_NOT_FOUND;
+	}
+
+	// Load from cache if there is a valid entry
+	const CacheFile* file = cache->map ? cache_find(cache, path) : NULL;
+	if (file && stamp_equals(file, &stamp) &&
+	    !cache_file_load(world, file, graph, blank_prefix)) {
+		free(path);
+		return SERD_SUCCESS;
+	}
+
+	// Otherwise, parse the file and record what was read
+	LilvCacheRecord* record = NULL;
+	const SerdStatus st     = record_file(world->world, world->model, graph,
+	                                      uri, path, &stamp, blank_prefix,
+	                                      &record);
+	if (record) {
+		lilv_cache_add_record(cache, record);
+	}
+
+	free(path);
+	return st;
+}
+
+bool
+lilv_cache_has_file(const LilvCache* cache, const LilvNode* uri)
+{
+	char* const path = lilv_file_uri_parse(lilv_node_as_uri(uri), NULL);
+	CacheFile   stamp;
+	if (!path || !cache->map || file_stamp(path, &stamp)) {
+		free(path);
+		return false;
+	}
+
+	const CacheFile* file = cache_find(cache, path);
+	free(path);
+	return file && stamp_equals(file, &stamp);
+}
+
+void
+lilv_cache_add_record(LilvCache* cache, LilvCacheRecord* record)
+{
+	ZixTreeIter* iter = NULL;
+	if (!zix_tree_find(cache->records, record, &iter)) {
+		zix_tree_remove(cache->records, iter);
+	}
+	zix_tree_insert(cache->records, record, NULL);
+}
+
+LilvCacheRecord*
+lilv_cache_record_parse(SordWorld* world, const LilvNode* uri, SerdStatus* st)
+{
+	char* const path = lilv_file_uri_parse(lilv_node_as_uri(uri), NULL);
+	CacheFile   stamp;
+	if (!path || file_stamp(path, &stamp)) {
+		free(path);
+		*st = SERD_ERR_NOT_FOUND;
+		return NULL;
+	}
+
+	/* The prefix is stripped from the record, and the real one is applied
+	   when it is loaded, so any non-empty prefix will do here. */
+	LilvCacheRecord* record = NULL;
+	*st = record_file(world, NULL, NULL, uri, path, &stamp, USTR("p"), &record);
+	if (!*st && !record) {
+		*st = SERD_ERR_NOT_FOUND;
+	}
+
+	free(path);
+	return record;
+}
+
+SerdStatus
+lilv_cache_record_load(const LilvCacheRecord* record,
+                       LilvWorld*             world,
+                       SordNode*              graph,
+                       const uint8_t*         blank_prefix)
+{
+	return cache_file_load(
+		world, (const CacheFile*)record->data, graph, blank_prefix);
+}
+
+void
+lilv_cache_record_free(LilvCacheRecord* record)
+{
+	if (record) {
+		record_free(record);
+	}
+}
@@ -94,6 +94,13 @@ lilv_plugin_classes_new(void)
 	                           (ZixDestroyFunc)lilv_plugin_class_free);
 }
 
+LilvStates*
+lilv_states_new(void)
+{
+	return lilv_collection_new(lilv_state_compare_by_uri,
+	                           (ZixDestroyFunc)lilv_state_free);
+}
+
 /* URI based accessors (for collections of things with URIs) */
 
 LILV_API const LilvPluginClass*
@@ -192,6 +199,7 @@ LILV_COLLECTION_IMPL(lilv_scale_points, LilvScalePoints, LilvScalePoint)
 LILV_COLLECTION_IMPL(lilv_uis, LilvUIs, LilvUI)
 LILV_COLLECTION_IMPL(lilv_nodes, LilvNodes, LilvNode)
 LILV_COLLECTION_IMPL(lilv_plugins, LilvPlugins, LilvPlugin)
+LILV_COLLECTION_IMPL(lilv_states, LilvStates, LilvState)
 
 LILV_API void
 lilv_plugin_classes_free(LilvPluginClasses* collection) {
@@ -213,6 +221,11 @@ lilv_nodes_free(LilvNodes* collection) {
 	lilv_collection_free(collection);
 }
 
+LILV_API void
+lilv_states_free(LilvStates* collection) {
+	lilv_collection_free(collection);
+}
+
 LILV_API LilvNode*
 lilv_nodes_get_first(const LilvNodes* collection) {
 	return (LilvNode*)lilv_collection_get(collection,
@@ -60,6 +60,8 @@ static inline char* dlerror(void) { return "Unknown error"; }
  */
 
 typedef struct LilvSpecImpl LilvSpec;
+typedef struct LilvCacheImpl LilvCache;
+typedef struct LilvCacheRecordImpl LilvCacheRecord;
 
 typedef void LilvCollection;
 
@@ -117,6 +119,7 @@ struct LilvPluginImpl {
 	const LilvPluginClass* plugin_class;
 	LilvNodes*             data_uris;  ///< rdfs::seeAlso
 	LilvPort**             ports;
+	LilvPortDescriptor*    port_descriptors;  ///< Built on demand, or NULL
 	uint32_t               num_ports;
 	bool                   loaded;
 	bool                   replaced;
@@ -150,6 +153,7 @@ struct LilvWorldImpl {
 	LilvPlugins*       plugins;
 	LilvNodes*         loaded_files;
 	ZixTree*           libs;
+	LilvCache*         cache;
 	struct {
 		SordNode* dc_replaces;
 		SordNode* dman_DynManifest;
@@ -272,11 +276,12 @@ LilvPlugins*       lilv_plugins_new(void);
 LilvScalePoints*   lilv_scale_points_new(void);
 LilvPluginClasses* lilv_plugin_classes_new(void);
 LilvUIs*           lilv_uis_new(void);
+LilvStates*        lilv_states_new(void);
 
 const uint8_t* lilv_world_blank_node_prefix(LilvWorld* world);
 
 SerdStatus lilv_world_load_file(LilvWorld*      world,
-                                SerdReader*     reader,
+                                SordNode*       graph,
                                 const LilvNode* uri);
 
 SerdStatus
@@ -284,6 +289,47 @@ lilv_world_load_graph(LilvWorld*      world,
                       SordNode*       graph,
                       const LilvNode* uri);
 
+LilvCache* lilv_cache_new(const char* path);
+void       lilv_cache_free(LilvCache* cache);
+
+/**
+   Load the file at `uri` into the world model in `graph`, via the cache.
+   Returns SERD_ERR_NOT_FOUND if the file is not a local file, in which case
+   it must be loaded without the cache.
+*/
+SerdStatus lilv_cache_load_file(LilvCache*      cache,
+                                LilvWorld*      world,
+                                SordNode*       graph,
+                                const LilvNode* uri,
+                                const uint8_t*  blank_prefix);
+
+/**
+   Return true iff the cache has a valid entry for the file at `uri`.
+   This only reads the cache, so may be called from any thread.
+*/
+bool lilv_cache_has_file(const LilvCache* cache, const LilvNode* uri);
+
+/** Add a parsed file to the cache, which takes ownership of `record`. */
+void lilv_cache_add_record(LilvCache* cache, LilvCacheRecord* record);
+
+/**
+   Parse the file at `uri` into a new record, without touching the world.
+   Only `world` is used, so this may be called from several threads at once
+   with different worlds.  Returns NULL and sets `st` on error, where
+   SERD_ERR_NOT_FOUND means the file must be loaded another way.
+*/
+LilvCacheRecord* lilv_cache_record_parse(SordWorld*      world,
+                                         const LilvNode* uri,
+                                         SerdStatus*     st);
+
+/** Load the statements of a parsed file into the world model in `graph`. */
+SerdStatus lilv_cache_record_load(const LilvCacheRecord* record,
+                                  LilvWorld*             world,
+                                  SordNode*              graph,
+                                  const uint8_t*         blank_prefix);
+
+void lilv_cache_record_free(LilvCacheRecord* record);
+
 LilvUI* lilv_ui_new(LilvWorld* world,
                     LilvNode*  uri,
                     LilvNode*  type_uri,
@@ -296,6 +342,7 @@ LilvNode* lilv_node_new_from_node(LilvWorld* world, const SordNode* node);
 
 int lilv_header_compare_by_uri(const void* a, const void* b, void* user_data);
 int lilv_lib_compare(const void* a, const void* b, void* user_data);
+int lilv_state_compare_by_uri(const void* a, const void* b, void* user_data);
 
 int lilv_ptr_cmp(const void* a, const void* b, void* user_data);
 int lilv_resource_node_cmp(const void* a, const void* b, void* user_data);
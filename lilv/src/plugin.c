@@ -27,10 +27,52 @@
 #include "lilv_config.h"
 #include "lilv_internal.h"
 
+#include "lv2/lv2plug.in/ns/ext/atom/atom.h"
+#include "lv2/lv2plug.in/ns/ext/event/event.h"
+#include "lv2/lv2plug.in/ns/ext/port-props/port-props.h"
+#include "lv2/lv2plug.in/ns/ext/resize-port/resize-port.h"
 #include "lv2/lv2plug.in/ns/extensions/ui/ui.h"
 
 #define NS_DOAP (const uint8_t*)"http://usefulinc.com/ns/doap#"
 #define NS_FOAF (const uint8_t*)"http://xmlns.com/foaf/0.1/"
+#define NS_MORPH "http://lv2plug.in/ns/ext/morph#"
+
+/** A well-known URI, and the bit that represents it in a port descriptor. */
+typedef struct {
+	const char* uri;
+	uint32_t    flag;
+} LilvPortFlagURI;
+
+static const LilvPortFlagURI port_class_uris[] = {
+	{ LV2_CORE__InputPort,         LILV_PORT_INPUT },
+	{ LV2_CORE__OutputPort,        LILV_PORT_OUTPUT },
+	{ LV2_CORE__ControlPort,       LILV_PORT_CONTROL },
+	{ LV2_CORE__AudioPort,         LILV_PORT_AUDIO },
+	{ LV2_CORE__CVPort,            LILV_PORT_CV },
+	{ LV2_ATOM__AtomPort,          LILV_PORT_ATOM },
+	{ LV2_EVENT__EventPort,        LILV_PORT_EVENT },
+	{ NS_MORPH "MorphPort",        LILV_PORT_MORPH },
+	{ NS_MORPH "AutoMorphPort",    LILV_PORT_AUTO_MORPH },
+	{ NULL,                        0 }
+};
+
+static const LilvPortFlagURI port_property_uris[] = {
+	{ LV2_CORE__connectionOptional,    LILV_PORT_CONNECTION_OPTIONAL },
+	{ LV2_CORE__enumeration,           LILV_PORT_ENUMERATION },
+	{ LV2_CORE__integer,               LILV_PORT_INTEGER },
+	{ LILV_NS_LV2 "isSideChain",       LILV_PORT_IS_SIDE_CHAIN },
+	{ LV2_CORE__reportsLatency,        LILV_PORT_REPORTS_LATENCY },
+	{ LV2_CORE__sampleRate,            LILV_PORT_SAMPLE_RATE },
+	{ LV2_CORE__toggled,               LILV_PORT_TOGGLED },
+	{ LV2_PORT_PROPS__causesArtifacts, LILV_PORT_CAUSES_ARTIFACTS },
+	{ LV2_PORT_PROPS__expensive,       LILV_PORT_EXPENSIVE },
+	{ LV2_PORT_PROPS__hasStrictBounds, LILV_PORT_HAS_STRICT_BOUNDS },
+	{ LV2_PORT_PROPS__logarithmic,     LILV_PORT_LOGARITHMIC },
+	{ LV2_PORT_PROPS__notAutomatic,    LILV_PORT_NOT_AUTOMATIC },
+	{ LV2_PORT_PROPS__notOnGUI,        LILV_PORT_NOT_ON_GUI },
+	{ LV2_PORT_PROPS__trigger,         LILV_PORT_TRIGGER },
+	{ NULL,                            0 }
+};
 
 /** Ownership of `uri` is taken */
 LilvPlugin*
@@ -49,15 +91,30 @@ lilv_plugin_new(LilvWorld* world, LilvNode* uri, LilvNode* bundle_uri)
 	plugin->data_uris    = lilv_nodes_new();
 	plugin->ports        = NULL;
 	plugin->num_ports    = 0;
+	plugin->port_descriptors = NULL;
 	plugin->loaded       = false;
 	plugin->replaced     = false;
 
 	return plugin;
 }
 
+static void
+lilv_plugin_free_port_descriptors(LilvPlugin* p)
+{
+	if (p->port_descriptors) {
+		for (uint32_t i = 0; i < p->num_ports; ++i) {
+			lilv_node_free((LilvNode*)p->port_descriptors[i].designation);
+			lilv_node_free((LilvNode*)p->port_descriptors[i].buffer_type);
+		}
+		free(p->port_descriptors);
+		p->port_descriptors = NULL;
+	}
+}
+
 static void
 lilv_plugin_free_ports(LilvPlugin* p)
 {
+	lilv_plugin_free_port_descriptors(p);
 	if (p->ports) {
 		for (uint32_t i = 0; i < p->num_ports; ++i) {
 			lilv_port_free(p, p->ports[i]);
@@ -135,12 +192,7 @@ lilv_plugin_get_unique(const LilvPlugin* p,
 static void
 lilv_plugin_load(LilvPlugin* p)
 {
-	SordNode*       bundle_uri_node  = p->bundle_uri->node;
-	const SerdNode* bundle_uri_snode = sord_node_to_serd_node(bundle_uri_node);
-
-	SerdEnv*    env    = serd_env_new(bundle_uri_snode);
-	SerdReader* reader = sord_new_reader(p->world->model, env, SERD_TURTLE,
-	                                     bundle_uri_node);
+	SordNode* bundle_uri_node = p->bundle_uri->node;
 
 	SordModel* prototypes = lilv_world_filter_model(p->world,
 	                                                p->world->model,
@@ -182,8 +234,7 @@ lilv_plugin_load(LilvPlugin* p)
 	LILV_FOREACH(nodes, i, p->data_uris) {
 		const LilvNode* data_uri = lilv_nodes_get(p->data_uris, i);
 
-		serd_env_set_base_uri(env, sord_node_to_serd_node(data_uri->node));
-		lilv_world_load_file(p->world, reader, data_uri);
+		lilv_world_load_file(p->world, bundle_uri_node, data_uri);
 	}
 
 #ifdef LILV_DYN_MANIFEST
@@ -197,7 +248,9 @@ lilv_plugin_load(LilvPlugin* p)
 			p->dynmanifest->lib, "lv2_dyn_manifest_get_data");
 		if (get_data_func) {
 			const SordNode* bundle = p->dynmanifest->bundle->node;
-			serd_env_set_base_uri(env, sord_node_to_serd_node(bundle));
+			SerdEnv*        env    = serd_env_new(sord_node_to_serd_node(bundle));
+			SerdReader*     reader = sord_new_reader(
+				p->world->model, env, SERD_TURTLE, bundle_uri_node);
 			FILE* fd = tmpfile();
 			get_data_func(p->dynmanifest->handle, fd,
 			              lilv_node_as_string(p->plugin_uri));
@@ -207,11 +260,11 @@ lilv_plugin_load(LilvPlugin* p)
 			serd_reader_read_file_handle(
 				reader, fd, (const uint8_t*)"(dyn-manifest)");
 			fclose(fd);
+			serd_reader_free(reader);
+			serd_env_free(env);
 		}
 	}
 #endif
-	serd_reader_free(reader);
-	serd_env_free(env);
 
 	p->loaded = true;
 }
@@ -494,50 +547,145 @@ lilv_plugin_get_num_ports(const LilvPlugin* p)
 	return p->num_ports;
 }
 
+/** Return the flag for `node` in `table`, where `nodes` are its URIs. */
+static uint32_t
+lilv_port_flag(const LilvPortFlagURI* table,
+               SordNode* const*       nodes,
+               const SordNode*        node)
+{
+	for (unsigned i = 0; table[i].uri; ++i) {
+		if (sord_node_equals(nodes[i], node)) {
+			return table[i].flag;
+		}
+	}
+	return 0;
+}
+
+/** Set `*value` to the first numeric value seen, or NAN. */
+static void
+lilv_port_set_float(LilvWorld*      world,
+                    const SordNode* node,
+                    float*          value,
+                    bool*           seen)
+{
+	if (!*seen) {
+		LilvNode* lnode = lilv_node_new_from_node(world, node);
+		if (lilv_node_is_float(lnode) || lilv_node_is_int(lnode)) {
+			*value = lilv_node_as_float(lnode);
+		}
+		lilv_node_free(lnode);
+		*seen = true;
+	}
+}
+
+static void
+lilv_plugin_load_port_descriptors(LilvPlugin* p)
+{
+	LilvWorld* const world = p->world;
+
+	SordNode* classes[sizeof(port_class_uris) / sizeof(LilvPortFlagURI)];
+	for (unsigned i = 0; port_class_uris[i].uri; ++i) {
+		classes[i] = sord_new_uri(
+			world->world, (const uint8_t*)port_class_uris[i].uri);
+	}
+
+	SordNode* props[sizeof(port_property_uris) / sizeof(LilvPortFlagURI)];
+	for (unsigned i = 0; port_property_uris[i].uri; ++i) {
+		props[i] = sord_new_uri(
+			world->world, (const uint8_t*)port_property_uris[i].uri);
+	}
+
+	SordNode* atom_bufferType = sord_new_uri(
+		world->world, (const uint8_t*)LV2_ATOM__bufferType);
+	SordNode* rsz_minimumSize = sord_new_uri(
+		world->world, (const uint8_t*)LV2_RESIZE_PORT__minimumSize);
+
+	p->port_descriptors = (LilvPortDescriptor*)calloc(
+		p->num_ports, sizeof(LilvPortDescriptor));
+
+	for (uint32_t i = 0; i < p->num_ports; ++i) {
+		LilvPortDescriptor* desc     = &p->port_descriptors[i];
+		bool                seen_min = false;
+		bool                seen_max = false;
+		bool                seen_def = false;
+
+		desc->min = desc->max = desc->def = NAN;
+
+		// Read everything about the port in one search rather than one each
+		SordIter* stmts = lilv_world_query_internal(
+			world, p->ports[i]->node->node, NULL, NULL);
+		FOREACH_MATCH(stmts) {
+			const SordNode* pred = sord_iter_get_node(stmts, SORD_PREDICATE);
+			const SordNode* obj  = sord_iter_get_node(stmts, SORD_OBJECT);
+			if (sord_node_equals(pred, world->uris.rdf_a)) {
+				desc->classes |= lilv_port_flag(port_class_uris, classes, obj);
+			} else if (sord_node_equals(pred, world->uris.lv2_portProperty)) {
+				desc->properties |= lilv_port_flag(
+					port_property_uris, props, obj);
+			} else if (sord_node_equals(pred, world->uris.lv2_minimum)) {
+				lilv_port_set_float(world, obj, &desc->min, &seen_min);
+			} else if (sord_node_equals(pred, world->uris.lv2_maximum)) {
+				lilv_port_set_float(world, obj, &desc->max, &seen_max);
+			} else if (sord_node_equals(pred, world->uris.lv2_default)) {
+				lilv_port_set_float(world, obj, &desc->def, &seen_def);
+			} else if (sord_node_equals(pred, rsz_minimumSize)) {
+				// Use the largest size, which satisfies every requirement
+				LilvNode* size = lilv_node_new_from_node(world, obj);
+				if (lilv_node_is_int(size) && lilv_node_as_int(size) > 0 &&
+				    (uint32_t)lilv_node_as_int(size) > desc->minimum_size) {
+					desc->minimum_size = lilv_node_as_int(size);
+				}
+				lilv_node_free(size);
+			} else if (sord_node_equals(pred, world->uris.lv2_designation) &&
+			           !desc->designation &&
+			           sord_node_get_type(obj) == SORD_URI) {
+				desc->designation = lilv_node_new_from_node(world, obj);
+			} else if (sord_node_equals(pred, atom_bufferType) &&
+			           !desc->buffer_type &&
+			           sord_node_get_type(obj) == SORD_URI) {
+				desc->buffer_type = lilv_node_new_from_node(world, obj);
+			}
+		}
+		sord_iter_free(stmts);
+	}
+
+	sord_node_free(world->world, rsz_minimumSize);
+	sord_node_free(world->world, atom_bufferType);
+	for (unsigned i = 0; port_property_uris[i].uri; ++i) {
+		sord_node_free(world->world, props[i]);
+	}
+	for (unsigned i = 0; port_class_uris[i].uri; ++i) {
+		sord_node_free(world->world, classes[i]);
+	}
+}
+
+LILV_API const LilvPortDescriptor*
+lilv_plugin_get_port_descriptors(const LilvPlugin* p)
+{
+	lilv_plugin_load_ports_if_necessary(p);
+	if (!p->port_descriptors && p->num_ports > 0) {
+		lilv_plugin_load_port_descriptors((LilvPlugin*)p);
+	}
+	return p->port_descriptors;
+}
+
 LILV_API void
 lilv_plugin_get_port_ranges_float(const LilvPlugin* p,
                                   float*            min_values,
                                   float*            max_values,
                                   float*            def_values)
 {
-	lilv_plugin_load_ports_if_necessary(p);
-	LilvNode*  min    = NULL;
-	LilvNode*  max    = NULL;
-	LilvNode*  def    = NULL;
-	LilvNode** minptr = min_values ? &min : NULL;
-	LilvNode** maxptr = max_values ? &max : NULL;
-	LilvNode** defptr = def_values ? &def : NULL;
-
+	const LilvPortDescriptor* descs = lilv_plugin_get_port_descriptors(p);
 	for (uint32_t i = 0; i < p->num_ports; ++i) {
-		lilv_port_get_range(p, p->ports[i], defptr, minptr, maxptr);
-
 		if (min_values) {
-			if (lilv_node_is_float(min) || lilv_node_is_int(min)) {
-				min_values[i] = lilv_node_as_float(min);
-			} else {
-				min_values[i] = NAN;
-			}
+			min_values[i] = descs[i].min;
 		}
-
 		if (max_values) {
-			if (lilv_node_is_float(max) || lilv_node_is_int(max)) {
-				max_values[i] = lilv_node_as_float(max);
-			} else {
-				max_values[i] = NAN;
-			}
+			max_values[i] = descs[i].max;
 		}
-
 		if (def_values) {
-			if (lilv_node_is_float(def) || lilv_node_is_int(def)) {
-				def_values[i] = lilv_node_as_float(def);
-			} else {
-				def_values[i] = NAN;
-			}
+			def_values[i] = descs[i].def;
 		}
-
-		lilv_node_free(def);
-		lilv_node_free(min);
-		lilv_node_free(max);
 	}
 }
 
@@ -30,11 +30,18 @@
 #define USTR(s) ((const uint8_t*)(s))
 
 typedef struct {
-	void*    value;  ///< Value/Object
-	size_t   size;   ///< Size of value
-	uint32_t key;    ///< Key/Predicate (URID)
-	uint32_t type;   ///< Type of value (URID)
-	uint32_t flags;  ///< State flags (POD, etc)
+	char* str;       ///< Literal string
+	char* datatype;  ///< Datatype URI, or NULL
+	char* lang;      ///< Language tag, or NULL
+} Literal;
+
+typedef struct {
+	void*     value;    ///< Value/Object
+	size_t    size;     ///< Size of value
+	uint32_t  key;      ///< Key/Predicate (URID)
+	uint32_t  type;     ///< Type of value (URID)
+	uint32_t  flags;    ///< State flags (POD, etc)
+	Literal*  literal;  ///< Literal to read value from, if not read yet
 } Property;
 
 typedef struct {
@@ -42,6 +49,7 @@ typedef struct {
 	void*    value;   ///< Value of port
 	uint32_t size;    ///< Size of value
 	uint32_t type;    ///< Type of value (URID)
+	uint32_t index;   ///< Index of port, or UINT32_MAX if not prepared
 } PortValue;
 
 typedef struct {
@@ -50,19 +58,22 @@ typedef struct {
 } PathMap;
 
 struct LilvStateImpl {
-	LilvNode*  plugin_uri;  ///< Plugin URI
-	char*      dir;         ///< Save directory (if saved)
-	char*      file_dir;    ///< Directory for files created by plugin
-	char*      copy_dir;    ///< Directory for snapshots of external files
-	char*      link_dir;    ///< Directory for links to external files
-	char*      label;       ///< State/Preset label
-	ZixTree*   abs2rel;     ///< PathMap sorted by abs
-	ZixTree*   rel2abs;     ///< PathMap sorted by rel
-	Property*  props;       ///< State properties
-	PortValue* values;      ///< Port values
-	uint32_t   atom_Path;   ///< atom:Path URID
-	uint32_t   num_props;   ///< Number of state properties
-	uint32_t   num_values;  ///< Number of port values
+	LV2_URID_Map* map;         ///< URID map (if properties are not read yet)
+	LilvNode*     uri;         ///< State URI (if loaded)
+	LilvNode*     plugin_uri;  ///< Plugin URI
+	char*         dir;         ///< Save directory (if saved)
+	char*         file_dir;    ///< Directory for files created by plugin
+	char*         copy_dir;    ///< Directory for snapshots of external files
+	char*         link_dir;    ///< Directory for links to external files
+	char*         label;       ///< State/Preset label
+	ZixTree*      abs2rel;     ///< PathMap sorted by abs
+	ZixTree*      rel2abs;     ///< PathMap sorted by rel
+	Property*     props;       ///< State properties
+	PortValue*    values;      ///< Port values
+	uint32_t      atom_Path;   ///< atom:Path URID
+	uint32_t      num_props;   ///< Number of state properties
+	uint32_t      num_values;  ///< Number of port values
+	uint32_t      num_unread;  ///< Number of properties not read yet
 };
 
 static int
@@ -113,6 +124,7 @@ append_port_value(LilvState*  state,
 		pv->value  = malloc(size);
 		pv->size   = size;
 		pv->type   = type;
+		pv->index  = UINT32_MAX;
 		memcpy(pv->value, value, size);
 		return pv;
 	}
@@ -167,7 +179,7 @@ retrieve_callback(LV2_State_Handle handle,
                   uint32_t*        flags)
 {
 	const LilvState* const state      = (LilvState*)handle;
-	const Property         search_key = { NULL, 0, key, 0, 0 };
+	const Property         search_key = { NULL, 0, key, 0, 0, NULL };
 	const Property* const  prop       = (Property*)bsearch(
 		&search_key, state->props, state->num_props,
 		sizeof(Property), property_cmp);
@@ -363,7 +375,11 @@ lilv_state_new_from_instance(const LilvPlugin*          plugin,
 				uint32_t size, type;
 				const char* sym   = lilv_node_as_string(port->symbol);
 				const void* value = get_value(sym, user_data, &size, &type);
-				append_port_value(state, sym, value, size, type);
+				PortValue*  pv    = append_port_value(
+					state, sym, value, size, type);
+				if (pv) {
+					pv->index = i;
+				}
 			}
 		}
 		lilv_node_free(lv2_ControlPort);
@@ -395,6 +411,137 @@ lilv_state_new_from_instance(const LilvPlugin*          plugin,
 	return state;
 }
 
+/** Copy the literal `node` so its value can be read later without a world. */
+static Literal*
+literal_new(const SordNode* node)
+{
+	const SordNode* datatype = sord_node_get_datatype(node);
+	const char*     lang     = sord_node_get_language(node);
+
+	Literal* const lit = (Literal*)malloc(sizeof(Literal));
+	lit->str      = lilv_strdup((const char*)sord_node_get_string(node));
+	lit->datatype = datatype
+		? lilv_strdup((const char*)sord_node_get_string(datatype))
+		: NULL;
+	lit->lang     = lilv_strdup(lang);
+	return lit;
+}
+
+static void
+literal_free(Literal* lit)
+{
+	if (lit) {
+		free(lit->str);
+		free(lit->datatype);
+		free(lit->lang);
+		free(lit);
+	}
+}
+
+/**
+   Read the value of every property of `state` that was loaded lazily into
+   the corresponding element of `props`, which may be `state->props`.
+
+   Literals are read in a private world, so this does not touch the world the
+   state was loaded from and is safe to call from any thread.
+*/
+static void
+lilv_state_read_values(const LilvState* state, Property* props)
+{
+	SordWorld*     world  = sord_world_new();
+	Sratom*        sratom = sratom_new(state->map);
+	SerdChunk      chunk  = { NULL, 0 };
+	LV2_Atom_Forge forge;
+	lv2_atom_forge_init(&forge, state->map);
+
+	for (uint32_t i = 0; i < state->num_props; ++i) {
+		const Literal* const lit  = state->props[i].literal;
+		Property* const      prop = &props[i];
+		if (!lit) {
+			continue;
+		}
+
+		SordNode* datatype = lit->datatype
+			? sord_new_uri(world, USTR(lit->datatype))
+			: NULL;
+		SordNode* node = sord_new_literal(world, datatype, USTR(lit->str),
+		                                  lit->lang);
+
+		chunk.len = 0;
+		lv2_atom_forge_set_sink(
+			&forge, sratom_forge_sink, sratom_forge_deref, &chunk);
+
+		sratom_read(sratom, &forge, world, NULL, node);
+		const LV2_Atom* atom = (const LV2_Atom*)chunk.buf;
+
+		prop->type  = atom->type;
+		prop->size  = atom->size;
+		prop->value = malloc(atom->size);
+		memcpy(prop->value, LV2_ATOM_BODY_CONST(atom), atom->size);
+		if (atom->type == forge.Path) {
+			prop->flags = LV2_STATE_IS_PORTABLE;
+		}
+
+		sord_node_free(world, node);
+		sord_node_free(world, datatype);
+	}
+
+	free((void*)chunk.buf);
+	sratom_free(sratom);
+	sord_world_free(world);
+}
+
+/** Read the values of properties that were loaded lazily into `state`. */
+static void
+lilv_state_read_properties(LilvState* state)
+{
+	if (!state->num_unread) {
+		return;
+	}
+
+	lilv_state_read_values(state, state->props);
+	for (uint32_t i = 0; i < state->num_props; ++i) {
+		literal_free(state->props[i].literal);
+		state->props[i].literal = NULL;
+	}
+
+	state->num_unread = 0;
+}
+
+/**
+   Return the properties of `state` with every value read.
+
+   A state is not modified by functions which take it as const, so if any
+   values have not been read yet, they are read into a new array which must
+   be freed with lilv_state_free_props().
+*/
+static Property*
+lilv_state_get_props(const LilvState* state)
+{
+	if (!state->num_unread) {
+		return state->props;
+	}
+
+	Property* props = (Property*)malloc(state->num_props * sizeof(Property));
+	memcpy(props, state->props, state->num_props * sizeof(Property));
+	lilv_state_read_values(state, props);
+	return props;
+}
+
+/** Free properties returned by lilv_state_get_props(). */
+static void
+lilv_state_free_props(const LilvState* state, Property* props)
+{
+	if (props != state->props) {
+		for (uint32_t i = 0; i < state->num_props; ++i) {
+			if (state->props[i].literal) {
+				free(props[i].value);
+			}
+		}
+		free(props);
+	}
+}
+
 LILV_API void
 lilv_state_restore(const LilvState*           state,
                    LilvInstance*              instance,
@@ -407,7 +554,12 @@ lilv_state_restore(const LilvState*           state,
 		LILV_ERROR("lilv_state_restore() called on NULL state\n");
 		return;
 	}
-		
+
+	// Properties are retrieved from a view of the state with every value read
+	LilvState view = *state;
+	view.props      = lilv_state_get_props(state);
+	view.num_unread = 0;
+
 	LV2_State_Map_Path map_path = {
 		(LilvState*)state, abstract_path, absolute_path };
 	LV2_Feature map_feature = { LV2_STATE__mapPath, &map_path };
@@ -421,10 +573,11 @@ lilv_state_restore(const LilvState*           state,
 
 	if (iface) {
 		iface->restore(instance->lv2_handle, retrieve_callback,
-		               (LV2_State_Handle)state, flags, sfeatures);
+		               (LV2_State_Handle)&view, flags, sfeatures);
 	}
 
 	free(sfeatures);
+	lilv_state_free_props(state, view.props);
 
 	if (set_value) {
 		for (uint32_t i = 0; i < state->num_values; ++i) {
@@ -435,12 +588,57 @@ lilv_state_restore(const LilvState*           state,
 	}
 }
 
+/** Resolve the port symbol of every port value to an index of `plugin`. */
+static int
+lilv_state_resolve_ports(LilvState* state, const LilvPlugin* plugin)
+{
+	int ret = 0;
+	for (uint32_t i = 0; i < state->num_values; ++i) {
+		PortValue* const value  = &state->values[i];
+		LilvNode* const  symbol = lilv_new_string(plugin->world, value->symbol);
+		const LilvPort*  port   = lilv_plugin_get_port_by_symbol(plugin,
+		                                                         symbol);
+		if (port) {
+			value->index = port->index;
+		} else {
+			LILV_ERRORF("State port `%s' not found on plugin %s\n",
+			            value->symbol, lilv_node_as_uri(plugin->plugin_uri));
+			value->index = UINT32_MAX;
+			ret          = 1;
+		}
+		lilv_node_free(symbol);
+	}
+
+	return ret;
+}
+
+LILV_API int
+lilv_state_prepare(LilvState* state, const LilvPlugin* plugin)
+{
+	lilv_state_read_properties(state);
+	return lilv_state_resolve_ports(state, plugin);
+}
+
+LILV_API void
+lilv_state_apply_port_values(const LilvState*            state,
+                             LilvSetPortValueByIndexFunc set_value,
+                             void*                       user_data)
+{
+	for (uint32_t i = 0; i < state->num_values; ++i) {
+		const PortValue* val = &state->values[i];
+		if (val->index != UINT32_MAX) {
+			set_value(val->index, user_data, val->value, val->size, val->type);
+		}
+	}
+}
+
 static LilvState*
 new_state_from_model(LilvWorld*       world,
                      LV2_URID_Map*    map,
                      SordModel*       model,
                      const SordNode*  node,
-                     const char*      dir)
+                     const char*      dir,
+                     bool             lazy)
 {
 	// Check that we know at least something about this state subject
 	if (!sord_ask(model, node, 0, 0, 0)) {
@@ -450,112 +648,154 @@ new_state_from_model(LilvWorld*       world,
 	// Allocate state
 	LilvState* const state = (LilvState*)malloc(sizeof(LilvState));
 	memset(state, '\0', sizeof(LilvState));
+	state->uri       = lilv_node_new_from_node(world, node);
 	state->dir       = lilv_strdup(dir);
 	state->atom_Path = map->map(map->handle, LV2_ATOM__Path);
 
-	// Get the plugin URI this state applies to
-	SordIter* i = sord_search(model, node, world->uris.lv2_appliesTo, 0, 0);
-	if (i) {
-		const SordNode* object = sord_iter_get_node(i, SORD_OBJECT);
-		const SordNode* graph  = sord_iter_get_node(i, SORD_GRAPH);
-		state->plugin_uri = lilv_node_new_from_node(world, object);
-		if (!state->dir && graph) {
-			state->dir = lilv_strdup((const char*)sord_node_get_string(graph));
+	Sratom*        sratom = sratom_new(map);
+	SerdChunk      chunk  = { NULL, 0 };
+	LV2_Atom_Forge forge;
+	lv2_atom_forge_init(&forge, map);
+
+	SordNode* statep = sord_new_uri(world->world, USTR(LV2_STATE__state));
+
+	const SordNode* applies_to  = NULL;
+	const SordNode* plugin_node = NULL;
+	const SordNode* label       = NULL;
+	const SordNode* label_graph = NULL;
+	const SordNode* port_label  = NULL;
+	const SordNode* state_node  = NULL;
+
+	// Read the state description in a single pass over its statements
+	SordIter* i = sord_search(model, node, 0, 0, 0);
+	FOREACH_MATCH(i) {
+		const SordNode* p = sord_iter_get_node(i, SORD_PREDICATE);
+		const SordNode* o = sord_iter_get_node(i, SORD_OBJECT);
+		const SordNode* g = sord_iter_get_node(i, SORD_GRAPH);
+		if (sord_node_equals(p, world->uris.lv2_appliesTo)) {
+			if (!state->plugin_uri) {
+				// Get the plugin URI this state applies to
+				state->plugin_uri = lilv_node_new_from_node(world, o);
+				applies_to        = g;
+			}
+		} else if (sord_node_equals(p, world->uris.rdf_a)) {
+			if (sord_node_equals(o, world->uris.lv2_Plugin)) {
+				// Loading plugin description as state (default state)
+				plugin_node = node;
+			}
+		} else if (sord_node_equals(p, world->uris.rdfs_label)) {
+			if (!label) {
+				label       = o;
+				label_graph = g;
+			}
+		} else if (sord_node_equals(p, statep)) {
+			if (!state_node) {
+				state_node = o;
+			}
+		} else if (sord_node_equals(p, world->uris.lv2_port)) {
+			// Get port symbol, value, and label in a single search
+			const SordNode* plabel = NULL;
+			const SordNode* symbol = NULL;
+			const SordNode* value  = NULL;
+			const SordNode* def    = NULL;
+			SordIter*       j      = sord_search(model, o, 0, 0, 0);
+			FOREACH_MATCH(j) {
+				const SordNode* pp = sord_iter_get_node(j, SORD_PREDICATE);
+				const SordNode* po = sord_iter_get_node(j, SORD_OBJECT);
+				if (sord_node_equals(pp, world->uris.rdfs_label)) {
+					plabel = plabel ? plabel : po;
+				} else if (sord_node_equals(pp, world->uris.lv2_symbol)) {
+					symbol = symbol ? symbol : po;
+				} else if (sord_node_equals(pp, world->uris.pset_value)) {
+					value = value ? value : po;
+				} else if (sord_node_equals(pp, world->uris.lv2_default)) {
+					def = def ? def : po;
+				}
+			}
+			sord_iter_free(j);
+
+			value = value ? value : def;
+			if (!symbol) {
+				LILV_ERRORF("State `%s' port missing symbol.\n",
+				            sord_node_get_string(node));
+			} else if (value) {
+				chunk.len = 0;
+				lv2_atom_forge_set_sink(
+					&forge, sratom_forge_sink, sratom_forge_deref, &chunk);
+
+				sratom_read(sratom, &forge, world->world, model, value);
+				const LV2_Atom* atom = (const LV2_Atom*)chunk.buf;
+
+				append_port_value(state,
+				                  (const char*)sord_node_get_string(symbol),
+				                  LV2_ATOM_BODY_CONST(atom),
+				                  atom->size, atom->type);
+
+				port_label = plabel ? plabel : port_label;
+			}
+		}
+	}
+	sord_iter_free(i);
+
+	if (state->plugin_uri) {
+		if (!state->dir && applies_to) {
+			state->dir = lilv_strdup(
+				(const char*)sord_node_get_string(applies_to));
 		}
-		sord_iter_free(i);
-	} else if (sord_ask(model,
-	                    node,
-	                    world->uris.rdf_a,
-	                    world->uris.lv2_Plugin, 0)) {
-		// Loading plugin description as state (default state)
-		state->plugin_uri = lilv_node_new_from_node(world, node);
+	} else if (plugin_node) {
+		state->plugin_uri = lilv_node_new_from_node(world, plugin_node);
 	} else {
 		LILV_ERRORF("State %s missing lv2:appliesTo property\n",
 		            sord_node_get_string(node));
 	}
 
-	// Get the state label
-	i = sord_search(model, node, world->uris.rdfs_label, NULL, NULL);
-	if (i) {
-		const SordNode* object = sord_iter_get_node(i, SORD_OBJECT);
-		const SordNode* graph  = sord_iter_get_node(i, SORD_GRAPH);
-		state->label = lilv_strdup((const char*)sord_node_get_string(object));
-		if (!state->dir) {
-			state->dir = lilv_strdup((const char*)sord_node_get_string(graph));
+	// Get the state label (which a port label overrides)
+	if (label) {
+		state->label = lilv_strdup((const char*)sord_node_get_string(label));
+		if (!state->dir && label_graph) {
+			state->dir = lilv_strdup(
+				(const char*)sord_node_get_string(label_graph));
 		}
-		sord_iter_free(i);
 	}
-
-	Sratom*        sratom = sratom_new(map);
-	SerdChunk      chunk  = { NULL, 0 };
-	LV2_Atom_Forge forge;
-	lv2_atom_forge_init(&forge, map);
-	lv2_atom_forge_set_sink(
-		&forge, sratom_forge_sink, sratom_forge_deref, &chunk);
-
-	// Get port values
-	SordIter* ports = sord_search(model, node, world->uris.lv2_port, 0, 0);
-	FOREACH_MATCH(ports) {
-		const SordNode* port = sord_iter_get_node(ports, SORD_OBJECT);
-
-		SordNode* label  = sord_get(model, port, world->uris.rdfs_label, 0, 0);
-		SordNode* symbol = sord_get(model, port, world->uris.lv2_symbol, 0, 0);
-		SordNode* value  = sord_get(model, port, world->uris.pset_value, 0, 0);
-		if (!value) {
-			value = sord_get(model, port, world->uris.lv2_default, 0, 0);
-		}
-		if (!symbol) {
-			LILV_ERRORF("State `%s' port missing symbol.\n",
-			            sord_node_get_string(node));
-		} else if (value) {
-			chunk.len = 0;
-			sratom_read(sratom, &forge, world->world, model, value);
-			const LV2_Atom* atom = (const LV2_Atom*)chunk.buf;
-
-			append_port_value(state,
-			                  (const char*)sord_node_get_string(symbol),
-			                  LV2_ATOM_BODY_CONST(atom),
-			                  atom->size, atom->type);
-
-			if (label) {
-				lilv_state_set_label(state,
-				                     (const char*)sord_node_get_string(label));
-			}
-		}
-		sord_node_free(world->world, value);
-		sord_node_free(world->world, symbol);
-		sord_node_free(world->world, label);
+	if (port_label) {
+		lilv_state_set_label(state,
+		                     (const char*)sord_node_get_string(port_label));
 	}
-	sord_iter_free(ports);
 
 	// Get properties
-	SordNode* statep     = sord_new_uri(world->world, USTR(LV2_STATE__state));
-	SordNode* state_node = sord_get(model, node, statep, NULL, NULL);
 	if (state_node) {
 		SordIter* props = sord_search(model, state_node, 0, 0, 0);
 		FOREACH_MATCH(props) {
 			const SordNode* p = sord_iter_get_node(props, SORD_PREDICATE);
 			const SordNode* o = sord_iter_get_node(props, SORD_OBJECT);
 
-			chunk.len = 0;
-			lv2_atom_forge_set_sink(
-				&forge, sratom_forge_sink, sratom_forge_deref, &chunk);
-
-			sratom_read(sratom, &forge, world->world, model, o);
-			const LV2_Atom* atom  = (const LV2_Atom*)chunk.buf;
-			uint32_t        flags = LV2_STATE_IS_POD|LV2_STATE_IS_PORTABLE;
-			Property        prop  = { NULL, 0, 0, 0, flags };
-
-			prop.key   = map->map(map->handle, (const char*)sord_node_get_string(p));
-			prop.type  = atom->type;
-			prop.size  = atom->size;
-			prop.value = malloc(atom->size);
-			memcpy(prop.value, LV2_ATOM_BODY_CONST(atom), atom->size);
-			if (atom->type == forge.Path) {
-				prop.flags = LV2_STATE_IS_PORTABLE;
+			uint32_t flags = LV2_STATE_IS_POD|LV2_STATE_IS_PORTABLE;
+			Property prop  = { NULL, 0, 0, 0, flags, NULL };
+
+			prop.key = map->map(map->handle,
+			                    (const char*)sord_node_get_string(p));
+			if (lazy && sord_node_get_type(o) == SORD_LITERAL) {
+				// Literals need no model, so read the value when it is needed
+				prop.literal = literal_new(o);
+				++state->num_unread;
+			} else {
+				chunk.len = 0;
+				lv2_atom_forge_set_sink(
+					&forge, sratom_forge_sink, sratom_forge_deref, &chunk);
+
+				sratom_read(sratom, &forge, world->world, model, o);
+				const LV2_Atom* atom = (const LV2_Atom*)chunk.buf;
+
+				prop.type  = atom->type;
+				prop.size  = atom->size;
+				prop.value = malloc(atom->size);
+				memcpy(prop.value, LV2_ATOM_BODY_CONST(atom), atom->size);
+				if (atom->type == forge.Path) {
+					prop.flags = LV2_STATE_IS_PORTABLE;
+				}
 			}
 
-			if (prop.value) {
+			if (prop.value || prop.literal) {
 				state->props = (Property*)realloc(
 					state->props, (++state->num_props) * sizeof(Property));
 				state->props[state->num_props - 1] = prop;
@@ -563,9 +803,12 @@ new_state_from_model(LilvWorld*       world,
 		}
 		sord_iter_free(props);
 	}
-	sord_node_free(world->world, state_node);
 	sord_node_free(world->world, statep);
 
+	if (state->num_unread) {
+		state->map = map;
+	}
+
 	free((void*)chunk.buf);
 	sratom_free(sratom);
 
@@ -586,7 +829,8 @@ lilv_state_new_from_world(LilvWorld*      world,
 		return NULL;
 	}
 
-	return new_state_from_model(world, map, world->model, node->node, NULL);
+	return new_state_from_model(
+		world, map, world->model, node->node, NULL, false);
 }
 
 LILV_API LilvState*
@@ -617,7 +861,7 @@ lilv_state_new_from_file(LilvWorld*      world,
 	char* dirname   = lilv_dirname(path);
 	char* real_path = lilv_realpath(dirname);
 	LilvState* state = new_state_from_model(
-		world, map, model, subject_node, real_path);
+		world, map, model, subject_node, real_path, false);
 	free(dirname);
 	free(real_path);
 
@@ -662,7 +906,7 @@ lilv_state_new_from_string(LilvWorld*    world,
 	SordNode* o = sord_new_uri(world->world, USTR(LV2_PRESETS__Preset));
 	SordNode* s = sord_get(model, NULL, world->uris.rdf_a, o, NULL);
 
-	LilvState* state = new_state_from_model(world, map, model, s, NULL);
+	LilvState* state = new_state_from_model(world, map, model, s, NULL, false);
 
 	sord_node_free(world->world, s);
 	sord_node_free(world->world, o);
@@ -673,6 +917,95 @@ lilv_state_new_from_string(LilvWorld*    world,
 	return state;
 }
 
+int
+lilv_state_compare_by_uri(const void* a, const void* b, void* user_data)
+{
+	return strcmp(lilv_node_as_string(((const LilvState*)a)->uri),
+	              lilv_node_as_string(((const LilvState*)b)->uri));
+}
+
+LILV_API LilvStates*
+lilv_plugin_load_presets(const LilvPlugin* plugin, LV2_URID_Map* map)
+{
+	LilvWorld* const world  = plugin->world;
+	SordNode*        preset = sord_new_uri(world->world,
+	                                       USTR(LV2_PRESETS__Preset));
+
+	// Copy statements first, since loading data files modifies the model
+	SordModel* applies = lilv_world_filter_model(world,
+	                                             world->model,
+	                                             NULL,
+	                                             world->uris.lv2_appliesTo,
+	                                             plugin->plugin_uri->node,
+	                                             NULL);
+
+	// Find the distinct data files of all presets
+	ZixTree*  files = zix_tree_new(false, lilv_resource_node_cmp, NULL,
+	                               (ZixDestroyFunc)lilv_node_free);
+	SordIter* i     = sord_begin(applies);
+	FOREACH_MATCH(i) {
+		const SordNode* s = sord_iter_get_node(i, SORD_SUBJECT);
+		if (!sord_ask(world->model, s, world->uris.rdf_a, preset, NULL)) {
+			continue;
+		}
+
+		SordIter* f = sord_search(
+			world->model, s, world->uris.rdfs_seeAlso, NULL, NULL);
+		FOREACH_MATCH(f) {
+			const SordNode* file = sord_iter_get_node(f, SORD_OBJECT);
+			if (sord_node_get_type(file) != SORD_URI) {
+				LILV_ERRORF("rdfs:seeAlso node `%s' is not a URI\n",
+				            sord_node_get_string(file));
+				continue;
+			}
+
+			LilvNode* node = lilv_node_new_from_node(world, file);
+			if (zix_tree_insert(files, node, NULL)) {
+				lilv_node_free(node);  // Already found
+			}
+		}
+		sord_iter_free(f);
+	}
+	sord_iter_free(i);
+
+	// Load each data file once
+	for (ZixTreeIter* f = zix_tree_begin(files);
+	     !zix_tree_iter_is_end(f);
+	     f = zix_tree_iter_next(f)) {
+		const LilvNode* file = (const LilvNode*)zix_tree_get(f);
+		lilv_world_load_graph(world, file->node, file);
+	}
+	zix_tree_free(files);
+
+	// Build a state for each preset, reading property values lazily
+	LilvStates* states = lilv_states_new();
+	i = sord_begin(applies);
+	FOREACH_MATCH(i) {
+		const SordNode* s   = sord_iter_get_node(i, SORD_SUBJECT);
+		LilvNode        uri = { world, (SordNode*)s, LILV_VALUE_URI, { 0 } };
+		LilvState       key;
+		ZixTreeIter*    iter = NULL;
+		memset(&key, '\0', sizeof(key));
+		key.uri = &uri;
+		if (!zix_tree_find((ZixTree*)states, &key, &iter)
+		    || !sord_ask(world->model, s, world->uris.rdf_a, preset, NULL)) {
+			continue;  // Already loaded, or not a preset
+		}
+
+		LilvState* state = new_state_from_model(
+			world, map, world->model, s, NULL, true);
+		if (state) {
+			lilv_state_resolve_ports(state, plugin);
+			zix_tree_insert((ZixTree*)states, state, NULL);
+		}
+	}
+	sord_iter_free(i);
+
+	sord_free(applies);
+	sord_node_free(world->world, preset);
+	return states;
+}
+
 static SerdWriter*
 ttl_writer(SerdSink sink, void* stream, const SerdNode* base, SerdEnv** new_env)
 {
@@ -861,8 +1194,9 @@ lilv_state_write(LilvWorld*       world,
 		serd_writer_write_statement(writer, SERD_ANON_O_BEGIN, NULL,
 		                            &subject, &p, &state_node, NULL, NULL);
 	}
+	Property* const props = lilv_state_get_props(state);
 	for (uint32_t i = 0; i < state->num_props; ++i) {
-		Property*   prop = &state->props[i];
+		Property*   prop = &props[i];
 		const char* key  = unmap->unmap(unmap->handle, prop->key);
 
 		p = serd_node_from_string(SERD_URI, USTR(key));
@@ -877,6 +1211,7 @@ lilv_state_write(LilvWorld*       world,
 			             &state_node, &p, prop->type, prop->size, prop->value);
 		}
 	}
+	lilv_state_free_props(state, props);
 	if (state->num_props > 0) {
 		serd_writer_end_anon(writer, &state_node);
 	}
@@ -1012,12 +1347,14 @@ lilv_state_free(LilvState* state)
 {
 	if (state) {
 		for (uint32_t i = 0; i < state->num_props; ++i) {
+			literal_free(state->props[i].literal);
 			free(state->props[i].value);
 		}
 		for (uint32_t i = 0; i < state->num_values; ++i) {
 			free(state->values[i].value);
 			free(state->values[i].symbol);
 		}
+		lilv_node_free(state->uri);
 		lilv_node_free(state->plugin_uri);
 		zix_tree_free(state->abs2rel);
 		zix_tree_free(state->rel2abs);
@@ -1054,25 +1391,28 @@ lilv_state_equals(const LilvState* a, const LilvState* b)
 		}
 	}
 
-	for (uint32_t i = 0; i < a->num_props; ++i) {
-		Property* const ap = &a->props[i];
-		Property* const bp = &b->props[i];
+	Property* const a_props = lilv_state_get_props(a);
+	Property* const b_props = lilv_state_get_props(b);
+	bool            equal   = true;
+	for (uint32_t i = 0; equal && i < a->num_props; ++i) {
+		Property* const ap = &a_props[i];
+		Property* const bp = &b_props[i];
 		if (ap->key != bp->key
 		    || ap->type != bp->type
 		    || ap->flags != bp->flags) {
-			return false;
+			equal = false;
 		} else if (ap->type == a->atom_Path) {
-			if (!lilv_file_equals(lilv_state_rel2abs(a, (char*)ap->value),
-			                      lilv_state_rel2abs(b, (char*)bp->value))) {
-				return false;
-			}
+			equal = lilv_file_equals(lilv_state_rel2abs(a, (char*)ap->value),
+			                         lilv_state_rel2abs(b, (char*)bp->value));
 		} else if (ap->size != bp->size
 		           || memcmp(ap->value, bp->value, ap->size)) {
-			return false;
+			equal = false;
 		}
 	}
 
-	return true;
+	lilv_state_free_props(b, b_props);
+	lilv_state_free_props(a, a_props);
+	return equal;
 }
 
 LILV_API unsigned
@@ -1081,6 +1421,12 @@ lilv_state_get_num_properties(const LilvState* state)
 	return state->num_props;
 }
 
+LILV_API const LilvNode*
+lilv_state_get_uri(const LilvState* state)
+{
+	return state->uri;
+}
+
 LILV_API const LilvNode*
 lilv_state_get_plugin_uri(const LilvState* state)
 {
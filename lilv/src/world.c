@@ -23,6 +23,18 @@
 
 #include "lilv_internal.h"
 
+#ifdef HAVE_PTHREAD
+#    include <pthread.h>
+#    include <unistd.h>
+#endif
+
+/** A file to load, which may be parsed in advance by another thread. */
+typedef struct {
+	const LilvNode*  uri;     ///< File to load
+	SordNode*        graph;   ///< Graph to load file into, or NULL
+	LilvCacheRecord* record;  ///< Statements parsed in advance, or NULL
+} LilvLoadJob;
+
 LILV_API LilvWorld*
 lilv_world_new(void)
 {
@@ -42,7 +54,8 @@ lilv_world_new(void)
 	world->loaded_files   = zix_tree_new(
 		false, lilv_resource_node_cmp, NULL, (ZixDestroyFunc)lilv_node_free);
 
-	world->libs = zix_tree_new(false, lilv_lib_compare, NULL, NULL);
+	world->libs  = zix_tree_new(false, lilv_lib_compare, NULL, NULL);
+	world->cache = NULL;
 
 #define NS_DCTERMS "http://purl.org/dc/terms/"
 #define NS_DYNMAN  "http://lv2plug.in/ns/ext/dynmanifest#"
@@ -140,6 +153,9 @@ lilv_world_free(LilvWorld* world)
 	zix_tree_free((ZixTree*)world->plugin_classes);
 	world->plugin_classes = NULL;
 
+	lilv_cache_free(world->cache);
+	world->cache = NULL;
+
 	sord_free(world->model);
 	world->model = NULL;
 
@@ -164,6 +180,12 @@ lilv_world_set_option(LilvWorld*      world,
 			world->opt.filter_language = lilv_node_as_bool(value);
 			return;
 		}
+	} else if (!strcmp(option, LILV_OPTION_CACHE)) {
+		if (lilv_node_is_string(value)) {
+			lilv_cache_free(world->cache);
+			world->cache = lilv_cache_new(lilv_node_as_string(value));
+			return;
+		}
 	}
 	LILV_WARNF("Unrecognized or invalid option `%s'\n", option);
 }
@@ -423,16 +445,7 @@ lilv_world_add_plugin(LilvWorld*       world,
 SerdStatus
 lilv_world_load_graph(LilvWorld* world, SordNode* graph, const LilvNode* uri)
 {
-	const SerdNode* base   = sord_node_to_serd_node(uri->node);
-	SerdEnv*        env    = serd_env_new(base);
-	SerdReader*     reader = sord_new_reader(
-		world->model, env, SERD_TURTLE, graph);
-
-	const SerdStatus st = lilv_world_load_file(world, reader, uri);
-
-	serd_env_free(env);
-	serd_reader_free(reader);
-	return st;
+	return lilv_world_load_file(world, graph, uri);
 }
 
 static void
@@ -576,26 +589,117 @@ lilv_world_get_manifest_uri(LilvWorld* world, LilvNode* bundle_uri)
 	return manifest;
 }
 
-LILV_API void
-lilv_world_load_bundle(LilvWorld* world, LilvNode* bundle_uri)
+static SerdStatus
+lilv_world_load_parsed(LilvWorld*       world,
+                       SordNode*        graph,
+                       const LilvNode*  uri,
+                       LilvCacheRecord* record);
+
+#ifdef HAVE_PTHREAD
+/** Shared state of threads parsing files in advance. */
+typedef struct {
+	LilvWorld*      world;
+	LilvLoadJob*    jobs;
+	size_t          n_jobs;
+	size_t          next;   ///< Index of next job to parse
+	pthread_mutex_t mutex;
+} LilvParser;
+
+static void*
+lilv_parser_run(void* data)
 {
-	if (!lilv_node_is_uri(bundle_uri)) {
-		LILV_ERRORF("Bundle URI `%s' is not a URI\n",
-		            sord_node_get_string(bundle_uri->node));
-		return;
+	LilvParser* const parser = (LilvParser*)data;
+	LilvWorld* const  world  = parser->world;
+
+	// Nodes can not be shared between threads, so each has its own world
+	SordWorld* const sworld = sord_world_new();
+	for (;;) {
+		pthread_mutex_lock(&parser->mutex);
+		LilvLoadJob* const job = (parser->next < parser->n_jobs)
+			? &parser->jobs[parser->next++] : NULL;
+		pthread_mutex_unlock(&parser->mutex);
+		if (!job) {
+			break;
+		}
+
+		// Skip files which will not be parsed when loaded anyway
+		ZixTreeIter* iter = NULL;
+		if (!zix_tree_find((ZixTree*)world->loaded_files, job->uri, &iter) ||
+		    (world->cache && lilv_cache_has_file(world->cache, job->uri))) {
+			continue;
+		}
+
+		SerdStatus st = SERD_SUCCESS;
+		job->record = lilv_cache_record_parse(sworld, job->uri, &st);
 	}
+	sord_world_free(sworld);
+	return NULL;
+}
+#endif
+
+/**
+   Parse the files of `jobs` in parallel, in advance of loading them.
 
+   The world is not modified, jobs are only given records which
+   lilv_world_load_parsed() loads into the model.  This way, the world is
+   built in the same order, with the same blank node IDs, as if every file was
+   parsed as it is loaded.  A job which could not be parsed in advance, for
+   whatever reason, is simply parsed when it is loaded.
+*/
+static void
+lilv_world_parse_jobs(LilvWorld* world, LilvLoadJob* jobs, size_t n_jobs)
+{
+#if defined(HAVE_PTHREAD) && defined(_SC_NPROCESSORS_ONLN)
+	long n_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (n_threads > (long)n_jobs) {
+		n_threads = (long)n_jobs;
+	}
+	if (n_threads < 2) {
+		return;  // Parse as files are loaded instead
+	}
+
+	LilvParser parser;
+	parser.world  = world;
+	parser.jobs   = jobs;
+	parser.n_jobs = n_jobs;
+	parser.next   = 0;
+	pthread_mutex_init(&parser.mutex, NULL);
+
+	// Parse in this thread as well as n_threads - 1 others
+	pthread_t* threads   = (pthread_t*)malloc(
+		(n_threads - 1) * sizeof(pthread_t));
+	long       n_started = 0;
+	while (n_started < n_threads - 1 &&
+	       !pthread_create(&threads[n_started], NULL, lilv_parser_run, &parser)) {
+		++n_started;
+	}
+
+	lilv_parser_run(&parser);
+	for (long i = 0; i < n_started; ++i) {
+		pthread_join(threads[i], NULL);
+	}
+
+	free(threads);
+	pthread_mutex_destroy(&parser.mutex);
+#endif
+}
+
+/** Load the manifest of a bundle and discover the plugins it describes. */
+static void
+lilv_world_load_parsed_bundle(LilvWorld*       world,
+                              LilvNode*        bundle_uri,
+                              const LilvNode*  manifest,
+                              LilvCacheRecord* record)
+{
 	SordNode* bundle_node = bundle_uri->node;
-	LilvNode* manifest    = lilv_world_get_manifest_uri(world, bundle_uri);
 
 	// Read manifest into model with graph = bundle_node
-	SerdStatus st = lilv_world_load_graph(world, bundle_node, manifest);
+	SerdStatus st = lilv_world_load_parsed(world, bundle_node, manifest, record);
 	if (st > SERD_FAILURE) {
 		LILV_ERRORF("Error reading %s\n", lilv_node_as_string(manifest));
-		lilv_node_free(manifest);
 		return;
 	}
-		
+
 	// ?plugin a lv2:Plugin
 	SordIter* plug_results = sord_search(world->model,
 	                                     NULL,
@@ -621,10 +725,48 @@ lilv_world_load_bundle(LilvWorld* world, LilvNode* bundle_uri)
 		lilv_world_add_spec(world, spec, bundle_node);
 	}
 	sord_iter_free(spec_results);
+}
 
+LILV_API void
+lilv_world_load_bundle(LilvWorld* world, LilvNode* bundle_uri)
+{
+	if (!lilv_node_is_uri(bundle_uri)) {
+		LILV_ERRORF("Bundle URI `%s' is not a URI\n",
+		            sord_node_get_string(bundle_uri->node));
+		return;
+	}
+
+	LilvNode* manifest = lilv_world_get_manifest_uri(world, bundle_uri);
+	lilv_world_load_parsed_bundle(world, bundle_uri, manifest, NULL);
 	lilv_node_free(manifest);
 }
 
+/**
+   Load several bundles in order.
+
+   Manifests are parsed in parallel first, then loaded and searched one bundle
+   at a time exactly as lilv_world_load_bundle() would.
+*/
+static void
+lilv_world_load_bundles(LilvWorld* world, LilvNode** bundles, size_t n_bundles)
+{
+	LilvLoadJob* jobs = (LilvLoadJob*)calloc(n_bundles, sizeof(LilvLoadJob));
+	for (size_t i = 0; i < n_bundles; ++i) {
+		jobs[i].uri   = lilv_world_get_manifest_uri(world, bundles[i]);
+		jobs[i].graph = bundles[i]->node;
+	}
+
+	lilv_world_parse_jobs(world, jobs, n_bundles);
+
+	for (size_t i = 0; i < n_bundles; ++i) {
+		lilv_world_load_parsed_bundle(
+			world, bundles[i], jobs[i].uri, jobs[i].record);
+		lilv_node_free((LilvNode*)jobs[i].uri);
+	}
+
+	free(jobs);
+}
+
 static int
 lilv_world_drop_graph(LilvWorld* world, LilvNode* graph)
 {
@@ -666,30 +808,38 @@ lilv_world_unload_bundle(LilvWorld* world, LilvNode* bundle_uri)
 	return lilv_world_drop_graph(world, bundle_uri);
 }
 
+/** Bundles found while scanning directories, in the order they were found. */
+typedef struct {
+	LilvWorld* world;
+	LilvNode** bundles;
+	size_t     n_bundles;
+} LilvBundleList;
+
 static void
 load_dir_entry(const char* dir, const char* name, void* data)
 {
-	LilvWorld* world = (LilvWorld*)data;
+	LilvBundleList* list = (LilvBundleList*)data;
 	if (!strcmp(name, ".") || !strcmp(name, ".."))
 		return;
 
 	char*     path = lilv_strjoin(dir, "/", name, "/", NULL);
 	SerdNode  suri = serd_node_new_file_uri((const uint8_t*)path, 0, 0, true);
-	LilvNode* node = lilv_new_uri(world, (const char*)suri.buf);
+	LilvNode* node = lilv_new_uri(list->world, (const char*)suri.buf);
 
-	lilv_world_load_bundle(world, node);
-	lilv_node_free(node);
+	list->bundles = (LilvNode**)realloc(
+		list->bundles, ++list->n_bundles * sizeof(LilvNode*));
+	list->bundles[list->n_bundles - 1] = node;
 	serd_node_free(&suri);
 	free(path);
 }
 
-/** Load all bundles in the directory at `dir_path`. */
+/** Find all bundles in the directory at `dir_path`. */
 static void
-lilv_world_load_directory(LilvWorld* world, const char* dir_path)
+lilv_world_load_directory(LilvBundleList* list, const char* dir_path)
 {
 	char* path = lilv_expand(dir_path);
 	if (path) {
-		lilv_dir_for_each(path, world, load_dir_entry);
+		lilv_dir_for_each(path, list, load_dir_entry);
 		free(path);
 	}
 }
@@ -714,6 +864,7 @@ static void
 lilv_world_load_path(LilvWorld*  world,
                      const char* lv2_path)
 {
+	LilvBundleList list = { world, NULL, 0 };
 	while (lv2_path[0] != '\0') {
 		const char* const sep = first_path_sep(lv2_path);
 		if (sep) {
@@ -721,25 +872,45 @@ lilv_world_load_path(LilvWorld*  world,
 			char* const  dir     = (char*)malloc(dir_len + 1);
 			memcpy(dir, lv2_path, dir_len);
 			dir[dir_len] = '\0';
-			lilv_world_load_directory(world, dir);
+			lilv_world_load_directory(&list, dir);
 			free(dir);
 			lv2_path += dir_len + 1;
 		} else {
-			lilv_world_load_directory(world, lv2_path);
+			lilv_world_load_directory(&list, lv2_path);
 			lv2_path = "\0";
 		}
 	}
+
+	lilv_world_load_bundles(world, list.bundles, list.n_bundles);
+	for (size_t i = 0; i < list.n_bundles; ++i) {
+		lilv_node_free(list.bundles[i]);
+	}
+	free(list.bundles);
 }
 
 void
 lilv_world_load_specifications(LilvWorld* world)
 {
+	size_t n_files = 0;
+	for (LilvSpec* spec = world->specs; spec; spec = spec->next) {
+		n_files += lilv_nodes_size(spec->data_uris);
+	}
+
+	LilvLoadJob* jobs = (LilvLoadJob*)calloc(n_files, sizeof(LilvLoadJob));
+	size_t       n    = 0;
 	for (LilvSpec* spec = world->specs; spec; spec = spec->next) {
 		LILV_FOREACH(nodes, f, spec->data_uris) {
-			LilvNode* file = (LilvNode*)lilv_collection_get(spec->data_uris, f);
-			lilv_world_load_graph(world, NULL, file);
+			jobs[n++].uri = lilv_collection_get(spec->data_uris, f);
 		}
 	}
+
+	lilv_world_parse_jobs(world, jobs, n_files);
+
+	for (size_t i = 0; i < n_files; ++i) {
+		lilv_world_load_parsed(world, NULL, jobs[i].uri, jobs[i].record);
+	}
+
+	free(jobs);
 }
 
 void
@@ -815,17 +986,49 @@ lilv_world_load_all(LilvWorld* world)
 	lilv_world_load_plugin_classes(world);
 }
 
-SerdStatus
-lilv_world_load_file(LilvWorld* world, SerdReader* reader, const LilvNode* uri)
+/**
+   Load a file into the world model, from `record` if it was parsed in advance.
+   This takes ownership of `record`, which may be NULL.
+*/
+static SerdStatus
+lilv_world_load_parsed(LilvWorld*       world,
+                       SordNode*        graph,
+                       const LilvNode*  uri,
+                       LilvCacheRecord* record)
 {
 	ZixTreeIter* iter;
 	if (!zix_tree_find((ZixTree*)world->loaded_files, uri, &iter)) {
+		lilv_cache_record_free(record);
 		return SERD_FAILURE;  // File has already been loaded
 	}
 
-	serd_reader_add_blank_prefix(reader, lilv_world_blank_node_prefix(world));
-	const SerdStatus st = serd_reader_read_file(
-		reader, sord_node_get_string(uri->node));
+	const uint8_t* prefix = lilv_world_blank_node_prefix(world);
+	SerdStatus     st     = SERD_ERR_NOT_FOUND;
+	if (record) {
+		st = lilv_cache_record_load(record, world, graph, prefix);
+		if (world->cache && !st) {
+			lilv_cache_add_record(world->cache, record);
+		} else {
+			lilv_cache_record_free(record);
+		}
+	} else if (world->cache) {
+		st = lilv_cache_load_file(world->cache, world, graph, uri, prefix);
+	}
+
+	if (st == SERD_ERR_NOT_FOUND) {
+		// No cache, or not a local file, parse directly into the model
+		const SerdNode* base   = sord_node_to_serd_node(uri->node);
+		SerdEnv*        env    = serd_env_new(base);
+		SerdReader*     reader = sord_new_reader(
+			world->model, env, SERD_TURTLE, graph);
+
+		serd_reader_add_blank_prefix(reader, prefix);
+		st = serd_reader_read_file(reader, sord_node_get_string(uri->node));
+
+		serd_reader_free(reader);
+		serd_env_free(env);
+	}
+
 	if (st) {
 		LILV_ERRORF("Error loading file `%s'\n", lilv_node_as_string(uri));
 		return st;
@@ -837,6 +1040,12 @@ lilv_world_load_file(LilvWorld* world, SerdReader* reader, const LilvNode* uri)
 	return SERD_SUCCESS;
 }
 
+SerdStatus
+lilv_world_load_file(LilvWorld* world, SordNode* graph, const LilvNode* uri)
+{
+	return lilv_world_load_parsed(world, graph, uri, NULL);
+}
+
 LILV_API int
 lilv_world_load_resource(LilvWorld*      world,
                          const LilvNode* resource)
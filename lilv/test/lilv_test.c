@@ -1268,6 +1268,79 @@ test_port(void)
 
 /*****************************************************************************/
 
+static int
+test_port_descriptors(void)
+{
+	if (!start_bundle(MANIFEST_PREFIXES
+			":plug a lv2:Plugin ; lv2:binary <foo" SHLIB_EXT "> ; rdfs:seeAlso <plugin.ttl> .\n",
+			BUNDLE_PREFIXES PREFIX_LV2EV
+			"@prefix pprops: <http://lv2plug.in/ns/ext/port-props#> .\n"
+			"@prefix rsz: <http://lv2plug.in/ns/ext/resize-port#> .\n"
+			":plug a lv2:Plugin ; "
+			PLUGIN_NAME("Test plugin") " ; "
+			LICENSE_GPL " ; "
+			"lv2:port [ "
+			"  a lv2:ControlPort , lv2:InputPort ; "
+			"  lv2:index 0 ; lv2:symbol \"gain\" ; lv2:name \"Gain\" ; "
+			"  lv2:portProperty lv2:integer , pprops:logarithmic , :unknown ; "
+			"  lv2:minimum 1 ; lv2:maximum 10.0 ; lv2:default \"bad\" ; "
+			"  lv2:designation lv2:freeWheeling "
+			"] , [\n"
+			"  a atom:AtomPort , lv2:OutputPort ; "
+			"  lv2:index 1 ; lv2:symbol \"notify\" ; lv2:name \"Notify\" ; "
+			"  atom:bufferType atom:Sequence ; "
+			"  rsz:minimumSize 4096 ; "
+			"  lv2:portProperty lv2:connectionOptional "
+			"] , [\n"
+			"  a lv2ev:EventPort , lv2:InputPort , :OtherPort ; "
+			"  lv2:index 2 ; lv2:symbol \"events\" ; lv2:name \"Events\" "
+			"] ."))
+		return 0;
+
+	init_uris();
+	const LilvPlugins* plugins = lilv_world_get_all_plugins(world);
+	const LilvPlugin*  plug    = lilv_plugins_get_by_uri(plugins, plugin_uri_value);
+	TEST_ASSERT(plug);
+
+	const LilvPortDescriptor* descs = lilv_plugin_get_port_descriptors(plug);
+	TEST_ASSERT(descs);
+	TEST_ASSERT(descs == lilv_plugin_get_port_descriptors(plug));
+
+	TEST_ASSERT(descs[0].classes == (LILV_PORT_CONTROL | LILV_PORT_INPUT));
+	TEST_ASSERT(descs[0].properties ==
+	            (LILV_PORT_INTEGER | LILV_PORT_LOGARITHMIC));
+	TEST_ASSERT(descs[0].min == 1.0f);
+	TEST_ASSERT(descs[0].max == 10.0f);
+	TEST_ASSERT(isnan(descs[0].def));
+	TEST_ASSERT(descs[0].minimum_size == 0);
+	TEST_ASSERT(!strcmp(lilv_node_as_uri(descs[0].designation),
+	                    LILV_NS_LV2 "freeWheeling"));
+	TEST_ASSERT(!descs[0].buffer_type);
+
+	TEST_ASSERT(descs[1].classes == (LILV_PORT_ATOM | LILV_PORT_OUTPUT));
+	TEST_ASSERT(descs[1].properties == LILV_PORT_CONNECTION_OPTIONAL);
+	TEST_ASSERT(isnan(descs[1].min));
+	TEST_ASSERT(isnan(descs[1].max));
+	TEST_ASSERT(descs[1].minimum_size == 4096);
+	TEST_ASSERT(!descs[1].designation);
+	TEST_ASSERT(!strcmp(lilv_node_as_uri(descs[1].buffer_type),
+	                    "http://lv2plug.in/ns/ext/atom#Sequence"));
+
+	TEST_ASSERT(descs[2].classes == (LILV_PORT_EVENT | LILV_PORT_INPUT));
+	TEST_ASSERT(descs[2].properties == 0);
+
+	// Descriptors agree with the ranges from the older API
+	float mins[3], maxs[3], defs[3];
+	lilv_plugin_get_port_ranges_float(plug, mins, maxs, defs);
+	TEST_ASSERT(mins[0] == 1.0f && maxs[0] == 10.0f && isnan(defs[0]));
+	TEST_ASSERT(isnan(mins[2]) && isnan(maxs[2]) && isnan(defs[2]));
+
+	cleanup_uris();
+	return 1;
+}
+
+/*****************************************************************************/
+
 static unsigned
 ui_supported(const char* container_type_uri,
              const char* ui_type_uri)
@@ -1424,6 +1497,55 @@ set_port_value(const char*     port_symbol,
 	}
 }
 
+static void
+set_port_value_by_index(uint32_t    port_index,
+                        void*       user_data,
+                        const void* value,
+                        uint32_t    size,
+                        uint32_t    type)
+{
+	if (port_index == 0) {
+		in = *(const float*)value;
+	} else if (port_index == 1) {
+		out = *(const float*)value;
+	} else {
+		fprintf(stderr, "error: set_port_value for nonexistent port %u\n",
+		        port_index);
+	}
+}
+
+#ifdef __GLIBC__
+/* Count allocations, to check that real-time functions do not allocate */
+
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t nmemb, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+
+static bool     count_allocs = false;
+static unsigned n_allocs     = 0;
+
+void*
+malloc(size_t size)
+{
+	n_allocs += count_allocs;
+	return __libc_malloc(size);
+}
+
+void*
+calloc(size_t nmemb, size_t size)
+{
+	n_allocs += count_allocs;
+	return __libc_calloc(nmemb, size);
+}
+
+void*
+realloc(void* ptr, size_t size)
+{
+	n_allocs += count_allocs;
+	return __libc_realloc(ptr, size);
+}
+#endif
+
 char** uris   = NULL;
 size_t n_uris = 0;
 
@@ -1603,6 +1725,95 @@ test_state(void)
 	LilvState* state6 = lilv_state_new_from_world(world, &map, test_state_node);
 	TEST_ASSERT(lilv_state_equals(state, state6));  // Round trip accuracy
 
+	// Load all presets of the plugin at once
+	LilvStates* presets = lilv_plugin_load_presets(plugin, &map);
+	TEST_ASSERT(lilv_states_size(presets) == 1);
+	LILV_FOREACH(states, i, presets) {
+		const LilvState* preset = lilv_states_get(presets, i);
+		TEST_ASSERT(lilv_node_equals(lilv_state_get_uri(preset),
+		                             test_state_node));
+
+		// Restore first, which reads the property values without keeping them
+		lilv_state_restore(preset, instance, set_port_value, NULL, 0, NULL);
+		TEST_ASSERT(lilv_state_equals(preset, state6));
+	}
+	lilv_states_free(presets);
+
+	presets = lilv_plugin_load_presets(plugin, &map);
+	const LilvState* preset = lilv_states_get(presets,
+	                                          lilv_states_begin(presets));
+	TEST_ASSERT(lilv_state_equals(preset, state6));
+	in = out = 0.0f;
+	lilv_state_apply_port_values(preset, set_port_value_by_index, NULL);
+	TEST_ASSERT(in == 1.0 && out == 1.0);
+	lilv_states_free(presets);
+
+	// Write a bundle with two presets in one data file
+	char* preset1_str = lilv_state_to_string(
+		world, &map, &unmap, state, "http://example.org/preset1", NULL);
+	char* preset2_str = lilv_state_to_string(
+		world, &map, &unmap, state3, "http://example.org/preset2", NULL);
+	mkdir("state/presets.lv2", 0700);
+	FILE* presets_file = fopen("state/presets.lv2/presets.ttl", "w");
+	fprintf(presets_file, "%s\n%s", preset1_str, preset2_str);
+	fclose(presets_file);
+	FILE* manifest_file = fopen("state/presets.lv2/manifest.ttl", "w");
+	for (unsigned n = 1; n <= 2; ++n) {
+		fprintf(manifest_file,
+		        "<http://example.org/preset%u>\n"
+		        "\ta <" LV2_PRESETS__Preset "> ;\n"
+		        "\t<http://lv2plug.in/ns/lv2core#appliesTo> <%s> ;\n"
+		        "\t<http://www.w3.org/2000/01/rdf-schema#seeAlso> "
+		        "<presets.ttl> .\n",
+		        n, lilv_node_as_uri(plugin_uri));
+	}
+	fclose(manifest_file);
+	free(preset2_str);
+	free(preset1_str);
+
+	// Load both presets from the same file
+	uint8_t*  presets_path   = (uint8_t*)lilv_path_absolute("state/presets.lv2/");
+	SerdNode  presets_uri    = serd_node_new_file_uri(presets_path, 0, 0, true);
+	LilvNode* presets_bundle = lilv_new_uri(world, (const char*)presets_uri.buf);
+	lilv_world_load_bundle(world, presets_bundle);
+	serd_node_free(&presets_uri);
+	free(presets_path);
+
+	presets = lilv_plugin_load_presets(plugin, &map);
+	TEST_ASSERT(lilv_states_size(presets) == 3);
+	LilvIter*        iter    = lilv_states_begin(presets);
+	const LilvState* preset1 = lilv_states_get(presets, iter);
+	iter = lilv_states_next(presets, iter);
+	const LilvState* preset2 = lilv_states_get(presets, iter);
+	TEST_ASSERT(!strcmp(lilv_node_as_uri(lilv_state_get_uri(preset1)),
+	                    "http://example.org/preset1"));
+	TEST_ASSERT(!strcmp(lilv_node_as_uri(lilv_state_get_uri(preset2)),
+	                    "http://example.org/preset2"));
+	TEST_ASSERT(lilv_state_equals(preset1, state));
+	TEST_ASSERT(lilv_state_equals(preset2, state3));
+	TEST_ASSERT(!lilv_state_equals(preset1, preset2));
+
+	// Unloading one preset drops the file shared by both
+	lilv_world_unload_resource(world, lilv_state_get_uri(preset1));
+	lilv_states_free(presets);
+
+	lilv_world_unload_bundle(world, presets_bundle);
+	lilv_node_free(presets_bundle);
+
+	// Apply the port values of a prepared state without allocating
+	TEST_ASSERT(!lilv_state_prepare(state6, plugin));
+	in = out = 0.0f;
+#ifdef __GLIBC__
+	n_allocs     = 0;
+	count_allocs = true;
+#endif
+	lilv_state_apply_port_values(state6, set_port_value_by_index, NULL);
+#ifdef __GLIBC__
+	count_allocs = false;
+	TEST_ASSERT(n_allocs == 0);
+#endif
+	TEST_ASSERT(in == 1.0 && out == 1.0);
+
 	lilv_world_unload_resource(world, test_state_node);
 	lilv_world_unload_bundle(world, test_state_bundle);
 
@@ -1854,6 +2065,90 @@ test_string(void)
 
 /*****************************************************************************/
 
+static bool
+load_cached(const char* cache_path, const char* name, uint32_t n_ports)
+{
+	init_world();
+	LilvNode* path = lilv_new_string(world, cache_path);
+	lilv_world_set_option(world, LILV_OPTION_CACHE, path);
+	lilv_node_free(path);
+	lilv_world_load_all(world);
+
+	init_uris();
+	const LilvPlugins* plugins = lilv_world_get_all_plugins(world);
+	const LilvPlugin*  plug    = lilv_plugins_get_by_uri(plugins,
+	                                                     plugin_uri_value);
+	bool ok = false;
+	if (plug) {
+		LilvNode*       plug_name = lilv_plugin_get_name(plug);
+		LilvNode*       symbol    = lilv_new_string(world, "bar");
+		const LilvPort* port      = lilv_plugin_get_port_by_symbol(plug, symbol);
+		ok = (plug_name && !strcmp(lilv_node_as_string(plug_name), name) &&
+		      lilv_plugin_get_num_ports(plug) == n_ports &&
+		      port && lilv_port_get_index(plug, port) == 1);
+		lilv_node_free(symbol);
+		lilv_node_free(plug_name);
+	}
+	cleanup_uris();
+
+	lilv_world_free(world);
+	world = NULL;
+	return ok;
+}
+
+static int
+test_cache(void)
+{
+	char cache_path[TEST_PATH_MAX];
+	snprintf(cache_path, sizeof(cache_path), "%s/lilv-test.cache",
+	         getenv("HOME"));
+	remove(cache_path);
+
+	static const char* const manifest = MANIFEST_PREFIXES
+		":plug a lv2:Plugin ; lv2:binary <foo" SHLIB_EXT "> ; rdfs:seeAlso <plugin.ttl> .\n";
+
+	create_bundle(manifest,
+	              BUNDLE_PREFIXES
+	              ":plug a lv2:Plugin ; "
+	              PLUGIN_NAME("Cached plugin") " ; "
+	              LICENSE_GPL " ; "
+	              "lv2:port [ a lv2:ControlPort ; a lv2:InputPort ; "
+	              " lv2:index 0 ; lv2:symbol \"foo\" ; lv2:name \"Foo\" ; "
+	              "] , [ a lv2:ControlPort ; a lv2:OutputPort ; "
+	              " lv2:index 1 ; lv2:symbol \"bar\" ; lv2:name \"Bar\" ; ] .");
+
+	// Cold load, writes cache
+	TEST_ASSERT(load_cached(cache_path, "Cached plugin", 2));
+	TEST_ASSERT(lilv_path_exists(cache_path, NULL));
+
+	// Warm load, reads cache
+	TEST_ASSERT(load_cached(cache_path, "Cached plugin", 2));
+
+	// Change data file, which must be re-read
+	write_file(content_name,
+	           BUNDLE_PREFIXES
+	           ":plug a lv2:Plugin ; "
+	           PLUGIN_NAME("Changed plugin") " ; "
+	           LICENSE_GPL " ; "
+	           "lv2:port [ a lv2:ControlPort ; a lv2:InputPort ; "
+	           " lv2:index 0 ; lv2:symbol \"foo\" ; lv2:name \"Foo\" ; "
+	           "] , [ a lv2:ControlPort ; a lv2:OutputPort ; "
+	           " lv2:index 1 ; lv2:symbol \"bar\" ; lv2:name \"Bar\" ; "
+	           "] , [ a lv2:ControlPort ; a lv2:OutputPort ; "
+	           " lv2:index 2 ; lv2:symbol \"baz\" ; lv2:name \"Baz\" ; ] .");
+	TEST_ASSERT(load_cached(cache_path, "Changed plugin", 3));
+	TEST_ASSERT(load_cached(cache_path, "Changed plugin", 3));
+
+	// Garbage cache is ignored
+	write_file(cache_path, "This is not a cache");
+	TEST_ASSERT(load_cached(cache_path, "Changed plugin", 3));
+
+	remove(cache_path);
+	return 1;
+}
+
+/*****************************************************************************/
+
 /* add tests here */
 static struct TestCase tests[] = {
 	TEST_CASE(value),
@@ -1869,12 +2164,14 @@ static struct TestCase tests[] = {
 	TEST_CASE(preset),
 	TEST_CASE(prototype),
 	TEST_CASE(port),
+	TEST_CASE(port_descriptors),
 	TEST_CASE(ui),
 	TEST_CASE(bad_port_symbol),
 	TEST_CASE(bad_port_index),
 	TEST_CASE(bad_port_index),
 	TEST_CASE(string),
 	TEST_CASE(state),
+	TEST_CASE(cache),
 	{ NULL, NULL }
 };
 
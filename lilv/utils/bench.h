@@ -1,5 +1,5 @@
 /*
-  Copyright 2011-2014 David Robillard <http://drobilla.net>
+  Copyright 2011-2015 David Robillard <http://drobilla.net>
 
   Permission to use, copy, modify, and/or distribute this software for any
   purpose with or without fee is hereby granted, provided that the above
@@ -21,7 +21,9 @@
 #ifndef BENCH_H
 #define BENCH_H
 
-#define _POSIX_C_SOURCE 199309L
+#ifndef _POSIX_C_SOURCE
+#    define _POSIX_C_SOURCE 199309L
+#endif
 
 #include <time.h>
 #include <sys/time.h>
@@ -37,7 +39,7 @@ static inline struct timespec
 bench_start(void)
 {
 	struct timespec start_t;
-	clock_gettime(CLOCK_REALTIME, &start_t);
+	clock_gettime(CLOCK_MONOTONIC, &start_t);
 	return start_t;
 }
 
@@ -45,7 +47,7 @@ static inline double
 bench_end(const struct timespec* start_t)
 {
 	struct timespec end_t;
-	clock_gettime(CLOCK_REALTIME, &end_t);
+	clock_gettime(CLOCK_MONOTONIC, &end_t);
 	return bench_elapsed_s(start_t, &end_t);
 }
 
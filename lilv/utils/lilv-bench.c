@@ -1,5 +1,5 @@
 /*
-  Copyright 2007-2012 David Robillard <http://drobilla.net>
+  Copyright 2007-2015 David Robillard <http://drobilla.net>
 
   Permission to use, copy, modify, and/or distribute this software for any
   purpose with or without fee is hereby granted, provided that the above
@@ -14,25 +14,111 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#define _POSIX_C_SOURCE 199309L
+
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "lilv/lilv.h"
 
 #include "lilv_config.h"
+#include "bench.h"
 
-int
-main(int argc, char** argv)
+static void
+print_usage(void)
 {
+	printf("lilv-bench - Benchmark loading all installed LV2 plugin data.\n");
+	printf("Usage: lilv-bench [OPTIONS]\n");
+	printf("\n");
+	printf("  -c CACHE    Use (and keep) the cache file CACHE.\n");
+	printf("  -h, --help  Display this help and exit.\n");
+	printf("  -n RUNS     Number of warm runs to average (default 1).\n");
+}
+
+/** Load the world and every plugin's data, returning the time taken. */
+static double
+load(const char* cache_path, unsigned* n_plugins)
+{
+	struct timespec start = bench_start();
+
 	LilvWorld* world = lilv_world_new();
+	if (cache_path) {
+		LilvNode* path = lilv_new_string(world, cache_path);
+		lilv_world_set_option(world, LILV_OPTION_CACHE, path);
+		lilv_node_free(path);
+	}
+
 	lilv_world_load_all(world);
 
 	const LilvPlugins* plugins = lilv_world_get_all_plugins(world);
 	LILV_FOREACH(plugins, p, plugins) {
 		const LilvPlugin* plugin = lilv_plugins_get(plugins, p);
 		lilv_plugin_get_class(plugin);
+		lilv_plugin_get_num_ports(plugin);  // Loads plugin data files
+	}
+	*n_plugins = lilv_plugins_size(plugins);
+
+	lilv_world_free(world);  // Writes cache
+
+	return bench_end(&start);
+}
+
+int
+main(int argc, char** argv)
+{
+	const char* cache_arg = NULL;
+	unsigned    n_runs    = 1;
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-h") || !strcmp(argv[i], "--help")) {
+			print_usage();
+			return 0;
+		} else if (!strcmp(argv[i], "-c") && (i + 1 < argc)) {
+			cache_arg = argv[++i];
+		} else if (!strcmp(argv[i], "-n") && (i + 1 < argc)) {
+			const int n = atoi(argv[++i]);
+			n_runs = (n > 0) ? n : 1;
+		} else {
+			print_usage();
+			return 1;
+		}
+	}
+
+	char cache_path[1024];
+	if (cache_arg) {
+		snprintf(cache_path, sizeof(cache_path), "%s", cache_arg);
+	} else {
+		const char* tmp = getenv("TMPDIR");
+		snprintf(cache_path, sizeof(cache_path), "%s/lilv-bench-%d.cache",
+		         tmp ? tmp : "/tmp", (int)getpid());
+	}
+
+	unsigned n_plugins = 0;
+
+	// Without a cache, as lilv has always loaded
+	const double uncached = load(NULL, &n_plugins);
+
+	// With an empty cache, which is written when the world is freed
+	remove(cache_path);
+	const double cold = load(cache_path, &n_plugins);
+
+	// With a full cache
+	double warm = 0.0;
+	for (unsigned i = 0; i < n_runs; ++i) {
+		warm += load(cache_path, &n_plugins);
+	}
+	warm /= n_runs;
+
+	if (!cache_arg) {
+		remove(cache_path);
 	}
 
-	lilv_world_free(world);
+	printf("Plugins   %u\n", n_plugins);
+	printf("Uncached  %lf s\n", uncached);
+	printf("Cold      %lf s\n", cold);
+	printf("Warm      %lf s (%.1fx)\n",
+	       warm, warm > 0.0 ? uncached / warm : 0.0);
 
 	return 0;
 }
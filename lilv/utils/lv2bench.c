@@ -1,5 +1,5 @@
 /*
-  Copyright 2012 David Robillard <http://drobilla.net>
+  Copyright 2012-2015 David Robillard <http://drobilla.net>
 
   Permission to use, copy, modify, and/or distribute this software for any
   purpose with or without fee is hereby granted, provided that the above
@@ -14,36 +14,83 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
-#define _POSIX_C_SOURCE 199309L
+#define _GNU_SOURCE             /* for pthread_setaffinity_np */
+#define _POSIX_C_SOURCE 200112L /* for pthread_barrier_t */
 
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "lilv/lilv.h"
 #include "lv2/lv2plug.in/ns/ext/atom/atom.h"
+#include "lv2/lv2plug.in/ns/ext/midi/midi.h"
 
 #include "lilv_config.h"
 #include "bench.h"
 #include "uri_table.h"
 
-static LilvNode* atom_AtomPort   = NULL;
-static LilvNode* atom_Sequence   = NULL;
-static LilvNode* lv2_AudioPort   = NULL;
-static LilvNode* lv2_CVPort      = NULL;
-static LilvNode* lv2_ControlPort = NULL;
-static LilvNode* lv2_InputPort   = NULL;
-static LilvNode* lv2_OutputPort  = NULL;
-static LilvNode* urid_map        = NULL;
-
-static bool full_output = false;
+#ifdef HAVE_PTHREAD_BARRIER
+#    include <pthread.h>
+#endif
+
+#define MAX_CONFIGS 16     ///< Maximum number of values in a list option
+#define ATOM_CAPACITY 8192 ///< Minimum size of atom port buffers
+
+static LilvNode* urid_map = NULL;
+
+typedef enum {
+	SIGNAL_SILENCE,  ///< Zero audio input
+	SIGNAL_NOISE,    ///< Uniform white noise
+	SIGNAL_IMPULSE,  ///< A single full scale sample, then silence
+	SIGNAL_MIDI      ///< Silence, with MIDI notes on atom inputs
+} Signal;
+
+static const char* const signal_names[] = {
+	"silence", "noise", "impulse", "midi"
+};
+
+typedef enum {
+	FORMAT_TEXT,
+	FORMAT_CSV,
+	FORMAT_JSON
+} Format;
+
+/** A single configuration to run a plugin in. */
+typedef struct {
+	uint32_t block_size;
+	uint32_t sample_rate;
+	Signal   signal;
+} Config;
+
+/** Timing statistics for one run, with block times in seconds. */
+typedef struct {
+	uint32_t n_blocks;
+	double   total;
+	double   min;
+	double   median;
+	double   p99;
+	double   max;
+} Result;
+
+/** A MIDI event in an atom sequence. */
+typedef struct {
+	LV2_Atom_Event event;
+	uint8_t        msg[3];
+	uint8_t        pad[5];
+} MIDIEvent;
+
+static Format format  = FORMAT_TEXT;
+static bool   first   = true;
+static bool   verbose = false;
 
 static void
 print_version(void)
 {
 	printf(
 		"lv2bench (lilv) " LILV_VERSION "\n"
-		"Copyright 2012 David Robillard <http://drobilla.net>\n"
+		"Copyright 2012-2015 David Robillard <http://drobilla.net>\n"
 		"License: <http://www.opensource.org/licenses/isc-license>\n"
 		"This is free software: you are free to change and redistribute it.\n"
 		"There is NO WARRANTY, to the extent permitted by law.\n");
@@ -53,176 +100,901 @@ static void
 print_usage(void)
 {
 	printf("lv2bench - Benchmark all installed and supported LV2 plugins.\n");
-	printf("Usage: lv2bench [OPTIONS]\n");
+	printf("Usage: lv2bench [OPTIONS] [PLUGIN_URI]...\n");
+	printf("\n");
+	printf("Every plugin, or only the given plugins, is run for every\n");
+	printf("combination of block size, sample rate, and signal.\n");
+	printf("In parallel mode, several instances of the given plugins are run\n");
+	printf("in lockstep on pinned threads, to show how they scale and share\n");
+	printf("caches.\n");
 	printf("\n");
-	printf("  -b BLOCK_SIZE  Specify block size, in audio frames.\n");
-	printf("  -f, --full     Full plottable output.\n");
+	printf("  -b SIZES       Block sizes in frames, comma separated "
+	       "(default 512).\n");
+	printf("  -f, --full     Full plottable output (same as -o csv).\n");
 	printf("  -h, --help     Display this help and exit.\n");
-	printf("  -n FRAMES      Total number of audio frames to process\n");
+	printf("  -i INSTANCES   Number of instances in parallel mode "
+	       "(default most threads).\n");
+	printf("  -j THREADS     Run the given plugins in parallel, with each\n");
+	printf("                 number of threads, comma separated.\n");
+	printf("  -n FRAMES      Total number of audio frames to process.\n");
+	printf("  -o FORMAT      Output format: text (default), csv, or json.\n");
+	printf("  -r RATES       Sample rates in Hz, comma separated "
+	       "(default 48000).\n");
+	printf("  -s SIGNALS     Input signals, comma separated "
+	       "(default silence).\n");
+	printf("                 Signals: silence, noise, impulse, midi.\n");
+	printf("  -v             Print skipped plugins.\n");
 	printf("  --version      Display version information and exit\n");
 }
 
-static double
-bench(const LilvPlugin* p, uint32_t sample_count, uint32_t block_size)
+/** Parse a comma separated list of positive integers into `values`. */
+static unsigned
+parse_uints(const char* str, uint32_t* values)
 {
-	URITable uri_table;
-	uri_table_init(&uri_table);
+	unsigned n = 0;
+	for (const char* s = str; *s;) {
+		char*      end   = NULL;
+		const long value = strtol(s, &end, 10);
+		if (n == MAX_CONFIGS || end == s || value <= 0 ||
+		    (*end && *end != ',')) {
+			return 0;
+		}
+		values[n++] = (uint32_t)value;
+		s = *end ? end + 1 : end;
+	}
+	return n;
+}
 
-	LV2_URID_Map       map           = { &uri_table, uri_table_map };
-	LV2_Feature        map_feature   = { LV2_URID_MAP_URI, &map };
-	LV2_URID_Unmap     unmap         = { &uri_table, uri_table_unmap };
-	LV2_Feature        unmap_feature = { LV2_URID_UNMAP_URI, &unmap };
-	const LV2_Feature* features[]    = { &map_feature, &unmap_feature, NULL };
+/** Parse a comma separated list of signal names into `signals`. */
+static unsigned
+parse_signals(const char* str, Signal* signals)
+{
+	unsigned n = 0;
+	for (const char* s = str; *s;) {
+		const size_t len = strcspn(s, ",");
+		unsigned     i   = 0;
+		for (; i <= SIGNAL_MIDI; ++i) {
+			if (strlen(signal_names[i]) == len &&
+			    !strncmp(s, signal_names[i], len)) {
+				break;
+			}
+		}
+		if (n == MAX_CONFIGS || i > SIGNAL_MIDI) {
+			return 0;
+		}
+		signals[n++] = (Signal)i;
+		s += s[len] ? len + 1 : len;
+	}
+	return n;
+}
 
-	float* const buf = (float*)calloc(block_size * 2, sizeof(float));
-	float* const in  = buf;
-	float* const out = buf + block_size;
-	if (!buf) {
-		fprintf(stderr, "Out of memory\n");
-		return 0.0;
+static int
+cmp_double(const void* a, const void* b)
+{
+	const double x = *(const double*)a;
+	const double y = *(const double*)b;
+	return (x < y) ? -1 : (x > y) ? 1 : 0;
+}
+
+/** Sort `times` and calculate statistics. */
+static Result
+summarise(double* times, uint32_t n_blocks)
+{
+	Result r = { n_blocks, 0.0, 0.0, 0.0, 0.0, 0.0 };
+	if (n_blocks == 0) {
+		return r;
+	}
+
+	for (uint32_t i = 0; i < n_blocks; ++i) {
+		r.total += times[i];
+	}
+
+	qsort(times, n_blocks, sizeof(double), cmp_double);
+	r.min    = times[0];
+	r.median = times[n_blocks / 2];
+	r.p99    = times[(uint32_t)ceil(n_blocks * 0.99) - 1];
+	r.max    = times[n_blocks - 1];
+	return r;
+}
+
+/** Return a uniformly distributed sample in [-1, 1). */
+static inline float
+noise(uint32_t* state)
+{
+	// xorshift32
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return (float)(*state / 2147483648.0 - 1.0);
+}
+
+/** Fill the input buffers for block number `i` of `config`. */
+static void
+fill_input(const Config*      config,
+           uint32_t           i,
+           float*             in,
+           LV2_Atom_Sequence* seq,
+           LV2_URID           midi_MidiEvent,
+           uint32_t*          rand_state)
+{
+	switch (config->signal) {
+	case SIGNAL_SILENCE:
+	case SIGNAL_MIDI:
+		memset(in, 0, config->block_size * sizeof(float));
+		break;
+	case SIGNAL_NOISE:
+		for (uint32_t f = 0; f < config->block_size; ++f) {
+			in[f] = noise(rand_state);
+		}
+		break;
+	case SIGNAL_IMPULSE:
+		memset(in, 0, config->block_size * sizeof(float));
+		in[0] = (i == 0) ? 1.0f : 0.0f;
+		break;
 	}
 
-	LV2_Atom_Sequence seq = {
-		{ sizeof(LV2_Atom_Sequence_Body),
-		  uri_table_map(&uri_table, LV2_ATOM__Sequence) },
-		{ 0, 0 } };
+	// A note on at the start of every 8 blocks, and off half way between
+	seq->atom.size = sizeof(LV2_Atom_Sequence_Body);
+	if (config->signal == SIGNAL_MIDI && i % 4 == 0) {
+		const uint8_t note = 48 + (i / 8) % 24;
+		MIDIEvent*    ev   = (MIDIEvent*)(seq + 1);
+		ev->event.time.frames = 0;
+		ev->event.body.type   = midi_MidiEvent;
+		ev->event.body.size   = 3;
+		ev->msg[0] = (i % 8 == 0) ? LV2_MIDI_MSG_NOTE_ON : LV2_MIDI_MSG_NOTE_OFF;
+		ev->msg[1] = note;
+		ev->msg[2] = (i % 8 == 0) ? 100 : 0;
+		seq->atom.size += sizeof(MIDIEvent);
+	}
+}
+
+/** A plugin instance with everything needed to run it. */
+typedef struct {
+	const Config*      config;
+	URITable           uri_table;
+	LV2_URID_Map       map;
+	LV2_URID_Unmap     unmap;
+	LV2_Feature        map_feature;
+	LV2_Feature        unmap_feature;
+	const LV2_Feature* features[3];
+	LilvInstance*      instance;
+	float*             buf;
+	float*             controls;
+	uint64_t*          seq_in_buf;
+	uint64_t*          seq_out_buf;
+	uint32_t           atom_capacity;
+	LV2_URID           midi_MidiEvent;
+	uint32_t           rand_state;
+	double*            times;  ///< Time taken to run each block
+} Runner;
 
+static void
+runner_free(Runner* r)
+{
+	if (r->instance) {
+		lilv_instance_free(r->instance);
+	}
+	uri_table_destroy(&r->uri_table);
+	free(r->buf);
+	free(r->controls);
+	free(r->seq_in_buf);
+	free(r->seq_out_buf);
+	free(r->times);
+	free(r);
+}
+
+/** Instantiate and connect `p`, or return NULL if it is unsupported. */
+static Runner*
+runner_new(const LilvPlugin* p, const Config* config, uint32_t n_blocks)
+{
 	const char* uri      = lilv_node_as_string(lilv_plugin_get_uri(p));
 	LilvNodes*  required = lilv_plugin_get_required_features(p);
 	LILV_FOREACH(nodes, i, required) {
 		const LilvNode* feature = lilv_nodes_get(required, i);
 		if (!lilv_node_equals(feature, urid_map)) {
-			fprintf(stderr, "<%s> requires feature <%s>, skipping\n",
-			        uri, lilv_node_as_uri(feature));
-			free(buf);
-			uri_table_destroy(&uri_table);
-			return 0.0;
+			if (verbose) {
+				fprintf(stderr, "<%s> requires feature <%s>, skipping\n",
+				        uri, lilv_node_as_uri(feature));
+			}
+			lilv_nodes_free(required);
+			return NULL;
 		}
 	}
+	lilv_nodes_free(required);
 
-	LilvInstance* instance = lilv_plugin_instantiate(p, 48000.0, features);
-	if (!instance) {
-		fprintf(stderr, "Failed to instantiate <%s>\n",
-		        lilv_node_as_uri(lilv_plugin_get_uri(p)));
-		free(buf);
-		uri_table_destroy(&uri_table);
-		return 0.0;
+	const uint32_t            n_ports = lilv_plugin_get_num_ports(p);
+	const LilvPortDescriptor* ports   = lilv_plugin_get_port_descriptors(p);
+	if (n_ports > 0 && !ports) {
+		fprintf(stderr, "<%s> has invalid ports, skipping\n", uri);
+		return NULL;
 	}
 
-	float* controls = (float*)calloc(
-		lilv_plugin_get_num_ports(p), sizeof(float));
-	lilv_plugin_get_port_ranges_float(p, NULL, NULL, controls);
+	Runner* r = (Runner*)calloc(1, sizeof(Runner));
+	uri_table_init(&r->uri_table);
+	r->config                = config;
+	r->map.handle            = &r->uri_table;
+	r->map.map               = uri_table_map;
+	r->unmap.handle          = &r->uri_table;
+	r->unmap.unmap           = uri_table_unmap;
+	r->map_feature.URI       = LV2_URID_MAP_URI;
+	r->map_feature.data      = &r->map;
+	r->unmap_feature.URI     = LV2_URID_UNMAP_URI;
+	r->unmap_feature.data    = &r->unmap;
+	r->features[0]           = &r->map_feature;
+	r->features[1]           = &r->unmap_feature;
+	r->features[2]           = NULL;
+	r->rand_state            = 1;
+
+	// Atom buffers, large enough for every port
+	r->atom_capacity = ATOM_CAPACITY;
+	for (uint32_t index = 0; index < n_ports; ++index) {
+		if (ports[index].minimum_size > r->atom_capacity) {
+			r->atom_capacity = ports[index].minimum_size;
+		}
+	}
+	r->atom_capacity = (r->atom_capacity + 7U) & ~7U;  // Whole 64-bit words
+
+	const uint32_t block_size = config->block_size;
+	r->buf         = (float*)calloc(block_size * 2, sizeof(float));
+	r->controls    = (float*)calloc(n_ports + 1, sizeof(float));
+	r->seq_in_buf  = (uint64_t*)calloc(r->atom_capacity / 8, 8);
+	r->seq_out_buf = (uint64_t*)calloc(r->atom_capacity / 8, 8);
+	r->times       = (double*)calloc(n_blocks, sizeof(double));
+	if (!r->buf || !r->controls || !r->seq_in_buf || !r->seq_out_buf ||
+	    !r->times) {
+		fprintf(stderr, "Out of memory\n");
+		runner_free(r);
+		return NULL;
+	}
+
+	float* const             in      = r->buf;
+	float* const             out     = r->buf + block_size;
+	LV2_Atom_Sequence* const seq_in  = (LV2_Atom_Sequence*)r->seq_in_buf;
+	LV2_Atom_Sequence* const seq_out = (LV2_Atom_Sequence*)r->seq_out_buf;
+
+	seq_in->atom.type = uri_table_map(&r->uri_table, LV2_ATOM__Sequence);
+	r->midi_MidiEvent = uri_table_map(&r->uri_table, LV2_MIDI__MidiEvent);
+
+	r->instance = lilv_plugin_instantiate(p, config->sample_rate, r->features);
+	if (!r->instance) {
+		fprintf(stderr, "Failed to instantiate <%s>\n", uri);
+		runner_free(r);
+		return NULL;
+	}
 
-	const uint32_t n_ports = lilv_plugin_get_num_ports(p);
 	for (uint32_t index = 0; index < n_ports; ++index) {
-		const LilvPort* port = lilv_plugin_get_port_by_index(p, index);
-		if (lilv_port_is_a(p, port, lv2_ControlPort)) {
-			lilv_instance_connect_port(instance, index, &controls[index]);
-		} else if (lilv_port_is_a(p, port, lv2_AudioPort) ||
-		           lilv_port_is_a(p, port, lv2_CVPort)) {
-			if (lilv_port_is_a(p, port, lv2_InputPort)) {
-				lilv_instance_connect_port(instance, index, in);
-			} else if (lilv_port_is_a(p, port, lv2_OutputPort)) {
-				lilv_instance_connect_port(instance, index, out);
+		const uint32_t classes = ports[index].classes;
+		if (classes & LILV_PORT_CONTROL) {
+			const float def = ports[index].def;
+			r->controls[index] = isnan(def) ? 0.0f : def;
+			lilv_instance_connect_port(
+				r->instance, index, &r->controls[index]);
+		} else if (classes & (LILV_PORT_AUDIO | LILV_PORT_CV)) {
+			if (classes & LILV_PORT_INPUT) {
+				lilv_instance_connect_port(r->instance, index, in);
+			} else if (classes & LILV_PORT_OUTPUT) {
+				lilv_instance_connect_port(r->instance, index, out);
 			} else {
-				fprintf(stderr, "<%s> port %d neither input nor output, skipping\n",
-				        uri, index);
-				lilv_instance_free(instance);
-				free(buf);
-				free(controls);
-				uri_table_destroy(&uri_table);
-				return 0.0;
+				fprintf(stderr, "<%s> port %u neither input nor output, "
+				        "skipping\n", uri, index);
+				runner_free(r);
+				return NULL;
 			}
-		} else if (lilv_port_is_a(p, port, atom_AtomPort)) {
-			lilv_instance_connect_port(instance, index, &seq);
-		} else {
-			fprintf(stderr, "<%s> port %d has unknown type, skipping\n",
+		} else if (classes & LILV_PORT_ATOM) {
+			lilv_instance_connect_port(
+				r->instance, index,
+				(classes & LILV_PORT_OUTPUT) ? seq_out : seq_in);
+		} else if (!(ports[index].properties & LILV_PORT_CONNECTION_OPTIONAL)) {
+			fprintf(stderr, "<%s> port %u has unknown type, skipping\n",
 			        uri, index);
-			lilv_instance_free(instance);
-			free(buf);
-			free(controls);
-			uri_table_destroy(&uri_table);
-			return 0.0;
+			runner_free(r);
+			return NULL;
 		}
 	}
 
-	lilv_instance_activate(instance);
+	return r;
+}
+
+/** Run block number `i` and record the time it took. */
+static inline void
+runner_run(Runner* r, uint32_t i)
+{
+	LV2_Atom_Sequence* const seq_in  = (LV2_Atom_Sequence*)r->seq_in_buf;
+	LV2_Atom_Sequence* const seq_out = (LV2_Atom_Sequence*)r->seq_out_buf;
+
+	fill_input(r->config, i, r->buf, seq_in, r->midi_MidiEvent,
+	           &r->rand_state);
+	seq_out->atom.type = 0;
+	seq_out->atom.size = r->atom_capacity - sizeof(LV2_Atom);
 
 	struct timespec ts = bench_start();
-	for (uint32_t i = 0; i < (sample_count / block_size); ++i) {
-		lilv_instance_run(instance, block_size);
+	lilv_instance_run(r->instance, r->config->block_size);
+	r->times[i] = bench_end(&ts);
+}
+
+static bool
+bench(const LilvPlugin* p, const Config* config, uint32_t sample_count,
+      Result* result)
+{
+	const uint32_t n_blocks = sample_count / config->block_size;
+	Runner* const  r        = runner_new(p, config, n_blocks);
+	if (!r) {
+		return false;
 	}
-	const double elapsed = bench_end(&ts);
 
-	lilv_instance_deactivate(instance);
-	lilv_instance_free(instance);
+	lilv_instance_activate(r->instance);
+	for (uint32_t i = 0; i < n_blocks; ++i) {
+		runner_run(r, i);
+	}
+	lilv_instance_deactivate(r->instance);
 
-	uri_table_destroy(&uri_table);
+	*result = summarise(r->times, n_blocks);
+	runner_free(r);
+	return true;
+}
 
-	if (full_output) {
-		printf("%d %d ", block_size, sample_count);
+static void
+print_json_string(const char* str)
+{
+	putchar('"');
+	for (const char* s = str; *s; ++s) {
+		if (*s == '"' || *s == '\\') {
+			putchar('\\');
+		}
+		putchar(*s);
 	}
-	printf("%lf %s\n", elapsed, uri);
+	putchar('"');
+}
 
-	free(buf);
-	free(controls);
-	return elapsed;
+static void
+print_header(bool parallel)
+{
+	switch (format) {
+	case FORMAT_TEXT:
+		printf("#");
+		if (parallel) {
+			printf(" %7s %4s %3s", "Threads", "Inst", "CPU");
+		}
+		printf(" %5s %6s %-7s %10s %10s %10s %10s %10s %6s %6s",
+		       "Block", "Rate", "Signal", "Total(s)", "Min(us)", "Median(us)",
+		       "P99(us)", "Max(us)", "Load%", "Peak%");
+		if (parallel) {
+			printf(" %7s %7s", "xRT", "Speedup");
+		}
+		printf(" %s\n", "Plugin");
+		break;
+	case FORMAT_CSV:
+		if (parallel) {
+			printf("threads,instance,cpu,");
+		}
+		printf("plugin,block_size,sample_rate,signal,blocks,total_s,"
+		       "min_us,median_us,p99_us,max_us,load_pct,peak_load_pct");
+		if (parallel) {
+			printf(",realtime_factor,speedup");
+		}
+		printf("\n");
+		break;
+	case FORMAT_JSON:
+		printf("[");
+		break;
+	}
+}
+
+static void
+print_footer(void)
+{
+	if (format == FORMAT_JSON) {
+		printf("%s]\n", first ? "" : "\n");
+	}
+}
+
+/** Print the statistics columns of a result. */
+static void
+print_stats(const Config* config, const Result* r)
+{
+	// Load is time taken as a percentage of the real time of the audio
+	const double period = (double)config->block_size / config->sample_rate;
+	const double load   = r->total * 100.0 / (r->n_blocks * period);
+	const double peak   = r->max * 100.0 / period;
+	const char*  signal = signal_names[config->signal];
+
+	switch (format) {
+	case FORMAT_TEXT:
+		printf(" %5u %6u %-7s %10.6f %10.2f %10.2f %10.2f %10.2f %6.2f %6.2f",
+		       config->block_size, config->sample_rate, signal, r->total,
+		       r->min * 1e6, r->median * 1e6, r->p99 * 1e6, r->max * 1e6,
+		       load, peak);
+		break;
+	case FORMAT_CSV:
+		printf(",%u,%u,%s,%u,%f,%f,%f,%f,%f,%f,%f",
+		       config->block_size, config->sample_rate, signal,
+		       r->n_blocks, r->total,
+		       r->min * 1e6, r->median * 1e6, r->p99 * 1e6, r->max * 1e6,
+		       load, peak);
+		break;
+	case FORMAT_JSON:
+		printf(", \"block_size\": %u, \"sample_rate\": %u, \"signal\": \"%s\", "
+		       "\"blocks\": %u, \"total_s\": %f, \"min_us\": %f, "
+		       "\"median_us\": %f, \"p99_us\": %f, \"max_us\": %f, "
+		       "\"load_pct\": %f, \"peak_load_pct\": %f",
+		       config->block_size, config->sample_rate, signal,
+		       r->n_blocks, r->total,
+		       r->min * 1e6, r->median * 1e6, r->p99 * 1e6, r->max * 1e6,
+		       load, peak);
+		break;
+	}
 }
 
+/** Print the result of running `uri` in `config`. */
+static void
+print_result(const char* uri, const Config* config, const Result* r)
+{
+	switch (format) {
+	case FORMAT_TEXT:
+		printf(" ");
+		print_stats(config, r);
+		printf(" %s\n", uri);
+		break;
+	case FORMAT_CSV:
+		printf("%s", uri);
+		print_stats(config, r);
+		printf("\n");
+		break;
+	case FORMAT_JSON:
+		printf("%s\n  {\"plugin\": ", first ? "" : ",");
+		print_json_string(uri);
+		print_stats(config, r);
+		printf("}");
+		break;
+	}
+	first = false;
+	fflush(stdout);
+}
+
+/** Benchmark `p` in every combination of the given configurations. */
+static void
+bench_plugin(const LilvPlugin* p,
+             uint32_t          sample_count,
+             const uint32_t*   block_sizes,
+             unsigned          n_block_sizes,
+             const uint32_t*   rates,
+             unsigned          n_rates,
+             const Signal*     signals,
+             unsigned          n_signals)
+{
+	const char* uri = lilv_node_as_string(lilv_plugin_get_uri(p));
+	for (unsigned b = 0; b < n_block_sizes; ++b) {
+		for (unsigned r = 0; r < n_rates; ++r) {
+			for (unsigned s = 0; s < n_signals; ++s) {
+				const Config config = { block_sizes[b], rates[r], signals[s] };
+				Result       result;
+				if (!bench(p, &config, sample_count, &result)) {
+					return;  // Plugin is unsupported
+				}
+				print_result(uri, &config, &result);
+			}
+		}
+	}
+}
+
+#ifdef HAVE_PTHREAD_BARRIER
+
+/**
+   Print a result of running instances in parallel.
+
+   If `uri` is NULL, this is the aggregate result for all instances, where
+   block times are the time taken for all threads to finish a cycle.
+*/
+static void
+print_parallel_result(unsigned      n_threads,
+                      unsigned      instance,
+                      int           cpu,
+                      const char*   uri,
+                      const Config* config,
+                      const Result* r,
+                      double        factor,
+                      double        speedup)
+{
+	char inst_str[16] = "all";
+	char cpu_str[16]  = "-";
+	if (uri) {
+		snprintf(inst_str, sizeof(inst_str), "%u", instance);
+		if (cpu >= 0) {
+			snprintf(cpu_str, sizeof(cpu_str), "%d", cpu);
+		}
+	}
+
+	switch (format) {
+	case FORMAT_TEXT:
+		printf("  %7u %4s %3s", n_threads, inst_str, cpu_str);
+		print_stats(config, r);
+		if (uri) {
+			printf(" %7.2f %7s %s\n", factor, "-", uri);
+		} else {
+			printf(" %7.2f %7.2f %s\n", factor, speedup, "*");
+		}
+		break;
+	case FORMAT_CSV:
+		printf("%u,%s,%s,%s", n_threads, uri ? inst_str : "",
+		       (uri && cpu >= 0) ? cpu_str : "", uri ? uri : "");
+		print_stats(config, r);
+		if (uri) {
+			printf(",%f,\n", factor);
+		} else {
+			printf(",%f,%f\n", factor, speedup);
+		}
+		break;
+	case FORMAT_JSON:
+		printf("%s\n  {\"threads\": %u, ", first ? "" : ",", n_threads);
+		if (uri) {
+			printf("\"instance\": %u, \"cpu\": %d, \"plugin\": ", instance, cpu);
+			print_json_string(uri);
+		} else {
+			printf("\"instance\": null, \"cpu\": null, \"plugin\": null");
+		}
+		print_stats(config, r);
+		printf(", \"realtime_factor\": %f", factor);
+		if (!uri) {
+			printf(", \"speedup\": %f", speedup);
+		}
+		printf("}");
+		break;
+	}
+	first = false;
+	fflush(stdout);
+}
+
+/** A thread which runs some instances in lockstep with other threads. */
+typedef struct {
+	pthread_t          thread;
+	pthread_mutex_t*   start;     ///< Held by main until the barrier is ready
+	pthread_barrier_t* barrier;
+	Runner**           runners;
+	unsigned           n_runners;
+	int                cpu;       ///< CPU the thread is pinned to, or -1
+	uint32_t           n_blocks;
+} BenchThread;
+
+static void*
+bench_thread_run(void* data)
+{
+	BenchThread* const t = (BenchThread*)data;
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	CPU_SET(t->cpu, &cpus);
+	if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus)) {
+		t->cpu = -1;
+	}
+#else
+	t->cpu = -1;  // Not pinned
+#endif
+
+	// Wait until main has created every thread it can and set up the barrier
+	pthread_mutex_lock(t->start);
+	pthread_mutex_unlock(t->start);
+
+	// Every cycle starts when all threads (and main) reach the barrier
+	for (uint32_t i = 0; i < t->n_blocks; ++i) {
+		pthread_barrier_wait(t->barrier);
+		for (unsigned r = 0; r < t->n_runners; ++r) {
+			runner_run(t->runners[r], i);
+		}
+	}
+	pthread_barrier_wait(t->barrier);
+	return NULL;
+}
+
+/**
+   Run `n_instances` instances of `plugins` on `n_threads` threads.
+
+   Instance i is of plugins[i % n_plugins], and is run by thread
+   i % n_threads.  Each thread runs one block of all its instances per cycle,
+   and waits for every other thread to finish before starting the next.
+
+   @return The realtime factor of all instances together, or 0 on error.
+*/
+static double
+bench_parallel(const LilvPlugin** plugins,
+               unsigned           n_plugins,
+               unsigned           n_instances,
+               unsigned           n_threads,
+               const Config*      config,
+               uint32_t           sample_count,
+               double             base_factor)
+{
+	const uint32_t n_blocks = sample_count / config->block_size;
+	const long     n_cpus   = sysconf(_SC_NPROCESSORS_ONLN);
+
+	Runner**     runners = (Runner**)calloc(n_instances, sizeof(Runner*));
+	BenchThread* threads = (BenchThread*)calloc(n_threads, sizeof(BenchThread));
+	double*      cycles  = (double*)calloc(n_blocks, sizeof(double));
+	bool         ok      = true;
+	for (unsigned i = 0; i < n_instances && ok; ++i) {
+		runners[i] = runner_new(plugins[i % n_plugins], config, n_blocks);
+		ok         = runners[i] != NULL;
+	}
+
+	if (!ok) {
+		for (unsigned i = 0; i < n_instances; ++i) {
+			if (runners[i]) {
+				runner_free(runners[i]);
+			}
+		}
+		free(runners);
+		free(threads);
+		free(cycles);
+		return 0.0;
+	}
+
+	pthread_mutex_t   start;
+	pthread_barrier_t barrier;
+	pthread_mutex_init(&start, NULL);
+
+	for (unsigned t = 0; t < n_threads; ++t) {
+		threads[t].start    = &start;
+		threads[t].barrier  = &barrier;
+		threads[t].runners  = (Runner**)calloc(
+			n_instances / n_threads + 1, sizeof(Runner*));
+		threads[t].cpu      = (n_cpus > 0) ? (int)(t % n_cpus) : -1;
+		threads[t].n_blocks = n_blocks;
+	}
+	for (unsigned i = 0; i < n_instances; ++i) {
+		BenchThread* const t = &threads[i % n_threads];
+		t->runners[t->n_runners++] = runners[i];
+		lilv_instance_activate(runners[i]->instance);
+	}
+
+	// Create threads, which wait for the barrier until start is unlocked
+	pthread_mutex_lock(&start);
+	unsigned n_started = 0;
+	for (; n_started < n_threads; ++n_started) {
+		const int st = pthread_create(&threads[n_started].thread, NULL,
+		                              bench_thread_run, &threads[n_started]);
+		if (st) {
+			fprintf(stderr, "error: Failed to create thread (%s)\n",
+			        strerror(st));
+			ok = false;
+			break;
+		}
+	}
+
+	if (!ok) {
+		// Let the threads that did start go straight to the final barrier
+		for (unsigned t = 0; t < n_started; ++t) {
+			threads[t].n_blocks = 0;
+		}
+	}
+
+	pthread_barrier_init(&barrier, NULL, n_started + 1);
+	pthread_mutex_unlock(&start);
+
+	if (ok) {
+		// Release threads for each cycle and time how long it takes
+		pthread_barrier_wait(&barrier);
+		struct timespec prev = bench_start();
+		for (uint32_t i = 0; i < n_blocks; ++i) {
+			pthread_barrier_wait(&barrier);
+			const struct timespec now = bench_start();
+			cycles[i] = bench_elapsed_s(&prev, &now);
+			prev      = now;
+		}
+	} else {
+		pthread_barrier_wait(&barrier);
+	}
+
+	for (unsigned t = 0; t < n_started; ++t) {
+		pthread_join(threads[t].thread, NULL);
+	}
+	pthread_barrier_destroy(&barrier);
+	pthread_mutex_destroy(&start);
+
+	const double period = (double)config->block_size / config->sample_rate;
+	const double audio  = n_blocks * period;
+	for (unsigned i = 0; i < n_instances; ++i) {
+		Runner* const r = runners[i];
+		lilv_instance_deactivate(r->instance);
+
+		if (ok) {
+			const Result result = summarise(r->times, n_blocks);
+			print_parallel_result(
+				n_threads, i, threads[i % n_threads].cpu,
+				lilv_node_as_string(
+					lilv_plugin_get_uri(plugins[i % n_plugins])),
+				config, &result,
+				result.total > 0.0 ? audio / result.total : 0.0, 0.0);
+		}
+		runner_free(r);
+	}
+
+	double factor = 0.0;
+	if (ok) {
+		const Result result = summarise(cycles, n_blocks);
+		factor = (result.total > 0.0)
+			? n_instances * audio / result.total : 0.0;
+		print_parallel_result(n_threads, 0, -1, NULL, config, &result, factor,
+		                      base_factor > 0.0 ? factor / base_factor : 1.0);
+	}
+
+	for (unsigned t = 0; t < n_threads; ++t) {
+		free(threads[t].runners);
+	}
+	free(runners);
+	free(threads);
+	free(cycles);
+	return factor;
+}
+
+#endif  /* HAVE_PTHREAD_BARRIER */
+
 int
 main(int argc, char** argv)
 {
-	uint32_t block_size   = 512;
 	uint32_t sample_count = (1 << 19);
-
-	for (int i = 1; i < argc; ++i) {
-		if (!strcmp(argv[i], "--version")) {
+	uint32_t block_sizes[MAX_CONFIGS] = { 512 };
+	uint32_t rates[MAX_CONFIGS]       = { 48000 };
+	Signal   signals[MAX_CONFIGS]     = { SIGNAL_SILENCE };
+	uint32_t thread_counts[MAX_CONFIGS];
+	unsigned n_block_sizes            = 1;
+	unsigned n_rates                  = 1;
+	unsigned n_signals                = 1;
+	unsigned n_thread_counts          = 0;
+	unsigned n_instances              = 0;
+
+	int a = 1;
+	for (; a < argc && argv[a][0] == '-'; ++a) {
+		if (!strcmp(argv[a], "--version")) {
 			print_version();
 			return 0;
-		} else if (!strcmp(argv[i], "--help")) {
+		} else if (!strcmp(argv[a], "-h") || !strcmp(argv[a], "--help")) {
 			print_usage();
 			return 0;
-		} else if (!strcmp(argv[i], "-f")) {
-			full_output = true;
-		} else if (!strcmp(argv[i], "-n") && (i + 1 < argc)) {
-			sample_count = atoi(argv[++i]);
-		} else if (!strcmp(argv[i], "-b") && (i + 1 < argc)) {
-			block_size = atoi(argv[++i]);
+		} else if (!strcmp(argv[a], "-f") || !strcmp(argv[a], "--full")) {
+			format = FORMAT_CSV;
+		} else if (!strcmp(argv[a], "-v")) {
+			verbose = true;
+		} else if (!strcmp(argv[a], "-n") && (a + 1 < argc)) {
+			sample_count = atoi(argv[++a]);
+		} else if (!strcmp(argv[a], "-b") && (a + 1 < argc)) {
+			n_block_sizes = parse_uints(argv[++a], block_sizes);
+		} else if (!strcmp(argv[a], "-r") && (a + 1 < argc)) {
+			n_rates = parse_uints(argv[++a], rates);
+		} else if (!strcmp(argv[a], "-s") && (a + 1 < argc)) {
+			n_signals = parse_signals(argv[++a], signals);
+		} else if (!strcmp(argv[a], "-j") && (a + 1 < argc)) {
+			if (!(n_thread_counts = parse_uints(argv[++a], thread_counts))) {
+				fprintf(stderr, "error: Invalid list of thread counts\n");
+				return 1;
+			}
+		} else if (!strcmp(argv[a], "-i") && (a + 1 < argc)) {
+			const int n = atoi(argv[++a]);
+			n_instances = (n > 0) ? n : 1;
+		} else if (!strcmp(argv[a], "-o") && (a + 1 < argc)) {
+			const char* name = argv[++a];
+			if (!strcmp(name, "text")) {
+				format = FORMAT_TEXT;
+			} else if (!strcmp(name, "csv")) {
+				format = FORMAT_CSV;
+			} else if (!strcmp(name, "json")) {
+				format = FORMAT_JSON;
+			} else {
+				fprintf(stderr, "error: Unknown format `%s'\n", name);
+				return 1;
+			}
 		} else {
 			print_usage();
 			return 1;
 		}
 	}
 
+	if (!n_block_sizes || !n_rates || !n_signals) {
+		fprintf(stderr, "error: Invalid list of block sizes, rates, "
+		        "or signals\n");
+		return 1;
+	}
+
+	for (unsigned b = 0; b < n_block_sizes; ++b) {
+		if (sample_count < block_sizes[b]) {
+			fprintf(stderr, "error: Fewer frames than block size %u\n",
+			        block_sizes[b]);
+			return 1;
+		}
+	}
+
+#ifdef HAVE_PTHREAD_BARRIER
+	if (n_thread_counts && a == argc) {
+		fprintf(stderr, "error: Parallel mode (-j) requires plugin URIs\n");
+		return 1;
+	}
+#else
+	if (n_thread_counts) {
+		fprintf(stderr, "error: Parallel mode (-j) is not supported\n");
+		return 1;
+	}
+#endif
+
 	LilvWorld* world = lilv_world_new();
 	lilv_world_load_all(world);
 
-	atom_AtomPort   = lilv_new_uri(world, LV2_ATOM__AtomPort);
-	atom_Sequence   = lilv_new_uri(world, LV2_ATOM__Sequence);
-	lv2_AudioPort   = lilv_new_uri(world, LV2_CORE__AudioPort);
-	lv2_CVPort      = lilv_new_uri(world, LV2_CORE__CVPort);
-	lv2_ControlPort = lilv_new_uri(world, LV2_CORE__ControlPort);
-	lv2_InputPort   = lilv_new_uri(world, LV2_CORE__InputPort);
-	lv2_OutputPort  = lilv_new_uri(world, LV2_CORE__OutputPort);
-	urid_map        = lilv_new_uri(world, LV2_URID__map);
+	urid_map = lilv_new_uri(world, LV2_URID__map);
 
-	if (full_output) {
-		printf("# Block Samples Time Plugin\n");
+	const LilvPlugins* plugins = lilv_world_get_all_plugins(world);
+	const LilvPlugin** selected = (const LilvPlugin**)calloc(
+		argc, sizeof(LilvPlugin*));
+	unsigned n_selected = 0;
+	bool     missing    = false;
+	for (; a < argc; ++a) {
+		LilvNode*         uri = lilv_new_uri(world, argv[a]);
+		const LilvPlugin* p   = lilv_plugins_get_by_uri(plugins, uri);
+		if (p) {
+			selected[n_selected++] = p;
+		} else {
+			fprintf(stderr, "error: Plugin <%s> not found\n", argv[a]);
+			missing = true;
+		}
+		lilv_node_free(uri);
 	}
 
-	const LilvPlugins* plugins = lilv_world_get_all_plugins(world);
-	LILV_FOREACH(plugins, i, plugins) {
-		bench(lilv_plugins_get(plugins, i), sample_count, block_size);
+	if (missing) {
+		free(selected);
+		lilv_node_free(urid_map);
+		lilv_world_free(world);
+		return 1;
 	}
 
+	if (!n_instances) {
+		// Default to one instance per thread with the most threads
+		for (unsigned t = 0; t < n_thread_counts; ++t) {
+			if (thread_counts[t] > n_instances) {
+				n_instances = thread_counts[t];
+			}
+		}
+	}
+
+	print_header(n_thread_counts > 0);
+
+	if (n_thread_counts) {
+#ifdef HAVE_PTHREAD_BARRIER
+		for (unsigned b = 0; b < n_block_sizes && n_selected; ++b) {
+			for (unsigned r = 0; r < n_rates; ++r) {
+				for (unsigned s = 0; s < n_signals; ++s) {
+					const Config config = {
+						block_sizes[b], rates[r], signals[s] };
+
+					// Speedup is relative to the first thread count
+					double base = 0.0;
+					for (unsigned t = 0; t < n_thread_counts; ++t) {
+						const double factor = bench_parallel(
+							selected, n_selected, n_instances,
+							thread_counts[t], &config, sample_count, base);
+						if (t == 0) {
+							base = factor;
+						}
+					}
+				}
+			}
+		}
+#endif
+	} else if (n_selected) {
+		for (unsigned i = 0; i < n_selected; ++i) {
+			bench_plugin(selected[i], sample_count,
+			             block_sizes, n_block_sizes,
+			             rates, n_rates,
+			             signals, n_signals);
+		}
+	} else {
+		LILV_FOREACH(plugins, i, plugins) {
+			bench_plugin(lilv_plugins_get(plugins, i), sample_count,
+			             block_sizes, n_block_sizes,
+			             rates, n_rates,
+			             signals, n_signals);
+		}
+	}
+
+	print_footer();
+
+	free(selected);
 	lilv_node_free(urid_map);
-	lilv_node_free(lv2_OutputPort);
-	lilv_node_free(lv2_InputPort);
-	lilv_node_free(lv2_ControlPort);
-	lilv_node_free(lv2_CVPort);
-	lilv_node_free(lv2_AudioPort);
-	lilv_node_free(atom_Sequence);
-	lilv_node_free(atom_AtomPort);
 
 	lilv_world_free(world);
 
@@ -22,39 +22,26 @@ namespace client {
 SPtr<ClientObject>
 ClientModel::find(uint64_t id)
 {
-	SPtr<ClientObject> key(new ClientObjectKey(id));
-	Objects::iterator  i = _objects.find(key);
-	if (i != _objects.end()) {
-		return *i;
-	} else {
-		return SPtr<ClientObject>();
-	}
+	return _objects.find(id);
 }
 
 SPtr<const ClientObject>
 ClientModel::find(uint64_t id) const
 {
-	SPtr<ClientObject> key(new ClientObjectKey(id));
-	Objects::const_iterator  i = _objects.find(key);
-	if (i != _objects.end()) {
-		return *i;
-	} else {
-		return SPtr<ClientObject>();
-	}
+	return _objects.find(id);
 }
 
 void
 ClientModel::new_object(uint64_t id, const Properties& properties)
 {
-	SPtr<ClientObject> key(new ClientObjectKey(id));
-	Objects::iterator i = _objects.find(key);
-	if (i == _objects.end()) {
-		SPtr<ClientObject> object(new ClientObject(id, properties));
+	SPtr<ClientObject> object = _objects.find(id);
+	if (!object) {
+		object = SPtr<ClientObject>(new ClientObject(id, properties));
 		_objects.insert(object);
 		signal_new_object.emit(object);
 	} else {
 		for (const auto& p : properties) {
-			(*i)->set(p.first, p.second);
+			object->set(p.first, p.second);
 		}
 	}
 }
@@ -62,15 +49,14 @@ ClientModel::new_object(uint64_t id, const Properties& properties)
 void
 ClientModel::erase_object(uint64_t id)
 {
-	SPtr<ClientObject> key(new ClientObjectKey(id));
-	Objects::iterator  i = _objects.find(key);
-	if (i == _objects.end()) {
+	SPtr<ClientObject> object = _objects.find(id);
+	if (!object) {
 		return;
 	}
 
-	signal_erase_object.emit(*i);
-	(*i)->set_view(NULL);
-	_objects.erase(i);
+	signal_erase_object.emit(object);
+	object->set_view(NULL);
+	_objects.erase(id);
 }
 
 void
@@ -17,10 +17,9 @@
 #ifndef MACHINA_CLIENTMODEL_HPP
 #define MACHINA_CLIENTMODEL_HPP
 
-#include <set>
-
 #include <sigc++/sigc++.h>
 
+#include "machina/IdMap.hpp"
 #include "machina/Model.hpp"
 
 #include "ClientObject.hpp"
@@ -49,16 +48,7 @@ public:
 	sigc::signal< void, SPtr<ClientObject> > signal_erase_object;
 
 private:
-	struct ClientObjectComparator {
-		inline bool operator()(SPtr<ClientObject> lhs,
-		                       SPtr<ClientObject> rhs) const {
-			return lhs->id() < rhs->id();
-		}
-
-	};
-
-	typedef std::set<SPtr<ClientObject>, ClientObjectComparator> Objects;
-	Objects _objects;
+	IdMap<ClientObject> _objects;
 };
 
 }
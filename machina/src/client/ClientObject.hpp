@@ -38,7 +38,7 @@ public:
 	void        set(URIInt key, const Atom& value);
 	const Atom& get(URIInt key) const;
 
-	sigc::signal<void, URIInt, Atom> signal_property;
+	sigc::signal<void, URIInt, const Atom&> signal_property;
 
 	class View
 	{
@@ -59,12 +59,6 @@ private:
 	Properties _properties;
 };
 
-/** Stub client object to use as a search key. */
-struct ClientObjectKey : public ClientObject
-{
-	explicit ClientObjectKey(uint64_t id) : ClientObject(id) {}
-};
-
 }
 }
 
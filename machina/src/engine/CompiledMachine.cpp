@@ -0,0 +1,310 @@
+/*
+  This file is part of Machina.
+  Copyright 2007-2013 David Robillard <http://drobilla.net>
+
+  Machina is free software: you can redistribute it and/or modify it under the
+  terms of the GNU General Public License as published by the Free Software
+  Foundation, either version 3 of the License, or any later version.
+
+  Machina is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Machina.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <unordered_map>
+
+#include "machina/Context.hpp"
+#include "machina/Machine.hpp"
+#include "machina/URIs.hpp"
+#include "machina/Updates.hpp"
+
+#include "Action.hpp"
+#include "CompiledMachine.hpp"
+#include "Edge.hpp"
+#include "Node.hpp"
+
+using namespace Raul;
+using namespace std;
+
+namespace machina {
+
+CompiledMachine::CompiledMachine(TimeUnit unit)
+	: _active(MAX_ACTIVE_NODES, Active(unit))
+	, _n_active(0)
+	, _rng(1)
+	, _time(unit, 0, 0)
+	, _is_finished(false)
+{}
+
+CompiledMachine::CompiledMachine(const Machine& machine, uint64_t seed)
+	: _active(MAX_ACTIVE_NODES, Active(machine.time().unit()))
+	, _n_active(0)
+	, _rng(seed ? seed : 1)  // Xorshift state must be non-zero
+	, _time(machine.time().unit(), 0, 0)
+	, _is_finished(false)
+{
+	const TimeUnit unit = machine.time().unit();
+
+	// Number nodes, with the initial node first
+	std::vector<Node*>                        order;
+	std::unordered_map<const Node*, uint32_t> index;
+	order.push_back(machine.initial_node().get());
+	for (const auto& n : machine.nodes()) {
+		if (n != machine.initial_node()) {
+			order.push_back(n.get());
+		}
+	}
+	for (uint32_t i = 0; i < order.size(); ++i) {
+		index[order[i]] = i;
+	}
+
+	_nodes.reserve(order.size());
+	for (Node* n : order) {
+		CNode node(unit);
+		node.duration    = n->duration();
+		node.id          = n->id();
+		node.is_selector = n->is_selector();
+		node.first_edge  = _edges.size();
+
+		if (n->enter_action()) {
+			_actions.push_back(n->enter_action());
+			node.enter_action = n->enter_action().get();
+		}
+		if (n->exit_action()) {
+			_actions.push_back(n->exit_action());
+			node.exit_action = n->exit_action().get();
+		}
+
+		float cumulative = 0.0f;
+		for (const auto& e : n->edges()) {
+			std::unordered_map<const Node*, uint32_t>::const_iterator h =
+				index.find(e->head().get());
+			if (h == index.end()) {
+				continue;  // Head is not in this machine
+			}
+
+			CEdge edge;
+			edge.head = h->second;
+			if (node.is_selector) {
+				cumulative      += e->probability();
+				edge.probability = cumulative;
+			} else {
+				edge.probability = e->probability();
+			}
+			_edges.push_back(edge);
+		}
+		node.n_edges = _edges.size() - node.first_edge;
+
+		_nodes.push_back(node);
+		_ids.push_back(NodeIndex(node.id, _nodes.size() - 1));
+	}
+
+	std::sort(_ids.begin(), _ids.end());
+}
+
+inline double
+CompiledMachine::random()
+{
+	// xorshift64*
+	_rng ^= _rng >> 12;
+	_rng ^= _rng << 25;
+	_rng ^= _rng >> 27;
+	return ((_rng * 2685821657736338717ULL) >> 11) / 9007199254740992.0;
+}
+
+void
+CompiledMachine::transfer(CompiledMachine& old, MIDISink* sink)
+{
+	if (old._is_finished) {
+		return;
+	}
+
+	for (size_t i = 0; i < old._n_active; ++i) {
+		CNode& node = old._nodes[old._active[i].node];
+
+		std::vector<NodeIndex>::const_iterator n = std::lower_bound(
+			_ids.begin(), _ids.end(), NodeIndex(node.id, 0));
+
+		node.is_active = false;
+		if (n != _ids.end() && n->first == node.id
+		    && !_nodes[n->second].is_active && _n_active < MAX_ACTIVE_NODES) {
+			// Node still exists, keep it active until the same time
+			_nodes[n->second].is_active  = true;
+			_active[_n_active].exit_time = old._active[i].exit_time;
+			_active[_n_active].node      = n->second;
+			++_n_active;
+			std::push_heap(_active.begin(), _active.begin() + _n_active,
+			               ExitsLater());
+		} else if (sink && node.exit_action) {
+			node.exit_action->execute(sink, old._time);
+		}
+	}
+	old._n_active = 0;
+
+	if (_n_active > 0) {
+		_time = old._time;
+	}
+}
+
+void
+CompiledMachine::reset(MIDISink* sink, Raul::TimeStamp time)
+{
+	if (!_is_finished) {
+		for (size_t i = 0; i < _n_active; ++i) {
+			CNode& node = _nodes[_active[i].node];
+			if (sink && node.exit_action) {
+				node.exit_action->execute(sink, time);
+			}
+			node.is_active = false;
+		}
+		_n_active = 0;
+	}
+
+	_time        = TimeStamp(_time.unit(), 0, 0);
+	_is_finished = false;
+}
+
+bool
+CompiledMachine::enter_node(Context&                      context,
+                            uint32_t                      index,
+                            const SPtr<Raul::RingBuffer>& updates)
+{
+	CNode& node = _nodes[index];
+	assert(!node.is_active);
+
+	if (_n_active == MAX_ACTIVE_NODES) {
+		return false;  // Ran out of active node spots, don't enter node
+	}
+
+	node.is_active = true;
+	if (context.sink() && node.enter_action) {
+		node.enter_action->execute(context.sink(), _time);
+	}
+
+	_active[_n_active].exit_time = _time + node.duration;
+	_active[_n_active].node      = index;
+	++_n_active;
+	std::push_heap(_active.begin(), _active.begin() + _n_active, ExitsLater());
+
+	write_set(updates,
+	          node.id,
+	          URIs::instance().machina_active,
+	          context.forge().make(true));
+
+	return true;
+}
+
+void
+CompiledMachine::exit_node(Context&                      context,
+                           uint32_t                      index,
+                           const SPtr<Raul::RingBuffer>& updates)
+{
+	CNode& node = _nodes[index];
+
+	// Exit node (already removed from the heap by run())
+	if (context.sink() && node.exit_action) {
+		node.exit_action->execute(context.sink(), _time);
+	}
+	node.is_active = false;
+
+	// Notify UI
+	write_set(updates,
+	          node.id,
+	          URIs::instance().machina_active,
+	          context.forge().make(false));
+
+	// Activate successors
+	const CEdge* const begin = _edges.data() + node.first_edge;
+	const CEdge* const end   = begin + node.n_edges;
+	if (node.is_selector) {
+		// Choose the edge whose cumulative probability range contains r
+		const double r = random();
+		for (const CEdge* e = begin; e != end; ++e) {
+			if (r < e->probability) {
+				if (!_nodes[e->head].is_active) {
+					enter_node(context, e->head, updates);
+				}
+				break;
+			}
+		}
+	} else {
+		for (const CEdge* e = begin; e != end; ++e) {
+			if (random() <= e->probability && !_nodes[e->head].is_active) {
+				enter_node(context, e->head, updates);
+			}
+		}
+	}
+}
+
+uint32_t
+CompiledMachine::run(Context& context, const SPtr<Raul::RingBuffer>& updates)
+{
+	if (_is_finished) {
+		return 0;
+	} else if (_nodes.empty()) {
+		_is_finished = true;
+		return 0;
+	}
+
+	const Raul::TimeSlice& time = context.time();
+
+	const TimeStamp end_frames = (time.start_ticks() + time.length_ticks());
+	const TimeStamp end_beats  = time.ticks_to_beats(end_frames);
+
+	if (_time.is_zero()) {  // Initial run
+		// Exit any active nodes
+		for (size_t i = 0; i < _n_active; ++i) {
+			CNode& node = _nodes[_active[i].node];
+			if (context.sink() && node.exit_action) {
+				node.exit_action->execute(context.sink(), _time);
+			}
+			node.is_active = false;
+			write_set(updates,
+			          node.id,
+			          URIs::instance().machina_active,
+			          context.forge().make(false));
+		}
+		_n_active = 0;
+
+		// Enter initial node
+		enter_node(context, 0, updates);
+
+		if (_nodes[0].n_edges == 0) {  // Nowhere to go, exit
+			_is_finished = true;
+			return 0;
+		}
+	}
+
+	while (true) {
+		if (_n_active == 0) {
+			// No more active states, machine is finished
+			_is_finished = true;
+			break;
+		}
+
+		const Active earliest = _active.front();
+		if (time.beats_to_ticks(earliest.exit_time) < end_frames) {
+			// Earliest active state ends this cycle, exit it
+			std::pop_heap(_active.begin(), _active.begin() + _n_active,
+			              ExitsLater());
+			--_n_active;
+
+			_time = earliest.exit_time;
+			exit_node(context, earliest.node, updates);
+
+		} else {
+			// Earliest active state ends in the future, done this cycle
+			_time = end_beats;
+			break;
+		}
+	}
+
+	return time.beats_to_ticks(_time).ticks() - time.start_ticks().ticks();
+}
+
+} // namespace machina
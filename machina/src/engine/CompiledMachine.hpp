@@ -0,0 +1,152 @@
+/*
+  This file is part of Machina.
+  Copyright 2007-2013 David Robillard <http://drobilla.net>
+
+  Machina is free software: you can redistribute it and/or modify it under the
+  terms of the GNU General Public License as published by the Free Software
+  Foundation, either version 3 of the License, or any later version.
+
+  Machina is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Machina.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MACHINA_COMPILEDMACHINE_HPP
+#define MACHINA_COMPILEDMACHINE_HPP
+
+#include <stdint.h>
+
+#include <utility>
+#include <vector>
+
+#include "raul/Maid.hpp"
+#include "raul/RingBuffer.hpp"
+#include "raul/TimeStamp.hpp"
+
+#include "machina/types.hpp"
+
+namespace machina {
+
+struct Action;
+class Context;
+class MIDISink;
+class Machine;
+
+/** A Machine compiled into a flat form for running in a realtime thread.
+ *
+ * Nodes and edges are stored in arrays and refer to each other by index,
+ * active nodes are kept in a fixed-size heap ordered by exit time, and
+ * random numbers come from a private xorshift generator, so run() and
+ * reset() never allocate, lock, or touch reference counts.
+ *
+ * A compiled machine is a snapshot: it is built from a Machine in a non-
+ * realtime thread whenever the machine is edited, then swapped in by the
+ * driver, which hands the old one to a Raul::Maid for deletion.
+ */
+class CompiledMachine : public Raul::Maid::Disposable
+{
+public:
+	/** Create an empty machine that never plays anything. */
+	explicit CompiledMachine(Raul::TimeUnit unit);
+
+	/** Compile `machine`, seeding the random number generator with `seed`. */
+	CompiledMachine(const Machine& machine, uint64_t seed);
+
+	bool is_empty()    const { return _nodes.empty(); }
+	bool is_finished() const { return _is_finished; }
+
+	inline Raul::TimeStamp time() const { return _time; }
+
+	/** Continue from the state of `old`, a previous compile of this machine.
+	 *
+	 * Nodes active in `old` which still exist stay active with the same exit
+	 * time, the rest are exited (writing their exit actions to `sink`).  If
+	 * no nodes remain active, this machine starts from the beginning.
+	 * Realtime safe.
+	 */
+	void transfer(CompiledMachine& old, MIDISink* sink);
+
+	/** Exit all active nodes and reset time to 0.  Realtime safe. */
+	void reset(MIDISink* sink, Raul::TimeStamp time);
+
+	/** Run for a (real) time slice, exactly like Machine::run().
+	 *
+	 * Realtime safe.
+	 */
+	uint32_t run(Context& context, const SPtr<Raul::RingBuffer>& updates);
+
+	static const size_t MAX_ACTIVE_NODES = 128;
+
+private:
+	struct CNode {
+		CNode(Raul::TimeUnit unit)
+			: duration(unit, 0, 0)
+			, enter_action(NULL)
+			, exit_action(NULL)
+			, id(0)
+			, first_edge(0)
+			, n_edges(0)
+			, is_selector(false)
+			, is_active(false)
+		{}
+
+		Raul::TimeDuration duration;
+		Action*            enter_action;
+		Action*            exit_action;
+		uint64_t           id;           ///< Stateful ID, for UI updates
+		uint32_t           first_edge;   ///< Index of first edge in _edges
+		uint32_t           n_edges;
+		bool               is_selector;
+		bool               is_active;
+	};
+
+	struct CEdge {
+		uint32_t head;         ///< Index of head node in _nodes
+		float    probability;  ///< Cumulative for selectors
+	};
+
+	struct Active {
+		Active(Raul::TimeUnit unit) : exit_time(unit, 0, 0), node(0) {}
+
+		Raul::TimeStamp exit_time;
+		uint32_t        node;
+	};
+
+	typedef std::pair<uint64_t, uint32_t> NodeIndex;
+
+	/** Heap order, so the earliest exit time is at the front. */
+	struct ExitsLater {
+		inline bool operator()(const Active& a, const Active& b) const {
+			return a.exit_time > b.exit_time
+				|| (a.exit_time == b.exit_time && a.node > b.node);
+		}
+	};
+
+	/** Return a random number in [0, 1). */
+	inline double random();
+
+	bool enter_node(Context&                      context,
+	                uint32_t                      node,
+	                const SPtr<Raul::RingBuffer>& updates);
+
+	void exit_node(Context&                      context,
+	               uint32_t                      node,
+	               const SPtr<Raul::RingBuffer>& updates);
+
+	std::vector<CNode>          _nodes;    ///< Initial node is _nodes[0]
+	std::vector<CEdge>          _edges;
+	std::vector<NodeIndex>      _ids;      ///< Sorted by ID, for transfer()
+	std::vector<Active>         _active;   ///< Heap of _n_active nodes
+	size_t                      _n_active;
+	std::vector< SPtr<Action> > _actions;  ///< Keeps actions alive
+	uint64_t                    _rng;
+	Raul::TimeStamp             _time;
+	bool                        _is_finished;
+};
+
+} // namespace machina
+
+#endif // MACHINA_COMPILEDMACHINE_HPP
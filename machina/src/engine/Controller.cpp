@@ -51,6 +51,7 @@ Controller::create(const Properties& properties)
 	_objects.insert(node);
 	_model.new_object(node->id(), properties);
 	_engine->machine()->add_node(node);
+	_engine->driver()->machine_changed();
 	return node->id();
 }
 
@@ -110,17 +111,6 @@ Controller::announce(SPtr<Machine> machine)
 	}
 }
 
-SPtr<Stateful>
-Controller::find(uint64_t id)
-{
-	SPtr<StatefulKey> key(new StatefulKey(id));
-	Objects::iterator i = _objects.find(key);
-	if (i != _objects.end()) {
-		return *i;
-	}
-	return SPtr<Stateful>();
-}
-
 void
 Controller::learn(SPtr<Raul::Maid> maid, uint64_t node_id)
 {
@@ -142,6 +132,7 @@ Controller::set_property(uint64_t    object_id,
 	if (object) {
 		object->set(key, value);
 		_model.set(object_id, key, value);
+		_engine->driver()->machine_changed();
 	}
 }
 
@@ -162,6 +153,7 @@ Controller::connect(uint64_t tail_id, uint64_t head_id)
 	SPtr<Edge> edge(new Edge(tail, head));
 	tail->add_edge(edge);
 	_objects.insert(edge);
+	_engine->driver()->machine_changed();
 
 	Forge& forge = _engine->forge();
 
@@ -187,6 +179,7 @@ Controller::disconnect(uint64_t tail_id, uint64_t head_id)
 
 	SPtr<Edge> edge = tail->remove_edge_to(head);
 	if (edge) {
+		_engine->driver()->machine_changed();
 		_model.erase_object(edge->id());
 	} else {
 		std::cerr << "Edge not found" << std::endl;
@@ -196,19 +189,18 @@ Controller::disconnect(uint64_t tail_id, uint64_t head_id)
 void
 Controller::erase(uint64_t id)
 {
-	SPtr<StatefulKey> key(new StatefulKey(id));
-	Objects::iterator i = _objects.find(key);
-	if (i == _objects.end()) {
+	SPtr<Stateful> object = _objects.erase(id);
+	if (!object) {
 		return;
 	}
 
-	SPtr<Node> node = dynamic_ptr_cast<Node>(*i);
+	SPtr<Node> node = dynamic_ptr_cast<Node>(object);
 	if (node) {
 		_engine->machine()->remove_node(node);
+		_engine->driver()->machine_changed();
 	}
 
-	_model.erase_object((*i)->id());
-	_objects.erase(i);
+	_model.erase_object(id);
 }
 
 void
@@ -219,9 +211,17 @@ Controller::process_updates()
 	uint64_t subject;
 	URIInt   key;
 	Atom     value;
+	bool     learned = false;
 	for (uint32_t i = 0; i < read_space; ) {
 		i += read_set(_updates, &subject, &key, &value);
 		_model.set(subject, key, value);
+		if (key == URIs::instance().machina_enter_action) {
+			learned = true;  // Driver finished a MIDI learn
+		}
+	}
+
+	if (learned) {
+		_engine->driver()->machine_changed();
 	}
 }
 
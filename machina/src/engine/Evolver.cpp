@@ -14,7 +14,10 @@
   along with Machina.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
+#include <ctime>
 #include <iostream>
+#include <thread>
 
 #include "eugene/HybridMutation.hpp"
 #include "eugene/Mutation.hpp"
@@ -33,8 +36,10 @@ namespace machina {
 Evolver::Evolver(TimeUnit      unit,
                  const string& target_midi,
                  SPtr<Machine> seed)
-	: _problem(new Problem(unit, target_midi, seed))
+	: _rng(time(NULL))
+	, _problem(new Problem(unit, target_midi, seed))
 	, _seed_fitness(-FLT_MAX)
+	, _exit_flag(false)
 {
 	SPtr<eugene::HybridMutation<Machine> > m(new HybridMutation<Machine>());
 
@@ -59,7 +64,13 @@ Evolver::Evolver(TimeUnit      unit,
 		new TournamentSelection<Machine>(*_problem.get(), 3, 0.8));
 	std::shared_ptr< Crossover<Machine> > crossover;
 	size_t gene_length = 20; // FIXME
+	size_t pop_size    = 20;
 	Problem::Population pop;
+	_problem->initial_population(_rng, pop, gene_length, pop_size);
+
+	// Evaluation simulates a private copy of each machine, so is parallel
+	const size_t n_threads = std::max(1u, std::thread::hardware_concurrency());
+
 	_ga = SPtr<MachinaGA>(
 		new MachinaGA(_rng,
 		              _problem,
@@ -68,10 +79,11 @@ Evolver::Evolver(TimeUnit      unit,
 		              m,
 		              pop,
 		              gene_length,
-		              20,
+		              pop_size,
 		              2,
 		              1.0,
-		              0.0));
+		              0.0,
+		              n_threads));
 }
 
 void
@@ -83,6 +95,24 @@ Evolver::seed(SPtr<Machine> parent)
 	_seed_fitness = _problem->evaluate(*parent.get());
 }
 
+void
+Evolver::start()
+{
+	if (!_thread.joinable()) {
+		_exit_flag = false;
+		_thread    = std::thread(&Evolver::_run, this);
+	}
+}
+
+void
+Evolver::join()
+{
+	if (_thread.joinable()) {
+		_exit_flag = true;
+		_thread.join();
+	}
+}
+
 void
 Evolver::_run()
 {
@@ -94,7 +124,6 @@ Evolver::_run()
 
 	while (!_exit_flag) {
 		//cout << "{" << endl;
-		_problem->clear_fitness_cache();
 		_ga->iteration();
 
 		float new_best = _ga->best_fitness();
@@ -14,6 +14,7 @@
   along with Machina.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <cstdlib>
 #include <iostream>
 
 #include "machina/Context.hpp"
@@ -36,6 +37,8 @@ JackDriver::JackDriver(Forge& forge, SPtr<Machine> machine)
 	: Driver(forge, machine)
 	, _client(NULL)
 	, _machine_changed(0)
+	, _compiled(NULL)
+	, _new_compiled(NULL)
 	, _input_port(NULL)
 	, _output_port(NULL)
 	, _context(forge, 48000, MACHINA_PPQN, 120.0)
@@ -47,11 +50,16 @@ JackDriver::JackDriver(Forge& forge, SPtr<Machine> machine)
 	, _is_activated(false)
 {
 	_context.set_sink(this);
+	if (_machine) {
+		machine_changed();
+	}
 }
 
 JackDriver::~JackDriver()
 {
 	detach();
+	delete _new_compiled.exchange(NULL);
+	delete _compiled;
 }
 
 void
@@ -104,6 +112,7 @@ JackDriver::attach(const std::string& client_name)
 			_machine = SPtr<Machine>(
 				new Machine(TimeUnit::frames(
 					            jack_get_sample_rate(jack_client()))));
+			machine_changed();
 		}
 	}
 }
@@ -165,6 +174,7 @@ JackDriver::set_machine(SPtr<Machine> machine)
 	_machine_changed.reset(0);
 	assert(!last_machine.unique());
 	_machine = machine;
+	machine_changed();
 	if (is_activated()) {
 		_machine_changed.wait();
 	}
@@ -172,6 +182,25 @@ JackDriver::set_machine(SPtr<Machine> machine)
 	last_machine.reset();
 }
 
+void
+JackDriver::machine_changed()
+{
+	// Free machines the process thread has finished with
+	_maid.cleanup();
+
+	SPtr<Machine>    machine  = _machine;
+	CompiledMachine* compiled = NULL;
+	if (machine) {
+		const uint64_t seed = ((uint64_t)rand() << 32) ^ (uint64_t)rand();
+		compiled = new CompiledMachine(*machine.get(), seed);
+	} else {
+		compiled = new CompiledMachine(_beats_unit);
+	}
+
+	// Replace any pending machine, which the process thread has not seen
+	delete _new_compiled.exchange(compiled);
+}
+
 void
 JackDriver::read_input_recording(SPtr<Machine>          machine,
                                  const Raul::TimeSlice& time)
@@ -318,23 +347,32 @@ JackDriver::on_process(jack_nframes_t nframes)
 	 * cycle so _machine can be switched with set_machine during a cycle. */
 	SPtr<Machine> machine = _machine;
 
+	// Machine was recompiled since last cycle, switch to the new one
+	CompiledMachine* const compiled = _new_compiled.exchange(NULL);
+	if (compiled) {
+		if (_compiled) {
+			compiled->transfer(*_compiled, _context.sink());
+			_maid.dispose(_compiled);  // Realtime, can't delete
+		}
+		_compiled = compiled;
+	}
+
 	// Machine was switched since last cycle, finalize old machine.
 	if (machine != _last_machine) {
 		if (_last_machine) {
-			assert(!_last_machine.unique());                              // Realtime, can't delete
-			_last_machine->reset(_context.sink(), _last_machine->time()); // Exit all active states
-			_last_machine.reset();                                        // Cut our reference
+			assert(!_last_machine.unique()); // Realtime, can't delete
+			_last_machine.reset();           // Cut our reference
 		}
 		_machine_changed.post(); // Signal we're done with it
 	}
 
-	if (!machine) {
+	if (!machine || !_compiled) {
 		_last_machine = machine;
 		goto end;
 	}
 
 	if (_stop_flag) {
-		machine->reset(_context.sink(), _context.time().start_beats());
+		_compiled->reset(_context.sink(), _context.time().start_beats());
 	}
 
 	switch (_play_state) {
@@ -349,23 +387,23 @@ JackDriver::on_process(jack_nframes_t nframes)
 		break;
 	}
 
-	if (machine->is_empty()) {
+	if (_compiled->is_empty()) {
 		goto end;
 	}
 
 	while (true) {
-		const uint32_t run_dur_frames = machine->run(_context, _updates);
+		const uint32_t run_dur_frames = _compiled->run(_context, _updates);
 
 		if (run_dur_frames == 0) {
 			// Machine didn't run at all (machine has no initial states)
-			machine->reset(_context.sink(), machine->time()); // Try again next cycle
+			_compiled->reset(_context.sink(), _compiled->time()); // Try again next cycle
 			_context.time().set_slice(TimeStamp(_frames_unit, 0, 0),
 			                          TimeStamp(_frames_unit, 0, 0));
 			break;
 
-		} else if (machine->is_finished()) {
+		} else if (_compiled->is_finished()) {
 			// Machine ran for portion of cycle and is finished
-			machine->reset(_context.sink(), machine->time());
+			_compiled->reset(_context.sink(), _compiled->time());
 
 			_context.time().set_slice(TimeStamp(_frames_unit, 0, 0),
 			                          TimeStamp(_frames_unit, nframes
@@ -453,6 +491,7 @@ JackDriver::finish_record()
 	SPtr<Machine> machine = _recorder->finish();
 	_recorder.reset();
 	_machine->merge(*machine.get());
+	machine_changed();
 }
 
 int
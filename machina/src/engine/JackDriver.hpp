@@ -20,6 +20,9 @@
 #include <jack/jack.h>
 #include <jack/midiport.h>
 
+#include <atomic>
+
+#include "raul/Maid.hpp"
 #include "raul/Semaphore.hpp"
 
 #include "machina/Context.hpp"
@@ -27,6 +30,7 @@
 #include "machina/Machine.hpp"
 #include "machina/types.hpp"
 
+#include "CompiledMachine.hpp"
 #include "Recorder.hpp"
 
 namespace machina {
@@ -38,6 +42,10 @@ class Node;
  *
  * "Ticks" are individual frames when running under this driver, and all code
  * in the processing context must be realtime safe (non-blocking).
+ *
+ * The process thread does not run the editable Machine, but a CompiledMachine
+ * which is rebuilt by machine_changed() and swapped in at the start of the
+ * next cycle.
  */
 class JackDriver : public machina::Driver
 {
@@ -53,6 +61,7 @@ public:
 	void deactivate();
 
 	void set_machine(SPtr<Machine> machine);
+	void machine_changed();
 
 	void write_event(Raul::TimeStamp      time,
 	                 size_t               size,
@@ -98,6 +107,10 @@ private:
 	Raul::Semaphore _machine_changed;
 	SPtr<Machine>   _last_machine;
 
+	Raul::Maid                    _maid;
+	CompiledMachine*              _compiled;      ///< Process thread only
+	std::atomic<CompiledMachine*> _new_compiled;  ///< Next to switch to
+
 	jack_port_t* _input_port;
 	jack_port_t* _output_port;
 
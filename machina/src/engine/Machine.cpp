@@ -53,6 +53,12 @@ Machine::assign(const Machine& copy)
 
 	replacements[copy.initial_node()] = _initial_node;
 
+	// The initial node is not copied, but its edges must be
+	_initial_node->edges().clear();
+	for (const auto& e : copy.initial_node()->edges()) {
+		_initial_node->edges().insert(SPtr<Edge>(new Edge(*e.get())));
+	}
+
 	for (const auto& n : copy._nodes) {
 		if (!n->is_initial()) {
 			SPtr<machina::Node> node(new machina::Node(*n.get()));
@@ -71,7 +77,7 @@ Machine::assign(const Machine& copy)
 
 Machine::Machine(const Machine& copy)
 	: Stateful() // don't copy RDF ID
-	, fitness(0.0)
+	, fitness(copy.fitness)
 	, _initial_node(new Node(TimeStamp(copy.time().unit(), 0, 0), true))
 	, _active_nodes(MAX_ACTIVE_NODES, SPtr<Node>())
 	, _time(copy.time())
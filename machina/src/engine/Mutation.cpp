@@ -40,7 +40,7 @@ Compress::mutate(Random& rng, Machine& machine)
 		Machine::Nodes::iterator next = i;
 		++next;
 
-		if ((*i)->edges().empty()) {
+		if ((*i)->edges().empty() && !(*i)->is_initial()) {
 			machine.remove_node(*i);
 		}
 
@@ -137,6 +137,9 @@ SwapNodes::mutate(Random& rng, Machine& machine)
 	SPtr<MidiAction> a_exit  = dynamic_ptr_cast<MidiAction>(a->exit_action());
 	SPtr<MidiAction> b_enter = dynamic_ptr_cast<MidiAction>(b->enter_action());
 	SPtr<MidiAction> b_exit  = dynamic_ptr_cast<MidiAction>(b->exit_action());
+	if (!a_enter || !a_exit || !b_enter || !b_exit) {
+		return;  // Initial node, or not a note
+	}
 
 	uint8_t note_a = a_enter->event()[1];
 	uint8_t note_b = b_enter->event()[1];
@@ -18,7 +18,10 @@
 
 #include <stdint.h>
 
+#include <string.h>
+
 #include <set>
+#include <unordered_map>
 #include <vector>
 #include <iostream>
 
@@ -26,6 +29,7 @@
 
 #include "eugene/Problem.hpp"
 
+#include "machina/Context.hpp"
 #include "machina/Machine.hpp"
 
 #include "ActionFactory.hpp"
@@ -36,6 +40,7 @@
 #include "machina_config.h"
 
 using namespace std;
+using namespace Raul;
 
 namespace machina {
 
@@ -75,81 +80,152 @@ Problem::Problem(TimeUnit           unit,
 	_target.compute();
 }
 
-float
-Problem::evaluate(const Machine& const_machine) const
+/** Tick rate for headless simulation. */
+static const uint32_t SIM_RATE = 48000;
+
+/** Number of ticks simulated per cycle. */
+static const uint32_t SIM_BLOCK = 4096;
+
+/** Maximum number of cycles to simulate a single machine for. */
+static const size_t SIM_MAX_CYCLES = 4096;
+
+/** Maximum number of fitnesses to remember before starting over. */
+static const size_t MAX_CACHED_FITNESSES = 1 << 16;
+
+static inline uint64_t
+mix(uint64_t h)
 {
-	#if 0
-	//cout << "(";
+	h ^= h >> 33;
+	h *= 0xFF51AFD7ED558CCDULL;
+	h ^= h >> 33;
+	h *= 0xC4CEB9FE1A85EC53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+static uint64_t
+node_hash(Node& node)
+{
+	const TimeDuration d = node.duration();
+	uint64_t           h = mix(((uint64_t)d.ticks() << 32) + d.subticks());
 
-	// kluuudge
-	Machine& machine = const_cast<Machine&>(const_machine);
+	h = mix(h ^ ((node.is_initial() ? 1 : 0) | (node.is_selector() ? 2 : 0)));
 
-	map<Machine*, float>::const_iterator cached = _fitness.find(&machine);
-	if (cached != _fitness.end()) {
-		return cached->second;
+	SPtr<MidiAction> action = dynamic_ptr_cast<MidiAction>(node.enter_action());
+	if (action) {
+		const byte* ev = action->event();
+		for (size_t i = 0; ev && i < action->event_size(); ++i) {
+			h = mix(h ^ ev[i]);
+		}
 	}
 
-	SPtr<Evaluator> eval(new Evaluator(*this));
+	return h;
+}
 
-	//machine.reset();
-	machine.set_sink(eval);
+uint64_t
+Problem::structural_hash(const Machine& machine)
+{
+	std::unordered_map<const Node*, uint64_t> node_hashes;
+	for (const auto& n : machine.nodes()) {
+		node_hashes[n.get()] = node_hash(*n.get());
+	}
 
-	// FIXME: timing stuff here isn't right at all...
+	// Sums so the result is independent of node and edge order
+	uint64_t h = 0;
+	for (const auto& n : machine.nodes()) {
+		uint64_t edges = 0;
+		for (const auto& e : n->edges()) {
+			float    prob      = e->probability();
+			uint32_t prob_bits = 0;
+			memcpy(&prob_bits, &prob, sizeof(prob_bits));
+			edges += mix(node_hashes[e->head().get()] ^ prob_bits);
+		}
+		h += mix(node_hashes[n.get()] ^ mix(edges));
+	}
 
-	static const unsigned ppqn = MACHINA_PPQN;
-	Raul::TimeSlice       time(ppqn, ppqn, 120.0);
-	time.set_slice(TimeStamp(_unit, 0, 0), TimeDuration(_unit, 2 * ppqn));
+	return h;
+}
 
-	machine.run(time);
-	if (eval->n_notes() == 0) {
-		return 0.0f; // bad dog
+float
+Problem::evaluate(const Machine& machine) const
+{
+	const uint64_t key = structural_hash(machine);
+	{
+		std::lock_guard<std::mutex> lock(_fitness_mutex);
+		FitnessCache::const_iterator cached = _fitness.find(key);
+		if (cached != _fitness.end()) {
+			return cached->second;
+		}
 	}
-	TimeStamp end(_unit, time.start_ticks().ticks() + 2 * ppqn);
-	time.set_slice(end, TimeStamp(_unit, 0, 0));
 
-	while (eval->n_notes() < _target.n_notes()) {
-		machine.run(time);
-		if (machine.is_finished()) {
-			machine.reset(time.start_ticks());
-		}
-		time.set_slice(end, TimeStamp(end.unit(), 0, 0));
+	Evaluator eval(*this);
+	simulate(machine, eval);
+
+	const float f = (eval.n_notes() == 0) ? 0.0f : score(eval);
+
+	std::lock_guard<std::mutex> lock(_fitness_mutex);
+	if (_fitness.size() >= MAX_CACHED_FITNESSES) {
+		_fitness.clear();
 	}
+	_fitness[key] = f;
 
-	eval->compute();
+	return f;
+}
 
-	// count
-#if 0
-	float f = 0;
+void
+Problem::simulate(const Machine& genome, Evaluator& eval) const
+{
+	// Run a private copy, so evaluation does not touch the genome at all
+	Machine machine(genome);
+	machine.reset(NULL, machine.time());
+
+	Forge          forge;
+	Context        context(forge, SIM_RATE, MACHINA_PPQN, 120.0);
+	const TimeUnit frames(TimeUnit::FRAMES, SIM_RATE);
+
+	context.set_sink(&eval);
+	context.time().set_slice(TimeStamp(frames, 0, 0),
+	                         TimeStamp(frames, SIM_BLOCK, 0));
+
+	for (size_t cycle = 0;
+	     cycle < SIM_MAX_CYCLES && eval.n_notes() < _target.n_notes();
+	     ++cycle) {
+		const uint32_t run_frames = machine.run(context, SPtr<Raul::RingBuffer>());
+		if (machine.is_finished()) {
+			if (run_frames == 0) {
+				break;  // Machine can not go anywhere
+			}
 
-	for (uint8_t i = 0; i < 128; ++i) {
-		/*if (eval->_note_frequency[i] <= _target._note_frequency[i])
-		  f += eval->_note_frequency[i];
-		  else
-		  f -= _target._note_frequency[i] - eval->_note_frequency[i];*/
-		//f -= fabs(eval->_note_frequency[i] - _target._note_frequency[i]);
+			// Start again from the beginning next cycle
+			machine.reset(&eval, machine.time());
+			context.time().set_slice(TimeStamp(frames, 0, 0),
+			                         TimeStamp(frames, SIM_BLOCK, 0));
+		} else {
+			context.time().set_slice(
+				context.time().start_ticks() + context.time().length_ticks(),
+				TimeStamp(frames, SIM_BLOCK, 0));
+		}
 	}
-#endif
-	//cout << ")";
 
-	// distance
-	//float f = distance(eval->_notes, _target._notes);
+	eval.compute();
+}
 
+float
+Problem::score(const Evaluator& eval) const
+{
 	float f = 0.0;
 
-	for (Evaluator::Patterns::const_iterator i = eval->_patterns.begin();
-	     i != eval->_patterns.end(); ++i) {
+	for (Evaluator::Patterns::const_iterator i = eval._patterns.begin();
+	     i != eval._patterns.end(); ++i) {
 		// Reward for matching patterns
-		if (_target._patterns.find(i->first) != _target._patterns.end()) {
-			Evaluator::Patterns::const_iterator c = _target._patterns.find(
-				i->first);
-			const uint32_t cnt
-				= (c == _target._patterns.end()) ? 1 : c->second;
-			f  += min(i->second, cnt) * (i->first.length());
+		Evaluator::Patterns::const_iterator c = _target._patterns.find(i->first);
+		if (c != _target._patterns.end()) {
+			f += min(i->second, c->second) * (i->first.length());
 
 		} else {
 			// Punish for bad patterns
-			const uint32_t invlen = (eval->_order - i->first.length() + 1);
-			f -= (i->second / (float)eval->_patterns.size()
+			const uint32_t invlen = (eval._order - i->first.length() + 1);
+			f -= (i->second / (float)eval._patterns.size()
 			      * (float)(invlen * invlen * invlen)) * 4;
 		}
 	}
@@ -157,19 +233,13 @@ Problem::evaluate(const Machine& const_machine) const
 	// Punish for missing patterns
 	for (Evaluator::Patterns::const_iterator i = _target._patterns.begin();
 	     i != _target._patterns.end(); ++i) {
-		if (eval->_patterns.find(i->first) == _target._patterns.end()) {
+		if (eval._patterns.find(i->first) == eval._patterns.end()) {
 			f -= i->second / (float)_target.n_notes()
-				* (float)(eval->_order - i->first.length() + 1);
+				* (float)(eval._order - i->first.length() + 1);
 		}
 	}
 
-	//cout << "f = " << f << endl;
-
-	_fitness[&machine] = f;
-
 	return f;
-	#endif
-	return 0.0f;
 }
 
 void
@@ -254,8 +324,13 @@ Problem::initial_population(eugene::Random& rng,
 
 		for (Machine::Nodes::iterator i = m.nodes().begin(); i != m.nodes().end();
 		     ++i) {
-			if (dynamic_ptr_cast<MidiAction>((*i)->enter_action())->event()[1] ==
-			    _target.first_note()) {
+			if ((*i)->is_initial()) {
+				continue;
+			}
+
+			SPtr<MidiAction> action = dynamic_ptr_cast<MidiAction>(
+				(*i)->enter_action());
+			if (action && action->event()[1] == _target.first_note()) {
 				m.initial_node()->add_edge(
 					SPtr<Edge>(new Edge(m.initial_node(), *i)));
 			} else {
@@ -274,7 +349,8 @@ Problem::initial_population(eugene::Random& rng,
 				head = *unreachable.begin();
 			}
 
-			if (!head->connected_to(head) ) {
+			// The initial node takes no time, so an edge to it could loop forever
+			if (!head->is_initial() && !head->connected_to(head)) {
 				cur->add_edge(SPtr<Edge>(new Edge(cur, head)));
 				unreachable.erase(head);
 				cur = head;
@@ -20,7 +20,9 @@
 #include <stdint.h>
 
 #include <map>
+#include <mutex>
 #include <stdexcept>
+#include <unordered_map>
 
 #include "machina/Machine.hpp"
 #include "eugene/Problem.hpp"
@@ -42,7 +44,18 @@ public:
 
 	bool fitness_less_than(float a, float b) const { return a < b; }
 
-	void clear_fitness_cache() { _fitness.clear(); }
+	void clear_fitness_cache() {
+		std::lock_guard<std::mutex> lock(_fitness_mutex);
+		_fitness.clear();
+	}
+
+	/** Return a hash of the structure of `machine`.
+	 *
+	 * This depends only on the nodes (duration, type, and note) and the edges
+	 * between them, not on object identity, so copies of a machine hash the
+	 * same.
+	 */
+	static uint64_t structural_hash(const Machine& machine);
 
 	void initial_population(eugene::Random& rng,
 	                        Population&     pop,
@@ -50,6 +63,14 @@ public:
 	                        size_t          pop_size) const;
 
 private:
+	struct Evaluator;
+
+	/** Run a copy of `machine` headless until it has played the target. */
+	void simulate(const Machine& machine, Evaluator& eval) const;
+
+	/** Return the fitness of the output collected by `eval`. */
+	float score(const Evaluator& eval) const;
+
 	size_t distance(const std::vector<uint8_t>& source,
 	                const std::vector<uint8_t>& target) const;
 
@@ -126,8 +147,10 @@ private:
 	/// for levenshtein distance
 	mutable std::vector< std::vector<uint16_t> > _matrix;
 
-	/// memoization
-	mutable std::map<Machine*, float> _fitness;
+	/// memoization, keyed by structural_hash()
+	typedef std::unordered_map<uint64_t, float> FitnessCache;
+	mutable std::mutex   _fitness_mutex;
+	mutable FitnessCache _fitness;
 };
 
 } // namespace machina
@@ -14,8 +14,13 @@
   along with Machina.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iostream>
 #include <list>
+#include <memory>
+#include <thread>
 
 #include <glibmm/convert.h>
 
@@ -109,17 +114,121 @@ SMFDriver::learn(const string& filename, double q, Raul::TimeStamp max_duration)
 	}
 }
 
-void
+/** Learn every track of several MIDI files into a single machine.
+ *
+ * Each track is learned into a separate machine by its own MachineBuilder,
+ * using a pool of `num_threads` threads, then the results are merged in
+ * file and track order.  The result is like learning every file into one
+ * machine, with one disjoint subgraph per track.
+ */
+SPtr<Machine>
+SMFDriver::learn(const std::vector<std::string>& filenames,
+                 double                          q,
+                 Raul::TimeDuration              max_duration,
+                 unsigned                        num_threads,
+                 LearnStats*                     stats)
+{
+	typedef std::chrono::steady_clock Clock;
+
+	const Clock::time_point start = Clock::now();
+
+	// Open every file, which maps it and indexes its tracks
+	std::vector< std::unique_ptr<SMFReader> > readers;
+	for (const auto& f : filenames) {
+		std::unique_ptr<SMFReader> reader(new SMFReader());
+		try {
+			if (reader->open(f)) {
+				readers.push_back(std::move(reader));
+				continue;
+			}
+		} catch (const std::exception& e) {
+			cerr << f << ": " << e.what() << endl;
+		}
+		cerr << "Unable to open MIDI file " << f << endl;
+	}
+
+	struct Job {
+		const SMFReader* reader;
+		unsigned         track;
+		SPtr<Machine>    machine;
+		size_t           events;
+	};
+
+	std::vector<Job> jobs;
+	for (const auto& r : readers) {
+		for (unsigned t = 1; t <= r->num_tracks(); ++t) {
+			const Job job = { r.get(), t, SPtr<Machine>(), 0 };
+			jobs.push_back(job);
+		}
+	}
+
+	// Learn tracks in parallel, each into its own machine
+	std::atomic<size_t> next(0);
+	auto work = [&]() {
+		for (size_t i = next++; i < jobs.size(); i = next++) {
+			Job&                 job = jobs[i];
+			SPtr<Machine>        m(new Machine(max_duration.unit()));
+			SPtr<MachineBuilder> builder(new MachineBuilder(m, q, false));
+			try {
+				job.events = learn_track(
+					builder, *job.reader, job.track, q, max_duration);
+				m->reset(NULL, m->time());
+				job.machine = m;
+			} catch (const std::exception& e) {
+				cerr << "Failed to learn track " << job.track << ": "
+				     << e.what() << endl;
+			}
+		}
+	};
+
+	const size_t n_threads = std::min(std::max(num_threads, 1u),
+	                                  (unsigned)std::max(jobs.size(),
+	                                                     size_t(1)));
+	std::vector<std::thread> threads;
+	for (size_t i = 1; i < n_threads; ++i) {
+		threads.push_back(std::thread(work));
+	}
+	work();
+	for (auto& t : threads) {
+		t.join();
+	}
+
+	// Merge results in order, so output does not depend on scheduling
+	SPtr<Machine> m(new Machine(max_duration.unit()));
+	size_t        n_tracks = 0;
+	size_t        n_events = 0;
+	for (const auto& job : jobs) {
+		if (job.machine && job.machine->nodes().size() > 1) {
+			m->merge(*job.machine.get());
+			++n_tracks;
+			n_events += job.events;
+		}
+	}
+
+	if (stats) {
+		stats->files   = readers.size();
+		stats->tracks  = n_tracks;
+		stats->events  = n_events;
+		stats->seconds = std::chrono::duration<double>(
+			Clock::now() - start).count();
+	}
+
+	if (m->nodes().size() > 1) {
+		return m;
+	} else {
+		return SPtr<Machine>();
+	}
+}
+
+/** Learn a single track, returning the number of events learned. */
+size_t
 SMFDriver::learn_track(SPtr<MachineBuilder> builder,
-                       SMFReader&           reader,
+                       const SMFReader&     reader,
                        unsigned             track,
                        double               q,
                        Raul::TimeDuration   max_duration)
 {
-	const bool found_track = reader.seek_to_track(track);
-	if (!found_track) {
-		return;
-	}
+	SMFReader::TrackReader events = reader.track(track);
 
 	uint8_t  buf[4];
 	uint32_t ev_size;
@@ -127,8 +236,9 @@ SMFDriver::learn_track(SPtr<MachineBuilder> builder,
 
 	Raul::TimeUnit unit = Raul::TimeUnit(TimeUnit::BEATS, MACHINA_PPQN);
 
-	uint64_t t = 0;
-	while (reader.read_event(4, buf, &ev_size, &ev_delta_time) >= 0) {
+	uint64_t t        = 0;
+	size_t   n_events = 0;
+	while (events.read_event(4, buf, &ev_size, &ev_delta_time) >= 0) {
 		t += ev_delta_time;
 
 		const uint32_t beats     = t / (uint32_t)reader.ppqn();
@@ -143,10 +253,12 @@ SMFDriver::learn_track(SPtr<MachineBuilder> builder,
 		if (ev_size > 0) {
 			// TODO: quantize
 			builder->event(TimeStamp(unit, beats, ticks), ev_size, buf);
+			++n_events;
 		}
 	}
 
 	builder->resolve();
+	return n_events;
 }
 
 void
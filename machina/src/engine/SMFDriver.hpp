@@ -17,6 +17,9 @@
 #ifndef MACHINA_SMFDRIVER_HPP
 #define MACHINA_SMFDRIVER_HPP
 
+#include <string>
+#include <vector>
+
 #include <glibmm/ustring.h>
 
 #include "machina/Driver.hpp"
@@ -45,6 +48,20 @@ public:
 	                    double             q,
 	                    Raul::TimeDuration max_duration);
 
+	/** Statistics about a call to learn() for several files. */
+	struct LearnStats {
+		size_t files;    ///< Number of files successfully opened
+		size_t tracks;   ///< Number of tracks learned
+		size_t events;   ///< Number of MIDI events learned
+		double seconds;  ///< Wall clock time taken
+	};
+
+	SPtr<Machine> learn(const std::vector<std::string>& filenames,
+	                    double                          q,
+	                    Raul::TimeDuration              max_duration,
+	                    unsigned                        num_threads,
+	                    LearnStats*                     stats = NULL);
+
 	void run(SPtr<Machine> machine, Raul::TimeStamp max_time);
 
 	void write_event(Raul::TimeStamp      time,
@@ -57,11 +74,11 @@ public:
 private:
 	SPtr<SMFWriter> _writer;
 
-	void learn_track(SPtr<MachineBuilder> builder,
-	                 SMFReader&           reader,
-	                 unsigned             track,
-	                 double               q,
-	                 Raul::TimeDuration   max_duration);
+	size_t learn_track(SPtr<MachineBuilder> builder,
+	                   const SMFReader&     reader,
+	                   unsigned             track,
+	                   double               q,
+	                   Raul::TimeDuration   max_duration);
 };
 
 } // namespace machina
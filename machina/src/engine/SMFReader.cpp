@@ -14,13 +14,17 @@
   along with Raul.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <cassert>
 #include <cstdio>
 #include <cstring>
+#include <iostream>
 #include <string>
 
-#include <glib.h>
-
 #include "lv2/lv2plug.in/ns/ext/midi/midi.h"
 
 #include "SMFReader.hpp"
@@ -35,7 +39,7 @@ namespace machina {
 static int
 midi_event_size(unsigned char status)
 {
-	if (status >= 0x80 && status <= 0xE0) {
+	if (status >= 0x80 && status < 0xF0) {
 		status &= 0xF0; // mask off the channel
 	}
 
@@ -70,11 +74,25 @@ midi_event_size(unsigned char status)
 	return -1;
 }
 
+static inline uint16_t
+read_u16_be(const uint8_t* p)
+{
+	return (p[0] << 8) | p[1];
+}
+
+static inline uint32_t
+read_u32_be(const uint8_t* p)
+{
+	return ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
 SMFReader::SMFReader(const std::string filename)
-	: _fd(NULL)
+	: _data(NULL)
+	, _size(0)
+	, _type(0)
 	, _ppqn(0)
+	, _num_tracks(0)
 	, _track(0)
-	, _track_size(0)
 {
 	if (filename.length() > 0) {
 		open(filename);
@@ -83,7 +101,7 @@ SMFReader::SMFReader(const std::string filename)
 
 SMFReader::~SMFReader()
 {
-	if (_fd) {
+	if (_data) {
 		close();
 	}
 }
@@ -92,55 +110,75 @@ bool
 SMFReader::open(const std::string& filename)
 		throw (std::logic_error, UnsupportedTime)
 {
-	if (_fd) {
+	if (_data) {
 		throw std::logic_error(
 			"Attempt to start new read while write in progress.");
 	}
 
 	std::cout << "Opening SMF file " << filename << " for reading." << endl;
 
-	_fd = fopen(filename.c_str(), "r+");
-
-	if (_fd) {
-		// Read type (bytes 8..9)
-		fseek(_fd, 0, SEEK_SET);
-		char mthd[5];
-		mthd[4] = '\0';
-		fread(mthd, 1, 4, _fd);
-		if (strcmp(mthd, "MThd")) {
-			std::cerr << filename << " is not an SMF file, aborting." << endl;
-			fclose(_fd);
-			_fd = NULL;
-			return false;
-		}
+	const int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
 
-		// Read type (bytes 8..9)
-		fseek(_fd, 8, SEEK_SET);
-		uint16_t type_be = 0;
-		fread(&type_be, 2, 1, _fd);
-		_type = GUINT16_FROM_BE(type_be);
-
-		// Read number of tracks (bytes 10..11)
-		uint16_t num_tracks_be = 0;
-		fread(&num_tracks_be, 2, 1, _fd);
-		_num_tracks = GUINT16_FROM_BE(num_tracks_be);
-
-		// Read PPQN (bytes 12..13)
-		uint16_t ppqn_be = 0;
-		fread(&ppqn_be, 2, 1, _fd);
-		_ppqn = GUINT16_FROM_BE(ppqn_be);
-
-		// TODO: Absolute (SMPTE seconds) time support
-		if ((_ppqn & 0x8000) != 0) {
-			throw UnsupportedTime();
-		}
+	struct stat st;
+	if (fstat(fd, &st) || st.st_size < 14) {
+		std::cerr << filename << " is not an SMF file, aborting." << endl;
+		::close(fd);
+		return false;
+	}
 
-		seek_to_track(1);
+	void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);  // Mapping stays valid
+	if (data == MAP_FAILED) {
+		return false;
+	}
 
-		return true;
-	} else {
+	_data = static_cast<const uint8_t*>(data);
+	_size = st.st_size;
+	madvise(data, _size, MADV_SEQUENTIAL);
+
+	if (memcmp(_data, "MThd", 4)) {
+		std::cerr << filename << " is not an SMF file, aborting." << endl;
+		close();
 		return false;
 	}
+
+	const uint32_t header_size = read_u32_be(_data + 4);
+	_type       = read_u16_be(_data + 8);
+	_num_tracks = read_u16_be(_data + 10);
+	_ppqn       = read_u16_be(_data + 12);
+
+	// TODO: Absolute (SMPTE seconds) time support
+	if ((_ppqn & 0x8000) != 0) {
+		close();
+		throw UnsupportedTime();
+	}
+
+	// Index every track chunk, so tracks can be read in any order
+	const uint8_t* const end = _data + _size;
+	for (const uint8_t* p = _data + 8 + header_size; p + 8 <= end;) {
+		const uint32_t chunk_size = read_u32_be(p + 4);
+		const uint8_t* chunk      = p + 8;
+		const uint8_t* chunk_end  = ((size_t)(end - chunk) < chunk_size)
+			? end : chunk + chunk_size;
+
+		if (!memcmp(p, "MTrk", 4)) {
+			const Chunk track = { chunk, chunk_end };
+			_tracks.push_back(track);
+		} else {
+			std::cerr << "Unknown chunk ID " << std::string((const char*)p, 4)
+			          << endl;
+		}
+
+		p = chunk_end;
+	}
+
+	_filename = filename;
+	seek_to_track(1);
+
+	return true;
 }
 
 /** Seek to the start of a given track, starting from 1.
@@ -153,49 +191,57 @@ SMFReader::seek_to_track(unsigned track) throw (std::logic_error)
 		throw std::logic_error("Seek to track 0 out of range (must be >= 1)");
 	}
 
-	if (!_fd) {
+	if (!_data) {
 		throw std::logic_error("Attempt to seek to track on unopened SMF file.");
 	}
 
-	unsigned track_pos = 0;
+	if (track > _tracks.size()) {
+		return false;
+	}
 
-	fseek(_fd, 14, SEEK_SET);
-	char id[5];
-	id[4] = '\0';
-	uint32_t chunk_size = 0;
+	_track   = track;
+	_current = SMFReader::track(track);
+	return true;
+}
 
-	while (!feof(_fd)) {
-		fread(id, 1, 4, _fd);
+SMFReader::TrackReader
+SMFReader::track(unsigned track) const throw (std::logic_error)
+{
+	if (track == 0) {
+		throw std::logic_error("Track 0 out of range (must be >= 1)");
+	}
 
-		if (!strcmp(id, "MTrk")) {
-			++track_pos;
-		} else {
-			std::cerr << "Unknown chunk ID " << id << endl;
-		}
+	if (!_data) {
+		throw std::logic_error("Attempt to read track of unopened SMF file.");
+	}
 
-		uint32_t chunk_size_be;
-		fread(&chunk_size_be, 4, 1, _fd);
-		chunk_size = GUINT32_FROM_BE(chunk_size_be);
+	if (track > _tracks.size()) {
+		return TrackReader();
+	}
 
-		if (track_pos == track) {
-			break;
-		}
+	return TrackReader(_tracks[track - 1].begin, _tracks[track - 1].end);
+}
 
-		fseek(_fd, chunk_size, SEEK_CUR);
+/** Read an event from the current track.
+ *
+ * See TrackReader::read_event().
+ */
+int
+SMFReader::read_event(size_t    buf_len,
+                      uint8_t*  buf,
+                      uint32_t* ev_size,
+                      uint32_t* delta_time)
+		throw (std::logic_error, PrematureEOF, CorruptFile)
+{
+	if (_track == 0) {
+		throw std::logic_error("Attempt to read from unopened SMF file");
 	}
 
-	if (!feof(_fd) && track_pos == track) {
-		_track      = track;
-		_track_size = chunk_size;
-		return true;
-	} else {
-		return false;
-	}
+	return _current.read_event(buf_len, buf, ev_size, delta_time);
 }
 
-/** Read an event from the current position in file.
+/** Read the next event in the track.
  *
- * File position MUST be at the beginning of a delta time, or this will die very messily.
  * ev.buffer must be of size ev.size, and large enough for the event.  The returned event
  * will have it's time field set to it's delta time (so it's the caller's responsibility
  * to keep track of delta time, even for ignored events).
@@ -207,17 +253,13 @@ SMFReader::seek_to_track(unsigned track) throw (std::logic_error)
  * set to the actual size of the event.
  */
 int
-SMFReader::read_event(size_t    buf_len,
-                      uint8_t*  buf,
-                      uint32_t* ev_size,
-                      uint32_t* delta_time)
-		throw (std::logic_error, PrematureEOF, CorruptFile)
+SMFReader::TrackReader::read_event(size_t    buf_len,
+                                   uint8_t*  buf,
+                                   uint32_t* ev_size,
+                                   uint32_t* delta_time)
+		throw (PrematureEOF, CorruptFile)
 {
-	if (_track == 0) {
-		throw std::logic_error("Attempt to read from unopened SMF file");
-	}
-
-	if (!_fd || feof(_fd)) {
+	if (_pos >= _end) {
 		return -1;
 	}
 
@@ -226,98 +268,111 @@ SMFReader::read_event(size_t    buf_len,
 	assert(ev_size);
 	assert(delta_time);
 
-	// Running status state
-	static uint8_t  last_status = 0;
-	static uint32_t last_size   = 0;
-
-	*delta_time = read_var_len(_fd);
-	int status = fgetc(_fd);
-	if (status == EOF) {
+	*delta_time = read_var_len();
+	if (_pos >= _end) {
 		throw PrematureEOF();
-	} else if (status > 0xFF) {
-		throw CorruptFile();
 	}
 
+	uint8_t status = *_pos;
 	if (status < 0x80) {
-		if (last_status == 0) {
+		// Running status, data starts here
+		if (_last_status == 0) {
 			throw CorruptFile();
 		}
-		status   = last_status;
-		*ev_size = last_size;
-		fseek(_fd, -1, SEEK_CUR);
+		status   = _last_status;
+		*ev_size = _last_size;
 	} else {
-		last_status = status;
-		*ev_size    = midi_event_size(status) + 1;
-		last_size   = *ev_size;
-	}
-
-	buf[0] = static_cast<uint8_t>(status);
+		++_pos;
+		if (status == 0xFF) {
+			// Meta event
+			*ev_size = 0;
+			if (_pos >= _end) {
+				throw PrematureEOF();
+			}
+			const uint8_t  type = *_pos++;
+			const uint32_t size = read_var_len();
+			if (type == 0x2F) {
+				return -1; // we hit the logical EOF anyway...
+			} else if ((size_t)(_end - _pos) < size) {
+				throw PrematureEOF();
+			}
+			_pos += size;
+			return 0;
+		} else if (status == 0xF0 || status == 0xF7) {
+			// Sysex, skip
+			*ev_size = 0;
+			const uint32_t size = read_var_len();
+			if ((size_t)(_end - _pos) < size) {
+				throw PrematureEOF();
+			}
+			_pos += size;
+			return 0;
+		}
 
-	if (status == 0xFF) {
-		*ev_size = 0;
-		if (feof(_fd)) {
-			throw PrematureEOF();
+		const int size = midi_event_size(status);
+		if (size < 0) {
+			throw CorruptFile();
 		}
-		uint8_t        type = fgetc(_fd);
-		const uint32_t size = read_var_len(_fd);
 
-		if (type == 0x2F) {
-			return -1; // we hit the logical EOF anyway...
-		} else {
-			fseek(_fd, size, SEEK_CUR);
-			return 0;
+		*ev_size = size + 1;
+		if (status < 0xF0) {
+			// Only channel messages set running status
+			_last_status = status;
+			_last_size   = *ev_size;
 		}
 	}
 
-	if ((*ev_size > buf_len) || (*ev_size == 0) || feof(_fd)) {
+	if ((size_t)(_end - _pos) < *ev_size - 1) {
+		throw PrematureEOF();
+	}
+
+	buf[0] = status;
+
+	if (*ev_size > buf_len) {
 		// Skip event, return 0
-		fseek(_fd, *ev_size - 1, SEEK_CUR);
+		_pos += *ev_size - 1;
 		return 0;
-	} else {
-		// Read event, return size
-		if (ferror(_fd)) {
-			throw CorruptFile();
-		}
+	}
 
-		fread(buf + 1, 1, *ev_size - 1, _fd);
+	// Read event, return size
+	memcpy(buf + 1, _pos, *ev_size - 1);
+	_pos += *ev_size - 1;
 
-		if (((buf[0] & 0xF0) == 0x90) && (buf[2] == 0) ) {
-			buf[0] = (0x80 | (buf[0] & 0x0F));
-			buf[2] = 0x40;
-		}
-
-		return *ev_size;
+	if (((buf[0] & 0xF0) == 0x90) && (buf[2] == 0) ) {
+		buf[0] = (0x80 | (buf[0] & 0x0F));
+		buf[2] = 0x40;
 	}
+
+	return *ev_size;
 }
 
 void
 SMFReader::close()
 {
-	if (_fd) {
-		fclose(_fd);
+	if (_data) {
+		munmap(const_cast<uint8_t*>(_data), _size);
 	}
 
-	_fd = NULL;
+	_data       = NULL;
+	_size       = 0;
+	_track      = 0;
+	_current    = TrackReader();
+	_tracks.clear();
 }
 
 uint32_t
-SMFReader::read_var_len(FILE* fd) throw (PrematureEOF)
+SMFReader::TrackReader::read_var_len() throw (PrematureEOF)
 {
-	if (feof(fd)) {
-		throw PrematureEOF();
-	}
-
-	uint32_t value;
-	uint8_t  c;
-
-	if ((value = getc(fd)) & 0x80) {
-		value &= 0x7F;
-		do {
-			if (feof(fd)) {
-				throw PrematureEOF();
-			}
-			value = (value << 7) + ((c = getc(fd)) & 0x7F);
-		} while (c & 0x80);
+	uint32_t value = 0;
+	for (unsigned i = 0; i < 4; ++i) {
+		if (_pos >= _end) {
+			throw PrematureEOF();
+		}
+		const uint8_t c = *_pos++;
+		value = (value << 7) | (c & 0x7F);
+		if (!(c & 0x80)) {
+			break;
+		}
 	}
 
 	return value;
@@ -19,6 +19,7 @@
 
 #include <stdexcept>
 #include <string>
+#include <vector>
 #include <inttypes.h>
 #include "raul/TimeStamp.hpp"
 
@@ -26,7 +27,9 @@ namespace machina {
 
 /** Standard Midi File (Type 0) Reader
  *
- * Currently this only reads SMF files with tempo-based timing.
+ * The file is memory mapped and the offset of every track is found when it
+ * is opened, so tracks can be read independently.  Currently this only reads
+ * SMF files with tempo-based timing.
  * \ingroup raul
  */
 class SMFReader
@@ -49,6 +52,36 @@ public:
 			                                   "Unsupported time stamp type (SMPTE)"; }
 	};
 
+	/** Reads the events of a single track.
+	 *
+	 * A TrackReader only refers to the (read-only) mapped file and keeps its
+	 * own running status, so several may be used at once, from any thread,
+	 * as long as the SMFReader stays open.
+	 */
+	class TrackReader
+	{
+	public:
+		TrackReader() : _pos(NULL), _end(NULL), _last_status(0), _last_size(0) {}
+
+		TrackReader(const uint8_t* begin, const uint8_t* end)
+			: _pos(begin), _end(end), _last_status(0), _last_size(0)
+		{}
+
+		int read_event(size_t    buf_len,
+		               uint8_t*  buf,
+		               uint32_t* ev_size,
+		               uint32_t* ev_delta_time)
+		throw (PrematureEOF, CorruptFile);
+
+	private:
+		uint32_t read_var_len() throw (PrematureEOF);
+
+		const uint8_t* _pos;
+		const uint8_t* _end;
+		uint8_t        _last_status;
+		uint32_t       _last_size;
+	};
+
 	explicit SMFReader(const std::string filename = "");
 	~SMFReader();
 
@@ -57,9 +90,12 @@ public:
 
 	bool seek_to_track(unsigned track) throw (std::logic_error);
 
+	/** Return a reader for the given track, starting from 1. */
+	TrackReader track(unsigned track) const throw (std::logic_error);
+
 	uint16_t type() const { return _type; }
 	uint16_t ppqn() const { return _ppqn; }
-	size_t   num_tracks() { return _num_tracks; }
+	size_t   num_tracks() const { return _num_tracks; }
 
 	int read_event(size_t    buf_len,
 	               uint8_t*  buf,
@@ -69,19 +105,22 @@ public:
 
 	void close();
 
-	static uint32_t read_var_len(FILE* fd) throw (PrematureEOF);
-
 protected:
-	/** size of SMF header, including MTrk chunk header */
-	static const uint32_t HEADER_SIZE = 22;
-
-	std::string _filename;
-	FILE*       _fd;
-	uint16_t    _type;
-	uint16_t    _ppqn;
-	uint16_t    _num_tracks;
-	uint32_t    _track;
-	uint32_t    _track_size;
+	/** A track chunk, not including the chunk header. */
+	struct Chunk {
+		const uint8_t* begin;
+		const uint8_t* end;
+	};
+
+	std::string        _filename;
+	const uint8_t*     _data;
+	size_t             _size;
+	uint16_t           _type;
+	uint16_t           _ppqn;
+	uint16_t           _num_tracks;
+	std::vector<Chunk> _tracks;
+	uint32_t           _track;
+	TrackReader        _current;
 };
 
 } // namespace machina
@@ -18,7 +18,7 @@
 
 namespace machina {
 
-uint64_t Stateful::_next_id = 1;
+std::atomic<uint64_t> Stateful::_next_id(1);
 
 Stateful::Stateful()
 	: _id(next_id())
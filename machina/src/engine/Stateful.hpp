@@ -19,6 +19,8 @@
 
 #include <stdint.h>
 
+#include <atomic>
+
 #include "sord/sordmm.hpp"
 
 #include "machina/Atom.hpp"
@@ -51,20 +53,12 @@ protected:
 	explicit Stateful(uint64_t id) : _id(id) {}
 
 private:
-	static uint64_t _next_id;
+	static std::atomic<uint64_t> _next_id;
 
 	uint64_t           _id;
 	mutable Sord::Node _rdf_id;
 };
 
-class StatefulKey : public Stateful
-{
-public:
-	explicit StatefulKey(uint64_t id) : Stateful(id) {}
-
-	void write_state(Sord::Model& model) {}
-};
-
 } // namespace machina
 
 #endif // MACHINA_STATEFUL_HPP
@@ -23,11 +23,15 @@
 namespace machina {
 
 void
-write_set(SPtr<Raul::RingBuffer> buf,
-          uint64_t               subject,
-          URIInt                 key,
-          const Atom&            value)
+write_set(const SPtr<Raul::RingBuffer>& buf,
+          uint64_t                      subject,
+          URIInt                        key,
+          const Atom&                   value)
 {
+	if (!buf) {
+		return;  // Running headless, nobody to notify
+	}
+
 	const uint32_t update_type = UPDATE_SET;
 	buf->write(sizeof(update_type), &update_type);
 	buf->write(sizeof(subject), &subject);
@@ -39,10 +43,10 @@ write_set(SPtr<Raul::RingBuffer> buf,
 }
 
 uint32_t
-read_set(SPtr<Raul::RingBuffer> buf,
-         uint64_t*              subject,
-         URIInt*                key,
-         Atom*                  value)
+read_set(const SPtr<Raul::RingBuffer>& buf,
+         uint64_t*                     subject,
+         URIInt*                       key,
+         Atom*                         value)
 {
 	uint32_t update_type = 0;
 	buf->read(sizeof(update_type), &update_type);
@@ -55,8 +59,7 @@ read_set(SPtr<Raul::RingBuffer> buf,
 
 	LV2_Atom atom = { 0, 0 };
 	buf->read(sizeof(LV2_Atom), &atom);
-	*value = Atom(atom.size, atom.type, NULL);
-	buf->read(atom.size, value->get_body());
+	buf->read(atom.size, value->reset(atom.size, atom.type));
 
 	return sizeof(update_type) + sizeof(*subject) + sizeof(*key)
 	       + sizeof(LV2_Atom) + atom.size;
@@ -0,0 +1,165 @@
+/*
+  This file is part of Machina.
+  Copyright 2007-2013 David Robillard <http://drobilla.net>
+
+  Machina is free software: you can redistribute it and/or modify it under the
+  terms of the GNU General Public License as published by the Free Software
+  Foundation, either version 3 of the License, or any later version.
+
+  Machina is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Machina.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "machina/Context.hpp"
+#include "machina/Evolver.hpp"
+#include "machina/Machine.hpp"
+#include "machina/URIs.hpp"
+
+#include "Edge.hpp"
+#include "MIDISink.hpp"
+#include "MidiAction.hpp"
+#include "Problem.hpp"
+#include "machina_config.h"
+
+using namespace std;
+using namespace machina;
+using namespace Raul;
+
+#define CHECK(cond) \
+	do { if (!(cond)) { \
+			cerr << "Test at " << __FILE__ << ":" << __LINE__ \
+			     << " failed: " << __STRING(cond) << endl; \
+			return 1; \
+		} \
+	} \
+	while (0)
+
+/** Sink which records every event written to it. */
+struct Recorder : public MIDISink {
+	void write_event(TimeStamp time, size_t ev_size, const uint8_t* ev) {
+		events.push_back(time.ticks());
+		events.insert(events.end(), ev, ev + ev_size);
+	}
+
+	vector<uint32_t> events;
+};
+
+static const uint8_t notes[] = { 60, 62, 64, 62 };
+static const size_t  n_notes = sizeof(notes) / sizeof(uint8_t);
+
+/** Build a machine which plays `notes` in a loop. */
+static SPtr<Machine>
+build_machine(TimeUnit unit)
+{
+	SPtr<Machine> machine(new Machine(unit));
+	SPtr<Node>    prev = machine->initial_node();
+	SPtr<Node>    first;
+	for (size_t i = 0; i < n_notes; ++i) {
+		const uint8_t on[]  = { 0x90, notes[i], 100 };
+		const uint8_t off[] = { 0x80, notes[i], 0 };
+
+		SPtr<Node> node(new Node(TimeDuration(unit, 1 / 4.0)));
+		node->set_enter_action(SPtr<Action>(new MidiAction(3, on)));
+		node->set_exit_action(SPtr<Action>(new MidiAction(3, off)));
+		machine->add_node(node);
+		prev->add_edge(SPtr<Edge>(new Edge(prev, node)));
+		prev  = node;
+		first = first ? first : node;
+	}
+	prev->add_edge(SPtr<Edge>(new Edge(prev, first)));
+	return machine;
+}
+
+/** Run `machine` headless for a few cycles and record its output. */
+static vector<uint32_t>
+play(Machine& machine)
+{
+	Forge          forge;
+	Recorder       sink;
+	Context        context(forge, 48000, MACHINA_PPQN, 120.0);
+	const TimeUnit frames(TimeUnit::FRAMES, 48000);
+
+	context.set_sink(&sink);
+	context.time().set_slice(TimeStamp(frames, 0, 0),
+	                         TimeStamp(frames, 4096, 0));
+
+	machine.reset(NULL, machine.time());
+	for (unsigned cycle = 0; cycle < 64; ++cycle) {
+		machine.run(context, SPtr<RingBuffer>());
+		context.time().set_slice(
+			context.time().start_ticks() + context.time().length_ticks(),
+			TimeStamp(frames, 4096, 0));
+	}
+
+	return sink.events;
+}
+
+int
+main()
+{
+	URIs::init();
+
+	const TimeUnit beats(TimeUnit::BEATS, MACHINA_PPQN);
+
+	// A copy of a machine plays exactly the same events
+	SPtr<Machine>          original = build_machine(beats);
+	Machine                copy(*original.get());
+	const vector<uint32_t> expected = play(*original.get());
+	CHECK(!expected.empty());
+	CHECK(play(copy) == expected);
+
+	// So does a machine assigned from it
+	Machine assigned(beats);
+	assigned = *original.get();
+	CHECK(play(assigned) == expected);
+
+	// Write a target file which repeats the notes (timing is ignored)
+	vector<uint8_t> track;
+	for (unsigned i = 0; i < 8 * n_notes; ++i) {
+		const uint8_t ev[] = { 0, 0x90, notes[i % n_notes], 100,
+		                       0, 0x80, notes[i % n_notes], 0 };
+		track.insert(track.end(), ev, ev + sizeof(ev));
+	}
+	const uint8_t eot[] = { 0, 0xFF, 0x2F, 0 };
+	track.insert(track.end(), eot, eot + sizeof(eot));
+
+	const uint8_t header[] = {
+		'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 0, 0, 1,
+		MACHINA_PPQN >> 8, MACHINA_PPQN & 0xFF,
+		'M', 'T', 'r', 'k', 0, 0,
+		(uint8_t)(track.size() >> 8), (uint8_t)(track.size() & 0xFF) };
+
+	const string filename = "./evolver_test.mid";
+	FILE*        fd       = fopen(filename.c_str(), "wb");
+	CHECK(fd);
+	fwrite(header, 1, sizeof(header), fd);
+	fwrite(&track[0], 1, track.size(), fd);
+	fclose(fd);
+
+	// Evaluation plays a copy of the machine, which matches the target, and a
+	// silent machine scores 0
+	Problem       problem(beats, filename, original);
+	const float   fitness = problem.evaluate(*original.get());
+	const Machine silent(beats);
+	CHECK(problem.evaluate(silent) == 0.0f);
+
+	// Constructing an evolver builds and evaluates the initial population
+	Evolver evolver(beats, filename, original);
+	evolver.iteration();
+	const float best = evolver.best_fitness();
+
+	remove(filename.c_str());
+	CHECK(fitness > 0.0f);
+	CHECK(best >= 0.0f);  // At least as good as a silent machine
+
+	return 0;
+}
@@ -76,18 +76,27 @@ public:
 		if (&other == this) {
 			return *this;
 		}
-		dealloc();
-		_size = other._size;
-		_type = other._type;
-		if (is_reference()) {
-			_val._blob = malloc(_size);
-			memcpy(_val._blob, other._val._blob, _size);
-		} else {
-			memcpy(&_val, &other._val, _size);
-		}
+		memcpy(reset(other._size, other._type), other.get_body(), other._size);
 		return *this;
 	}
 
+	/** Set the size and type of this atom and return its uninitialised body.
+	 *
+	 * Memory is reused if the size has not changed, so repeatedly writing
+	 * values of the same size into an Atom does not allocate.
+	 */
+	void* reset(uint32_t size, TypeID type) {
+		if (!(is_reference() && size == _size)) {
+			dealloc();
+			_size = size;
+			if (is_reference()) {
+				_val._blob = malloc(_size);
+			}
+		}
+		_type = type;
+		return get_body();
+	}
+
 	inline bool operator==(const Atom& other) const {
 		if (_type == other.type() && _size == other.size()) {
 			if (is_reference()) {
@@ -19,11 +19,10 @@
 
 #include <stdint.h>
 
-#include <set>
-
 #include "raul/RingBuffer.hpp"
 #include "raul/Maid.hpp"
 
+#include "machina/IdMap.hpp"
 #include "machina/Model.hpp"
 #include "machina/URIs.hpp"
 #include "machina/types.hpp"
@@ -58,16 +57,9 @@ public:
 	void process_updates();
 
 private:
-	SPtr<Stateful> find(uint64_t id);
-
-	struct StatefulComparator {
-		inline bool operator()(SPtr<Stateful> a, SPtr<Stateful> b) const {
-			return a->id() < b->id();
-		}
-	};
+	SPtr<Stateful> find(uint64_t id) { return _objects.find(id); }
 
-	typedef std::set<SPtr<Stateful>, StatefulComparator> Objects;
-	Objects _objects;
+	IdMap<Stateful> _objects;
 
 	SPtr<Engine> _engine;
 	Model&       _model;
@@ -54,6 +54,9 @@ public:
 		_machine = machine;
 	}
 
+	/** Called after the structure of machine() has been edited. */
+	virtual void machine_changed() {}
+
 	SPtr<Raul::RingBuffer> update_sink() { return _updates; }
 
 	void set_update_sink(SPtr<Raul::RingBuffer> b) {
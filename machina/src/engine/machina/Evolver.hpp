@@ -17,10 +17,12 @@
 #ifndef MACHINA_EVOLVER_HPP
 #define MACHINA_EVOLVER_HPP
 
+#include <atomic>
+#include <thread>
+
 #include "eugene/GA.hpp"
 #include "eugene/Random.hpp"
 #include "machina/types.hpp"
-#include "raul/Thread.hpp"
 #include "raul/TimeStamp.hpp"
 
 #include "Machine.hpp"
@@ -34,17 +36,29 @@ namespace machina {
 
 class Problem;
 
-class Evolver : public Raul::Thread
+class Evolver
 {
 public:
 	Evolver(Raul::TimeUnit     unit,
 	        const std::string& target_midi,
 	        SPtr<Machine>      seed);
 
+	~Evolver() { join(); }
+
+	/** Start evolving in a background thread. */
+	void start();
+
+	/** Stop evolving after the current generation and wait for the thread. */
+	void join();
+
+	/** Evolve a single generation in the calling thread. */
+	void iteration() { _ga->iteration(); }
+
 	void seed(SPtr<Machine> parent);
 	bool improvement() { return _improvement; }
 
 	const Machine& best() { return _ga->best(); }
+	float          best_fitness() const { return _ga->best_fitness(); }
 
 	typedef eugene::GA<Machine> MachinaGA;
 
@@ -56,6 +70,9 @@ private:
 	SPtr<Problem>   _problem;
 	float           _seed_fitness;
 	Schrodinbit     _improvement;
+
+	std::atomic<bool> _exit_flag;
+	std::thread       _thread;
 };
 
 } // namespace machina
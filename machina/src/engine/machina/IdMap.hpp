@@ -0,0 +1,155 @@
+/*
+  This file is part of Machina.
+  Copyright 2007-2013 David Robillard <http://drobilla.net>
+
+  Machina is free software: you can redistribute it and/or modify it under the
+  terms of the GNU General Public License as published by the Free Software
+  Foundation, either version 3 of the License, or any later version.
+
+  Machina is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Machina.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MACHINA_IDMAP_HPP
+#define MACHINA_IDMAP_HPP
+
+#include <stdint.h>
+
+#include <cassert>
+#include <utility>
+#include <vector>
+
+#include "machina/types.hpp"
+
+namespace machina {
+
+/** A hash table of objects keyed by their id().
+ *
+ * Objects are held by shared pointer, so handles returned by find() remain
+ * valid when the table grows or other objects are erased.  Lookup does not
+ * allocate.  The table uses open addressing with linear probing and ID 0 to
+ * mark empty slots, so 0 is not a valid ID (Stateful IDs start at 1).
+ */
+template<typename T>
+class IdMap
+{
+public:
+	IdMap() : _size(0) {}
+
+	size_t size()  const { return _size; }
+	bool   empty() const { return _size == 0; }
+
+	/** Return the object with the given ID, or null. */
+	SPtr<T> find(uint64_t id) const {
+		if (_slots.empty() || !id) {
+			return SPtr<T>();
+		}
+
+		const Slot& slot = _slots[probe(id)];
+		return slot.id ? slot.value : SPtr<T>();
+	}
+
+	/** Insert `object`, returning false if its ID is already present. */
+	bool insert(const SPtr<T>& object) {
+		const uint64_t id = object->id();
+		assert(id);
+
+		if ((_size + 1) * 2 > _slots.size()) {
+			rehash(_slots.empty() ? 16 : _slots.size() * 2);
+		}
+
+		Slot& slot = _slots[probe(id)];
+		if (slot.id) {
+			return false;
+		}
+
+		slot.id    = id;
+		slot.value = object;
+		++_size;
+		return true;
+	}
+
+	/** Remove the object with the given ID and return it, or null. */
+	SPtr<T> erase(uint64_t id) {
+		if (_slots.empty() || !id) {
+			return SPtr<T>();
+		}
+
+		const size_t mask = _slots.size() - 1;
+		size_t       i    = probe(id);
+		if (!_slots[i].id) {
+			return SPtr<T>();
+		}
+
+		SPtr<T> object = std::move(_slots[i].value);
+
+		// Shift following entries back so probe sequences stay unbroken
+		for (size_t j = (i + 1) & mask; _slots[j].id; j = (j + 1) & mask) {
+			const size_t home = hash(_slots[j].id) & mask;
+			const bool   stay = (i <= j) ? (i < home && home <= j)
+			                             : (i < home || home <= j);
+			if (!stay) {
+				_slots[i] = std::move(_slots[j]);
+				i         = j;
+			}
+		}
+
+		_slots[i].id = 0;
+		_slots[i].value.reset();
+		--_size;
+		return object;
+	}
+
+	void clear() {
+		_slots.clear();
+		_size = 0;
+	}
+
+private:
+	struct Slot {
+		Slot() : id(0) {}
+
+		uint64_t id;
+		SPtr<T>  value;
+	};
+
+	static inline size_t hash(uint64_t id) {
+		id ^= id >> 33;
+		id *= 0xFF51AFD7ED558CCDULL;
+		id ^= id >> 33;
+		return id;
+	}
+
+	/** Return the slot for `id`, which is either its slot or empty. */
+	size_t probe(uint64_t id) const {
+		const size_t mask = _slots.size() - 1;
+		size_t       i    = hash(id) & mask;
+		while (_slots[i].id && _slots[i].id != id) {
+			i = (i + 1) & mask;
+		}
+		return i;
+	}
+
+	void rehash(size_t capacity) {
+		std::vector<Slot> old(capacity);
+		old.swap(_slots);
+		for (auto& s : old) {
+			if (s.id) {
+				Slot& slot = _slots[probe(s.id)];
+				slot.id    = s.id;
+				slot.value = std::move(s.value);
+			}
+		}
+	}
+
+	std::vector<Slot> _slots;
+	size_t            _size;
+};
+
+} // namespace machina
+
+#endif // MACHINA_IDMAP_HPP
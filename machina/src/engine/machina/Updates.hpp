@@ -29,16 +29,21 @@ enum UpdateType {
 };
 
 void
-write_set(SPtr<Raul::RingBuffer> buf,
-          uint64_t               subject,
-          URIInt                 key,
-          const Atom&            value);
-
+write_set(const SPtr<Raul::RingBuffer>& buf,
+          uint64_t                      subject,
+          URIInt                        key,
+          const Atom&                   value);
+
+/** Read a set update from `buf`.
+ *
+ * The body is read directly into `value`, reusing its memory where possible,
+ * so a single Atom can be used to read many updates without allocating.
+ */
 uint32_t
-read_set(SPtr<Raul::RingBuffer> buf,
-         uint64_t*              subject,
-         URIInt*                key,
-         Atom*                  value);
+read_set(const SPtr<Raul::RingBuffer>& buf,
+         uint64_t*                     subject,
+         URIInt*                       key,
+         Atom*                         value);
 
 } // namespace machina
 
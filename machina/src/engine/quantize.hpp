@@ -17,12 +17,15 @@
 #ifndef MACHINA_QUANTIZE_HPP
 #define MACHINA_QUANTIZE_HPP
 
+#include <cassert>
 #include <cmath>
 
 #include "raul/TimeStamp.hpp"
 
 namespace machina {
 
+using Raul::TimeStamp;
+
 inline TimeStamp
 quantize(TimeStamp q, TimeStamp t)
 {
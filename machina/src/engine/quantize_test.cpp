@@ -20,6 +20,7 @@
 
 using namespace std;
 using namespace machina;
+using namespace Raul;
 
 int
 main()
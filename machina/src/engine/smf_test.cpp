@@ -14,21 +14,23 @@
   along with Machina.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <cstdio>
 #include <iostream>
 #include <string>
-#include "raul/log.hpp"
-#include "raul/SMFReader.hpp"
-#include "raul/SMFWriter.hpp"
+
+#include "SMFReader.hpp"
+#include "SMFWriter.hpp"
 
 using namespace std;
 using namespace machina;
+using namespace Raul;
 
 int
 main(int argc, char** argv)
 {
 #define CHECK(cond) \
 	do { if (!(cond)) { \
-			error << "Test at " << __FILE__ << ":" << __LINE__ \
+			cerr << "Test at " << __FILE__ << ":" << __LINE__ \
 			      << " failed: " << __STRING(cond) << endl; \
 			return 1; \
 		} \
@@ -80,5 +82,9 @@ main(int argc, char** argv)
 		}
 	}
 
+	if (argc < 2) {
+		remove(filename);
+	}
+
 	return 0;
 }
@@ -14,68 +14,90 @@
   along with Machina.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <stdlib.h>
+#include <string.h>
+
 #include <iostream>
-#include <signal.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glibmm/convert.h>
+#include <glibmm/miscutils.h>
+
 #include "sord/sordmm.hpp"
-#include "machina/Engine.hpp"
+
 #include "machina/Machine.hpp"
-#include "machina/Action.hpp"
-#include "machina/Edge.hpp"
-#include "machina/SMFDriver.hpp"
-#include "machina/MidiAction.hpp"
+#include "machina/URIs.hpp"
+#include "machina_config.h"
+
+#include "SMFDriver.hpp"
 
 using namespace std;
 using namespace machina;
 
-bool quit = false;
-
-void
-catch_int(int)
+static int
+print_usage()
 {
-	signal(SIGINT, catch_int);
-	signal(SIGTERM, catch_int);
-
-	std::cout << "Interrupted" << std::endl;
-
-	quit = true;
+	cout << "Usage: midi2machina [OPTION]... QUANTIZATION OUTPUT FILE..." << endl;
+	cout << "Learn a machine from every track of every MIDI FILE, and write it"
+	     << endl << "to the Turtle file OUTPUT." << endl << endl;
+	cout << "Specify quantization in beats, e.g. 1.0, or 0 for none" << endl;
+	cout << endl << "Options:" << endl;
+	cout << "  -j THREADS  Number of threads to learn tracks with" << endl;
+	return -1;
 }
 
 int
 main(int argc, char** argv)
 {
-	if (argc != 3) {
-		cout << "Usage: midi2machina QUANTIZATION FILE" << endl;
-		cout << "Specify quantization in beats, e.g. 1.0, or 0 for none"
-		     << endl;
-		return -1;
+	unsigned n_threads = std::thread::hardware_concurrency();
+
+	int a = 1;
+	for (; a < argc && argv[a][0] == '-'; ++a) {
+		if (!strcmp(argv[a], "-j") && a + 1 < argc) {
+			n_threads = strtoul(argv[++a], NULL, 10);
+		} else {
+			return print_usage();
+		}
+	}
+
+	if (argc - a < 3) {
+		return print_usage();
 	}
 
-	SPtr<SMFDriver> driver(new SMFDriver());
+	machina::URIs::init();
+
+	const double         q      = strtod(argv[a++], NULL);
+	const string         output = argv[a++];
+	const vector<string> files(argv + a, argv + argc);
 
-	SPtr<Machine> machine = driver->learn(argv[2], strtof(argv[1], NULL));
+	Forge          forge;
+	Raul::TimeUnit beats(TimeUnit::BEATS, MACHINA_PPQN);
+	SMFDriver      driver(forge, beats);
+
+	SMFDriver::LearnStats stats;
+	SPtr<Machine>         machine = driver.learn(
+		files, q, Raul::TimeDuration(beats, 0, 0), n_threads, &stats);
+
+	cerr << "Learned " << stats.events << " events from " << stats.tracks
+	     << " tracks of " << stats.files << " files in " << stats.seconds
+	     << " s (" << (stats.seconds > 0.0 ? stats.events / stats.seconds : 0)
+	     << " events/s)" << endl;
 
 	if (!machine) {
-		cout << "Failed to load MIDI file." << endl;
+		cerr << "Failed to learn anything from MIDI files." << endl;
 		return -1;
 	}
 
-	/*
-	   string out_filename = argv[1];
-	   if (out_filename.find_last_of("/") != string::npos)
-	        out_filename = out_filename.substr(out_filename.find_last_of("/")+1);
-
-	   const string::size_type last_dot = out_filename.find_last_of(".");
-	   if (last_dot != string::npos && last_dot != 0)
-	        out_filename = out_filename.substr(0, last_dot);
-	   out_filename += ".machina";
-
-	   cout << "Writing output to " << out_filename << endl;
-	 */
+	const string uri = Glib::filename_to_uri(
+		Glib::path_is_absolute(output)
+		? output : Glib::build_filename(Glib::get_current_dir(), output));
 
 	Sord::World world;
-	Sord::Model model(world);
+	Sord::Model model(world, uri);
 	machine->write_state(model);
-	model.serialise_to_file_handle(stdout);
+	model.write_to_file(uri, SERD_TURTLE);
 
 	return 0;
 }
@@ -188,6 +188,129 @@ sratom_from_turtle(Sratom*         sratom,
                    const SerdNode* predicate,
                    const char*     str);
 
+/**
+   Version of the binary document format written by sratom_to_binary().
+*/
+#define SRATOM_BINARY_VERSION 1
+
+/**
+   Serialise an Atom to a binary document.
+
+   The document starts with the magic string "SRAT" and the format version,
+   followed by a table of every URI used by the atom, then the atom itself
+   with each URID replaced by the index of its URI in the table.  This allows
+   documents to be read by a process with a different URID map.  The atom is
+   stored in native byte order, so documents are not portable between
+   machines of different endianness.
+
+   The returned document must be free()'d by the caller.
+   @param doc_size Set to the size of the returned document in bytes.
+   @return The document, or NULL if the atom is invalid or a URID could not
+   be unmapped.
+*/
+SRATOM_API
+void*
+sratom_to_binary(Sratom*         sratom,
+                 LV2_URID_Unmap* unmap,
+                 uint32_t        type,
+                 uint32_t        size,
+                 const void*     body,
+                 size_t*         doc_size);
+
+/**
+   Read an Atom from a binary document written by sratom_to_binary().
+   The returned atom must be free()'d by the caller.
+   @return The atom, or NULL if the document is invalid or has a different
+   version.
+*/
+SRATOM_API
+LV2_Atom*
+sratom_from_binary(Sratom*     sratom,
+                   const void* doc,
+                   size_t      doc_size);
+
+/**
+   Writer for serialising many atoms to Turtle strings.
+
+   This is equivalent to calling sratom_to_turtle() repeatedly, but the
+   environment, writer, and output buffer are only created once.
+*/
+typedef struct SratomWriterImpl SratomWriter;
+
+/**
+   Reader for reading many atoms from Turtle strings.
+
+   This reads the same atoms as calling sratom_from_turtle() repeatedly, but
+   atoms are read directly from the Turtle statements without building a
+   model, and the reader and output buffer are only created once.  Documents
+   that can not be read this way, such as those which refer to blank nodes
+   described elsewhere rather than writing them in place, are read with a
+   model as before.
+
+   The order of object properties depends on which way a document was read.
+   Properties of streamed documents are in document order, and properties of
+   documents read with a model are in the model's sorted order, as with
+   sratom_from_turtle().  The results are identical only for documents which
+   list properties in sorted order.
+*/
+typedef struct SratomReaderImpl SratomReader;
+
+/**
+   Create a new writer which uses `sratom` to write atoms.
+*/
+SRATOM_API
+SratomWriter*
+sratom_writer_new(Sratom*         sratom,
+                  LV2_URID_Unmap* unmap,
+                  const char*     base_uri);
+
+/**
+   Free a writer.
+*/
+SRATOM_API
+void
+sratom_writer_free(SratomWriter* writer);
+
+/**
+   Serialise an Atom to a Turtle string.
+   The returned string is owned by the writer, and is only valid until the
+   next call to this function.
+*/
+SRATOM_API
+const char*
+sratom_writer_to_turtle(SratomWriter*   writer,
+                        const SerdNode* subject,
+                        const SerdNode* predicate,
+                        uint32_t        type,
+                        uint32_t        size,
+                        const void*     body);
+
+/**
+   Create a new reader which uses `sratom` to read atoms.
+*/
+SRATOM_API
+SratomReader*
+sratom_reader_new(Sratom* sratom, const char* base_uri);
+
+/**
+   Free a reader.
+*/
+SRATOM_API
+void
+sratom_reader_free(SratomReader* reader);
+
+/**
+   Read an Atom from a Turtle string.
+   The returned atom is owned by the reader, and is only valid until the next
+   call to this function.
+*/
+SRATOM_API
+const LV2_Atom*
+sratom_reader_from_turtle(SratomReader*   reader,
+                          const SerdNode* subject,
+                          const SerdNode* predicate,
+                          const char*     str);
+
 /**
    A convenient resizing sink for LV2_Atom_Forge.
    The handle must point to an initialized SerdChunk.
@@ -60,6 +60,13 @@ struct SratomImpl {
 	} nodes;
 };
 
+/** A growable buffer, which is reused to avoid allocating for every atom. */
+typedef struct {
+	uint8_t* buf;
+	size_t   len;
+	size_t   size;
+} Buffer;
+
 static void
 read_node(Sratom*         sratom,
           LV2_Atom_Forge* forge,
@@ -441,6 +448,21 @@ sratom_write(Sratom*         sratom,
 	return 0;
 }
 
+static void
+set_prefixes(SerdEnv* env)
+{
+	serd_env_set_prefix_from_strings(env, USTR("midi"),
+	                                 USTR(LV2_MIDI_PREFIX));
+	serd_env_set_prefix_from_strings(env, USTR("atom"),
+	                                 USTR(LV2_ATOM_URI "#"));
+	serd_env_set_prefix_from_strings(env, USTR("rdf"), NS_RDF);
+	serd_env_set_prefix_from_strings(env, USTR("xsd"), NS_XSD);
+}
+
+static const SerdStyle turtle_style = (SerdStyle)(SERD_STYLE_ABBREVIATED |
+                                                  SERD_STYLE_RESOLVED |
+                                                  SERD_STYLE_CURIED);
+
 SRATOM_API
 char*
 sratom_to_turtle(Sratom*         sratom,
@@ -457,19 +479,10 @@ sratom_to_turtle(Sratom*         sratom,
 	SerdEnv*  env  = serd_env_new(&base);
 	SerdChunk str  = { NULL, 0 };
 
-	serd_env_set_prefix_from_strings(env, USTR("midi"),
-	                                 USTR(LV2_MIDI_PREFIX));
-	serd_env_set_prefix_from_strings(env, USTR("atom"),
-	                                 USTR(LV2_ATOM_URI "#"));
-	serd_env_set_prefix_from_strings(env, USTR("rdf"), NS_RDF);
-	serd_env_set_prefix_from_strings(env, USTR("xsd"), NS_XSD);
+	set_prefixes(env);
 
 	SerdWriter* writer = serd_writer_new(
-		SERD_TURTLE,
-		(SerdStyle)(SERD_STYLE_ABBREVIATED |
-		            SERD_STYLE_RESOLVED |
-		            SERD_STYLE_CURIED),
-		env, &buri, serd_chunk_sink, &str);
+		SERD_TURTLE, turtle_style, env, &buri, serd_chunk_sink, &str);
 
 	// Write @prefix directives
 	serd_env_foreach(env,
@@ -556,6 +569,79 @@ atom_size(Sratom* sratom, uint32_t type_urid)
 	}
 }
 
+static void
+read_literal(Sratom*         sratom,
+             LV2_Atom_Forge* forge,
+             const char*     str,
+             size_t          len,
+             const char*     type_uri,
+             const char*     language)
+{
+	char* endptr;
+	if (type_uri) {
+		if (!strcmp(type_uri, (const char*)NS_XSD "int") ||
+		    !strcmp(type_uri, (const char*)NS_XSD "integer")) {
+			lv2_atom_forge_int(forge, strtol(str, &endptr, 10));
+		} else if (!strcmp(type_uri, (const char*)NS_XSD "long")) {
+			lv2_atom_forge_long(forge, strtol(str, &endptr, 10));
+		} else if (!strcmp(type_uri, (const char*)NS_XSD "float") ||
+		           !strcmp(type_uri, (const char*)NS_XSD "decimal")) {
+			lv2_atom_forge_float(forge, serd_strtod(str, &endptr));
+		} else if (!strcmp(type_uri, (const char*)NS_XSD "double")) {
+			lv2_atom_forge_double(forge, serd_strtod(str, &endptr));
+		} else if (!strcmp(type_uri, (const char*)NS_XSD "boolean")) {
+			lv2_atom_forge_bool(forge, !strcmp(str, "true"));
+		} else if (!strcmp(type_uri, (const char*)NS_XSD "base64Binary")) {
+			size_t size = 0;
+			void*  body = serd_base64_decode(USTR(str), len, &size);
+			lv2_atom_forge_atom(forge, size, forge->Chunk);
+			lv2_atom_forge_write(forge, body, size);
+			free(body);
+		} else if (!strcmp(type_uri, LV2_ATOM__Path)) {
+			lv2_atom_forge_path(forge, str, len);
+		} else if (!strcmp(type_uri, LV2_MIDI__MidiEvent)) {
+			lv2_atom_forge_atom(forge, len / 2, sratom->midi_MidiEvent);
+			for (const char* s = str; s < str + len; s += 2) {
+				unsigned num;
+				sscanf(s, "%2X", &num);
+				const uint8_t c = num;
+				lv2_atom_forge_raw(forge, &c, 1);
+			}
+			lv2_atom_forge_pad(forge, len / 2);
+		} else {
+			lv2_atom_forge_literal(
+				forge, str, len,
+				sratom->map->map(sratom->map->handle, type_uri),
+				0);
+		}
+	} else if (language) {
+		const char*  prefix   = "http://lexvo.org/id/iso639-3/";
+		const size_t lang_len = strlen(prefix) + strlen(language);
+		char*        lang_uri = (char*)calloc(lang_len + 1, 1);
+		snprintf(lang_uri, lang_len + 1, "%s%s", prefix, language);
+		lv2_atom_forge_literal(
+			forge, str, len, 0,
+			sratom->map->map(sratom->map->handle, lang_uri));
+		free(lang_uri);
+	} else {
+		lv2_atom_forge_string(forge, str, len);
+	}
+}
+
+static void
+read_uri(Sratom* sratom, LV2_Atom_Forge* forge, const char* str)
+{
+	if (!strcmp(str, (const char*)NS_RDF "nil")) {
+		lv2_atom_forge_atom(forge, 0, 0);
+	} else if (!strncmp(str, "file://", 7)) {
+		uint8_t* path = serd_file_uri_parse((const uint8_t*)str, NULL);
+		lv2_atom_forge_path(forge, (const char*)path, strlen((const char*)path));
+		free(path);
+	} else {
+		lv2_atom_forge_urid(forge, sratom->map->map(sratom->map->handle, str));
+	}
+}
+
 static void
 read_node(Sratom*         sratom,
           LV2_Atom_Forge* forge,
@@ -568,70 +654,15 @@ read_node(Sratom*         sratom,
 	size_t        len = 0;
 	const char*   str = (const char*)sord_node_get_string_counted(node, &len);
 	if (sord_node_get_type(node) == SORD_LITERAL) {
-		char*       endptr;
 		SordNode*   datatype = sord_node_get_datatype(node);
 		const char* language = sord_node_get_language(node);
-		if (datatype) {
-			const char* type_uri = (const char*)sord_node_get_string(datatype);
-			if (!strcmp(type_uri, (const char*)NS_XSD "int") ||
-			    !strcmp(type_uri, (const char*)NS_XSD "integer")) {
-				lv2_atom_forge_int(forge, strtol(str, &endptr, 10));
-			} else if (!strcmp(type_uri, (const char*)NS_XSD "long")) {
-				lv2_atom_forge_long(forge, strtol(str, &endptr, 10));
-			} else if (!strcmp(type_uri, (const char*)NS_XSD "float") ||
-			           !strcmp(type_uri, (const char*)NS_XSD "decimal")) {
-				lv2_atom_forge_float(forge, serd_strtod(str, &endptr));
-			} else if (!strcmp(type_uri, (const char*)NS_XSD "double")) {
-				lv2_atom_forge_double(forge, serd_strtod(str, &endptr));
-			} else if (!strcmp(type_uri, (const char*)NS_XSD "boolean")) {
-				lv2_atom_forge_bool(forge, !strcmp(str, "true"));
-			} else if (!strcmp(type_uri, (const char*)NS_XSD "base64Binary")) {
-				size_t size = 0;
-				void*  body = serd_base64_decode(USTR(str), len, &size);
-				lv2_atom_forge_atom(forge, size, forge->Chunk);
-				lv2_atom_forge_write(forge, body, size);
-				free(body);
-			} else if (!strcmp(type_uri, LV2_ATOM__Path)) {
-				lv2_atom_forge_path(forge, str, len);
-			} else if (!strcmp(type_uri, LV2_MIDI__MidiEvent)) {
-				lv2_atom_forge_atom(forge, len / 2, sratom->midi_MidiEvent);
-				for (const char* s = str; s < str + len; s += 2) {
-					unsigned num;
-					sscanf(s, "%2X", &num);
-					const uint8_t c = num;
-					lv2_atom_forge_raw(forge, &c, 1);
-				}
-				lv2_atom_forge_pad(forge, len / 2);
-			} else {
-				lv2_atom_forge_literal(
-					forge, str, len,
-					sratom->map->map(sratom->map->handle, type_uri),
-					0);
-			}
-		} else if (language) {
-			const char*  prefix   = "http://lexvo.org/id/iso639-3/";
-			const size_t lang_len = strlen(prefix) + strlen(language);
-			char*        lang_uri = (char*)calloc(lang_len + 1, 1);
-			snprintf(lang_uri, lang_len + 1, "%s%s", prefix, language);
-			lv2_atom_forge_literal(
-				forge, str, len, 0,
-				sratom->map->map(sratom->map->handle, lang_uri));
-			free(lang_uri);
-		} else {
-			lv2_atom_forge_string(forge, str, len);
-		}
+		read_literal(sratom, forge, str, len,
+		             datatype ? (const char*)sord_node_get_string(datatype) : NULL,
+		             language);
 	} else if (sord_node_get_type(node) == SORD_URI &&
 	           !(sratom->object_mode == SRATOM_OBJECT_MODE_BLANK_SUBJECT
 	             && mode == MODE_SUBJECT)) {
-		if (!strcmp(str, (const char*)NS_RDF "nil")) {
-			lv2_atom_forge_atom(forge, 0, 0);
-		} else if (!strncmp(str, "file://", 7)) {
-			uint8_t* path = serd_file_uri_parse((const uint8_t*)str, NULL);
-			lv2_atom_forge_path(forge, (const char*)path, strlen((const char*)path));
-			free(path);
-		} else {
-			lv2_atom_forge_urid(forge, map->map(map->handle, str));
-		}
+		read_uri(sratom, forge, str);
 	} else {
 		SordNode* type = sord_get(
 			model, node, sratom->nodes.rdf_type, NULL, NULL);
@@ -746,15 +777,15 @@ sratom_forge_deref(LV2_Atom_Forge_Sink_Handle handle, LV2_Atom_Forge_Ref ref)
 	return (LV2_Atom*)(chunk->buf + ref - 1);
 }
 
-SRATOM_API
-LV2_Atom*
-sratom_from_turtle(Sratom*         sratom,
-                   const char*     base_uri,
-                   const SerdNode* subject,
-                   const SerdNode* predicate,
-                   const char*     str)
+/** Read an atom from a Turtle string by loading it into a model. */
+static void
+read_model(Sratom*         sratom,
+           LV2_Atom_Forge* forge,
+           const char*     base_uri,
+           const SerdNode* subject,
+           const SerdNode* predicate,
+           const char*     str)
 {
-	SerdChunk   out    = { NULL, 0 };
 	SerdNode    base   = serd_node_new_uri_from_string(USTR(base_uri), NULL, NULL);
 	SordWorld*  world  = sord_world_new();
 	SordModel*  model  = sord_new(world, SORD_SPO, false);
@@ -763,19 +794,17 @@ sratom_from_turtle(Sratom*         sratom,
 
 	if (!serd_reader_read_string(reader, (const uint8_t*)str)) {
 		SordNode* s = sord_node_from_serd_node(world, env, subject, 0, 0);
-		lv2_atom_forge_set_sink(
-			&sratom->forge, sratom_forge_sink, sratom_forge_deref, &out);
 		if (subject && predicate) {
 			SordNode* p = sord_node_from_serd_node(world, env, predicate, 0, 0);
 			SordNode* o = sord_get(model, s, p, NULL, NULL);
 			if (o) {
-				sratom_read(sratom, &sratom->forge, world, model, o);
+				sratom_read(sratom, forge, world, model, o);
 				sord_node_free(world, o);
 			} else {
 				fprintf(stderr, "Failed to find node\n");
 			}
 		} else {
-			sratom_read(sratom, &sratom->forge, world, model, s);
+			sratom_read(sratom, forge, world, model, s);
 		}
 	} else {
 		fprintf(stderr, "Failed to read Turtle\n");
@@ -786,6 +815,947 @@ sratom_from_turtle(Sratom*         sratom,
 	sord_free(model);
 	sord_world_free(world);
 	serd_node_free(&base);
+}
 
+SRATOM_API
+LV2_Atom*
+sratom_from_turtle(Sratom*         sratom,
+                   const char*     base_uri,
+                   const SerdNode* subject,
+                   const SerdNode* predicate,
+                   const char*     str)
+{
+	SerdChunk out = { NULL, 0 };
+	lv2_atom_forge_set_sink(
+		&sratom->forge, sratom_forge_sink, sratom_forge_deref, &out);
+	read_model(sratom, &sratom->forge, base_uri, subject, predicate, str);
 	return (LV2_Atom*)out.buf;
 }
+
+/** Header at the start of a binary document, in native byte order. */
+typedef struct {
+	char     magic[4];   ///< "SRAT"
+	uint32_t version;    ///< SRATOM_BINARY_VERSION
+	uint32_t n_uris;     ///< Number of URIs in the URI table
+	uint32_t uris_size;  ///< Size of the URI table in bytes, padded to 64 bits
+} BinaryHeader;
+
+/**
+   Table of the URIs in a binary document.
+
+   Documents refer to URIs by their 1-based index in the table, which is
+   translated to or from a URID in the current map as the atom is copied.
+*/
+typedef struct {
+	Sratom*         sratom;
+	LV2_URID_Unmap* unmap;    ///< Unmap when writing, or NULL when reading
+	LV2_URID*       urids;    ///< URID of each URI in the table
+	uint32_t        n_urids;
+	bool            error;
+} URIDTable;
+
+/**
+   Translate `urid` in place between a URID and a document URI index.
+   Returns the URID in the current map.
+*/
+static uint32_t
+table_translate(URIDTable* table, uint32_t* urid)
+{
+	if (*urid == 0) {
+		return 0;
+	} else if (!table->unmap) {
+		if (*urid > table->n_urids) {
+			table->error = true;
+			return 0;
+		}
+		return (*urid = table->urids[*urid - 1]);
+	}
+
+	const uint32_t global = *urid;
+	for (uint32_t i = 0; i < table->n_urids; ++i) {
+		if (table->urids[i] == global) {
+			*urid = i + 1;
+			return global;
+		}
+	}
+
+	table->urids = (LV2_URID*)realloc(
+		table->urids, (table->n_urids + 1) * sizeof(LV2_URID));
+	table->urids[table->n_urids++] = global;
+	*urid = table->n_urids;
+	return global;
+}
+
+static void
+translate_atom(URIDTable* table, LV2_Atom* atom, size_t avail);
+
+/**
+   Translate a series of padded atoms, like the body of a tuple.
+   Each atom is preceded by `head` bytes, which are a property key and
+   context if `props` is true, or an event time otherwise.
+*/
+static void
+translate_series(URIDTable* table,
+                 uint8_t*   buf,
+                 uint32_t   size,
+                 uint32_t   head,
+                 bool       props)
+{
+	uint32_t offset = 0;
+	while (offset < size && !table->error) {
+		if (size - offset < head + sizeof(LV2_Atom)) {
+			table->error = true;
+			return;
+		} else if (props) {
+			LV2_Atom_Property_Body* prop = (LV2_Atom_Property_Body*)(buf + offset);
+			table_translate(table, &prop->key);
+			table_translate(table, &prop->context);
+		}
+
+		LV2_Atom* atom = (LV2_Atom*)(buf + offset + head);
+		translate_atom(table, atom, size - offset - head);
+		offset += head + lv2_atom_pad_size(sizeof(LV2_Atom) + atom->size);
+	}
+}
+
+/**
+   Translate every URID in `atom`, which has `avail` bytes available.
+   The structure of the atom is checked, since it may come from a document.
+*/
+static void
+translate_atom(URIDTable* table, LV2_Atom* atom, size_t avail)
+{
+	const LV2_Atom_Forge* forge = &table->sratom->forge;
+	if (avail < sizeof(LV2_Atom) || atom->size > avail - sizeof(LV2_Atom)) {
+		table->error = true;
+		return;
+	}
+
+	const uint32_t type = table_translate(table, &atom->type);
+	const uint32_t size = atom->size;
+	uint8_t* const body = (uint8_t*)(atom + 1);
+	if (type == forge->URID && size >= sizeof(uint32_t)) {
+		table_translate(table, (uint32_t*)body);
+	} else if (type == forge->Literal && size >= sizeof(LV2_Atom_Literal_Body)) {
+		LV2_Atom_Literal_Body* lit = (LV2_Atom_Literal_Body*)body;
+		table_translate(table, &lit->datatype);
+		table_translate(table, &lit->lang);
+	} else if (type == forge->Tuple) {
+		translate_series(table, body, size, 0, false);
+	} else if (type == forge->Vector && size >= sizeof(LV2_Atom_Vector_Body)) {
+		LV2_Atom_Vector_Body* vec        = (LV2_Atom_Vector_Body*)body;
+		const uint32_t        child_type = table_translate(table, &vec->child_type);
+		if (child_type == forge->URID && vec->child_size == sizeof(uint32_t)) {
+			uint32_t* elems = (uint32_t*)(vec + 1);
+			for (uint32_t i = 0; i < (size - sizeof(*vec)) / sizeof(uint32_t); ++i) {
+				table_translate(table, &elems[i]);
+			}
+		}
+	} else if (lv2_atom_forge_is_object_type(forge, type) &&
+	           size >= sizeof(LV2_Atom_Object_Body)) {
+		LV2_Atom_Object_Body* obj = (LV2_Atom_Object_Body*)body;
+		if (!lv2_atom_forge_is_blank(forge, type, obj)) {
+			table_translate(table, &obj->id);
+		}
+		table_translate(table, &obj->otype);
+		translate_series(table, (uint8_t*)(obj + 1), size - sizeof(*obj),
+		                 2 * sizeof(uint32_t), true);
+	} else if (type == forge->Sequence && size >= sizeof(LV2_Atom_Sequence_Body)) {
+		LV2_Atom_Sequence_Body* seq = (LV2_Atom_Sequence_Body*)body;
+		table_translate(table, &seq->unit);
+		translate_series(table, (uint8_t*)(seq + 1), size - sizeof(*seq),
+		                 sizeof(int64_t), false);
+	}
+}
+
+SRATOM_API
+void*
+sratom_to_binary(Sratom*         sratom,
+                 LV2_URID_Unmap* unmap,
+                 uint32_t        type,
+                 uint32_t        size,
+                 const void*     body,
+                 size_t*         doc_size)
+{
+	// Copy the atom, replacing URIDs with indices into the URI table
+	LV2_Atom* atom = (LV2_Atom*)malloc(sizeof(LV2_Atom) + size);
+	atom->type = type;
+	atom->size = size;
+	memcpy(atom + 1, body, size);
+
+	URIDTable table = { sratom, unmap, NULL, 0, false };
+	translate_atom(&table, atom, sizeof(LV2_Atom) + size);
+	if (table.error) {
+		fprintf(stderr, "Invalid atom\n");
+	}
+
+	size_t uris_size = 0;
+	for (uint32_t i = 0; i < table.n_urids && !table.error; ++i) {
+		const char* uri = unmap->unmap(unmap->handle, table.urids[i]);
+		if (!uri) {
+			fprintf(stderr, "Failed to unmap URID %u\n", table.urids[i]);
+			table.error = true;
+		} else {
+			uris_size += strlen(uri) + 1;
+		}
+	}
+
+	uint8_t* doc = NULL;
+	*doc_size = 0;
+	if (!table.error) {
+		const BinaryHeader head = {
+			{ 'S', 'R', 'A', 'T' },
+			SRATOM_BINARY_VERSION,
+			table.n_urids,
+			lv2_atom_pad_size((uint32_t)uris_size)
+		};
+
+		*doc_size = sizeof(head) + head.uris_size + sizeof(LV2_Atom) + size;
+		doc       = (uint8_t*)calloc(1, *doc_size);
+		memcpy(doc, &head, sizeof(head));
+
+		char* str = (char*)doc + sizeof(head);
+		for (uint32_t i = 0; i < table.n_urids; ++i) {
+			const char*  uri = unmap->unmap(unmap->handle, table.urids[i]);
+			const size_t len = strlen(uri) + 1;
+			memcpy(str, uri, len);
+			str += len;
+		}
+
+		memcpy(doc + sizeof(head) + head.uris_size, atom,
+		       sizeof(LV2_Atom) + size);
+	}
+
+	free(table.urids);
+	free(atom);
+	return doc;
+}
+
+SRATOM_API
+LV2_Atom*
+sratom_from_binary(Sratom* sratom, const void* doc, size_t doc_size)
+{
+	BinaryHeader head;
+	if (doc_size < sizeof(head) + sizeof(LV2_Atom)) {
+		fprintf(stderr, "Binary atom document is too short\n");
+		return NULL;
+	}
+
+	memcpy(&head, doc, sizeof(head));
+	if (memcmp(head.magic, "SRAT", 4)) {
+		fprintf(stderr, "Not a binary atom document\n");
+		return NULL;
+	} else if (head.version != SRATOM_BINARY_VERSION) {
+		fprintf(stderr, "Unsupported binary atom version %u\n", head.version);
+		return NULL;
+	} else if (head.uris_size > doc_size - sizeof(head) - sizeof(LV2_Atom) ||
+	           head.n_uris > head.uris_size) {
+		fprintf(stderr, "Invalid binary atom document\n");
+		return NULL;
+	}
+
+	// Map every URI in the table
+	LV2_URID_Map* map   = sratom->map;
+	const char*   str   = (const char*)doc + sizeof(head);
+	const char*   end   = str + head.uris_size;
+	URIDTable     table = { sratom, NULL, NULL, head.n_uris, false };
+	table.urids = (LV2_URID*)calloc(head.n_uris, sizeof(LV2_URID));
+	for (uint32_t i = 0; i < head.n_uris && !table.error; ++i) {
+		const char* nul = (const char*)memchr(str, '\0', end - str);
+		if (!nul) {
+			table.error = true;
+		} else {
+			table.urids[i] = map->map(map->handle, str);
+			str            = nul + 1;
+		}
+	}
+
+	// Copy the atom, replacing URI indices with URIDs
+	const size_t atom_size = doc_size - sizeof(head) - head.uris_size;
+	LV2_Atom*    atom      = NULL;
+	if (!table.error) {
+		atom = (LV2_Atom*)malloc(atom_size);
+		memcpy(atom, end, atom_size);
+		translate_atom(&table, atom, atom_size);
+	}
+
+	if (table.error) {
+		fprintf(stderr, "Invalid binary atom document\n");
+		free(atom);
+		atom = NULL;
+	}
+
+	free(table.urids);
+	return atom;
+}
+
+static size_t
+buffer_sink(const void* buf, size_t len, void* stream)
+{
+	Buffer* const buffer = (Buffer*)stream;
+	if (buffer->len + len > buffer->size) {
+		size_t size = buffer->size ? buffer->size : 256;
+		while (size < buffer->len + len) {
+			size *= 2;
+		}
+		buffer->buf  = (uint8_t*)realloc(buffer->buf, size);
+		buffer->size = size;
+	}
+	memcpy(buffer->buf + buffer->len, buf, len);
+	buffer->len += len;
+	return len;
+}
+
+static void
+buffer_set(Buffer* buffer, const char* str)
+{
+	buffer->len = 0;
+	buffer_sink(str, strlen(str) + 1, buffer);
+}
+
+static LV2_Atom_Forge_Ref
+buffer_forge_sink(LV2_Atom_Forge_Sink_Handle handle,
+                  const void*                buf,
+                  uint32_t                   size)
+{
+	Buffer* const            buffer = (Buffer*)handle;
+	const LV2_Atom_Forge_Ref ref    = buffer->len + 1;
+	buffer_sink(buf, size, buffer);
+	return ref;
+}
+
+static LV2_Atom*
+buffer_forge_deref(LV2_Atom_Forge_Sink_Handle handle, LV2_Atom_Forge_Ref ref)
+{
+	return (LV2_Atom*)(((Buffer*)handle)->buf + ref - 1);
+}
+
+struct SratomWriterImpl {
+	Sratom*         sratom;
+	LV2_URID_Unmap* unmap;
+	SerdNode        base;
+	SerdURI         base_uri;
+	SerdEnv*        env;
+	SerdWriter*     writer;
+	Buffer          out;
+	size_t          header_len;  ///< Length of prefix directives in out
+};
+
+SRATOM_API
+SratomWriter*
+sratom_writer_new(Sratom* sratom, LV2_URID_Unmap* unmap, const char* base_uri)
+{
+	SratomWriter* writer = (SratomWriter*)calloc(1, sizeof(SratomWriter));
+	writer->sratom = sratom;
+	writer->unmap  = unmap;
+	writer->base   = serd_node_new_uri_from_string(
+		USTR(base_uri), NULL, &writer->base_uri);
+	writer->env    = serd_env_new(&writer->base);
+	set_prefixes(writer->env);
+
+	writer->writer = serd_writer_new(SERD_TURTLE, turtle_style, writer->env,
+	                                 &writer->base_uri, buffer_sink, &writer->out);
+
+	// Write @prefix directives once, they are kept at the start of the output
+	serd_env_foreach(writer->env,
+	                 (SerdPrefixSink)serd_writer_set_prefix,
+	                 writer->writer);
+	writer->header_len = writer->out.len;
+	return writer;
+}
+
+SRATOM_API
+void
+sratom_writer_free(SratomWriter* writer)
+{
+	if (writer) {
+		serd_writer_free(writer->writer);
+		serd_env_free(writer->env);
+		serd_node_free(&writer->base);
+		free(writer->out.buf);
+		free(writer);
+	}
+}
+
+SRATOM_API
+const char*
+sratom_writer_to_turtle(SratomWriter*   writer,
+                        const SerdNode* subject,
+                        const SerdNode* predicate,
+                        uint32_t        type,
+                        uint32_t        size,
+                        const void*     body)
+{
+	// Temporarily direct the serialiser to this writer
+	Sratom* const           sratom          = writer->sratom;
+	const SerdNode          base_uri        = sratom->base_uri;
+	const SerdStatementSink write_statement = sratom->write_statement;
+	const SerdEndSink       end_anon        = sratom->end_anon;
+	void* const             handle          = sratom->handle;
+
+	sratom->base_uri        = writer->base;
+	sratom->write_statement = (SerdStatementSink)serd_writer_write_statement;
+	sratom->end_anon        = (SerdEndSink)serd_writer_end_anon;
+	sratom->handle          = writer->writer;
+
+	writer->out.len = writer->header_len;
+	sratom_write(sratom, writer->unmap, SERD_EMPTY_S,
+	             subject, predicate, type, size, body);
+	serd_writer_finish(writer->writer);
+	buffer_sink("", 1, &writer->out);
+
+	sratom->base_uri        = base_uri;
+	sratom->write_statement = write_statement;
+	sratom->end_anon        = end_anon;
+	sratom->handle          = handle;
+
+	return (const char*)writer->out.buf;
+}
+
+/** Maximum depth of nested nodes the streaming reader can handle. */
+#define READER_MAX_DEPTH 64
+
+typedef enum {
+	READ_SEARCHING,  ///< Looking for the requested node
+	READ_READING,    ///< Reading the requested node
+	READ_DONE,       ///< Finished, remaining statements are ignored
+	READ_FALLBACK    ///< Document can not be streamed, read it into a model
+} ReadState;
+
+typedef enum {
+	FRAME_RESOURCE,   ///< Resource whose kind is not known yet
+	FRAME_OBJECT,     ///< Object, statements are properties
+	FRAME_VECTOR,     ///< Vector, waiting for the child type
+	FRAME_CONTAINER,  ///< Tuple, Sequence, or Vector, waiting for the value
+	FRAME_EVENT,      ///< Sequence element
+	FRAME_LIST,       ///< List, node is the current list cell
+	FRAME_IGNORE      ///< Finished resource, statements are ignored
+} FrameKind;
+
+typedef struct {
+	FrameKind            kind;
+	ReadMode             mode;       ///< Mode for reading list elements
+	SerdType             type;       ///< SERD_BLANK or SERD_URI
+	Buffer               node;       ///< Blank node ID or URI
+	LV2_URID             id;         ///< Object ID
+	LV2_URID             otype;      ///< Type of resource
+	bool                 has_time;   ///< Event time has been written
+	bool                 has_value;  ///< Value has been read
+	LV2_Atom_Forge_Frame frame;
+} ReadFrame;
+
+/**
+   Streaming Turtle reader.
+
+   Rather than loading a model, atoms are forged directly from the statements
+   as they are read.  This works because abbreviated Turtle, as written by
+   sratom, describes every blank node and list in place, so their statements
+   arrive depth-first immediately after the statement which refers to them.
+   Anything else is detected and read with a model instead.  Unlike a model,
+   this preserves the order of object properties in the document.
+*/
+struct SratomReaderImpl {
+	Sratom*        sratom;
+	LV2_Atom_Forge forge;
+	SerdNode       base;
+	SerdURI        base_uri;
+	SerdEnv*       env;
+	SerdReader*    reader;
+	bool           rebased;    ///< Document has changed the base URI
+	ReadState      state;
+	Buffer         out;        ///< Forged atom
+	Buffer         subject;    ///< Requested subject URI
+	Buffer         predicate;  ///< Requested predicate URI, or empty
+	Buffer         s_str;      ///< Expanded statement subject
+	Buffer         p_str;      ///< Expanded statement predicate
+	Buffer         o_str;      ///< Expanded statement object
+	Buffer         d_str;      ///< Expanded statement object datatype
+	unsigned       depth;
+	ReadFrame      stack[READER_MAX_DEPTH];
+};
+
+/**
+   Return the string of `node`, with URIs and CURIEs expanded to full URIs.
+   Expanded URIs are written to `buf`.  Returns NULL on failure.
+*/
+static const char*
+reader_expand(SratomReader* reader, const SerdNode* node, Buffer* buf)
+{
+	if (node->type == SERD_URI) {
+		if (serd_uri_string_has_scheme(node->buf)) {
+			return (const char*)node->buf;
+		}
+		SerdURI uri;
+		SerdURI abs_uri;
+		serd_uri_parse(node->buf, &uri);
+		serd_uri_resolve(&uri, &reader->base_uri, &abs_uri);
+		buf->len = 0;
+		serd_uri_serialise(&abs_uri, buffer_sink, buf);
+	} else if (node->type == SERD_CURIE) {
+		SerdChunk prefix;
+		SerdChunk suffix;
+		if (serd_env_expand(reader->env, node, &prefix, &suffix)) {
+			return NULL;
+		}
+		buf->len = 0;
+		buffer_sink(prefix.buf, prefix.len, buf);
+		buffer_sink(suffix.buf, suffix.len, buf);
+	} else {
+		return (const char*)node->buf;
+	}
+	buffer_sink("", 1, buf);
+	return (const char*)buf->buf;
+}
+
+static inline bool
+is_uri(const SerdNode* node)
+{
+	return node->type == SERD_URI || node->type == SERD_CURIE;
+}
+
+static inline bool
+reader_fail(SratomReader* reader)
+{
+	reader->state = READ_FALLBACK;
+	return false;
+}
+
+static ReadFrame*
+reader_push(SratomReader* reader,
+            FrameKind     kind,
+            ReadMode      mode,
+            SerdType      type,
+            const char*   node)
+{
+	if (reader->depth == READER_MAX_DEPTH) {
+		reader_fail(reader);
+		return NULL;
+	}
+
+	ReadFrame* const frame = &reader->stack[reader->depth++];
+	frame->kind      = kind;
+	frame->mode      = mode;
+	frame->type      = type;
+	frame->id        = 0;
+	frame->otype     = 0;
+	frame->has_time  = false;
+	frame->has_value = false;
+	frame->frame.ref = 0;
+	buffer_set(&frame->node, node);
+	return frame;
+}
+
+static void
+reader_pop(SratomReader* reader)
+{
+	ReadFrame* const frame = &reader->stack[--reader->depth];
+	if (frame->frame.ref) {
+		lv2_atom_forge_pop(&reader->forge, &frame->frame);
+	}
+	if (reader->depth == 0) {
+		reader->state = READ_DONE;
+	}
+}
+
+/** Finish the resource on top of the stack after its last statement. */
+static bool
+reader_close(SratomReader* reader)
+{
+	ReadFrame* const frame = &reader->stack[reader->depth - 1];
+	if (frame->kind == FRAME_RESOURCE) {
+		// Resource with no properties, an empty object
+		lv2_atom_forge_object(
+			&reader->forge, &frame->frame, frame->id, frame->otype);
+	} else if (frame->kind == FRAME_VECTOR ||
+	           frame->kind == FRAME_LIST ||
+	           ((frame->kind == FRAME_CONTAINER || frame->kind == FRAME_EVENT)
+	            && !frame->has_value)) {
+		return reader_fail(reader);
+	}
+	reader_pop(reader);
+	return true;
+}
+
+/** Read a statement object as a value, or start reading a resource. */
+static bool
+reader_read_value(SratomReader*      reader,
+                  SerdStatementFlags flags,
+                  const SerdNode*    object,
+                  const SerdNode*    datatype,
+                  const SerdNode*    lang,
+                  ReadMode           mode)
+{
+	Sratom* const         sratom = reader->sratom;
+	LV2_Atom_Forge* const forge  = &reader->forge;
+	if (object->type == SERD_LITERAL) {
+		const char* type_uri = NULL;
+		if (datatype && datatype->buf &&
+		    !(type_uri = reader_expand(reader, datatype, &reader->d_str))) {
+			return reader_fail(reader);
+		}
+		read_literal(sratom, forge, (const char*)object->buf, object->n_bytes,
+		             type_uri, (lang && lang->buf) ? (const char*)lang->buf : NULL);
+	} else if (object->type == SERD_BLANK) {
+		if ((flags & SERD_EMPTY_O) && mode != MODE_SEQUENCE) {
+			LV2_Atom_Forge_Frame frame;
+			lv2_atom_forge_object(forge, &frame, 0, 0);
+			lv2_atom_forge_pop(forge, &frame);
+		} else if (flags & SERD_ANON_O_BEGIN) {
+			return reader_push(reader,
+			                   mode == MODE_SEQUENCE ? FRAME_EVENT : FRAME_RESOURCE,
+			                   mode, SERD_BLANK, (const char*)object->buf);
+		} else {
+			return reader_fail(reader);  // Blank node described elsewhere
+		}
+	} else if (sratom->object_mode == SRATOM_OBJECT_MODE_BLANK_SUBJECT &&
+	           mode == MODE_SUBJECT) {
+		return reader_fail(reader);  // Resource described elsewhere
+	} else {
+		const char* uri = reader_expand(reader, object, &reader->o_str);
+		if (!uri) {
+			return reader_fail(reader);
+		}
+		read_uri(sratom, forge, uri);
+	}
+	return true;
+}
+
+/** Read a statement about the node on top of the stack. */
+static bool
+reader_read_statement(SratomReader*      reader,
+                      SerdStatementFlags flags,
+                      const char*        p,
+                      const SerdNode*    object,
+                      const SerdNode*    datatype,
+                      const SerdNode*    lang)
+{
+	Sratom* const         sratom = reader->sratom;
+	LV2_URID_Map* const   map    = sratom->map;
+	LV2_Atom_Forge* const forge  = &reader->forge;
+	ReadFrame* const      frame  = &reader->stack[reader->depth - 1];
+	const bool is_type  = !strcmp(p, (const char*)NS_RDF "type");
+	const bool is_value = !strcmp(p, (const char*)NS_RDF "value");
+	const char* o = is_uri(object)
+		? reader_expand(reader, object, &reader->o_str)
+		: (const char*)object->buf;
+	if (!o) {
+		return reader_fail(reader);
+	}
+
+	if (frame->kind == FRAME_RESOURCE) {
+		const char* type_uri = (datatype && datatype->buf)
+			? reader_expand(reader, datatype, &reader->d_str)
+			: NULL;
+		if (is_type && is_uri(object) && !frame->otype) {
+			frame->otype = map->map(map->handle, o);
+			if (frame->otype == forge->Tuple) {
+				lv2_atom_forge_tuple(forge, &frame->frame);
+				frame->kind = FRAME_CONTAINER;
+				frame->mode = MODE_BODY;
+			} else if (frame->otype == forge->Sequence) {
+				lv2_atom_forge_sequence_head(forge, &frame->frame, 0);
+				frame->kind = FRAME_CONTAINER;
+				frame->mode = MODE_SEQUENCE;
+			} else if (frame->otype == forge->Vector) {
+				frame->kind = FRAME_VECTOR;
+			}
+			return true;
+		} else if (is_value && type_uri &&
+		           !strcmp(type_uri, (const char*)NS_XSD "base64Binary")) {
+			// Atom of some other type with a base64 encoded body
+			size_t size = 0;
+			void*  body = serd_base64_decode(object->buf, object->n_bytes, &size);
+			lv2_atom_forge_atom(forge, size, frame->otype);
+			lv2_atom_forge_write(forge, body, size);
+			free(body);
+			frame->kind = FRAME_IGNORE;
+			return true;
+		}
+
+		// Anything else is an object, and this is its first property
+		lv2_atom_forge_object(forge, &frame->frame, frame->id, frame->otype);
+		frame->kind = FRAME_OBJECT;
+	}
+
+	if (frame->kind == FRAME_OBJECT) {
+		if (is_type && is_uri(object)) {
+			if (!frame->otype) {
+				return reader_fail(reader);  // Type after properties
+			} else if (map->map(map->handle, o) == frame->otype) {
+				return true;  // Type of the object itself
+			}
+		}
+		lv2_atom_forge_key(forge, map->map(map->handle, p));
+		return reader_read_value(reader, flags, object, datatype, lang,
+		                         MODE_BODY);
+	} else if (frame->kind == FRAME_VECTOR) {
+		if (!strcmp(p, LV2_ATOM__childType)) {
+			const uint32_t child_type = map->map(map->handle, o);
+			const uint32_t child_size = atom_size(sratom, child_type);
+			if (!child_size) {
+				return reader_fail(reader);
+			}
+			lv2_atom_forge_vector_head(
+				forge, &frame->frame, child_size, child_type);
+			frame->kind = FRAME_CONTAINER;
+			frame->mode = MODE_BODY;
+		} else if (is_value) {
+			return reader_fail(reader);  // Value before child type
+		}
+	} else if (frame->kind == FRAME_CONTAINER) {
+		if (is_value) {
+			if (frame->has_value) {
+				return reader_fail(reader);
+			}
+			frame->has_value = true;
+			if (object->type == SERD_BLANK && (flags & SERD_LIST_O_BEGIN)) {
+				return reader_push(reader, FRAME_LIST, frame->mode,
+				                   SERD_BLANK, o);
+			} else if (!is_uri(object) || strcmp(o, (const char*)NS_RDF "nil")) {
+				return reader_fail(reader);
+			}
+		}
+	} else if (frame->kind == FRAME_EVENT) {
+		if (!strcmp(p, LV2_ATOM__frameTime)) {
+			if (frame->has_time) {
+				return reader_fail(reader);
+			}
+			lv2_atom_forge_frame_time(forge, serd_strtod(o, NULL));
+			frame->has_time = true;
+		} else if (is_value) {
+			if (frame->has_value) {
+				return reader_fail(reader);
+			} else if (!frame->has_time) {
+				lv2_atom_forge_frame_time(forge, 0);
+				frame->has_time = true;
+			}
+			frame->has_value = true;
+			return reader_read_value(reader, flags, object, datatype, lang,
+			                         MODE_BODY);
+		}
+	} else if (frame->kind == FRAME_LIST) {
+		if (!strcmp(p, (const char*)NS_RDF "first")) {
+			return reader_read_value(reader, flags, object, datatype, lang,
+			                         frame->mode);
+		} else if (strcmp(p, (const char*)NS_RDF "rest")) {
+			return reader_fail(reader);
+		} else if (object->type == SERD_BLANK) {
+			buffer_set(&frame->node, o);  // Move to next list cell
+		} else if (is_uri(object) && !strcmp(o, (const char*)NS_RDF "nil")) {
+			reader_pop(reader);
+		} else {
+			return reader_fail(reader);
+		}
+	} else if (frame->kind == FRAME_IGNORE && is_type) {
+		return reader_fail(reader);  // Type after a blob body
+	}
+	return true;
+}
+
+static SerdStatus
+reader_on_base(void* handle, const SerdNode* uri)
+{
+	SratomReader* const reader = (SratomReader*)handle;
+	const SerdStatus    st     = serd_env_set_base_uri(reader->env, uri);
+	serd_env_get_base_uri(reader->env, &reader->base_uri);
+	reader->rebased = true;
+	return st;
+}
+
+static SerdStatus
+reader_on_prefix(void* handle, const SerdNode* name, const SerdNode* uri)
+{
+	return serd_env_set_prefix(((SratomReader*)handle)->env, name, uri);
+}
+
+static SerdStatus
+reader_on_statement(void*              handle,
+                    SerdStatementFlags flags,
+                    const SerdNode*    graph,
+                    const SerdNode*    subject,
+                    const SerdNode*    predicate,
+                    const SerdNode*    object,
+                    const SerdNode*    object_datatype,
+                    const SerdNode*    object_lang)
+{
+	SratomReader* const reader = (SratomReader*)handle;
+	if (reader->state == READ_DONE || reader->state == READ_FALLBACK) {
+		return SERD_SUCCESS;
+	}
+
+	const char* s = reader_expand(reader, subject, &reader->s_str);
+	const char* p = reader_expand(reader, predicate, &reader->p_str);
+	if (!s || !p) {
+		reader_fail(reader);
+		return SERD_SUCCESS;
+	}
+
+	if (reader->state == READ_SEARCHING) {
+		if (!is_uri(subject) || strcmp(s, (const char*)reader->subject.buf)) {
+			return SERD_SUCCESS;  // Unrelated statement
+		} else if (reader->predicate.len) {
+			if (!strcmp(p, (const char*)reader->predicate.buf)) {
+				reader->state = READ_READING;
+				if (reader_read_value(reader, flags, object, object_datatype,
+				                      object_lang, MODE_SUBJECT) &&
+				    !reader->depth) {
+					reader->state = READ_DONE;
+				}
+			}
+			return SERD_SUCCESS;
+		}
+
+		// First statement about the requested subject
+		LV2_URID_Map* const map   = reader->sratom->map;
+		ReadFrame* const    frame = reader_push(
+			reader, FRAME_RESOURCE, MODE_BODY, SERD_URI, s);
+		frame->id     = map->map(map->handle, s);
+		reader->state = READ_READING;
+	}
+
+	const ReadFrame* const frame = &reader->stack[reader->depth - 1];
+	if (frame->type != (subject->type == SERD_BLANK ? SERD_BLANK : SERD_URI) ||
+	    strcmp(s, (const char*)frame->node.buf)) {
+		reader_fail(reader);  // Statement is not about the current node
+	} else {
+		reader_read_statement(
+			reader, flags, p, object, object_datatype, object_lang);
+	}
+	return SERD_SUCCESS;
+}
+
+static SerdStatus
+reader_on_end(void* handle, const SerdNode* node)
+{
+	SratomReader* const reader = (SratomReader*)handle;
+	if (reader->state == READ_READING) {
+		const ReadFrame* const frame = &reader->stack[reader->depth - 1];
+		if (frame->type != SERD_BLANK ||
+		    strcmp((const char*)node->buf, (const char*)frame->node.buf)) {
+			reader_fail(reader);
+		} else {
+			reader_close(reader);
+		}
+	}
+	return SERD_SUCCESS;
+}
+
+SRATOM_API
+SratomReader*
+sratom_reader_new(Sratom* sratom, const char* base_uri)
+{
+	SratomReader* reader = (SratomReader*)calloc(1, sizeof(SratomReader));
+	reader->sratom = sratom;
+	reader->base   = serd_node_new_uri_from_string(USTR(base_uri), NULL, NULL);
+	reader->env    = serd_env_new(&reader->base);
+	reader->reader = serd_reader_new(SERD_TURTLE, reader, NULL,
+	                                 reader_on_base,
+	                                 reader_on_prefix,
+	                                 reader_on_statement,
+	                                 reader_on_end);
+	serd_env_get_base_uri(reader->env, &reader->base_uri);
+	lv2_atom_forge_init(&reader->forge, sratom->map);
+	return reader;
+}
+
+SRATOM_API
+void
+sratom_reader_free(SratomReader* reader)
+{
+	if (reader) {
+		for (unsigned i = 0; i < READER_MAX_DEPTH; ++i) {
+			free(reader->stack[i].node.buf);
+		}
+		free(reader->d_str.buf);
+		free(reader->o_str.buf);
+		free(reader->p_str.buf);
+		free(reader->s_str.buf);
+		free(reader->predicate.buf);
+		free(reader->subject.buf);
+		free(reader->out.buf);
+		serd_reader_free(reader->reader);
+		serd_env_free(reader->env);
+		serd_node_free(&reader->base);
+		free(reader);
+	}
+}
+
+SRATOM_API
+const LV2_Atom*
+sratom_reader_from_turtle(SratomReader*   reader,
+                          const SerdNode* subject,
+                          const SerdNode* predicate,
+                          const char*     str)
+{
+	Sratom* const         sratom       = reader->sratom;
+	LV2_Atom_Forge* const forge        = &reader->forge;
+	const bool            read_subject = (
+		!predicate && sratom->object_mode != SRATOM_OBJECT_MODE_BLANK_SUBJECT);
+
+	if (reader->rebased) {
+		serd_env_set_base_uri(reader->env, &reader->base);
+		serd_env_get_base_uri(reader->env, &reader->base_uri);
+		reader->rebased = false;
+	}
+
+	reader->out.len = 0;
+	reader->depth   = 0;
+	reader->state   = READ_SEARCHING;
+	lv2_atom_forge_set_sink(
+		forge, buffer_forge_sink, buffer_forge_deref, &reader->out);
+
+	// Expand the requested nodes to compare them with statements
+	const char* s = (subject && subject->type == SERD_URI)
+		? reader_expand(reader, subject, &reader->s_str) : NULL;
+	const char* p = (predicate && is_uri(predicate))
+		? reader_expand(reader, predicate, &reader->p_str) : NULL;
+	reader->predicate.len = 0;
+	if (!s || (predicate && !p)) {
+		reader->state = READ_FALLBACK;
+	} else {
+		buffer_set(&reader->subject, s);
+		if (p) {
+			buffer_set(&reader->predicate, p);
+		} else if (read_subject) {
+			reader->state = READ_DONE;  // Subject itself is the value
+		}
+	}
+
+	if (serd_reader_read_string(reader->reader, USTR(str))) {
+		fprintf(stderr, "Failed to read Turtle\n");
+		return NULL;
+	}
+
+	if (reader->state == READ_DONE && read_subject) {
+		read_uri(sratom, forge, (const char*)reader->subject.buf);
+	} else if (reader->state == READ_SEARCHING) {
+		if (predicate) {
+			fprintf(stderr, "Failed to find node\n");
+			return NULL;
+		}
+
+		// Subject is not described, an empty object
+		LV2_Atom_Forge_Frame frame;
+		lv2_atom_forge_object(
+			forge, &frame,
+			sratom->map->map(sratom->map->handle,
+			                 (const char*)reader->subject.buf),
+			0);
+		lv2_atom_forge_pop(forge, &frame);
+		reader->state = READ_DONE;
+	} else if (reader->state == READ_READING && reader->depth == 1 &&
+	           !predicate) {
+		reader_close(reader);  // End of the description of the subject
+	}
+
+	if (reader->state != READ_DONE) {
+		// Not streamable, fall back to reading a model
+		reader->out.len = 0;
+		lv2_atom_forge_set_sink(
+			forge, buffer_forge_sink, buffer_forge_deref, &reader->out);
+		read_model(sratom, forge, (const char*)reader->base.buf,
+		           subject, predicate, str);
+	}
+
+	return reader->out.len ? (const LV2_Atom*)reader->out.buf : NULL;
+}
@@ -0,0 +1,189 @@
+/*
+  Copyright 2012-2015 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/**
+   @file sratom_bench.c Benchmark for converting many small atoms.
+
+   A small object, like a message with a few properties, is written to Turtle
+   and read back many times, once with sratom_to_turtle() and
+   sratom_from_turtle(), and once with a reused SratomWriter and SratomReader.
+*/
+
+#define _POSIX_C_SOURCE 200809L  /* for clock_gettime and strdup */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lv2/lv2plug.in/ns/ext/atom/forge.h"
+#include "lv2/lv2plug.in/ns/ext/atom/util.h"
+#include "sratom/sratom.h"
+
+#define NS_EG  "http://example.org/"
+#define NS_RDF "http://www.w3.org/1999/02/22-rdf-syntax-ns#"
+
+#define USTR(s) ((const uint8_t*)(s))
+
+static char**   uris   = NULL;
+static uint32_t n_uris = 0;
+
+static LV2_URID
+urid_map(LV2_URID_Map_Handle handle, const char* uri)
+{
+	for (uint32_t i = 0; i < n_uris; ++i) {
+		if (!strcmp(uris[i], uri)) {
+			return i + 1;
+		}
+	}
+
+	uris = (char**)realloc(uris, ++n_uris * sizeof(char*));
+	uris[n_uris - 1] = strdup(uri);
+	return n_uris;
+}
+
+static const char*
+urid_unmap(LV2_URID_Unmap_Handle handle, LV2_URID urid)
+{
+	if (urid > 0 && urid <= n_uris) {
+		return uris[urid - 1];
+	}
+	return NULL;
+}
+
+static double
+elapsed(const struct timespec* start)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((now.tv_sec - start->tv_sec)
+	        + (now.tv_nsec - start->tv_nsec) * 0.000000001);
+}
+
+/** Convert `obj` `n_atoms` times each way, returning non-zero on mismatch. */
+static int
+bench(Sratom*         sratom,
+      LV2_URID_Unmap* unmap,
+      const LV2_Atom* obj,
+      unsigned        n_atoms,
+      bool            reuse)
+{
+	const char* base_uri = "file:///tmp/base/";
+	SerdNode    s        = serd_node_from_string(SERD_URI, USTR(NS_EG "obj"));
+	SerdNode    p        = serd_node_from_string(SERD_URI, USTR(NS_RDF "value"));
+	char*       str      = sratom_to_turtle(sratom, unmap, base_uri, &s, &p,
+	                                        obj->type, obj->size,
+	                                        LV2_ATOM_BODY_CONST(obj));
+
+	SratomWriter* writer = NULL;
+	SratomReader* reader = NULL;
+	if (reuse) {
+		writer = sratom_writer_new(sratom, unmap, base_uri);
+		reader = sratom_reader_new(sratom, base_uri);
+	}
+
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (unsigned i = 0; i < n_atoms; ++i) {
+		if (reuse) {
+			sratom_writer_to_turtle(writer, &s, &p, obj->type, obj->size,
+			                        LV2_ATOM_BODY_CONST(obj));
+		} else {
+			free(sratom_to_turtle(sratom, unmap, base_uri, &s, &p,
+			                      obj->type, obj->size,
+			                      LV2_ATOM_BODY_CONST(obj)));
+		}
+	}
+	const double write_time = elapsed(&start);
+
+	int ret = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (unsigned i = 0; i < n_atoms; ++i) {
+		if (reuse) {
+			const LV2_Atom* atom = sratom_reader_from_turtle(reader, &s, &p, str);
+			ret |= !lv2_atom_equals(obj, atom);
+		} else {
+			LV2_Atom* atom = sratom_from_turtle(sratom, base_uri, &s, &p, str);
+			ret |= !lv2_atom_equals(obj, atom);
+			free(atom);
+		}
+	}
+	const double read_time = elapsed(&start);
+
+	if (ret) {
+		fprintf(stderr, "error: Read atom does not match original\n");
+	}
+
+	printf("%-8s %10.6f s  %8.1f ns/atom  %10.6f s  %8.1f ns/atom\n",
+	       reuse ? "Context" : "Legacy",
+	       write_time, write_time * 1e9 / n_atoms,
+	       read_time, read_time * 1e9 / n_atoms);
+
+	free(str);
+	sratom_reader_free(reader);
+	sratom_writer_free(writer);
+	return ret;
+}
+
+int
+main(int argc, char** argv)
+{
+	if (argc > 2 || (argc > 1 && !strcmp(argv[1], "-h"))) {
+		fprintf(stderr, "Usage: %s [ATOMS]\n", argv[0]);
+		return 1;
+	}
+
+	const unsigned n_atoms = (argc > 1) ? (unsigned)atoi(argv[1]) : 1000000;
+	if (n_atoms < 1) {
+		fprintf(stderr, "error: Invalid number of atoms\n");
+		return 1;
+	}
+
+	LV2_URID_Map   map   = { NULL, urid_map };
+	LV2_URID_Unmap unmap = { NULL, urid_unmap };
+	LV2_Atom_Forge forge;
+	lv2_atom_forge_init(&forge, &map);
+
+	Sratom* sratom = sratom_new(&map);
+
+	// A small message, with properties in the order a model sorts them
+	// [ a eg:Set ; eg:index 3 ; eg:name "x" ; eg:value 0.5 ]
+	uint8_t buf[256];
+	lv2_atom_forge_set_buffer(&forge, buf, sizeof(buf));
+	LV2_Atom_Forge_Frame frame;
+	lv2_atom_forge_object(&forge, &frame, 0, urid_map(NULL, NS_EG "Set"));
+	lv2_atom_forge_key(&forge, urid_map(NULL, NS_EG "index"));
+	lv2_atom_forge_int(&forge, 3);
+	lv2_atom_forge_key(&forge, urid_map(NULL, NS_EG "name"));
+	lv2_atom_forge_string(&forge, "x", 1);
+	lv2_atom_forge_key(&forge, urid_map(NULL, NS_EG "value"));
+	lv2_atom_forge_float(&forge, 0.5f);
+	lv2_atom_forge_pop(&forge, &frame);
+	const LV2_Atom* obj = (const LV2_Atom*)buf;
+
+	printf("%u atoms\n", n_atoms);
+	printf("%-8s %-32s %s\n", "", "Write", "Read");
+	int ret = bench(sratom, &unmap, obj, n_atoms, false);
+	ret |= bench(sratom, &unmap, obj, n_atoms, true);
+
+	sratom_free(sratom);
+	for (uint32_t i = 0; i < n_uris; ++i) {
+		free(uris[i]);
+	}
+	free(uris);
+	return ret;
+}
@@ -64,6 +64,20 @@ urid_unmap(LV2_URID_Unmap_Handle handle,
 	return NULL;
 }
 
+/** A map with different URIDs, for reading in "another process". */
+static LV2_URID
+offset_urid_map(LV2_URID_Map_Handle handle, const char* uri)
+{
+	return urid_map(handle, uri) + 1000;
+}
+
+static const char*
+offset_urid_unmap(LV2_URID_Unmap_Handle handle,
+                  LV2_URID              urid)
+{
+	return urid > 1000 ? urid_unmap(handle, urid - 1000) : NULL;
+}
+
 static int
 test_fail(const char* fmt, ...)
 {
@@ -277,6 +291,62 @@ test(bool top_level)
 		return test_fail("Re-serialised string differs from original\n");
 	}
 
+	// Reusable contexts must give the same results, and survive reuse
+	SratomWriter* writer = sratom_writer_new(sratom, &unmap, base_uri);
+	SratomReader* reader = sratom_reader_new(sratom, base_uri);
+	for (unsigned i = 0; i < 3; ++i) {
+		const char* str = sratom_writer_to_turtle(
+			writer, subj, pred, obj->type, obj->size, LV2_ATOM_BODY(obj));
+		if (strcmp(str, outstr)) {
+			return test_fail("Writer string differs from original\n");
+		}
+
+		const LV2_Atom* read = NULL;
+		if (top_level) {
+			SerdNode o = serd_node_from_string(SERD_URI, USTR(obj_uri));
+			read = sratom_reader_from_turtle(reader, &o, NULL, str);
+		} else {
+			read = sratom_reader_from_turtle(reader, subj, pred, str);
+		}
+		if (!lv2_atom_equals(obj, read)) {
+			return test_fail("Reader atom does not match original\n");
+		}
+	}
+	sratom_reader_free(reader);
+	sratom_writer_free(writer);
+
+	// Binary documents must be readable with a different map
+	LV2_URID_Map   other_map   = { NULL, offset_urid_map };
+	LV2_URID_Unmap other_unmap = { NULL, offset_urid_unmap };
+	Sratom*        other       = sratom_new(&other_map);
+	size_t         doc_size    = 0;
+	void*          doc         = sratom_to_binary(
+		sratom, &unmap, obj->type, obj->size, LV2_ATOM_BODY(obj), &doc_size);
+	LV2_Atom* other_atom = sratom_from_binary(other, doc, doc_size);
+	if (!other_atom) {
+		return test_fail("Failed to read binary document\n");
+	}
+
+	char* binstr = sratom_to_turtle(
+		other, &other_unmap, base_uri, subj, pred,
+		other_atom->type, other_atom->size, LV2_ATOM_BODY(other_atom));
+	if (strcmp(binstr, outstr)) {
+		return test_fail("Binary string differs from original\n");
+	}
+
+	LV2_Atom* binatom = sratom_from_binary(sratom, doc, doc_size);
+	if (!lv2_atom_equals(obj, binatom)) {
+		return test_fail("Binary atom does not match original\n");
+	} else if (sratom_from_binary(sratom, doc, doc_size - 1)) {
+		return test_fail("Read truncated binary document\n");
+	}
+
+	free(binatom);
+	free(binstr);
+	free(other_atom);
+	free(doc);
+	sratom_free(other);
+
 	printf("All tests passed.\n");
 
 	free(parsed);
@@ -294,6 +364,78 @@ test(bool top_level)
 	return 0;
 }
 
+/** Return the key of the first property of `atom`, which must be an Object. */
+static LV2_URID
+first_key(const LV2_Atom* atom)
+{
+	LV2_ATOM_OBJECT_FOREACH((const LV2_Atom_Object*)atom, prop) {
+		return prop->key;
+	}
+	return 0;
+}
+
+static int
+test_reader_fallback(void)
+{
+	LV2_URID_Map map    = { NULL, urid_map };
+	Sratom*      sratom = sratom_new(&map);
+
+	LV2_URID eg_one = urid_map(NULL, "http://example.org/a-one");
+	LV2_URID eg_two = urid_map(NULL, "http://example.org/b-two");
+
+	const char* base_uri = "file:///tmp/base/";
+	SerdNode    s = serd_node_from_string(SERD_URI, USTR("http://example.org/obj"));
+	SerdNode    p = serd_node_from_string(SERD_URI, USTR(NS_RDF "value"));
+
+	// Properties out of sorted order, which the model would sort
+	const char* const in_place =
+		"@prefix eg: <http://example.org/> .\n"
+		"@prefix rdf: <" NS_RDF "> .\n"
+		"eg:obj rdf:value [ a eg:Object ; eg:b-two 2 ; eg:a-one 1 ] .\n";
+
+	// The same object, but described before it is referred to
+	const char* const out_of_place =
+		"@prefix eg: <http://example.org/> .\n"
+		"@prefix rdf: <" NS_RDF "> .\n"
+		"_:b1 a eg:Object ; eg:b-two 2 ; eg:a-one 1 .\n"
+		"eg:obj rdf:value _:b1 .\n";
+
+	SratomReader* reader = sratom_reader_new(sratom, base_uri);
+	LV2_Atom*     model  = sratom_from_turtle(sratom, base_uri, &s, &p, in_place);
+	if (!model || first_key(model) != eg_one) {
+		return test_fail("Model did not sort object properties\n");
+	}
+
+	// Streamed document keeps the document order, so it was not read as a model
+	const LV2_Atom* read = sratom_reader_from_turtle(reader, &s, &p, in_place);
+	if (!read || read->size != model->size || first_key(read) != eg_two) {
+		return test_fail("Reader did not stream in place description\n");
+	}
+
+	// Document which can not be streamed is read as a model
+	LV2_Atom* fallback = sratom_from_turtle(
+		sratom, base_uri, &s, &p, out_of_place);
+	read = sratom_reader_from_turtle(reader, &s, &p, out_of_place);
+	if (!read || !lv2_atom_equals(read, fallback) ||
+	    !lv2_atom_equals(read, model)) {
+		return test_fail("Reader did not fall back for blank described out of place\n");
+	}
+
+	free(fallback);
+	free(model);
+	sratom_reader_free(reader);
+	sratom_free(sratom);
+	for (uint32_t i = 0; i < n_uris; ++i) {
+		free(uris[i]);
+	}
+
+	free(uris);
+	uris   = NULL;
+	n_uris = 0;
+
+	return 0;
+}
+
 int
 main(void)
 {
@@ -301,6 +443,8 @@ main(void)
 		return 1;
 	} else if (test(true)) {
 		return 1;
+	} else if (test_reader_fallback()) {
+		return 1;
 	}
 	return 0;
 }